@@ -41,6 +41,7 @@
 #include "curswitch/curswitch.h"
 #include "debug_support.h"
 #include "display/display.h"
+#include "display/disp_render.h"
 #include "expio/expio.h"
 #include "spi_ops.h"
 #include "util/util.h"
@@ -109,6 +110,7 @@ int board_init() {
     // SPI 1 initialization for the Touch Panel. Use SPI at 2MHz.
     spi_init(SPI_TOUCH_DEVICE, SPI_TOUCH_SPEED);
 
+#if SERVO_BUS_CNT < 2
     // I2C Isn't directly used on the board, but is provided on headers for external use.
     i2c_init(I2C_EXTERN, I2C_EXTERN_CLK_SPEED);
     gpio_set_function(I2C_EXTERN_SDA, GPIO_FUNC_I2C);
@@ -117,6 +119,7 @@ int board_init() {
     gpio_pull_up(I2C_EXTERN_SCL);
     gpio_set_drive_strength(I2C_EXTERN_SDA, GPIO_DRIVE_STRENGTH_4MA);
     gpio_set_drive_strength(I2C_EXTERN_SCL, GPIO_DRIVE_STRENGTH_4MA);
+#endif
 
     // UART Functions.
     //  UART 0 is used for communication with the host (setup, commands, status)
@@ -127,6 +130,13 @@ int board_init() {
     gpio_set_drive_strength(SERVO_CTRL_TX_EN_GPIO, GPIO_DRIVE_STRENGTH_2MA);
     //    Initial output state
     gpio_put(SERVO_CTRL_TX_EN_GPIO, SERVO_CTRL_TX_DIS);     // Bus-Servo TX Disabled
+#if SERVO_BUS_CNT > 1
+    //  Servo Bus 1 (PIO UART) TX Enable. The PIO pins are set up by the servo module.
+    gpio_set_function(SERVO_B1_TX_EN_GPIO, GPIO_FUNC_SIO);
+    gpio_set_dir(SERVO_B1_TX_EN_GPIO, GPIO_OUT);
+    gpio_set_drive_strength(SERVO_B1_TX_EN_GPIO, GPIO_DRIVE_STRENGTH_2MA);
+    gpio_put(SERVO_B1_TX_EN_GPIO, SERVO_CTRL_TX_DIS);       // Bus-Servo TX Disabled
+#endif
 
 
     // GPIO Outputs (other than SPI, I2C, UART, and chip-selects
@@ -312,11 +322,7 @@ void debug_printf(const char* format, ...) {
         index += vsnprintf(&buf[index], sizeof(buf) - index, format, xArgs);
         va_end(xArgs);
         if (disp_ready()) {
-            text_color_pair_t cp;
-            disp_text_colors_get(&cp);
-            disp_text_colors_set(C16_LT_BLUE, C16_BLACK);
-            disp_prints(buf, Paint);
-            disp_text_colors_cp_set(&cp);
+            disp_render_prints_color(buf, C16_LT_BLUE, C16_BLACK);
         }
     }
 }
@@ -329,11 +335,7 @@ void error_printf(const char* format, ...) {
     index += vsnprintf(&buf[index], sizeof(buf) - index, format, xArgs);
     va_end(xArgs);
     if (disp_ready()) {
-        text_color_pair_t cp;
-        disp_text_colors_get(&cp);
-        disp_text_colors_set(C16_RED, C16_BLACK);
-        disp_prints(buf, Paint);
-        disp_text_colors_cp_set(&cp);
+        disp_render_prints_color(buf, C16_RED, C16_BLACK);
     }
 }
 
@@ -345,11 +347,7 @@ void info_printf(const char* format, ...) {
     index += vsnprintf(&buf[index], sizeof(buf) - index, format, xArgs);
     va_end(xArgs);
     if (disp_ready()) {
-        text_color_pair_t cp;
-        disp_text_colors_get(&cp);
-        disp_text_colors_set(C16_BLUE, C16_BLACK);
-        disp_prints(buf, Paint);
-        disp_text_colors_cp_set(&cp);
+        disp_render_prints_color(buf, C16_BLUE, C16_BLACK);
     }
 }
 
@@ -361,11 +359,7 @@ void warn_printf(const char* format, ...) {
     index += vsnprintf(&buf[index], sizeof(buf) - index, format, xArgs);
     va_end(xArgs);
     if (disp_ready()) {
-        text_color_pair_t cp;
-        disp_text_colors_get(&cp);
-        disp_text_colors_set(C16_ORANGE, C16_BLACK);
-        disp_prints(buf, Paint);
-        disp_text_colors_cp_set(&cp);
+        disp_render_prints_color(buf, C16_ORANGE, C16_BLACK);
     }
 }
 
@@ -112,6 +112,9 @@ extern uint64_t now_us();
 /**
  * @brief Get the temperature from the on-chip temp sensor in Celsius.
  *
+ * This selects the ADC input, so it must only be used on core 0, where the
+ * cursor switches are read. Core 0 posts the reading to core 1 (MSG_CORE_TEMP).
+ *
  * @return float Celsius temperature
  */
 extern float onboard_temp_c();
@@ -119,6 +122,8 @@ extern float onboard_temp_c();
 /**
  * @brief Get the temperature from the on-chip temp sensor in Fahrenheit.
  *
+ * Core 0 only (see `onboard_temp_c`).
+ *
  * @return float Fahrenheit temperature
  */
 extern float onboard_temp_f();
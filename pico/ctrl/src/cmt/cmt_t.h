@@ -40,6 +40,7 @@ typedef enum MSG_ID_ {
     MSG_CONFIG_CHANGED,
     MSG_CMT_SLEEP,
     MSG_DEBUG_CHANGED,
+    MSG_DISP_RENDER,        // Display render service - do queued commands
     MSG_HOUSEKEEPING_RT,    // Housekeeping Repeating - Every 16ms (62.5Hz)
     MSG_INPUT_SW_PRESS,
     MSG_INPUT_SW_RELEASE,
@@ -56,8 +57,12 @@ typedef enum MSG_ID_ {
     MSG_ROTARY_CHG,
     MSG_SERVO_DATA_RCVD,
     MSG_SERVO_DATA_RX_TO,
+    MSG_SERVO_DATA_RX_TO_B1,
+    MSG_SERVO_POLL,
+    MSG_SERVO_POLL_B1,
     MSG_SERVO_READ_ERROR,
     MSG_SERVO_STATUS_RCVD,
+    MSG_SERVO_TX_DONE,
     MSG_STDIO_CHAR_READY,
     MSG_SW_LONGPRESS_DELAY,
     MSG_TOUCH_PANEL,
@@ -68,6 +73,7 @@ typedef enum MSG_ID_ {
     MSG_DCS_TEST,
     MSG_HWOS_STARTED,
     MSG_DISPLAY_MESSAGE,
+    MSG_CORE_TEMP,
 } msg_id_t;
 
 /**
@@ -110,6 +116,8 @@ union MSG_DATA_VALUE_ {
     sensbank_chg_t sensbank_chg;
     servo_params_t servo_params;
     switch_action_data_t sw_action;
+    int16_t temp_c10;
+    uint16_t term_rx_cnt;
     uint32_t ts_ms;
     uint64_t ts_us;
 };
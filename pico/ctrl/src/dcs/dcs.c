@@ -37,6 +37,7 @@ static int _dcs_hk_cnt;
 // Message handler functions...
 static void _handle_dcs_housekeeping(cmt_msg_t* msg);
 static void _handle_dcs_test(cmt_msg_t* msg);
+static void _handle_core_temp(cmt_msg_t* msg);
 static void _handle_hwos_started(cmt_msg_t* msg);
 static void _handle_sensbank_chg(cmt_msg_t* msg);
 
@@ -48,6 +49,7 @@ static void _dcs_idle_function_2();
 static void _dcs_started();
 
 
+static const msg_handler_entry_t _core_temp_he = { MSG_CORE_TEMP, _handle_core_temp };
 static const msg_handler_entry_t _dcs_housekeeping_he = { MSG_HOUSEKEEPING_RT, _handle_dcs_housekeeping };
 static const msg_handler_entry_t _dcs_test_he = { MSG_DCS_TEST, _handle_dcs_test };
 static const msg_handler_entry_t _hwos_started_he = { MSG_HWOS_STARTED, _handle_hwos_started };
@@ -58,6 +60,7 @@ static const msg_handler_entry_t* _dcs_handler_entries[] = {
     & _dcs_housekeeping_he,
     & cmt_sm_sleep_handler_entry,    // CMT Scheduled Message 'Sleep' handler
     & _sbchg_he,
+    & _core_temp_he,
     & _dcs_test_he,
     & _hwos_started_he,
     ((msg_handler_entry_t*)0), // Last entry must be a NULL
@@ -126,6 +129,11 @@ static void _handle_dcs_test(cmt_msg_t* msg) {
     times++;
 }
 
+static void _handle_core_temp(cmt_msg_t* msg) {
+    // HWOS read the onboard temperature (it owns the ADC). Update the HID.
+    hid_update_core_temp(msg->data.temp_c10);
+}
+
 static void _handle_hwos_started(cmt_msg_t* msg) {
     // The Hardware Operating System has reported that it is started.
     // Since we are responding to a message, it means we
@@ -0,0 +1,425 @@
+/**
+ * Display render service.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "disp_render.h"
+
+#include "board.h"
+#include "cmt/cmt.h"
+
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+
+#define DISP_RENDER_BATCH_MAX 128   // Commands done for each render message (lets other messages run)
+
+/**
+ * @brief Render command operations.
+ */
+typedef enum DISP_RCMD_OP_ {
+    DRC_PRINTC,
+    DRC_PRINTC_COLOR,               // Print in the command color (rather than the text colors)
+    DRC_CRLF,
+    DRC_CURSOR_BOL,
+    DRC_ERASE_EOL,
+    DRC_CHAR_COLOR,
+    DRC_CURSOR_SET,
+    DRC_CURSOR_SHOW,
+    DRC_ERASE,
+    DRC_SCROLL_AREA,
+    DRC_CLEAR,
+    DRC_WRAP_LEN,
+} disp_rcmd_op_t;
+
+/**
+ * @brief A render command.
+ */
+typedef struct DISP_RCMD_ {
+    uint8_t op;                     // disp_rcmd_op_t
+    char c;
+    colorbyte_t color;
+    uint8_t n;                      // Erase: Number of cells
+    uint16_t line;
+    uint16_t col;
+} disp_rcmd_t;
+
+static queue_t _render_q;
+static volatile bool _render_posted;    // A render message is waiting to be handled
+static volatile bool _rendering;        // The render core is doing commands
+static volatile bool _paint_pending;    // Painting ran out of time, there is more to paint
+static uint32_t _msg_us_max;
+static bool _offload = true;
+static uint32_t _queue_full_cnt;
+static volatile uint32_t _dropped_cnt;
+
+static void _handle_render(cmt_msg_t* msg);
+
+/**
+ * @brief Do a command.
+ */
+static void _execute(const disp_rcmd_t* cmd, paint_control_t paint) {
+    switch (cmd->op) {
+        case DRC_PRINTC:
+            disp_printc(cmd->c, paint);
+            break;
+        case DRC_PRINTC_COLOR:
+        {
+            text_color_pair_t cp;
+            disp_text_colors_get(&cp);
+            disp_text_colors_set(fg_from_cb(cmd->color), bg_from_cb(cmd->color));
+            if (cmd->c == '\n') {
+                disp_print_crlf(0, paint);
+            }
+            else {
+                disp_printc(cmd->c, paint);
+            }
+            disp_text_colors_cp_set(&cp);
+            break;
+        }
+        case DRC_CRLF:
+            disp_print_crlf(0, paint);
+            break;
+        case DRC_CURSOR_BOL:
+            disp_cursor_bol();
+            break;
+        case DRC_ERASE_EOL:
+            disp_print_erase_eol(paint);
+            break;
+        case DRC_CHAR_COLOR:
+            disp_char_colorbyte(cmd->line, cmd->col, cmd->c, cmd->color, paint);
+            break;
+        case DRC_CURSOR_SET:
+            disp_cursor_set(cmd->line, cmd->col);
+            break;
+        case DRC_CURSOR_SHOW:
+            disp_cursor_show(cmd->c != 0);
+            break;
+        case DRC_ERASE:
+            for (uint16_t i = 0; i < cmd->n; i++) {
+                disp_char_colorbyte(cmd->line, cmd->col + i, ' ', cmd->color, No_Paint);
+            }
+            if (paint) {
+                disp_line_paint(cmd->line);
+            }
+            break;
+        case DRC_SCROLL_AREA:
+            disp_scroll_area_define(cmd->line, cmd->col);
+            if (paint) {
+                disp_paint();
+            }
+            break;
+        case DRC_CLEAR:
+            // Always painted, as a clear without painting doesn't mark the lines to paint.
+            disp_text_colors_set(fg_from_cb(cmd->color), bg_from_cb(cmd->color));
+            disp_clear(Paint);
+            break;
+        case DRC_WRAP_LEN:
+            disp_print_wrap_len_set(cmd->line);
+            break;
+    }
+}
+
+static bool _render_loop_running(void) {
+    return (DISP_RENDER_CORE == 0 ? cmt_message_loop_0_running() : cmt_message_loop_1_running());
+}
+
+static void _render_post(void) {
+    _render_posted = true;
+    cmt_msg_t msg;
+    cmt_msg_init3(&msg, MSG_DISP_RENDER, MSG_PRI_NORM, _handle_render);
+#if DISP_RENDER_CORE == 0
+    postHWCtrlMsg(&msg);
+#else
+    postDCSMsg(&msg);
+#endif
+}
+
+/**
+ * @brief Do the queued commands without painting, then paint once for all of them.
+ *
+ * MUST BE CALLED ON THE RENDER CORE!
+ *
+ * @param all True to empty the queue and paint everything, false to do a
+ * batch and paint within the budget (and post to do more)
+ */
+static void _render_drain(bool all) {
+    disp_rcmd_t cmd;
+    int done = 0;
+    _rendering = true;
+    while ((all || done < DISP_RENDER_BATCH_MAX) && queue_try_remove(&_render_q, &cmd)) {
+        _execute(&cmd, No_Paint);
+        done++;
+    }
+    if (done || _paint_pending) {
+        if (all) {
+            disp_paint();
+            _paint_pending = false;
+        }
+        else {
+            _paint_pending = !disp_paint_budget(DISP_RENDER_PAINT_BUDGET_US);
+        }
+    }
+    _rendering = false;
+    if (!all && (!queue_is_empty(&_render_q) || _paint_pending)) {
+        _render_post();  // Let the other messages run, then continue
+    }
+}
+
+/**
+ * @brief Check if a command should be done immediately (on the calling core).
+ *
+ * On the render core, anything queued is done first to keep the order.
+ */
+static bool _direct(void) {
+    if (!_offload || !_render_loop_running()) {
+        return (true);
+    }
+    if (get_core_num() == DISP_RENDER_CORE) {
+        if (!_rendering) {
+            _render_drain(true);
+        }
+        // else - it's from a command being done (an error message, for instance)
+        return (true);
+    }
+    return (false);
+}
+
+static void _submit(const disp_rcmd_t* cmd) {
+    if (!queue_try_add(&_render_q, cmd)) {
+        if (__get_current_exception() != 0) {
+            // An interrupt handler can't wait for the render core (it could
+            // be holding up the core that needs to run). Drop it.
+            _dropped_cnt++;
+            return;
+        }
+        // The render core is working on it. Wait for room.
+        _queue_full_cnt++;
+        queue_add_blocking(&_render_q, cmd);
+    }
+    if (!_render_posted) {
+        _render_post();
+    }
+}
+
+static void _direct_or_submit(const disp_rcmd_t* cmd) {
+    if (_direct()) {
+        _execute(cmd, Paint);
+        return;
+    }
+    _submit(cmd);
+}
+
+static void _submit_prints(const char* s, disp_rcmd_op_t op, colorbyte_t color) {
+    disp_rcmd_t cmd = { .op = op, .color = color };
+    char c;
+    while ((c = *s++) != 0) {
+        if (c == '\n' && op == DRC_PRINTC) {
+            cmd.op = DRC_CRLF;
+            _submit(&cmd);
+            cmd.op = op;
+            continue;
+        }
+        cmd.c = c;
+        _submit(&cmd);
+    }
+}
+
+// ############################################################################
+// Message Handlers
+// ############################################################################
+//
+
+static void _handle_render(cmt_msg_t* msg) {
+    // Clear first, so a command submitted while draining posts again.
+    _render_posted = false;
+    uint64_t t0 = time_us_64();
+    _render_drain(false);
+    uint32_t us = (uint32_t)(time_us_64() - t0);
+    if (us > _msg_us_max) {
+        _msg_us_max = us;
+    }
+}
+
+// ############################################################################
+// Public Functions
+// ############################################################################
+//
+
+void disp_render_printc(char c) {
+    if (_direct()) {
+        disp_printc(c, Paint);
+        return;
+    }
+    disp_rcmd_t cmd = { .op = DRC_PRINTC, .c = c };
+    _submit(&cmd);
+}
+
+void disp_render_prints(const char* s) {
+    if (_direct()) {
+        disp_prints((char*)s, Paint);
+        return;
+    }
+    _submit_prints(s, DRC_PRINTC, 0);
+}
+
+void disp_render_prints_color(const char* s, colorn16_t fg, colorn16_t bg) {
+    if (_direct()) {
+        text_color_pair_t cp;
+        disp_text_colors_get(&cp);
+        disp_text_colors_set(fg, bg);
+        disp_prints((char*)s, Paint);
+        disp_text_colors_cp_set(&cp);
+        return;
+    }
+    _submit_prints(s, DRC_PRINTC_COLOR, colorbyte(fg, bg));
+}
+
+void disp_render_string_color(uint16_t line, uint16_t col, const char* s, colorn16_t fg, colorn16_t bg) {
+    if (_direct()) {
+        disp_string_color(line, col, s, fg, bg, Paint);
+        return;
+    }
+    uint16_t cols = disp_info_columns();
+    disp_rcmd_t cmd = { .op = DRC_CHAR_COLOR, .color = colorbyte(fg, bg), .line = line, .col = col };
+    while (*s && cmd.col < cols) {
+        cmd.c = *s++;
+        _submit(&cmd);
+        cmd.col++;
+    }
+}
+
+void disp_render_clear(colorn16_t fg, colorn16_t bg) {
+    disp_rcmd_t cmd = { .op = DRC_CLEAR, .color = colorbyte(fg, bg) };
+    _direct_or_submit(&cmd);
+}
+
+void disp_render_crlf(void) {
+    if (_direct()) {
+        disp_print_crlf(0, Paint);
+        return;
+    }
+    disp_rcmd_t cmd = { .op = DRC_CRLF };
+    _submit(&cmd);
+}
+
+void disp_render_cursor_bol(void) {
+    if (_direct()) {
+        disp_cursor_bol();
+        return;
+    }
+    disp_rcmd_t cmd = { .op = DRC_CURSOR_BOL };
+    _submit(&cmd);
+}
+
+void disp_render_erase_eol(void) {
+    if (_direct()) {
+        disp_print_erase_eol(Paint);
+        return;
+    }
+    disp_rcmd_t cmd = { .op = DRC_ERASE_EOL };
+    _submit(&cmd);
+}
+
+void disp_render_char_color(uint16_t line, uint16_t col, char c, colorn16_t fg, colorn16_t bg, paint_control_t paint) {
+    if (_direct()) {
+        disp_char_color(line, col, c, fg, bg, paint);
+        return;
+    }
+    disp_rcmd_t cmd = { .op = DRC_CHAR_COLOR, .c = c, .color = colorbyte(fg, bg), .line = line, .col = col };
+    _submit(&cmd);
+}
+
+void disp_render_cursor_set(uint16_t line, uint16_t col) {
+    disp_rcmd_t cmd = { .op = DRC_CURSOR_SET, .line = line, .col = col };
+    _direct_or_submit(&cmd);
+}
+
+void disp_render_cursor_show(bool show) {
+    disp_rcmd_t cmd = { .op = DRC_CURSOR_SHOW, .c = show };
+    _direct_or_submit(&cmd);
+}
+
+void disp_render_erase(uint16_t line, uint16_t col, uint16_t n, colorn16_t fg, colorn16_t bg) {
+    uint16_t cols = disp_info_columns();
+    if (col >= cols) {
+        return;
+    }
+    if (n > cols - col) {
+        n = cols - col;
+    }
+    disp_rcmd_t cmd = { .op = DRC_ERASE, .color = colorbyte(fg, bg), .n = n, .line = line, .col = col };
+    _direct_or_submit(&cmd);
+}
+
+void disp_render_scroll_area(uint16_t top_fixed_size, uint16_t bottom_fixed_size) {
+    disp_rcmd_t cmd = { .op = DRC_SCROLL_AREA, .line = top_fixed_size, .col = bottom_fixed_size };
+    _direct_or_submit(&cmd);
+}
+
+void disp_render_wrap_len_set(uint16_t len) {
+    disp_rcmd_t cmd = { .op = DRC_WRAP_LEN, .line = len };
+    _direct_or_submit(&cmd);
+}
+
+void disp_render_paint(void) {
+    if (_direct()) {
+        disp_paint();
+    }
+}
+
+void disp_render_offload(bool offload) {
+    if (!offload && _offload) {
+        if (get_core_num() == DISP_RENDER_CORE) {
+            _render_drain(true);
+        }
+        else {
+            while ((!queue_is_empty(&_render_q) || _rendering || _paint_pending) && _render_loop_running()) {
+                tight_loop_contents();
+            }
+        }
+    }
+    _offload = offload;
+}
+
+void disp_render_owner_check(const char* fn) {
+    if (_offload && get_core_num() != DISP_RENDER_CORE && _render_loop_running()) {
+        board_panic("%s used on core %d - the display belongs to the render core (use disp_render_*)", fn, get_core_num());
+    }
+}
+
+uint32_t disp_render_queue_full_cnt(void) {
+    return (_queue_full_cnt);
+}
+
+uint32_t disp_render_dropped_cnt(void) {
+    return (_dropped_cnt);
+}
+
+uint disp_render_room(void) {
+    if (!_offload || !_render_loop_running() || get_core_num() == DISP_RENDER_CORE) {
+        return (DISP_RENDER_QUEUE_SIZE);    // Commands are done immediately
+    }
+    return (DISP_RENDER_QUEUE_SIZE - queue_get_level(&_render_q));
+}
+
+uint32_t disp_render_msg_us_max(void) {
+    uint32_t us = _msg_us_max;
+    _msg_us_max = 0;
+    return (us);
+}
+
+// ############################################################################
+// Initialization and Maintainence Functions
+// ############################################################################
+//
+
+void disp_render_module_init(void) {
+    static bool _initialized = false;
+    if (_initialized) {
+        board_panic("disp_render_module_init already called");
+    }
+    _initialized = true;
+    queue_init(&_render_q, sizeof(disp_rcmd_t), DISP_RENDER_QUEUE_SIZE);
+}
@@ -0,0 +1,268 @@
+/**
+ * @brief Display render service.
+ * @ingroup display
+ *
+ * The render service owns the text screen on one core (DISP_RENDER_CORE).
+ * Code on the other core submits compact text commands into a queue and
+ * returns immediately. The service runs the commands in batches from its
+ * core's message loop, without painting, then paints once for the batch
+ * (only the changed cells are sent). Painting is limited to a time budget
+ * for each message (DISP_RENDER_PAINT_BUDGET_US), and what is left is painted
+ * by the next one, so other messages on the render core still get to run
+ * while a lot of output is being painted.
+ *
+ * Commands submitted on the render core (or before its message loop is
+ * running, or with the offload turned off) are done immediately, after
+ * anything that is already queued.
+ *
+ * While the service is running, the display (the `disp_*` functions that
+ * change or paint it) belongs to the render core. Use of it directly from
+ * the other core panics (see `disp_render_owner_check`), as it would race the
+ * render core on the screen buffers, the glyph cache and the SPI.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _DISP_RENDER_H_
+#define _DISP_RENDER_H_
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "display.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef DISP_RENDER_CORE
+#define DISP_RENDER_CORE 1          // The core that renders and paints the screen
+#endif
+
+#ifndef DISP_RENDER_QUEUE_SIZE
+#define DISP_RENDER_QUEUE_SIZE 512  // Commands that can be waiting
+#endif
+
+#ifndef DISP_RENDER_PAINT_BUDGET_US
+#define DISP_RENDER_PAINT_BUDGET_US 4000    // Time to paint for in each render message
+#endif
+
+/**
+ * @brief Print a character at the cursor (like `disp_printc`).
+ * @ingroup display
+ *
+ * @param c The character
+ */
+extern void disp_render_printc(char c);
+
+/**
+ * @brief Print a string at the cursor (like `disp_prints`).
+ * @ingroup display
+ *
+ * The string is copied into the queue, so it doesn't need to be kept.
+ *
+ * @param s The string ('\n' starts a new line)
+ */
+extern void disp_render_prints(const char* s);
+
+/**
+ * @brief Print a string at the cursor in colors other than the text colors.
+ * @ingroup display
+ *
+ * @param s The string ('\n' starts a new line)
+ * @param fg The foreground color
+ * @param bg The background color
+ */
+extern void disp_render_prints_color(const char* s, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Print a string at a line/column in colors (like `disp_string_color`).
+ * @ingroup display
+ *
+ * The string is copied into the queue, so it doesn't need to be kept. It is
+ * cut off at the end of the line.
+ *
+ * @param line 0-based line
+ * @param col 0-based column
+ * @param s The string
+ * @param fg The foreground color
+ * @param bg The background color
+ */
+extern void disp_render_string_color(uint16_t line, uint16_t col, const char* s, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Set the text colors and clear the screen (like `disp_text_colors_set` and `disp_clear`).
+ * @ingroup display
+ *
+ * The screen is painted when the clear is done.
+ *
+ * @param fg The foreground (text) color
+ * @param bg The background color
+ */
+extern void disp_render_clear(colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Start a new line (like `disp_print_crlf(0, ...)`).
+ * @ingroup display
+ */
+extern void disp_render_crlf(void);
+
+/**
+ * @brief Move the cursor to the beginning of the line (like `disp_cursor_bol`).
+ * @ingroup display
+ */
+extern void disp_render_cursor_bol(void);
+
+/**
+ * @brief Erase from the cursor to the end of the line (like `disp_print_erase_eol`).
+ * @ingroup display
+ */
+extern void disp_render_erase_eol(void);
+
+/**
+ * @brief Put a character in a line/column in colors (like `disp_char_color`).
+ * @ingroup display
+ *
+ * @param line 0-based line
+ * @param col 0-based column
+ * @param c The character
+ * @param fg The foreground color
+ * @param bg The background color
+ * @param paint Paint when done immediately (queued commands are painted with their batch)
+ */
+extern void disp_render_char_color(uint16_t line, uint16_t col, char c, colorn16_t fg, colorn16_t bg, paint_control_t paint);
+
+/**
+ * @brief Set the cursor position (like `disp_cursor_set`).
+ * @ingroup display
+ *
+ * @param line 0-based line within the scroll area
+ * @param col 0-based column
+ */
+extern void disp_render_cursor_set(uint16_t line, uint16_t col);
+
+/**
+ * @brief Show/hide the cursor (like `disp_cursor_show`).
+ * @ingroup display
+ *
+ * @param show True to show the cursor
+ */
+extern void disp_render_cursor_show(bool show);
+
+/**
+ * @brief Erase cells of a line to spaces in colors.
+ * @ingroup display
+ *
+ * @param line 0-based line
+ * @param col 0-based column of the first cell
+ * @param n The number of cells (limited to the end of the line)
+ * @param fg The foreground color
+ * @param bg The background color
+ */
+extern void disp_render_erase(uint16_t line, uint16_t col, uint16_t n, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Set the fixed areas of the screen (like `disp_scroll_area_define`).
+ * @ingroup display
+ *
+ * @param top_fixed_size Lines fixed at the top
+ * @param bottom_fixed_size Lines fixed at the bottom
+ */
+extern void disp_render_scroll_area(uint16_t top_fixed_size, uint16_t bottom_fixed_size);
+
+/**
+ * @brief Set the word wrap length for printing (like `disp_print_wrap_len_set`).
+ * @ingroup display
+ *
+ * @param len The wrap length (0 = no word wrap)
+ */
+extern void disp_render_wrap_len_set(uint16_t len);
+
+/**
+ * @brief Paint what was put with `No_Paint` (when commands are being done immediately).
+ * @ingroup display
+ *
+ * Queued commands are painted with their batch, so this only needs to be used
+ * after putting a group of cells, to paint them together.
+ */
+extern void disp_render_paint(void);
+
+/**
+ * @brief Turn offloading the rendering to the render core on/off.
+ * @ingroup display
+ *
+ * When off, the commands are done immediately on the calling core. Turning it
+ * off waits for the queued commands to be done. It is on by default.
+ *
+ * @param offload True to queue the commands for the render core
+ */
+extern void disp_render_offload(bool offload);
+
+/**
+ * @brief Check that the calling core may use the display directly.
+ * @ingroup display
+ *
+ * The `disp_*` functions that change or paint the display call this. While
+ * the render service is running (its message loop is running and the
+ * offload is on) only the render core may use them, so this panics when
+ * called on the other core.
+ *
+ * @param fn The name of the display function (for the panic message)
+ */
+extern void disp_render_owner_check(const char* fn);
+
+/**
+ * @brief Get the number of times a command had to wait for room in the queue.
+ * @ingroup display
+ *
+ * @return uint32_t The count
+ */
+extern uint32_t disp_render_queue_full_cnt(void);
+
+/**
+ * @brief Get the number of commands dropped because the queue was full.
+ * @ingroup display
+ *
+ * A command submitted from an interrupt handler doesn't wait for room in the
+ * queue (the handler could be holding up the core that has to make the room),
+ * it is dropped.
+ *
+ * @return uint32_t The count
+ */
+extern uint32_t disp_render_dropped_cnt(void);
+
+/**
+ * @brief Get the number of commands that can be submitted without waiting.
+ * @ingroup display
+ *
+ * Code that submits a lot of commands from a message handler can use this to
+ * stop before the queue fills (and continue in a later message), rather than
+ * waiting for the render core. When commands are done immediately (on the
+ * render core, or with the service not running) this is the queue size.
+ *
+ * @return uint The number of free entries in the queue
+ */
+extern uint disp_render_room(void);
+
+/**
+ * @brief Get the longest time a render message took (commands and painting).
+ * @ingroup display
+ *
+ * The longest time is reset each time this is called.
+ *
+ * @return uint32_t The time in microseconds
+ */
+extern uint32_t disp_render_msg_us_max(void);
+
+/**
+ * @brief Initialize the render service.
+ * @ingroup display
+ *
+ * The display must be initialized first.
+ */
+extern void disp_render_module_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _DISP_RENDER_H_
@@ -0,0 +1,146 @@
+/**
+ * Retained status widgets.
+ *
+ * Each widget renders its value into cells (characters and colors), compares
+ * them with the cells it has shown, and puts only the ones that are different.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "disp_widget.h"
+#include "disp_render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DW_BAR_FULL_CHR_ (' ' | DISP_CHAR_INVERT_BIT)  // A cell of the foreground color
+#define DW_BAR_EMPTY_CHR_ ' '
+
+static uint32_t _cells_put;
+
+/*
+ * Put a string (label or units) in the widget's colors. Returns the cells used.
+ *
+ * Each cell is painted on its own (when done immediately), so only that cell
+ * is sent. Queued cells are painted with their batch.
+ */
+static uint16_t _text_put(uint16_t line, uint16_t col, const char* s, colorbyte_t color) {
+    uint16_t n = 0;
+    if (s) {
+        for (; s[n]; n++) {
+            disp_render_char_color(line, col + n, s[n], fg_from_cb(color), bg_from_cb(color), Paint);
+        }
+    }
+    return (n);
+}
+
+static void _init(disp_widget_t* w, disp_widget_kind_t kind, uint16_t line, uint16_t col, uint8_t cells, colorn16_t fg, colorn16_t bg) {
+    memset(w, 0, sizeof(disp_widget_t));
+    w->kind = kind;
+    w->line = line;
+    w->col = col;
+    w->cells = (cells > DISP_WIDGET_CELLS_MAX ? DISP_WIDGET_CELLS_MAX : cells);
+    w->color = colorbyte(fg, bg);
+}
+
+/*
+ * Render the value into cells.
+ */
+static void _render(const disp_widget_t* w, int32_t value, char* text) {
+    switch (w->kind) {
+        case DW_FIELD: {
+            char buf[24];
+            int32_t scale = 1;
+            for (int i = 0; i < w->decimals; i++) {
+                scale *= 10;
+            }
+            int len;
+            if (w->decimals == 0) {
+                len = snprintf(buf, sizeof(buf), "%ld", (long)value);
+            }
+            else {
+                len = snprintf(buf, sizeof(buf), "%s%ld.%0*ld", (value < 0 ? "-" : ""),
+                    labs((long)(value / scale)), w->decimals, labs((long)(value % scale)));
+            }
+            if (len > w->cells) {
+                memset(text, '#', w->cells);
+            }
+            else {
+                memset(text, ' ', w->cells - len);
+                memcpy(text + (w->cells - len), buf, len);
+            }
+            break;
+        }
+        case DW_BAR: {
+            int32_t range = w->max - w->min;
+            int32_t v = (value < w->min ? w->min : (value > w->max ? w->max : value));
+            int filled = (range > 0 ? (int)((((int64_t)(v - w->min) * w->cells) + (range / 2)) / range) : 0);
+            for (int i = 0; i < w->cells; i++) {
+                text[i] = (i < filled ? DW_BAR_FULL_CHR_ : DW_BAR_EMPTY_CHR_);
+            }
+            break;
+        }
+        case DW_INDICATOR:
+            text[0] = (value ? w->on_chr : w->off_chr);
+            break;
+    }
+}
+
+void disp_widget_bar_init(disp_widget_t* w, uint16_t line, uint16_t col, const char* label, uint8_t cells, int32_t min, int32_t max, colorn16_t fg, colorn16_t bg) {
+    _init(w, DW_BAR, line, col, cells, fg, bg);
+    w->col += _text_put(line, col, label, w->color);
+    w->min = min;
+    w->max = max;
+}
+
+void disp_widget_field_init(disp_widget_t* w, uint16_t line, uint16_t col, const char* label, uint8_t cells, uint8_t decimals, const char* units, colorn16_t fg, colorn16_t bg) {
+    _init(w, DW_FIELD, line, col, cells, fg, bg);
+    w->col += _text_put(line, col, label, w->color);
+    w->decimals = decimals;
+    _text_put(line, w->col + w->cells, units, w->color);
+}
+
+void disp_widget_indicator_init(disp_widget_t* w, uint16_t line, uint16_t col, char on_chr, char off_chr, colorn16_t fg, colorn16_t bg) {
+    _init(w, DW_INDICATOR, line, col, 1, fg, bg);
+    w->on_chr = on_chr;
+    w->off_chr = off_chr;
+}
+
+void disp_widget_invalidate(disp_widget_t* w) {
+    w->shown = false;
+}
+
+bool disp_widget_set(disp_widget_t* w, int32_t value) {
+    return (disp_widget_set_color(w, value, fg_from_cb(w->color), bg_from_cb(w->color)));
+}
+
+bool disp_widget_set_color(disp_widget_t* w, int32_t value, colorn16_t fg, colorn16_t bg) {
+    colorbyte_t color = colorbyte(fg, bg);
+    if (w->shown && value == w->value && color == w->color) {
+        return (false);
+    }
+    char text[DISP_WIDGET_CELLS_MAX];
+    bool changed = false;
+    _render(w, value, text);
+    for (int i = 0; i < w->cells; i++) {
+        if (!w->shown || text[i] != w->text[i] || color != w->cell_color[i]) {
+            // Painted on its own, like the label cells.
+            disp_render_char_color(w->line, w->col + i, text[i], fg, bg, Paint);
+            w->text[i] = text[i];
+            w->cell_color[i] = color;
+            _cells_put++;
+            changed = true;
+        }
+    }
+    w->value = value;
+    w->color = color;
+    w->shown = true;
+
+    return (changed);
+}
+
+uint32_t disp_widget_cells_put(void) {
+    return (_cells_put);
+}
@@ -0,0 +1,163 @@
+/**
+ * @brief Retained status widgets.
+ * @ingroup display
+ *
+ * A widget is a piece of a status panel in fixed text cells: a labeled number,
+ * a bar gauge, or an indicator glyph. It keeps the value and the cells that it
+ * last put on the screen, so setting a value that is the same does nothing,
+ * and setting one that changed only puts (and paints) the cells that are
+ * different. Status can be updated as often as it is checked, without sending
+ * the panel to the display each time.
+ *
+ * The cells are put through the render service (`disp_render_char_color`).
+ * If the cells are changed by something else (like clearing the screen) the
+ * widget must be invalidated so its next value puts all of its cells.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _DISP_WIDGET_H_
+#define _DISP_WIDGET_H_
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+#include "display.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DISP_WIDGET_CELLS_MAX 16    // Most cells for the value of a widget
+
+/**
+ * @brief The kinds of widgets.
+ * @ingroup display
+ */
+typedef enum DISP_WIDGET_KIND_ {
+    DW_FIELD,                       // A number (fixed point), right justified
+    DW_BAR,                         // A bar gauge
+    DW_INDICATOR,                   // One of two glyphs
+} disp_widget_kind_t;
+
+/**
+ * @brief A widget.
+ * @ingroup display
+ *
+ * Set up with one of the `_init` functions, then use `disp_widget_set`.
+ */
+typedef struct DISP_WIDGET_ {
+    uint8_t kind;                   // disp_widget_kind_t
+    uint8_t cells;                  // Cells for the value
+    uint8_t decimals;               // Field: Digits after the decimal point
+    bool shown;                     // The cells are on the screen (the retained cells are good)
+    uint16_t line;
+    uint16_t col;                   // Column of the first value cell
+    int32_t min;                    // Bar: Value for an empty bar
+    int32_t max;                    // Bar: Value for a full bar
+    char on_chr;                    // Indicator: Glyph when on (value != 0)
+    char off_chr;                   // Indicator: Glyph when off
+    colorbyte_t color;              // The value's colors
+    int32_t value;                  // The value shown
+    char text[DISP_WIDGET_CELLS_MAX];               // The cells shown
+    colorbyte_t cell_color[DISP_WIDGET_CELLS_MAX];  // The colors of the cells shown
+} disp_widget_t;
+
+/**
+ * @brief Set up a bar gauge.
+ * @ingroup display
+ *
+ * The label is put in front of the bar (in the same colors). The bar is
+ * filled in proportion to where the value is between `min` and `max`.
+ *
+ * @param w The widget
+ * @param line 0-based line
+ * @param col 0-based column (of the label)
+ * @param label Label for the bar (can be NULL)
+ * @param cells The cells for the bar
+ * @param min Value for an empty bar
+ * @param max Value for a full bar
+ * @param fg The foreground (bar) color
+ * @param bg The background color
+ */
+extern void disp_widget_bar_init(disp_widget_t* w, uint16_t line, uint16_t col, const char* label, uint8_t cells, int32_t min, int32_t max, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Set up a number field.
+ * @ingroup display
+ *
+ * The label is put in front of the number and the units after it (in the
+ * same colors). The value is fixed point, with `decimals` digits after the
+ * decimal point (a value of 413 with 1 decimal is shown as `41.3`). A value
+ * that doesn't fit is shown as `#`s.
+ *
+ * @param w The widget
+ * @param line 0-based line
+ * @param col 0-based column (of the label)
+ * @param label Label for the number (can be NULL)
+ * @param cells The cells for the number
+ * @param decimals Digits after the decimal point
+ * @param units Units for the number (can be NULL)
+ * @param fg The foreground color
+ * @param bg The background color
+ */
+extern void disp_widget_field_init(disp_widget_t* w, uint16_t line, uint16_t col, const char* label, uint8_t cells, uint8_t decimals, const char* units, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Set up an indicator.
+ * @ingroup display
+ *
+ * @param w The widget
+ * @param line 0-based line
+ * @param col 0-based column
+ * @param on_chr Glyph when on
+ * @param off_chr Glyph when off
+ * @param fg The foreground color
+ * @param bg The background color
+ */
+extern void disp_widget_indicator_init(disp_widget_t* w, uint16_t line, uint16_t col, char on_chr, char off_chr, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Make the next value put all of the widget's cells.
+ * @ingroup display
+ *
+ * Use this when the cells were changed by something else.
+ *
+ * @param w The widget
+ */
+extern void disp_widget_invalidate(disp_widget_t* w);
+
+/**
+ * @brief Set a widget's value.
+ * @ingroup display
+ *
+ * @param w The widget
+ * @param value The value
+ * @return true Cells changed (and are being painted)
+ */
+extern bool disp_widget_set(disp_widget_t* w, int32_t value);
+
+/**
+ * @brief Set a widget's value and colors.
+ * @ingroup display
+ *
+ * @param w The widget
+ * @param value The value
+ * @param fg The foreground color
+ * @param bg The background color
+ * @return true Cells changed (and are being painted)
+ */
+extern bool disp_widget_set_color(disp_widget_t* w, int32_t value, colorn16_t fg, colorn16_t bg);
+
+/**
+ * @brief Get the number of cells that widgets have put on the screen.
+ * @ingroup display
+ *
+ * @return uint32_t The count
+ */
+extern uint32_t disp_widget_cells_put(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _DISP_WIDGET_H_
@@ -19,6 +19,64 @@
 static scr_context_t* _scr_contexts[NUMBER_OF_SCREEN_CONTEXTS];
 static int _scr_contexts_peek = -1;
 
+// Pool of screen contexts and their buffers (rather than the heap, so switching
+// screens doesn't fragment it). A bit is set in `_scr_pool_used` for each
+// context in use, so getting and returning one are constant time.
+#if DISP_SCREEN_POOL_SIZE < 1 || DISP_SCREEN_POOL_SIZE > 32
+#error "DISP_SCREEN_POOL_SIZE must be 1 to 32"
+#endif
+typedef struct scr_context_slot_ {
+    scr_context_t ctx;                  // First, so a context pointer is its slot
+    uint8_t text[DISP_SCREEN_CELLS_MAX];
+    colorbyte_t color[DISP_SCREEN_CELLS_MAX];
+    uint8_t painted_text[DISP_SCREEN_CELLS_MAX];
+    colorbyte_t painted_color[DISP_SCREEN_CELLS_MAX];
+    bool dirty[DISP_SCREEN_LINES_MAX];
+} scr_context_slot_t;
+static scr_context_slot_t _scr_pool[DISP_SCREEN_POOL_SIZE];
+static uint32_t _scr_pool_used;
+static uint16_t _scr_pool_peak;
+
+scr_context_t* _scr_context_alloc(uint16_t cols, uint16_t lines) {
+    uint32_t avail = ~_scr_pool_used & (uint32_t)((1ull << DISP_SCREEN_POOL_SIZE) - 1);
+    if (avail == 0) {
+        error_printf("Display - No screen contexts left in the pool.");
+        return NULL;
+    }
+    if (lines > DISP_SCREEN_LINES_MAX || (cols * lines) > DISP_SCREEN_CELLS_MAX) {
+        error_printf("Display - Screen is too big for a screen context (%hux%hu).", cols, lines);
+        return NULL;
+    }
+    int i = __builtin_ctz(avail);
+    _scr_pool_used |= (1u << i);
+    uint16_t used = __builtin_popcount(_scr_pool_used);
+    if (used > _scr_pool_peak) {
+        _scr_pool_peak = used;
+    }
+    scr_context_slot_t* slot = &_scr_pool[i];
+    slot->ctx.full_screen_text = slot->text;
+    slot->ctx.full_screen_color = slot->color;
+    slot->ctx.painted_text = slot->painted_text;
+    slot->ctx.painted_color = slot->painted_color;
+    slot->ctx.dirty_text_lines = slot->dirty;
+    memset(slot->dirty, false, sizeof(slot->dirty));
+    return (&slot->ctx);
+}
+
+void _scr_context_free(scr_context_t* sc) {
+    int i = (scr_context_slot_t*)sc - _scr_pool;
+    if (i < 0 || i >= DISP_SCREEN_POOL_SIZE || !(_scr_pool_used & (1u << i))) {
+        error_printf("Display - Screen context to free isn't from the pool.");
+        return;
+    }
+    _scr_pool_used &= ~(1u << i);
+}
+
+void disp_screen_pool_info(uint16_t* in_use, uint16_t* peak) {
+    *in_use = __builtin_popcount(_scr_pool_used);
+    *peak = _scr_pool_peak;
+}
+
 bool _has_scr_context() {
     return (_scr_contexts_peek > (-1));
 }
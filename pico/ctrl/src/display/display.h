@@ -17,6 +17,7 @@
  extern "C" {
 #endif
 
+#include "system_defs.h"
 #include "gfx/gfx.h"
 
 #include <stdbool.h>
@@ -78,6 +79,12 @@ typedef struct _text_color_pair_ {
     colorn16_t bg;
 } text_color_pair_t;
 
+/**
+ * @brief A screen that has been parked (see `disp_screen_park`).
+ * @ingroup display
+ */
+typedef struct scr_context_* disp_screen_t;
+
 /**
  * @brief Create 'color-byte number' from forground & background color numbers.
  * @ingroup display
@@ -332,12 +339,30 @@ extern void disp_line_paint(uint16_t line);
  */
 extern void disp_paint(void);
 
+/**
+ * @brief Paint the actual display screen, within a time budget.
+ * @ingroup display
+ *
+ * Like `disp_paint`, but stops when the time is used up (at least one dirty
+ * line is painted each call). The lines that weren't painted stay dirty, so
+ * calling it again continues.
+ *
+ * @param budget_us The time to paint for (0 for no limit)
+ * @return true Everything was painted
+ */
+extern bool disp_paint_budget(uint32_t budget_us);
+
 /**
  * @brief Move the cursor to the beginning of the next line. Scroll the display if needed.
  * @ingroup display
  *
  * The `disp_print...` use the cursor for position, advancing the cursor as they print.
  *
+ * Lines that are scrolled in are cleared in the text, and the display is scrolled
+ * (once) the next time it is painted. Printing a burst of lines without painting,
+ * then painting, scrolls the display once and only paints the lines that can be
+ * seen.
+ *
  * @param add_lines Additional lines to advance the cursor.
  * @param paint Controls painting of the screen after the operation.
  */
@@ -476,6 +501,21 @@ extern void disp_text_colors_set(colorn16_t fg, colorn16_t bg);
  */
 extern void disp_text_colors_cp_set(text_color_pair_t* cp);
 
+/**
+ * @brief Control repainting only the changed cells of a line.
+ * @ingroup display
+ *
+ * When a line is painted, only the cells whose text, color, or cursor differ
+ * from what was last painted are sent to the display. This is on by default.
+ * Turning it off repaints whole lines (for comparison). Only in an A/B
+ * benchmark build (`DISP_AB_BENCH`).
+ *
+ * @param cells True to repaint only the changed cells
+ */
+#if DISP_AB_BENCH
+extern void disp_cell_repaint_enable(bool cells);
+#endif
+
 /**
  * @brief Update the display (graphics) buffer from the text line data. Optionally paint the screen
  * @ingroup display
@@ -510,6 +550,52 @@ extern void disp_screen_close();
  */
 extern bool disp_screen_new();
 
+/**
+ * @brief Park the active screen and go back to the previous screen.
+ * @ingroup display
+ *
+ * Like `disp_screen_close`, but the screen (its text, colors, cursor, and
+ * scroll) is kept, to be made active again with `disp_screen_restore`. This
+ * lets views (like the terminal, keyboard, and status) be switched without
+ * creating them again. A parked screen keeps its context from the pool until
+ * it is discarded.
+ *
+ * @return disp_screen_t The parked screen, or NULL if the active screen is the main screen
+ */
+extern disp_screen_t disp_screen_park(void);
+
+/**
+ * @brief Make a parked screen the active screen.
+ * @ingroup display
+ *
+ * The active screen is saved (like `disp_screen_new`) until the restored one
+ * is closed or parked again. The screen is repainted.
+ *
+ * @param scr The parked screen
+ * @return true If the screen was made active
+ */
+extern bool disp_screen_restore(disp_screen_t scr);
+
+/**
+ * @brief Discard a parked screen (return its context to the pool).
+ * @ingroup display
+ *
+ * @param scr The parked screen
+ */
+extern void disp_screen_discard(disp_screen_t scr);
+
+/**
+ * @brief Get the use of the screen context pool.
+ * @ingroup display
+ *
+ * The screens (active, saved, and parked) come from a fixed pool of
+ * DISP_SCREEN_POOL_SIZE contexts.
+ *
+ * @param in_use Set to the number of contexts in use
+ * @param peak Set to the most contexts that have been in use at once
+ */
+extern void disp_screen_pool_info(uint16_t* in_use, uint16_t* peak);
+
 /**
  * @brief Clear the scroll area of the screen.
  * @ingroup display
@@ -24,6 +24,20 @@ extern "C" {
 #include "display_rgb18/display_rgb18.h"
 #include "fonts/font.h"
 
+/** @brief `painted_cursor` line value for no cursor painted. */
+#define DISP_NO_PAINTED_CURSOR 0xFFFF
+
+#ifndef DISP_SCREEN_POOL_SIZE
+#define DISP_SCREEN_POOL_SIZE 4     // Screen contexts in the pool (the most screens at once, up to 32)
+#endif
+
+/** @brief Most text cells for a screen (the ILI9488 with the 10x16 font, either way up). */
+#define DISP_SCREEN_CELLS_MAX ((320 / 10) * (480 / 16))
+/** @brief Most text lines for a screen. */
+#define DISP_SCREEN_LINES_MAX (480 / 16)
+/** @brief Most pixels across a screen. */
+#define DISP_SCREEN_WIDTH_MAX 480
+
 /**
  * @brief Context for a screen.
  * @ingroup display
@@ -39,6 +53,7 @@ typedef struct scr_context_ {
     uint16_t fixed_area_bottom_size;    // The bottom fixedarea line count
     uint16_t scroll_size;               // This is `lines` - `the fixed size`, but stored for performance
     uint16_t scroll_start;              // Start line of the scroll area in the text buffer
+    uint16_t scroll_start_shown;        // Start line the display was last scrolled to (set when painting)
     scr_position_t cursor_pos;          // The cursor position
     bool show_cursor;                   // Cursor visibility control
     rgb18_t cursor_color;               // The color of the cursor when it's shown
@@ -46,7 +61,10 @@ typedef struct scr_context_ {
     uint8_t* full_screen_text;          // Buffer for a full screen of characters
     colorbyte_t* full_screen_color;     // Buffer for a full screen of colors
     bool* dirty_text_lines;             // bool array to track lines modified since paint
-    rgb18_t *render_buf;                 // buffer large enough to render one line of characters into
+    uint8_t* painted_text;              // The characters as last painted on the screen (to find changed cells)
+    colorbyte_t* painted_color;         // The colors as last painted on the screen
+    scr_position_t painted_cursor;      // Where the cursor was last painted (DISP_NO_PAINTED_CURSOR line if not)
+    uint8_t *render_buf;                // Two pixel rows of a line of characters (rendered alternately) - also holds one character
 } scr_context_t;
 
 /**
@@ -66,6 +84,28 @@ bool _has_scr_context();
  */
 scr_context_t* _peek_scr_context();
 
+/**
+ * @brief Get a screen context from the pool.
+ * @ingroup display
+ *
+ * The context's text, color, and dirty line buffers are set (to the pool's
+ * static buffers). The rest of the context is up to the caller. The render
+ * buffer isn't part of the context storage, it is shared by the screens.
+ *
+ * @param cols The number of text columns
+ * @param lines The number of text lines
+ * @return scr_context_t* The context, or NULL if the pool is used up (or the screen is too big)
+ */
+scr_context_t* _scr_context_alloc(uint16_t cols, uint16_t lines);
+
+/**
+ * @brief Return a screen context to the pool.
+ * @ingroup display
+ *
+ * @param sc The screen context (from `_scr_context_alloc`)
+ */
+void _scr_context_free(scr_context_t* sc);
+
 /**
  * @brief Pop the top screen context from the stack.
  * @ingroup display
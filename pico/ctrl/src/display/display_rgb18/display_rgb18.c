@@ -4,8 +4,6 @@
  * SPDX-License-Identifier: MIT
  */
 #include "pico/stdlib.h"
-#include "pico/malloc.h"
-#include <malloc.h>
 
 #include "system_defs.h"
 #include "display_rgb18.h"
@@ -13,10 +11,16 @@
 #include "../fonts/font.h"
 #include "../fonts/font_10_16.h"
 #include "ili_lcd_spi.h"
+#include "glyph_cache.h"
+#include "pal_expand.h"
+#include "../disp_render.h"
 #include "board.h"
 #include "debug_support.h"
 #include "string.h"
 
+// The display belongs to the render core while the render service is running.
+#define DISP_OWNER_CHECK() disp_render_owner_check(__func__)
+
 // RGB-18 Color Constants that are used for the Color16 values.
 //    RGB-18 Colors are 6 bits each. So; 0-63
 //           The hex values below are shifted left 2.
@@ -41,12 +45,33 @@ static void _disp_char(uint16_t aline, uint16_t col, char c, paint_control_t pai
 static void _disp_char_colorbyte(uint16_t aline, uint16_t col, char c, uint8_t color, paint_control_t paint);
 static void _disp_line_clear(uint16_t aline, paint_control_t paint);
 static void _disp_line_paint(uint16_t aline);
+static void _disp_scroll_area_apply(void);
+static void _disp_scroll_show(void);
+static void _disp_scroll_unroll(void);
+static void _disp_span_paint_pal4(uint16_t aline, uint16_t col, uint16_t ncols);
 static uint16_t _translate_cursor_line(uint16_t curline);
 static uint16_t _translate_line(uint16_t line);
+static void _color16_pixels_build(void);
 
 /*! @brief Map of RGB-18 values indexed by Color16 numbers. */
 static rgb18_t _color16_map[16];
 
+/*! @brief Map of pixels (in the current pixel format) indexed by Color16 numbers. */
+static gfxd_pixel_t _color16_pixels[16];
+
+// The old paths (whole line repaints and pixel rendered text) can only be
+// switched back to in an A/B benchmark build.
+#if DISP_AB_BENCH
+/*! @brief Repaint only the cells of a line that changed (vs. the whole line). */
+static bool _cell_repaint = true;
+
+/*! @brief Render text lines as 4 bit palette indexes (when available). */
+static bool _pal4 = true;
+#else
+static const bool _cell_repaint = true;
+static const bool _pal4 = true;
+#endif
+
 // /** @brief Map of Color24 (RGB) values indexed by Color16 numbers. */
 // static const rgb16_t _color16_map[] = {
 //     ILI_BLACK;
@@ -73,6 +98,9 @@ static bool _display_ready = false;
 /** @brief The current/active screen context */
 static scr_context_t* _scr_ctx = NULL;
 
+/** @brief Render buffer (two pixel rows of a line of characters) shared by the screens (only the active one paints). */
+static uint8_t _render_buf[2 * DISP_SCREEN_WIDTH_MAX * GFXD_PIXEL_BYTES_MAX] __attribute__((aligned(4)));
+
 /** @brief The number of characters to scan (back) looking for a wrap break-point character */
 static uint16_t _wrap_len;
 
@@ -118,53 +146,64 @@ static void _disp_char_colorbyte(uint16_t aline, uint16_t col, char c, uint8_t c
     if (paint) {
         // Actually render the characher glyph onto the screen.
         bool invert = c & DISP_CHAR_INVERT_BIT;
-        unsigned char cl = c & 0x7F;
         uint8_t fg = (invert ? bg_from_cb(color) : fg_from_cb(color));
         uint8_t bg = (invert ? fg_from_cb(color) : bg_from_cb(color));
-        rgb18_t fgrgb = rgb18_from_color16(fg);
-        rgb18_t bgrgb = rgb18_from_color16(bg);
+        gfxd_pixel_t fgpx = pixel_from_color16(fg);
+        gfxd_pixel_t bgpx = pixel_from_color16(bg);
         const font_info_t* fi = _scr_ctx->font_info;
         int8_t font_height = fi->height;
         int8_t font_width = fi->width;
-        int8_t bpgl = fi->bytes_per_glyph_line;
-        rgb18_t* rbuf = _scr_ctx->render_buf;
-        uint16_t glyphindex = (cl * font_height * bpgl);
+        uint8_t pb = gfxd_pixel_bytes();
+        uint8_t* rbuf = _scr_ctx->render_buf;
+        const uint16_t* rows = font_glyph_rows(fi, c);
         // See if we need to show the cursor
         bool show_a_cursor = (_scr_ctx->show_cursor && col == _scr_ctx->cursor_pos.column && aline == _translate_cursor_line(_scr_ctx->cursor_pos.line));
-        rgb18_t cursor_color = _scr_ctx->cursor_color;
+        gfxd_pixel_t cursor_px = gfxd_pixel_from_rgb18(_scr_ctx->cursor_color);
+        // Record what the cell will have on the screen
+        uint16_t index = (aline * _scr_ctx->cols) + col;
+        _scr_ctx->painted_text[index] = c;
+        _scr_ctx->painted_color[index] = color;
+        if (show_a_cursor) {
+            _scr_ctx->painted_cursor = (scr_position_t){ aline, col };
+        }
+        else if (_scr_ctx->painted_cursor.line == aline && _scr_ctx->painted_cursor.column == col) {
+            _scr_ctx->painted_cursor.line = DISP_NO_PAINTED_CURSOR;
+        }
+        const uint8_t* glyph = glyph_cache_get(fi, c, color);
+        if (glyph) {
+            // The expanded glyph can be painted as is, unless the cursor needs to be added.
+            if (show_a_cursor) {
+                memcpy(rbuf, glyph, font_width * font_height * pb);
+                pixel_buf_fill(rbuf + (fi->suggested_cursor_line * font_width * pb), cursor_px, font_width);
+                glyph = rbuf;
+            }
+            gfxd_area_paint(col * font_width, aline * font_height, font_width, font_height, glyph);
+            return;
+        }
         for (int glyph_line = 0; glyph_line < font_height; glyph_line++) {
             if (show_a_cursor && glyph_line == _scr_ctx->font_info->suggested_cursor_line) {
                 for (int c = 0; c < font_width; c++) {
-                    *rbuf++ = cursor_color;
+                    rbuf = gfxd_pixel_put(rbuf, cursor_px, pb);
                 }
             }
             else {
                 // Get each glyph row for the character (each line of the font char height).
-                uint32_t cgr = 0;
+                uint32_t cgr = rows[glyph_line];
                 uint32_t mask = 1u << (font_width - 1u);
-                for (int byte = 0; byte < bpgl; byte++) {
-                    cgr |= (fi->glyphs[glyphindex + byte + (glyph_line * bpgl)]) << (8u * byte);
-                }
                 for (int c = 0; c < font_width; c++) {
                     // For each glyph column bit that is set, set the forground color in the character buffer.
                     if (cgr & mask) {
-                        *rbuf = fgrgb;
+                        rbuf = gfxd_pixel_put(rbuf, fgpx, pb);
                     }
                     else {
-                        *rbuf = bgrgb;
+                        rbuf = gfxd_pixel_put(rbuf, bgpx, pb);
                     }
                     mask >>= 1u;
-                    rbuf++;
                 }
             }
         }
-        // Set a window into the right part of the screen
-        uint16_t x = col * font_width;
-        uint16_t y = aline * font_height;
-        uint16_t w = font_width;
-        uint16_t h = font_height;
-        gfxd_window_set_area(x, y, w, h);
-        gfxd_screen_paint(_scr_ctx->render_buf, (font_width * font_height));
+        // Paint it into the right part of the screen
+        gfxd_area_paint(col * font_width, aline * font_height, font_width, font_height, _scr_ctx->render_buf);
     }
     else {
         _scr_ctx->dirty_text_lines[aline] = true;
@@ -204,62 +243,224 @@ static void _disp_line_clear(uint16_t aline, paint_control_t paint) {
 }
 
 /*
- * Update the portion of the screen containing the given character line.
+ * Paint a span of the cells of a line as 4 bit palette indexes.
+ *
+ * Like `_disp_span_paint`, but each glyph line is rendered as Color16 indexes,
+ * 8 pixels to a word, and they are expanded to pixels as they are sent. The
+ * span must not have the cursor (its color isn't in the palette).
+ *
+ * NOTE: This does not perform text line translation, nor bounds check.
+ */
+static void _disp_span_paint_pal4(uint16_t aline, uint16_t col, uint16_t ncols) {
+    const font_info_t* fi = _scr_ctx->font_info;
+    int8_t font_height = fi->height;
+    int8_t font_width = fi->width;
+    uint16_t base = (aline * _scr_ctx->cols) + col;
+    uint16_t row_pixels = ncols * font_width;
+    size_t row_words = PAL_EXPAND_WORDS(row_pixels);
+    gfxd_area_stream_begin(col * font_width, aline * font_height, row_pixels, font_height);
+    for (int glyph_line = 0; glyph_line < font_height; glyph_line++) {
+        // Alternate row buffers. The other one is being sent.
+        uint32_t* wbuf = ((uint32_t*)_scr_ctx->render_buf) + ((glyph_line & 1) * row_words);
+        uint32_t* row_buf = wbuf;
+        uint32_t acc = 0;
+        uint shift = 0;
+        for (uint16_t i = 0; i < ncols; i++) {
+            unsigned char c = _scr_ctx->full_screen_text[base + i];
+            bool invert = c & DISP_CHAR_INVERT_BIT;
+            uint8_t color = _scr_ctx->full_screen_color[base + i];
+            uint32_t fg = (invert ? bg_from_cb(color) : fg_from_cb(color));
+            uint32_t bg = (invert ? fg_from_cb(color) : bg_from_cb(color));
+            uint32_t cgr = font_glyph_rows(fi, c)[glyph_line];
+            for (uint32_t mask = (1u << (font_width - 1u)); mask; mask >>= 1u) {
+                acc |= ((cgr & mask) ? fg : bg) << shift;
+                shift += 4;
+                if (shift == 32) {
+                    *wbuf++ = acc;
+                    acc = 0;
+                    shift = 0;
+                }
+            }
+        }
+        if (shift) {
+            *wbuf = acc;
+        }
+        gfxd_area_stream_pal4(row_buf, row_pixels);
+    }
+    gfxd_area_stream_end();
+}
+
+/*
+ * Paint a span of the cells of a line.
  *
  * Getting the glyph data for the font character is similar to `disp_char_colorbyte`;
- * but the difference is that here we are rendering a complete line of characters one
+ * but the difference is that here we are rendering a span of characters one
  * glyph line at a time, and repeating that for all of the glyph lines.
  *
+ * Each glyph line (pixel row) is rendered into one of two row buffers and
+ * streamed to the display with DMA, so the next row is rendered while the
+ * previous one is being sent. With the glyph cache, rendering a row is a copy
+ * of that row of each character's expanded glyph.
+ *
  * NOTE: This does not perform text line translation, nor bounds check.
  */
-static void _disp_line_paint(uint16_t aline) {
+static void _disp_span_paint(uint16_t aline, uint16_t col, uint16_t ncols, int cursor_col) {
+    if (_pal4 && gfxd_pal4_ready() && (cursor_col < col || cursor_col >= col + ncols)) {
+        _disp_span_paint_pal4(aline, col, ncols);
+        return;
+    }
     const font_info_t* fi = _scr_ctx->font_info;
     int8_t font_height = fi->height;
     int8_t font_width = fi->width;
-    int8_t bpgl = fi->bytes_per_glyph_line;
-    bool show_cursor = (_scr_ctx->show_cursor && aline == _translate_cursor_line(_scr_ctx->cursor_pos.line));
     int8_t cursor_show_row = fi->suggested_cursor_line;
-    uint16_t screen_line = aline * font_height;
-    rgb18_t* rbuf = _scr_ctx->render_buf;
+    uint8_t pb = gfxd_pixel_bytes();
+    gfxd_pixel_t cursor_px = gfxd_pixel_from_rgb18(_scr_ctx->cursor_color);
+    uint16_t base = (aline * _scr_ctx->cols) + col;
+    uint16_t row_pixels = ncols * font_width;
+    // Get the expanded glyphs for the span (the cache holds at least a line of them).
+    const uint8_t* glyphs[ncols];
+    bool cached = true;
+    for (uint16_t i = 0; i < ncols && cached; i++) {
+        glyphs[i] = glyph_cache_get(fi, _scr_ctx->full_screen_text[base + i], _scr_ctx->full_screen_color[base + i]);
+        cached = (glyphs[i] != NULL);
+    }
+    gfxd_area_stream_begin(col * font_width, aline * font_height, row_pixels, font_height);
     for (int glyph_line = 0; glyph_line < font_height; glyph_line++) {
-        for (uint16_t textcol = 0; textcol < _scr_ctx->cols; textcol++) {
+        // Alternate row buffers. The other one is being sent.
+        uint8_t* row_buf = _scr_ctx->render_buf + ((glyph_line & 1) * row_pixels * pb);
+        uint8_t* rbuf = row_buf;
+        if (cached) {
+            size_t glyph_row_bytes = font_width * pb;
+            size_t glyph_row_offset = glyph_line * glyph_row_bytes;
+            for (uint16_t i = 0; i < ncols; i++) {
+                memcpy(rbuf, glyphs[i] + glyph_row_offset, glyph_row_bytes);
+                rbuf += glyph_row_bytes;
+            }
+            if (glyph_line == cursor_show_row && cursor_col >= col && cursor_col < col + ncols) {
+                pixel_buf_fill(row_buf + ((cursor_col - col) * glyph_row_bytes), cursor_px, font_width);
+            }
+            gfxd_area_stream(row_buf, row_pixels);
+            continue;
+        }
+        for (uint16_t textcol = col; textcol < col + ncols; textcol++) {
             uint16_t index = (aline * _scr_ctx->cols) + textcol;
             unsigned char c = _scr_ctx->full_screen_text[index];
             bool invert = c & DISP_CHAR_INVERT_BIT;
-            unsigned char cl = c & 0x7F;
             uint8_t color = _scr_ctx->full_screen_color[index];
             uint8_t fg = (invert ? bg_from_cb(color) : fg_from_cb(color));
             uint8_t bg = (invert ? fg_from_cb(color) : bg_from_cb(color));
-            rgb18_t fgrgb = rgb18_from_color16(fg);
-            rgb18_t bgrgb = rgb18_from_color16(bg);
+            gfxd_pixel_t fgpx = pixel_from_color16(fg);
+            gfxd_pixel_t bgpx = pixel_from_color16(bg);
             // Get the glyph row for the character (a line of the font char height).
-            uint16_t glyphindex = (cl * font_height * bpgl);
-            uint32_t cgr = 0;
-            for (int byte = 0; byte < bpgl; byte++) {
-                cgr |= (fi->glyphs[glyphindex + byte + (glyph_line * bpgl)]) << (8u * byte);
-            }
+            uint32_t cgr = font_glyph_rows(fi, c)[glyph_line];
             for (uint32_t mask = (1u << (font_width - 1u)); mask; mask >>= 1u) {
-                if (show_cursor && textcol == _scr_ctx->cursor_pos.column && glyph_line == cursor_show_row) {
+                if (textcol == cursor_col && glyph_line == cursor_show_row) {
                     // Draw a cursor line
-                    *rbuf++ = _scr_ctx->cursor_color;
+                    rbuf = gfxd_pixel_put(rbuf, cursor_px, pb);
                 }
                 else if (cgr & mask) {
                     // set the fg color
-                    *rbuf++ = fgrgb;
+                    rbuf = gfxd_pixel_put(rbuf, fgpx, pb);
                 }
                 else {
                     // set the bg color
-                    *rbuf++ = bgrgb;
+                    rbuf = gfxd_pixel_put(rbuf, bgpx, pb);
                 }
             }
         }
+        gfxd_area_stream(row_buf, row_pixels);
+    }
+    gfxd_area_stream_end();
+}
+
+/*
+ * Test if a cell is different from what was last painted on the screen.
+ *
+ * The text, the color, and whether the cursor is on the cell are compared.
+ */
+static inline bool _disp_cell_changed(uint16_t index, uint16_t col, int cursor_col, int painted_cursor_col) {
+    return (_scr_ctx->full_screen_text[index] != _scr_ctx->painted_text[index]
+        || _scr_ctx->full_screen_color[index] != _scr_ctx->painted_color[index]
+        || ((col == cursor_col) != (col == painted_cursor_col)));
+}
+
+/*
+ * Update the portion of the screen containing the given character line.
+ *
+ * Only the cells that are different from what is on the screen are painted.
+ * Each run of changed cells is painted as a span (a single window and write),
+ * so changing a character or two of a status line doesn't send the whole line.
+ *
+ * NOTE: This does not perform text line translation, nor bounds check.
+ */
+static void _disp_line_paint(uint16_t aline) {
+    uint16_t cols = _scr_ctx->cols;
+    uint16_t base = aline * cols;
+    bool show_cursor = (_scr_ctx->show_cursor && aline == _translate_cursor_line(_scr_ctx->cursor_pos.line));
+    int cursor_col = (show_cursor ? _scr_ctx->cursor_pos.column : -1);
+    int painted_cursor_col = (_scr_ctx->painted_cursor.line == aline ? _scr_ctx->painted_cursor.column : -1);
+    if (!_cell_repaint) {
+        _disp_span_paint(aline, 0, cols, cursor_col);
+    }
+    else {
+        uint16_t col = 0;
+        while (col < cols) {
+            if (!_disp_cell_changed(base + col, col, cursor_col, painted_cursor_col)) {
+                col++;
+                continue;
+            }
+            uint16_t start = col;
+            while (col < cols && _disp_cell_changed(base + col, col, cursor_col, painted_cursor_col)) {
+                col++;
+            }
+            _disp_span_paint(aline, start, (col - start), cursor_col);
+        }
+    }
+    // The screen now matches the text for the line.
+    memcpy(_scr_ctx->painted_text + base, _scr_ctx->full_screen_text + base, cols);
+    memcpy(_scr_ctx->painted_color + base, _scr_ctx->full_screen_color + base, cols);
+    if (cursor_col >= 0) {
+        _scr_ctx->painted_cursor = (scr_position_t){ aline, cursor_col };
+    }
+    else if (painted_cursor_col >= 0) {
+        _scr_ctx->painted_cursor.line = DISP_NO_PAINTED_CURSOR;
     }
-    // Write the pixel screen row to the display
-    gfxd_window_set_area(0, screen_line, _scr_ctx->cols * font_width, font_height);
-    gfxd_screen_paint(_scr_ctx->render_buf, _scr_ctx->cols * font_width * font_height);
     _scr_ctx->dirty_text_lines[aline] = false;  // The line isn't dirty
 }
 
+/*
+ * Scroll the display to the scroll start of the text, if it isn't there.
+ *
+ * Printing only moves the scroll start of the text. The display is scrolled
+ * when painting, so a burst of new lines is a single scroll.
+ */
+static void _disp_scroll_show(void) {
+    if (_scr_ctx->scroll_start_shown != _scr_ctx->scroll_start) {
+        gfxd_scroll_set_start(_scr_ctx->scroll_start * _scr_ctx->font_info->height);
+        _scr_ctx->scroll_start_shown = _scr_ctx->scroll_start;
+    }
+}
+
+/*
+ * Make the pixels for the Color16 colors in the current pixel format.
+ */
+static void _color16_pixels_build(void) {
+    for (int i = 0; i < 16; i++) {
+        _color16_pixels[i] = gfxd_pixel_from_rgb18(_color16_map[i]);
+    }
+    pal_expand_palette_set(_color16_pixels, gfxd_pixel_bytes());
+}
+
+/*
+ * Force everything to be repainted by making what was painted differ from the text.
+ */
+static void _disp_painted_invalidate(void) {
+    size_t chars = _scr_ctx->lines * _scr_ctx->cols;
+    for (size_t i = 0; i < chars; i++) {
+        _scr_ctx->painted_text[i] = ~_scr_ctx->full_screen_text[i];
+    }
+}
+
 /**
  * @brief Get the absolute text line index for the current cursor position, accounting for scroll.
  *
@@ -300,7 +501,26 @@ inline rgb18_t rgb18_from_color16(colorn16_t c16) {
     return (_color16_map[c16 & 0x0f]);
 }
 
+inline gfxd_pixel_t pixel_from_color16(colorn16_t c16) {
+    return (_color16_pixels[c16 & 0x0f]);
+}
+
+bool disp_pixel_format_set(gfxd_pixfmt_t fmt) {
+    DISP_OWNER_CHECK();
+    if (!gfxd_pixel_format_set(fmt)) {
+        return (false);
+    }
+    // Everything rendered for the old format needs to be redone.
+    _color16_pixels_build();
+    glyph_cache_clear();
+    if (_scr_ctx) {
+        disp_update(Paint);
+    }
+    return (true);
+}
+
 void disp_cursor_bol() {
+    DISP_OWNER_CHECK();
     // Move the cursor to the beginning of the current line.
     _scr_ctx->cursor_pos.column = 0;
 }
@@ -314,6 +534,7 @@ void disp_cursor_home(void) {
 }
 
 void disp_cursor_show(bool show) {
+    DISP_OWNER_CHECK();
     _scr_ctx->show_cursor = show;
 }
 
@@ -322,6 +543,7 @@ void disp_cursor_set(uint16_t line, uint16_t col) {
 }
 
 void disp_cursor_set_sp(scr_position_t pos) {
+    DISP_OWNER_CHECK();
     if (pos.line >= _scr_ctx->scroll_size || pos.column >= _scr_ctx->cols) {
         return;
     }
@@ -344,6 +566,7 @@ inline colorn16_t bg_from_cb(colorbyte_t cb) {
 }
 
 void disp_c16_color_chart() {
+    DISP_OWNER_CHECK();
     disp_clear(true);
     // VGA Color Test
     disp_text_colors_set(C16_BR_WHITE, C16_BLACK);
@@ -364,6 +587,7 @@ void disp_c16_color_chart() {
  * Clear the current text content and the screen.
 */
 void disp_clear(paint_control_t paint) {
+    DISP_OWNER_CHECK();
     size_t chars = _scr_ctx->lines * _scr_ctx->cols;
     memset(_scr_ctx->full_screen_text, SPACE_CHR, chars);
     memset(_scr_ctx->full_screen_color, colorbyte(_scr_ctx->color_fg_default, _scr_ctx->color_bg_default), chars);
@@ -373,10 +597,14 @@ void disp_clear(paint_control_t paint) {
         display_backlight_on(false);    // Turning off the backlight helps this from being distracting
         gfxd_screen_clr_c16(_scr_ctx->color_bg_default, false);
         display_backlight_on(true);
+        memcpy(_scr_ctx->painted_text, _scr_ctx->full_screen_text, chars);
+        memcpy(_scr_ctx->painted_color, _scr_ctx->full_screen_color, chars);
+        _scr_ctx->painted_cursor.line = DISP_NO_PAINTED_CURSOR;
     }
 }
 
 void disp_char(uint16_t line, uint16_t col, char c, paint_control_t paint) {
+    DISP_OWNER_CHECK();
     if (line >= _scr_ctx->lines || col >= _scr_ctx->cols) {
         return;  // Invalid line or column
     }
@@ -397,6 +625,7 @@ void disp_char_color(uint16_t line, uint16_t col, char c, colorn16_t fg, colorn1
  *
  */
 void disp_char_colorbyte(uint16_t line, uint16_t col, char c, colorbyte_t color, paint_control_t paint) {
+    DISP_OWNER_CHECK();
     if (line >= _scr_ctx->lines || col >= _scr_ctx->cols) {
         return;  // Invalid line or column
     }
@@ -409,6 +638,7 @@ void disp_char_colorbyte(uint16_t line, uint16_t col, char c, colorbyte_t color,
  * screen is filled.
  */
 void disp_font_test(void) {
+    DISP_OWNER_CHECK();
     disp_clear(true);
     // test font display 1
     char c = 0;
@@ -493,6 +723,10 @@ void disp_module_init(void) {
 
     ili_controller_type ctrl_type = ili_module_init();
     ili_disp_info_t* disp_info = ili_disp_info();
+    // The controller's pixel format is known now.
+    _color16_pixels_build();
+    // The glyph cache needs to hold at least a line of characters.
+    glyph_cache_module_init(&font_10_16, gfxd_screen_width() / font_10_16.width);
 
     // If in debug mode, print info about the display...
     if (debug_mode_enabled()) {
@@ -517,6 +751,8 @@ void disp_module_init(void) {
     }
 
     disp_screen_new();
+    disp_render_module_init();
+    pal_expand_module_init();
 
     if (ctrl_type != ILI_CONTROLLER_NONE) {
         _display_ready = true;
@@ -527,6 +763,7 @@ void disp_module_init(void) {
  * Clear a line of text.
  */
 void disp_line_clear(uint16_t line, paint_control_t paint) {
+    DISP_OWNER_CHECK();
     if (line >= _scr_ctx->lines) {
         return;  // Invalid line or column
     }
@@ -542,6 +779,7 @@ void disp_line_clear(uint16_t line, paint_control_t paint) {
  * glyph line at a time, and repeating that for all of the glyph lines.
  */
 void disp_line_paint(uint16_t line) {
+    DISP_OWNER_CHECK();
     if (line >= _scr_ctx->lines) {
         return; // invalid line number
     }
@@ -553,59 +791,72 @@ void disp_line_paint(uint16_t line) {
  * Paint the physical screen from the text.
  */
 void disp_paint(void) {
+    disp_paint_budget(0);
+}
+
+bool disp_paint_budget(uint32_t budget_us) {
+    DISP_OWNER_CHECK();
     int16_t lines = _scr_ctx->lines;
     uint16_t aline;
     bool some_lines_dirty = false;
+    // Scroll first, so the lines that are still visible stay in place while the
+    // new ones are painted.
+    _disp_scroll_show();
     for (uint16_t i = 0; i < lines && !some_lines_dirty; i++) {
         some_lines_dirty |= _scr_ctx->dirty_text_lines[i];
     }
     if (some_lines_dirty) {
+        uint64_t start = time_us_64();
+        bool painted = false;
         for (uint16_t line = 0; line < lines; line++) {
             aline = _translate_line(line);
             if (_scr_ctx->dirty_text_lines[aline]) {
+                if (painted && budget_us && (time_us_64() - start) >= budget_us) {
+                    return (false);  // Out of time, the rest is still dirty
+                }
                 _disp_line_paint(aline);
                 _scr_ctx->dirty_text_lines[aline] = false; // The text line has been painted, mark it 'not dirty'
+                painted = true;
             }
         }
     }
+    return (true);
 }
 
 void disp_print_crlf(int16_t add_lines, paint_control_t paint) {
-    int16_t total_scroll_lines = add_lines;
-    uint16_t ss = _scr_ctx->scroll_start;  // Scroll start line
+    DISP_OWNER_CHECK();
+    uint16_t top = _scr_ctx->fixed_area_top_size;
     uint16_t scroll_lines = _scr_ctx->scroll_size;  // Screen scroll lines
-    uint16_t scroll_cap = _scr_ctx->lines - _scr_ctx->fixed_area_bottom_size - 1;
     uint16_t cursor_cap = scroll_lines - 1;
-    scr_position_t new_cp = { _scr_ctx->cursor_pos.line + 1, 0 };
-    uint16_t aline;
-    if (new_cp.line > cursor_cap) {
-        total_scroll_lines += (new_cp.line - cursor_cap);
+    int32_t line = _scr_ctx->cursor_pos.line + 1 + (add_lines > 0 ? add_lines : 0);
+    scr_position_t new_cp = { line, 0 };
+    uint16_t clear_from = cursor_cap + 1;   // First cursor line to clear that was scrolled in (none)
+    if (line > cursor_cap) {
+        // Scroll the lines past the bottom in. Only the text is scrolled here,
+        // the display is scrolled (once) when it is painted.
+        int32_t scroll = line - cursor_cap;
         new_cp.line = cursor_cap;
-    }
-    if (total_scroll_lines > scroll_lines) {
-        total_scroll_lines = scroll_lines;
-    }
-    if (total_scroll_lines > 0) {
-        // Advance the Scroll-Start
-        ss++;
-        if (ss > scroll_cap) {
-            ss = _scr_ctx->fixed_area_top_size;
+        if (scroll >= scroll_lines) {
+            clear_from = 0;  // Everything scrolls off
         }
-        _scr_ctx->scroll_start = ss;
-        // blank out what will be the cursor line
-        aline = _translate_cursor_line(new_cp.line);
-        _disp_line_clear(aline, paint);
-        gfxd_scroll_set_start(ss * _scr_ctx->font_info->height);
-    }
-    else {
-        // blank out what will be the cursor line
-        aline = _translate_cursor_line(new_cp.line);
-        _disp_line_clear(aline, paint);
+        else {
+            clear_from = scroll_lines - scroll;
+        }
+        _scr_ctx->scroll_start = top + ((_scr_ctx->scroll_start - top + scroll) % scroll_lines);
     }
     _scr_ctx->cursor_pos = new_cp;
+    // Blank out the lines that were scrolled in, and the new cursor line
+    for (uint16_t l = clear_from; l < cursor_cap; l++) {
+        _disp_line_clear(_translate_cursor_line(l), No_Paint);
+    }
+    _disp_line_clear(_translate_cursor_line(new_cp.line), No_Paint);
+    if (paint) {
+        disp_paint();
+    }
 }
 
 void disp_print_erase_eol(paint_control_t paint) {
+    DISP_OWNER_CHECK();
     // blank out what will be the cursor line
     uint16_t aline = _translate_cursor_line(_scr_ctx->cursor_pos.line);
     _disp_eol_clear(aline, _scr_ctx->cursor_pos.column, paint);
@@ -616,11 +867,13 @@ uint16_t disp_print_wrap_len_get() {
 }
 
 void disp_print_wrap_len_set(uint16_t len) {
+    DISP_OWNER_CHECK();
     // Limit the value to the one less than the screen width.
     _wrap_len = (len < _scr_ctx->cols ? len : (_scr_ctx->cols - 1));
 }
 
 void disp_printc(char c, paint_control_t paint) {
+    DISP_OWNER_CHECK();
     // Since the line doesn't wrap right when the last column is written to;
     // we need to check the current cursor position against the current margins and
     // wrap/scroll if needed before printing the character.
@@ -699,6 +952,7 @@ void disp_printc(char c, paint_control_t paint) {
 }
 
 void disp_prints(char* str, paint_control_t paint) {
+    DISP_OWNER_CHECK();
     unsigned char c;
     while ((c = *str++) != 0) {
         if (c == '\n') {
@@ -714,6 +968,7 @@ void disp_prints(char* str, paint_control_t paint) {
 }
 
 void disp_string(uint16_t line, uint16_t col, const char *pString, bool invert, paint_control_t paint) {
+    DISP_OWNER_CHECK();
     if (line >= _scr_ctx->lines || col >= _scr_ctx->cols) {
         return;  // Invalid line or column
     }
@@ -737,6 +992,7 @@ void disp_string(uint16_t line, uint16_t col, const char *pString, bool invert,
 }
 
 void disp_string_color(uint16_t line, uint16_t col, const char* pString, colorn16_t fg, colorn16_t bg, paint_control_t paint){
+    DISP_OWNER_CHECK();
     if (line >= _scr_ctx->lines || col >= _scr_ctx->cols) {
         return;  // Invalid line or column
     }
@@ -758,6 +1014,7 @@ void disp_string_color(uint16_t line, uint16_t col, const char* pString, colorn1
 }
 
 void disp_text_colors_cp_set(text_color_pair_t* cp) {
+    DISP_OWNER_CHECK();
     // force them to 0-15
     _scr_ctx->color_fg_default = cp->fg & 0x0f;
     _scr_ctx->color_bg_default = cp->bg & 0x0f;
@@ -769,13 +1026,27 @@ void disp_text_colors_get(text_color_pair_t* cp) {
 }
 
 void disp_text_colors_set(colorn16_t fg, colorn16_t bg) {
+    DISP_OWNER_CHECK();
     // force them to 0-15
     _scr_ctx->color_fg_default = fg & 0x0f;
     _scr_ctx->color_bg_default = bg & 0x0f;
 }
 
+#if DISP_AB_BENCH
+void disp_cell_repaint_enable(bool cells) {
+    _cell_repaint = cells;
+}
+
+void disp_pal4_enable(bool pal4) {
+    _pal4 = pal4;
+}
+#endif
+
 void disp_update(paint_control_t paint) {
+    DISP_OWNER_CHECK();
     // Mark all lines as 'dirty' so they will be re-rendered during a `paint` operation.
+    // Since the screen might not match what was painted, all of the cells are repainted.
+    _disp_painted_invalidate();
     memset(_scr_ctx->dirty_text_lines, true, _scr_ctx->lines * sizeof(bool));
     if (paint) {
         disp_paint();
@@ -783,60 +1054,94 @@ void disp_update(paint_control_t paint) {
 }
 
 void disp_screen_close() {
+    DISP_OWNER_CHECK();
     if (!_has_scr_context()) {
         warn_printf("Display - Trying to close main screen context. Ignoring `disp_screen_close()` call.");
         return;
     }
-    // Free the buffers from the current context...
-    free(_scr_ctx->full_screen_text);
-    free(_scr_ctx->full_screen_color);
-    free(_scr_ctx->dirty_text_lines);
-    free(_scr_ctx->render_buf);
-    // Now free the current context
-    free(_scr_ctx);
+    // Return the current context to the pool
+    _scr_context_free(_scr_ctx);
 
     // Get the top context and make it current
     _scr_ctx = _pop_scr_context();
     // This will re-configure the ILI for correct scrolling
-    disp_scroll_area_define(_scr_ctx->fixed_area_top_size, _scr_ctx->fixed_area_bottom_size);
+    _disp_scroll_area_apply();
+    disp_update(Paint);
+}
+
+disp_screen_t disp_screen_park(void) {
+    DISP_OWNER_CHECK();
+    if (!_has_scr_context()) {
+        warn_printf("Display - Trying to park main screen context. Ignoring `disp_screen_park()` call.");
+        return (NULL);
+    }
+    scr_context_t* parked = _scr_ctx;
+    _scr_ctx = _pop_scr_context();
+    _disp_scroll_area_apply();
     disp_update(Paint);
+
+    return (parked);
+}
+
+bool disp_screen_restore(disp_screen_t scr) {
+    DISP_OWNER_CHECK();
+    if (scr == NULL || scr == _scr_ctx) {
+        return (false);
+    }
+    if (!_push_scr_context(_scr_ctx)) {
+        return (false);
+    }
+    _scr_ctx = scr;
+    _disp_scroll_area_apply();
+    disp_update(Paint);
+
+    return (true);
+}
+
+void disp_screen_discard(disp_screen_t scr) {
+    DISP_OWNER_CHECK();
+    if (scr == NULL || scr == _scr_ctx) {
+        warn_printf("Display - Trying to discard the active screen. Ignoring `disp_screen_discard()` call.");
+        return;
+    }
+    _scr_context_free(scr);
 }
 
 bool disp_screen_new() {
-    // First thing is to see if we can push the current screen context if there is one
+    DISP_OWNER_CHECK();
+    // For now, we only have one font - get its info
+    const font_info_t* fi = &font_10_16;
+    // Figure out how many lines and columns we have
+    int16_t cols = gfxd_screen_width() / fi->width;
+    int16_t lines = gfxd_screen_height() / fi->height;
+    // The context and its buffers come from the pool
+    scr_context_t* scr_context = _scr_context_alloc(cols, lines);
+    if (scr_context == NULL) {
+        error_printf("Display - Could not get a screen context.");
+        return false;
+    }
+    // See if we can push the current screen context if there is one
     if (_scr_ctx) {
         if (!_push_scr_context(_scr_ctx)) {
+            _scr_context_free(scr_context);
             return false;
         }
     }
-    scr_context_t* scr_context = malloc(sizeof(scr_context_t));
-    if (scr_context == NULL) {
-        error_printf("Display - Could not allocate a screen context.");
-        return false;
-    }
-    // For now, we only have one font - get its info
-    const font_info_t* fi = &font_10_16;
     info_printf("Display font: %s.\n", fi->name);
     scr_context->font_info = fi;
     scr_context->color_bg_default = C16_BLACK;
     scr_context->color_fg_default = C16_WHITE;
-    // Figure out how many lines and columns we have
-    int16_t cols = gfxd_screen_width() / fi->width;
-    int16_t lines = gfxd_screen_height() / fi->height;
     info_printf("Display size: %hdx%hd (cols x lines)\n", cols, lines);
-    size_t chars = lines * cols;
     scr_context->cols = cols;
     scr_context->lines = lines;
-    // Allocate buffers
-    scr_context->full_screen_text = (uint8_t*)malloc(chars);
-    scr_context->full_screen_color = (colorbyte_t*)malloc(chars);
-    scr_context->dirty_text_lines = (bool*)calloc(lines, sizeof(bool));
-    scr_context->render_buf = (rgb18_t*)malloc(fi->width * fi->height * cols * sizeof(rgb18_t));
+    scr_context->painted_cursor = (scr_position_t){ DISP_NO_PAINTED_CURSOR, 0 };
+    scr_context->render_buf = _render_buf;
     // Default scroll area to the full screen
     scr_context->fixed_area_top_size = 0;
     scr_context->fixed_area_bottom_size = 0;
     scr_context->scroll_size = lines;
     scr_context->scroll_start = 0;
+    scr_context->scroll_start_shown = 0;
     scr_context->cursor_pos = (scr_position_t){ 0, 0 };
     scr_context->show_cursor = false; // Start with the cursor off (typical for dialogs)
     scr_context->cursor_color = (rgb18_t){0xF8,0x3C,0xD4}; // Custom Color so it doesn't match any of the CN16
@@ -848,7 +1153,62 @@ bool disp_screen_new() {
     return (true);
 }
 
+/*
+ * Set the display's scroll area and start for the current context (when it
+ * becomes the active screen again), keeping its text where it is.
+ */
+static void _disp_scroll_area_apply(void) {
+    uint8_t font_height = _scr_ctx->font_info->height;
+    gfxd_scroll_set_area(_scr_ctx->fixed_area_top_size * font_height, _scr_ctx->fixed_area_bottom_size * font_height);
+    _scr_ctx->scroll_start_shown = _scr_ctx->scroll_start;
+    gfxd_scroll_set_start(_scr_ctx->scroll_start * font_height);
+}
+
+/*
+ * Put the lines of the scroll area back in screen order (undo the scrolling),
+ * so changing the scroll area keeps the text where it is on the screen.
+ *
+ * The lines are rotated by reversing the two parts and then the whole area.
+ * Since the display is no longer scrolled, the lines are repainted.
+ */
+static void _disp_scroll_unroll(void) {
+    uint16_t top = _scr_ctx->fixed_area_top_size;
+    uint16_t size = _scr_ctx->scroll_size;
+    uint16_t k = _scr_ctx->scroll_start - top;
+    uint16_t cols = _scr_ctx->cols;
+    if (k == 0 || k >= size) {
+        return;
+    }
+    uint8_t tmp[cols];
+    const uint16_t parts[3][2] = { { 0, k }, { k, size }, { 0, size } };
+    for (int p = 0; p < 3; p++) {
+        uint16_t a = top + parts[p][0];
+        uint16_t b = top + parts[p][1] - 1;
+        for (; a < b; a++, b--) {
+            uint8_t* ta = _scr_ctx->full_screen_text + (a * cols);
+            uint8_t* tb = _scr_ctx->full_screen_text + (b * cols);
+            memcpy(tmp, ta, cols);
+            memcpy(ta, tb, cols);
+            memcpy(tb, tmp, cols);
+            colorbyte_t* ca = _scr_ctx->full_screen_color + (a * cols);
+            colorbyte_t* cb = _scr_ctx->full_screen_color + (b * cols);
+            memcpy(tmp, ca, cols);
+            memcpy(ca, cb, cols);
+            memcpy(cb, tmp, cols);
+        }
+    }
+    for (uint16_t aline = top; aline < top + size; aline++) {
+        for (uint16_t col = 0; col < cols; col++) {
+            uint16_t index = (aline * cols) + col;
+            _scr_ctx->painted_text[index] = ~_scr_ctx->full_screen_text[index];
+        }
+        _scr_ctx->dirty_text_lines[aline] = true;
+    }
+    _scr_ctx->scroll_start = top;
+}
+
 void disp_scroll_area_define(uint16_t top_fixed_size, uint16_t bottom_fixed_size) {
+    DISP_OWNER_CHECK();
     uint16_t screen_lines = _scr_ctx->lines;
     uint16_t fixed_lines = top_fixed_size + bottom_fixed_size;
     int16_t scroll_lines = screen_lines - fixed_lines;
@@ -864,7 +1224,9 @@ void disp_scroll_area_define(uint16_t top_fixed_size, uint16_t bottom_fixed_size
         top_fixed_size = 0;
         bottom_fixed_size = 0;
     }
+    _disp_scroll_unroll();
     _scr_ctx->scroll_start = top_fixed_size;
+    _scr_ctx->scroll_start_shown = top_fixed_size;
     _scr_ctx->fixed_area_top_size = top_fixed_size;
     _scr_ctx->fixed_area_bottom_size = bottom_fixed_size;
     _scr_ctx->scroll_size = screen_lines - (top_fixed_size + bottom_fixed_size);
@@ -873,12 +1235,14 @@ void disp_scroll_area_define(uint16_t top_fixed_size, uint16_t bottom_fixed_size
     disp_cursor_home();
 }
 
-void rgb18_buf_fill(rgb18_t* rgb_buf, rgb18_t rgb, size_t size) {
-    for (int i=0; i<size; i++) {
-        rgb18_t* f = rgb_buf++;
-        f->r = rgb.r;
-        f->g = rgb.g;
-        f->b = rgb.b;
+void pixel_buf_fill(uint8_t* pixel_buf, gfxd_pixel_t px, size_t pixels) {
+    uint8_t pb = gfxd_pixel_bytes();
+    for (size_t i = 0; i < pixels; i++) {
+        pixel_buf = gfxd_pixel_put(pixel_buf, px, pb);
     }
 }
 
+void rgb18_buf_fill(uint8_t* pixel_buf, rgb18_t rgb, size_t pixels) {
+    pixel_buf_fill(pixel_buf, gfxd_pixel_from_rgb18(rgb), pixels);
+}
+
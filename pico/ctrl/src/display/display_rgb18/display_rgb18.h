@@ -132,31 +132,258 @@ static inline uint8_t blue_from_rgb18(rgb18_t rgb) {
  */
 extern rgb18_t rgb18_from_color16(colorn16_t cn16);
 
+/**
+ * @brief Pixel formats that can be sent to the display controller.
+ * @ingroup display
+ *
+ * The values are the COLMOD (Pixel Format Set) values for the formats.
+ * The ILI9341 accepts either over SPI. The ILI9488 only accepts RGB666.
+ */
+typedef enum GFXD_PIXFMT_ {
+    GFXD_PIXFMT_RGB565 = 0x55,  // 16 bit (5,6,5) - 2 bytes per pixel
+    GFXD_PIXFMT_RGB666 = 0x66,  // 18 bit (6,6,6) - 3 bytes per pixel
+} gfxd_pixfmt_t;
+
+/** @brief The most bytes a pixel can take (RGB666). Use to size pixel buffers. */
+#define GFXD_PIXEL_BYTES_MAX 3
+/** @brief The fewest bytes a pixel can take (RGB565). */
+#define GFXD_PIXEL_BYTES_MIN 2
+
+/**
+ * @brief A pixel in the format being sent to the controller.
+ * @ingroup display
+ *
+ * The bytes are sent from the low byte up (2 or 3 of them). Pixel data buffers
+ * (`uint8_t*`) hold the pixels packed in that form, `gfxd_pixel_bytes` each.
+ */
+typedef uint32_t gfxd_pixel_t;
+
+/**
+ * @brief Put a pixel into a pixel data buffer.
+ * @ingroup display
+ *
+ * @param buf Where to put the pixel
+ * @param px The pixel
+ * @param pixel_bytes The bytes per pixel (`gfxd_pixel_bytes`)
+ * @return uint8_t* The location for the next pixel
+ */
+static inline uint8_t* gfxd_pixel_put(uint8_t* buf, gfxd_pixel_t px, uint8_t pixel_bytes) {
+    buf[0] = (uint8_t)px;
+    buf[1] = (uint8_t)(px >> 8);
+    if (pixel_bytes > 2) {
+        buf[2] = (uint8_t)(px >> 16);
+    }
+    return (buf + pixel_bytes);
+}
+
+/**
+ * @brief The number of bytes per pixel for the current pixel format.
+ * @ingroup display
+ *
+ * @return uint8_t 2 (RGB565) or 3 (RGB666)
+ */
+extern uint8_t gfxd_pixel_bytes(void);
+
+/**
+ * @brief The current pixel format.
+ * @ingroup display
+ *
+ * This is RGB565 for controllers that support it and RGB666 otherwise,
+ * unless it has been changed with `gfxd_pixel_format_set`.
+ *
+ * @return gfxd_pixfmt_t The pixel format
+ */
+extern gfxd_pixfmt_t gfxd_pixel_format(void);
+
+/**
+ * @brief Set the pixel format used with the controller.
+ * @ingroup display
+ *
+ * Pixels that were made for the previous format (`gfxd_pixel_t` values and
+ * pixel data) need to be made again. Use `disp_pixel_format_set` to change
+ * the format used for the text screen.
+ *
+ * @param fmt The pixel format
+ * @return true The format was set
+ * @return false The controller doesn't support the format
+ */
+extern bool gfxd_pixel_format_set(gfxd_pixfmt_t fmt);
+
+/**
+ * @brief Get the pixel for an RGB-18 color in the current pixel format.
+ * @ingroup display
+ *
+ * @param rgb RGB-18 color
+ * @return gfxd_pixel_t The pixel
+ */
+extern gfxd_pixel_t gfxd_pixel_from_rgb18(rgb18_t rgb);
+
+/**
+ * @brief Get the pixel for a Color-16 (0-15 Color number) in the current pixel format.
+ * @ingroup display
+ *
+ * @param cn16 Color-16 number
+ * @return gfxd_pixel_t The pixel
+ */
+extern gfxd_pixel_t pixel_from_color16(colorn16_t cn16);
+
+/**
+ * @brief Change the pixel format used for the text screen.
+ * @ingroup display
+ *
+ * Sets the controller pixel format, remakes the color pixels and the glyph
+ * cache, and repaints the screen.
+ *
+ * @param fmt The pixel format
+ * @return true The format was changed
+ * @return false The controller doesn't support the format
+ */
+extern bool disp_pixel_format_set(gfxd_pixfmt_t fmt);
+
+/**
+ * @brief Control rendering text as 4 bit palette indexes.
+ * @ingroup display
+ *
+ * When on (and available), text lines are rendered as Color16 indexes and
+ * expanded to pixels as they are sent, so the CPU writes far fewer bytes.
+ * Spans with the cursor (which isn't a Color16 color) are rendered as pixels.
+ * This is on by default. Turning it off allows the two to be compared. Only
+ * in an A/B benchmark build (`DISP_AB_BENCH`).
+ *
+ * @param pal4 True to render as palette indexes
+ */
+#if DISP_AB_BENCH
+extern void disp_pal4_enable(bool pal4);
+#endif
+
+
+
+/**
+ * @brief Paint an area of the screen with the pixels in a buffer.
+ * @ingroup display
+ *
+ * Sets the window and sends the pixel data in one display operation, which
+ * is quicker than `gfxd_window_set_area` followed by `gfxd_screen_paint` for
+ * small areas (like a character).
+ *
+ * @param x Left pixel column
+ * @param y Top pixel line
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param pixel_data Pixel data buffer (in the current pixel format, w * h pixels)
+ */
+extern void gfxd_area_paint(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* pixel_data);
+
+/**
+ * @brief Fill an area of the screen with a color.
+ * @ingroup display
+ *
+ * The pixels are sent by DMA from a single pixel value, so it doesn't need
+ * a buffer, and the CPU only sets it up.
+ *
+ * @param x Left pixel column
+ * @param y Top pixel line
+ * @param w Width in pixels
+ * @param h Height in pixels
+ * @param color The color
+ */
+extern void gfxd_area_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, rgb18_t color);
+
+/**
+ * @brief Start streaming pixel data into an area of the screen.
+ * @ingroup display
+ *
+ * Sets the window and holds the display (SPI) until `gfxd_area_stream_end`.
+ * The pixel data is then sent in pieces with `gfxd_area_stream`.
+ *
+ * @param x Left pixel column
+ * @param y Top pixel line
+ * @param w Width in pixels
+ * @param h Height in pixels
+ */
+extern void gfxd_area_stream_begin(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/**
+ * @brief Send the next piece of pixel data for the area being streamed.
+ * @ingroup display
+ *
+ * The data is sent using DMA, and this returns once the transfer has started
+ * (after the previous piece has been sent). The buffer must not be changed
+ * until the next call (or `gfxd_area_stream_end`) returns. Alternating
+ * between two buffers allows rendering into one while the other is sent.
+ *
+ * @param pixel_data Pixel data (in the current pixel format)
+ * @param pixels Number of pixels in the buffer
+ */
+extern void gfxd_area_stream(const uint8_t* pixel_data, uint16_t pixels);
+
+/**
+ * @brief Move the area being streamed to a new window.
+ * @ingroup display
+ *
+ * The display stays held, so pieces of an image that are not one rectangle
+ * (like around transparent pixels) can be sent in one stream. The pixel data
+ * that follows goes into the new window.
+ *
+ * @param x Left pixel column
+ * @param y Top pixel line
+ * @param w Width in pixels
+ * @param h Height in pixels
+ */
+extern void gfxd_area_stream_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 
+/**
+ * @brief Send the next piece of the area being streamed as 4 bit palette indexes.
+ * @ingroup display
+ *
+ * Like `gfxd_area_stream`, but the pixels are indexes into the Color16
+ * palette, 8 to a word (first in the low nibble), and are expanded to the
+ * pixel format as they are sent (see `pal_expand.h`).
+ *
+ * @param packed The packed pixels
+ * @param pixels Number of pixels
+ */
+extern void gfxd_area_stream_pal4(const uint32_t* packed, uint16_t pixels);
+
+/**
+ * @brief Check if 4 bit palette pixels can be streamed.
+ * @ingroup display
+ *
+ * @return true `gfxd_area_stream_pal4` can be used
+ */
+extern bool gfxd_pal4_ready(void);
+
+/**
+ * @brief End streaming into an area of the screen.
+ * @ingroup display
+ *
+ * Returns once all of the data has been sent, and releases the display (SPI).
+ */
+extern void gfxd_area_stream_end(void);
 
 /**
  * @brief Get a pointer to a buffer large enough to hold
  * one scan line for the ILI display.
  * @ingroup display
  *
- * This can be used to put RGB data into to be written to the
+ * This can be used to put pixel data into to be written to the
  * screen. The `gfxd_line_paint` can be called to put the
  * line on the screen.
  *
- * The buffer holds `ILI_WIDTH` rgb18_t values.
+ * The buffer holds `ILI_WIDTH` pixels (of any pixel format).
  */
-extern rgb18_t* gfxd_get_line_buf();
+extern uint8_t* gfxd_get_line_buf();
 
 /**
- * @brief Paint a buffer of rgb18_t values to one horizontal line
+ * @brief Paint a buffer of pixels to one horizontal line
  * of the screen. The buffer passed in must be at least `ILI_WIDTH`
- * rgb18_t values in size.
+ * pixels in size.
  * @ingroup display
  *
  * @param line 0-based line number to paint (must be less than `ILI_HEIGHT`).
- * @param buf pointer to a rgb18_t buffer of data (must be at least 'ILI_WIDTH`)
+ * @param buf pointer to a buffer of pixel data (must be at least 'ILI_WIDTH` pixels)
  */
-extern void gfxd_line_paint(uint16_t line, rgb18_t* buf);
+extern void gfxd_line_paint(uint16_t line, uint8_t* buf);
 
 /**
  * @brief Clear the entire screen using a single color.
@@ -195,16 +422,16 @@ extern uint16_t gfxd_screen_height();
 extern void gfxd_screen_on(bool on);
 
 /**
- * @brief Paint the screen with the RGB-18 contents of a buffer.
+ * @brief Paint the screen with the pixels in a buffer.
  * @ingroup display
  *
- * Uses the buffer of RGB data to paint the screen into the screen window.
+ * Uses the buffer of pixel data to paint the screen into the screen window.
  * Set the screen window using `gfxd_window_set_area`.
  *
- * @param data RGB-18 pixel data buffer (1 rgb value for each pixel to paint)
- * @param pixels Number of pixels (size of the data buffer in rgb_t's)
+ * @param pixel_data Pixel data buffer (in the current pixel format)
+ * @param pixels Number of pixels in the buffer
  */
-extern void gfxd_screen_paint(const rgb18_t* rgb_pixel_data, uint16_t pixels);
+extern void gfxd_screen_paint(const uint8_t* pixel_data, uint16_t pixels);
 
 /**
  * @brief The width of the display screen (pixel columns).
@@ -284,14 +511,24 @@ extern void gfxd_window_set_fullscreen(void);
 
 
 /**
- * @brief Fill an RGB18 buffer with an RGB18 value.
+ * @brief Fill a pixel data buffer with a pixel.
+ * @ingroup display
+ *
+ * @param pixel_buf The buffer to fill
+ * @param px The pixel to fill with
+ * @param pixels The number of pixels to fill
+ */
+extern void pixel_buf_fill(uint8_t* pixel_buf, gfxd_pixel_t px, size_t pixels);
+
+/**
+ * @brief Fill a pixel data buffer with an RGB18 color (in the current pixel format).
  * @ingroup display
  *
- * @param rgb_buf The buffer to fill
- * @param rgb The value to fill with
- * @param size The size of the buffer (in rgb18_t's)
+ * @param pixel_buf The buffer to fill
+ * @param rgb The color to fill with
+ * @param pixels The number of pixels to fill
  */
-extern void rgb18_buf_fill(rgb18_t* rgb_buf, rgb18_t rgb, size_t size);
+extern void rgb18_buf_fill(uint8_t* pixel_buf, rgb18_t rgb, size_t pixels);
 
 #ifdef __cplusplus
 }
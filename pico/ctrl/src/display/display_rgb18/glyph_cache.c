@@ -0,0 +1,274 @@
+/**
+ * Cache of expanded (ready to send) glyphs.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "glyph_cache.h"
+
+#include "board.h"
+
+#include "pico/stdlib.h"
+#include <malloc.h>
+#include <string.h>
+
+#define GC_HASH_SIZE_ 64        // Hash chains (power of 2)
+#define GC_NONE_ 0xFFFF         // End of a hash chain or of the LRU list
+
+/**
+ * @brief A cache entry. The pixels for it are in the glyph buffer at the same index.
+ *
+ * The entries in use are also on a list from the most to the least recently
+ * used, so a hit moves an entry to the front and the one to replace is the
+ * one at the back.
+ */
+typedef struct GC_ENTRY_ {
+    uint16_t key;               // Character << 8 | color-byte
+    uint16_t next;              // Next entry in the hash chain
+    uint16_t newer;             // Entry used after this one
+    uint16_t older;             // Entry used before this one
+} gc_entry_t;
+
+static const font_info_t* _font;
+static uint16_t _want;          // Glyphs the cache should hold
+static uint16_t _glyph_pixels;  // Pixels in a glyph (font width x height)
+static size_t _glyph_size;      // Bytes for a glyph in the current pixel format
+static size_t _glyphs_size;     // Bytes for all of the glyphs
+static uint16_t _max_entries;   // Entries allocated (enough for the smallest pixels)
+static gc_entry_t* _entries;
+static uint8_t* _glyphs;
+static uint16_t _hash[GC_HASH_SIZE_];
+static uint16_t _newest;        // Most recently used entry
+static uint16_t _oldest;        // Least recently used entry
+#if DISP_AB_BENCH
+static bool _use = true;        // Can be switched off for the A/B benchmarks
+#else
+static const bool _use = true;
+#endif
+static glyph_cache_stats_t _stats;
+
+static inline uint16_t _hash_of(uint16_t key) {
+    // Mostly the character changes, with a few colors.
+    return (((key >> 8) + ((key & 0xFF) * 7)) & (GC_HASH_SIZE_ - 1));
+}
+
+/**
+ * @brief Get the color between the background (coverage 0) and the foreground
+ * (coverage 3).
+ */
+static uint8_t _blend(uint8_t bg, uint8_t fg, uint32_t coverage) {
+    return ((((bg * (3u - coverage)) + (fg * coverage)) / 3u) & 0xFC);
+}
+
+/**
+ * @brief Render a character into pixels.
+ *
+ * If the font has anti-aliasing, the edge pixels are blended between the
+ * background and foreground (it only costs something when the glyph is
+ * expanded into the cache).
+ */
+static void _expand(uint8_t* px, unsigned char c, colorbyte_t color) {
+    const font_info_t* fi = _font;
+    bool invert = c & DISP_CHAR_INVERT_BIT;
+    colorn16_t fg = (invert ? bg_from_cb(color) : fg_from_cb(color));
+    colorn16_t bg = (invert ? fg_from_cb(color) : bg_from_cb(color));
+    uint8_t pb = gfxd_pixel_bytes();
+    if (fi->aa_rows) {
+        rgb18_t fgc = rgb18_from_color16(fg);
+        rgb18_t bgc = rgb18_from_color16(bg);
+        gfxd_pixel_t levels[4];
+        for (uint32_t i = 0; i < 4; i++) {
+            rgb18_t rgb = { _blend(bgc.r, fgc.r, i), _blend(bgc.g, fgc.g, i), _blend(bgc.b, fgc.b, i) };
+            levels[i] = gfxd_pixel_from_rgb18(rgb);
+        }
+        const uint32_t* rows = font_glyph_aa_rows(fi, c);
+        for (int glyph_line = 0; glyph_line < fi->height; glyph_line++) {
+            uint32_t cgr = rows[glyph_line];
+            for (int shift = (2 * (fi->width - 1)); shift >= 0; shift -= 2) {
+                px = gfxd_pixel_put(px, levels[(cgr >> shift) & 3u], pb);
+            }
+        }
+        return;
+    }
+    gfxd_pixel_t fgpx = pixel_from_color16(fg);
+    gfxd_pixel_t bgpx = pixel_from_color16(bg);
+    const uint16_t* rows = font_glyph_rows(fi, c);
+    for (int glyph_line = 0; glyph_line < fi->height; glyph_line++) {
+        uint32_t cgr = rows[glyph_line];
+        for (uint32_t mask = (1u << (fi->width - 1u)); mask; mask >>= 1u) {
+            px = gfxd_pixel_put(px, ((cgr & mask) ? fgpx : bgpx), pb);
+        }
+    }
+}
+
+/**
+ * @brief Allocate (or grow) the entries and the glyph pixels.
+ *
+ * @param glyphs_size Bytes for the glyph pixels
+ * @return true if allocated (if not, what was there is kept)
+ */
+static bool _alloc(size_t glyphs_size) {
+    size_t max_entries = glyphs_size / (_glyph_pixels * GFXD_PIXEL_BYTES_MIN);
+    if (max_entries >= GC_NONE_) {
+        max_entries = GC_NONE_ - 1;
+    }
+    gc_entry_t* entries = realloc(_entries, max_entries * sizeof(gc_entry_t));
+    if (!entries) {
+        return (false);
+    }
+    _entries = entries;
+    uint8_t* glyphs = realloc(_glyphs, glyphs_size);
+    if (!glyphs) {
+        return (false);
+    }
+    _glyphs = glyphs;
+    _glyphs_size = glyphs_size;
+    _max_entries = (uint16_t)max_entries;
+
+    return (true);
+}
+
+static void _lru_unlink(uint16_t i) {
+    gc_entry_t* e = &_entries[i];
+    if (e->newer != GC_NONE_) {
+        _entries[e->newer].older = e->older;
+    }
+    else {
+        _newest = e->older;
+    }
+    if (e->older != GC_NONE_) {
+        _entries[e->older].newer = e->newer;
+    }
+    else {
+        _oldest = e->newer;
+    }
+}
+
+static void _lru_push(uint16_t i) {
+    gc_entry_t* e = &_entries[i];
+    e->newer = GC_NONE_;
+    e->older = _newest;
+    if (_newest != GC_NONE_) {
+        _entries[_newest].newer = i;
+    }
+    else {
+        _oldest = i;
+    }
+    _newest = i;
+}
+
+/**
+ * @brief Get an entry to use for a new glyph - a free one, or the least
+ * recently used one (taken out of its hash chain and the LRU list).
+ */
+static uint16_t _entry_take(void) {
+    if (_stats.used < _stats.entries) {
+        return (_stats.used++);
+    }
+    uint16_t lru = _oldest;
+    _lru_unlink(lru);
+    uint16_t* link = &_hash[_hash_of(_entries[lru].key)];
+    while (*link != lru) {
+        link = &_entries[*link].next;
+    }
+    *link = _entries[lru].next;
+    _stats.evictions++;
+
+    return (lru);
+}
+
+const uint8_t* glyph_cache_get(const font_info_t* fi, unsigned char c, colorbyte_t color) {
+    if (!_use || !_entries || fi != _font) {
+        return (NULL);
+    }
+    uint16_t key = ((uint16_t)c << 8) | color;
+    uint16_t h = _hash_of(key);
+    _stats.lookups++;
+    for (uint16_t i = _hash[h]; i != GC_NONE_; i = _entries[i].next) {
+        if (_entries[i].key == key) {
+            if (i != _newest) {
+                _lru_unlink(i);
+                _lru_push(i);
+            }
+            _stats.hits++;
+            return (_glyphs + (i * _glyph_size));
+        }
+    }
+    uint16_t i = _entry_take();
+    gc_entry_t* e = &_entries[i];
+    e->key = key;
+    e->next = _hash[h];
+    _hash[h] = i;
+    _lru_push(i);
+    uint8_t* px = _glyphs + (i * _glyph_size);
+    _expand(px, c, color);
+
+    return (px);
+}
+
+void glyph_cache_clear(void) {
+    for (int i = 0; i < GC_HASH_SIZE_; i++) {
+        _hash[i] = GC_NONE_;
+    }
+    _newest = _oldest = GC_NONE_;
+    _stats.used = 0;
+    if (_glyphs) {
+        // Fit as many glyphs as the pixel format allows, growing to hold the
+        // number wanted if the pixels got bigger.
+        _glyph_size = _glyph_pixels * gfxd_pixel_bytes();
+        size_t want_size = _want * _glyph_size;
+        if (_glyphs_size < want_size && !_alloc(want_size)) {
+            warn_printf("Glyph cache - Could not grow to %u bytes.\n", want_size);
+        }
+        size_t entries = _glyphs_size / _glyph_size;
+        _stats.entries = (uint16_t)(entries < _max_entries ? entries : _max_entries);
+    }
+}
+
+#if DISP_AB_BENCH
+void glyph_cache_enable(bool use) {
+    _use = use;
+}
+#endif
+
+void glyph_cache_stats(glyph_cache_stats_t* stats) {
+    *stats = _stats;
+}
+
+void glyph_cache_stats_clear(void) {
+    _stats.lookups = 0;
+    _stats.hits = 0;
+    _stats.evictions = 0;
+}
+
+void glyph_cache_module_init(const font_info_t* fi, uint16_t min_entries) {
+    if (_font) {
+        board_panic("glyph_cache_module_init already called");
+    }
+    _font = fi;
+    _glyph_pixels = fi->width * fi->height;
+    glyph_cache_clear();
+    if (DISP_GLYPH_CACHE_GLYPHS == 0) {
+        return;  // Configured without a cache
+    }
+    // Glyphs for a full line of text must all be in the cache at once.
+    _want = (min_entries > DISP_GLYPH_CACHE_GLYPHS ? min_entries : DISP_GLYPH_CACHE_GLYPHS);
+    // Size for the current pixels. A line of glyphs must still fit in the
+    // largest pixels, in case the cache can't grow when the format changes.
+    size_t glyphs_size = _want * _glyph_pixels * gfxd_pixel_bytes();
+    size_t line_size = min_entries * _glyph_pixels * GFXD_PIXEL_BYTES_MAX;
+    if (glyphs_size < line_size) {
+        glyphs_size = line_size;
+    }
+    if (!_alloc(glyphs_size)) {
+        error_printf("Glyph cache - Could not allocate %u bytes.\n", glyphs_size + ((glyphs_size / (_glyph_pixels * GFXD_PIXEL_BYTES_MIN)) * sizeof(gc_entry_t)));
+        free(_entries);
+        free(_glyphs);
+        _entries = NULL;
+        _glyphs = NULL;
+        return;
+    }
+    glyph_cache_clear();
+    info_printf("Glyph cache: %hu glyphs (%uKB).\n", _stats.entries, glyphs_size / 1024);
+}
@@ -0,0 +1,118 @@
+/**
+ * @brief Cache of expanded (ready to send) glyphs.
+ * @ingroup display
+ *
+ * Rendering a character from the font takes a lookup of the glyph bits and a
+ * color lookup for each pixel. This keeps the most recently used characters
+ * fully expanded to pixels, keyed by the character (including the invert bit)
+ * and its color-byte, so painting a character cell is a copy of each of its
+ * pixel rows. The pixels are in the current pixel format (`gfxd_pixel_bytes`).
+ *
+ * The cache holds DISP_GLYPH_CACHE_GLYPHS glyphs (at least the printable
+ * characters in one color). Its SRAM is sized from the font and the pixel
+ * format, and grows if the pixel format changes to a larger one. When it's
+ * full, the least recently used glyph is replaced.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _GLYPH_CACHE_H_
+#define _GLYPH_CACHE_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "system_defs.h"
+#include "display_rgb18.h"
+#include "../fonts/font.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DISP_GLYPH_CACHE_GLYPHS
+#define DISP_GLYPH_CACHE_GLYPHS 96  // Glyphs the cache holds (0 = no cache)
+#endif
+#if DISP_GLYPH_CACHE_GLYPHS && DISP_GLYPH_CACHE_GLYPHS < 96
+#error "DISP_GLYPH_CACHE_GLYPHS must be at least 96 (the printable characters) or 0"
+#endif
+
+/**
+ * @brief Glyph cache statistics.
+ * @ingroup display
+ */
+typedef struct GLYPH_CACHE_STATS_ {
+    uint32_t lookups;
+    uint32_t hits;
+    uint32_t evictions;
+    uint16_t entries;           // Number of glyphs the cache holds
+    uint16_t used;              // Number of glyphs in the cache
+} glyph_cache_stats_t;
+
+/**
+ * @brief Get the expanded pixels for a character.
+ * @ingroup display
+ *
+ * The glyph is expanded (and cached) if it isn't in the cache. The pixels are
+ * `width` x `height` of the font, a row at a time. The pointer is good until
+ * more than the cache `entries` other glyphs have been gotten.
+ *
+ * @param fi The font
+ * @param c The character (the top bit inverts the colors)
+ * @param color The color-byte (BG4FG4)
+ * @return const uint8_t* The pixels, or NULL if the cache isn't available (or is for a different font)
+ */
+extern const uint8_t* glyph_cache_get(const font_info_t* fi, unsigned char c, colorbyte_t color);
+
+/**
+ * @brief Empty the cache.
+ * @ingroup display
+ *
+ * Needed if the color map or the pixel format changes. The number of glyphs
+ * the cache holds is set for the current pixel format (the cache SRAM is
+ * grown if it can't hold DISP_GLYPH_CACHE_GLYPHS of them).
+ */
+extern void glyph_cache_clear(void);
+
+/**
+ * @brief Enable/disable use of the cache.
+ * @ingroup display
+ *
+ * When disabled, `glyph_cache_get` returns NULL (the characters are rendered
+ * from the font directly). Allows comparing the two. Only in an A/B benchmark
+ * build (`DISP_AB_BENCH`).
+ *
+ * @param use True to use the cache
+ */
+#if DISP_AB_BENCH
+extern void glyph_cache_enable(bool use);
+#endif
+
+/**
+ * @brief Get the cache statistics.
+ * @ingroup display
+ *
+ * @param stats Pointer to the structure to fill in
+ */
+extern void glyph_cache_stats(glyph_cache_stats_t* stats);
+
+/**
+ * @brief Clear the lookup, hit and eviction counts.
+ * @ingroup display
+ */
+extern void glyph_cache_stats_clear(void);
+
+/**
+ * @brief Initialize the glyph cache.
+ * @ingroup display
+ *
+ * @param fi The font to cache glyphs for
+ * @param min_entries The fewest glyphs the cache can hold and be useful (a line of text)
+ */
+extern void glyph_cache_module_init(const font_info_t* fi, uint16_t min_entries);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _GLYPH_CACHE_H_
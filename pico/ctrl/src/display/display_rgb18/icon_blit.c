@@ -0,0 +1,160 @@
+/**
+ * Draw run-length encoded icons.
+ *
+ * The icon is decoded a run at a time. Runs (or the parts of them) outside of
+ * the clip area are skipped. With no transparent color the clipped icon is one
+ * stream window. Otherwise each row's pieces of opaque runs get their own
+ * window, within the one stream.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "icon_blit.h"
+
+#include <stddef.h>
+
+static uint8_t _chunk[2][ICON_CHUNK_PIXELS * GFXD_PIXEL_BYTES_MAX];
+static int _chunk_sel;
+static uint16_t _chunk_n;
+static uint8_t _pixel_bytes;
+
+/*
+ * Get the next run. Returns the length (limited to the rest of the row), or 0
+ * if the data ran out.
+ */
+static int _run_next(const icon_t* icon, uint16_t* pos, int left, uint8_t* index) {
+    if (*pos >= icon->rle_len) {
+        return (0);
+    }
+    uint8_t b = icon->rle[(*pos)++];
+    int len = (b & ICON_RUN_LONG) + 1;
+    if ((b & ICON_RUN_LONG) == ICON_RUN_LONG) {
+        if (*pos >= icon->rle_len) {
+            return (0);
+        }
+        len = icon->rle[(*pos)++] + ICON_RUN_LONG_MIN;
+    }
+    *index = ICON_RUN_INDEX(b);
+    return (_min(len, left));
+}
+
+static void _palette_pixels(const icon_t* icon, gfxd_pixel_t* pal) {
+    for (int i = 0; i < icon->colors && i < ICON_COLORS_MAX; i++) {
+        gfx_color_t c = icon->palette[i];
+        rgb18_t rgb = { GFX_RED(c) & 0xFC, GFX_GREEN(c) & 0xFC, GFX_BLUE(c) & 0xFC };
+        pal[i] = gfxd_pixel_from_rgb18(rgb);
+    }
+}
+
+static void _stream_flush(void) {
+    if (_chunk_n > 0) {
+        gfxd_area_stream(_chunk[_chunk_sel], _chunk_n);
+        _chunk_sel ^= 1;
+        _chunk_n = 0;
+    }
+}
+
+static void _stream_put(gfxd_pixel_t px, int n) {
+    while (n > 0) {
+        int k = _min(n, ICON_CHUNK_PIXELS - _chunk_n);
+        uint8_t* p = _chunk[_chunk_sel] + (_chunk_n * _pixel_bytes);
+        for (int i = 0; i < k; i++) {
+            p = gfxd_pixel_put(p, px, _pixel_bytes);
+        }
+        _chunk_n += k;
+        n -= k;
+        if (_chunk_n == ICON_CHUNK_PIXELS) {
+            _stream_flush();
+        }
+    }
+}
+
+bool icon_decode(const icon_t* icon, uint8_t* pixels, gfxd_pixel_t bg) {
+    gfxd_pixel_t pal[ICON_COLORS_MAX];
+    uint8_t pb = gfxd_pixel_bytes();
+    uint16_t pos = 0;
+
+    _palette_pixels(icon, pal);
+    for (int row = 0; row < icon->height; row++) {
+        int col = 0;
+        while (col < icon->width) {
+            uint8_t index;
+            int len = _run_next(icon, &pos, icon->width - col, &index);
+            if (len == 0 || index >= icon->colors) {
+                return (false);
+            }
+            gfxd_pixel_t px = (index == icon->transparent ? bg : pal[index]);
+            for (int i = 0; i < len; i++) {
+                pixels = gfxd_pixel_put(pixels, px, pb);
+            }
+            col += len;
+        }
+    }
+    return (true);
+}
+
+bool icon_draw(const icon_t* icon, int x, int y, const gfx_rect* clip) {
+    // The clip area (screen, clip, and icon) in icon columns/rows (inclusive)
+    int cx1 = _max(0, -x);
+    int cy1 = _max(0, -y);
+    int cx2 = _min(icon->width, gfxd_screen_width() - x) - 1;
+    int cy2 = _min(icon->height, gfxd_screen_height() - y) - 1;
+    if (clip) {
+        gfx_rect c = *clip;
+        gfx_rect_normalize(&c);
+        cx1 = _max(cx1, c.p1.x - x);
+        cy1 = _max(cy1, c.p1.y - y);
+        cx2 = _min(cx2, c.p2.x - x);
+        cy2 = _min(cy2, c.p2.y - y);
+    }
+    if (cx1 > cx2 || cy1 > cy2) {
+        return (false);
+    }
+    gfxd_pixel_t pal[ICON_COLORS_MAX];
+    _palette_pixels(icon, pal);
+    _pixel_bytes = gfxd_pixel_bytes();
+    _chunk_n = 0;
+    bool opaque = (icon->transparent >= icon->colors);
+    bool drawn = false;
+    uint16_t pos = 0;
+
+    gfxd_area_stream_begin(x + cx1, y + cy1, (cx2 - cx1) + 1, (cy2 - cy1) + 1);
+    for (int row = 0; row <= cy2; row++) {
+        bool in_rows = (row >= cy1);
+        bool in_segment = false;  // Opaque pixels are going into a row window
+        int col = 0;
+        while (col < icon->width) {
+            uint8_t index;
+            int len = _run_next(icon, &pos, icon->width - col, &index);
+            if (len == 0 || index >= icon->colors) {
+                row = cy2;  // Bad data, stop
+                break;
+            }
+            int s = _max(col, cx1);
+            int e = _min(col + len - 1, cx2);
+            col += len;
+            if (!in_rows || s > e) {
+                continue;
+            }
+            if (index == icon->transparent) {
+                in_segment = false;
+                continue;
+            }
+            if (!opaque && !in_segment) {
+                // Send what is ready for the previous window, then move to this
+                // piece (the window runs to the end of the clipped row, the
+                // next window ends the writing).
+                _stream_flush();
+                gfxd_area_stream_window(x + s, y + row, (cx2 - s) + 1, 1);
+                in_segment = true;
+            }
+            _stream_put(pal[index], (e - s) + 1);
+            drawn = true;
+        }
+    }
+    _stream_flush();
+    gfxd_area_stream_end();
+
+    return (drawn);
+}
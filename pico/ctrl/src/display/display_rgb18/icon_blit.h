@@ -0,0 +1,63 @@
+/**
+ * @brief Draw run-length encoded icons.
+ * @ingroup display
+ *
+ * The runs are expanded straight into pixel data that is streamed to the
+ * display (alternating between two small buffers), so an icon never needs a
+ * full frame of pixels in SRAM. Pixels of the transparent color are skipped by
+ * moving the stream window, so what is on the screen shows through without
+ * having to read it back.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _ICON_BLIT_H_
+#define _ICON_BLIT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "display_rgb18.h"
+#include "../icons/icon.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef ICON_CHUNK_PIXELS
+#define ICON_CHUNK_PIXELS 64        // Pixels in each of the two stream buffers
+#endif
+
+/**
+ * @brief Decode an icon into pixel data.
+ * @ingroup display
+ *
+ * This is what `icon_draw` sends, as a full (raw) image. It is for comparing
+ * with drawing from the runs.
+ *
+ * @param icon The icon
+ * @param pixels Buffer for `width` x `height` pixels in the current pixel format
+ * @param bg Pixel to use for the transparent color
+ * @return true The icon data was good
+ */
+extern bool icon_decode(const icon_t* icon, uint8_t* pixels, gfxd_pixel_t bg);
+
+/**
+ * @brief Draw an icon.
+ * @ingroup display
+ *
+ * The icon is clipped to the screen and to the clip area (if one is given).
+ * Pixels of the transparent color are left as they are.
+ *
+ * @param icon The icon
+ * @param x Screen column for the left of the icon (can be off the screen)
+ * @param y Screen row for the top of the icon (can be off the screen)
+ * @param clip Area to draw within (NULL for the screen)
+ * @return true Some of the icon was drawn
+ */
+extern bool icon_draw(const icon_t* icon, int x, int y, const gfx_rect* clip);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _ICON_BLIT_H_
@@ -0,0 +1,428 @@
+/**
+ * ILI9341/ILI9488 command stream emulator.
+ *
+ * Decodes the bytes sent to the controller (commands, parameters and pixels)
+ * into a frame memory. See `ili_emu.h`.
+ *
+ * Addressing: MV exchanges the column and page addresses, then MX/MY mirror
+ * the frame memory columns/rows. The modules scan the sources from the right
+ * (which is why the init data sets MX), so the screen is read from the frame
+ * memory right to left.
+ *
+ * RGB565 pixels are stored as 18 bits the way the controller does by default,
+ * with the top bit of the 5 bit red and blue copied to the low bit.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "ili_emu.h"
+#include "ili9341_spi/ili9341_spi.h"
+#include "ili9488_spi/ili9488_spi.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MADCTL_MY_ 0x80
+#define MADCTL_MX_ 0x40
+#define MADCTL_MV_ 0x20
+
+#define READ_MAX_ 5         // Most bytes a register read returns (dummy + 4)
+
+static struct {
+    ili_controller_type controller;
+    uint16_t width;         // Frame memory columns
+    uint16_t height;        // Frame memory rows
+    uint8_t* fb;            // Frame memory (R, G, B of 6 bits each, in the high bits)
+    bool selected;
+    bool cmd_mode;
+    uint8_t cmd;            // The current command
+    uint32_t param_n;       // Parameter bytes received for the command
+    uint8_t params[6];
+    // Frames are shifted in here until there is a byte
+    uint32_t frame_acc;
+    unsigned frame_bits;
+    // Registers
+    uint8_t madctl;
+    uint8_t colmod;
+    bool sleep;
+    bool display_on;
+    bool scroll_mode;
+    uint16_t sc, ec;        // Column window
+    uint16_t sp, ep;        // Page window
+    uint16_t tfa, vsa, bfa; // Scroll definition
+    uint16_t vsp;           // Scroll start
+    // Memory write
+    bool writing;
+    uint16_t col, page;     // Next pixel address
+    uint8_t px[3];
+    uint8_t px_n;
+    // Register read response
+    uint8_t rd[READ_MAX_];
+    uint8_t rd_len;
+    uint8_t rd_pos;
+    ili_emu_stats_t stats;
+} _emu;
+
+static uint8_t _c5to6(uint8_t c5) {
+    return ((c5 << 1) | (c5 >> 4));
+}
+
+static uint16_t _param16(int i) {
+    return ((_emu.params[i] << 8) | _emu.params[i + 1]);
+}
+
+/*
+ * Put the controller in its reset state (SWRESET).
+ */
+static void _reset(void) {
+    _emu.madctl = 0;
+    _emu.colmod = 0x66;
+    _emu.sleep = true;
+    _emu.display_on = false;
+    _emu.scroll_mode = false;
+    _emu.sc = 0;
+    _emu.ec = _emu.width - 1;
+    _emu.sp = 0;
+    _emu.ep = _emu.height - 1;
+    _emu.tfa = 0;
+    _emu.vsa = _emu.height;
+    _emu.bfa = 0;
+    _emu.vsp = 0;
+    _emu.writing = false;
+    _emu.cmd = ILI_NOP;
+    _emu.param_n = 0;
+    _emu.rd_len = 0;
+}
+
+/*
+ * Store a pixel at the write address and advance it (wrapping in the window).
+ */
+static void _pixel_store(uint8_t r, uint8_t g, uint8_t b) {
+    uint16_t x = _emu.col;
+    uint16_t y = _emu.page;
+    if (_emu.madctl & MADCTL_MV_) {
+        x = _emu.page;
+        y = _emu.col;
+    }
+    if (_emu.madctl & MADCTL_MX_) {
+        x = _emu.width - 1 - x;
+    }
+    if (_emu.madctl & MADCTL_MY_) {
+        y = _emu.height - 1 - y;
+    }
+    if (x < _emu.width && y < _emu.height) {
+        uint8_t* p = _emu.fb + (((size_t)y * _emu.width) + x) * 3;
+        p[0] = r;
+        p[1] = g;
+        p[2] = b;
+    }
+    _emu.stats.pixels++;
+    if (_emu.col++ >= _emu.ec) {
+        _emu.col = _emu.sc;
+        if (_emu.page++ >= _emu.ep) {
+            _emu.page = _emu.sp;
+        }
+    }
+}
+
+static void _pixel_byte(uint8_t b) {
+    _emu.px[_emu.px_n++] = b;
+    if ((_emu.colmod & 0x07) == 0x05) {
+        // RGB565
+        if (_emu.px_n == 2) {
+            uint8_t r5 = _emu.px[0] >> 3;
+            uint8_t g6 = ((_emu.px[0] & 0x07) << 3) | (_emu.px[1] >> 5);
+            uint8_t b5 = _emu.px[1] & 0x1F;
+            _pixel_store(_c5to6(r5) << 2, g6 << 2, _c5to6(b5) << 2);
+            _emu.px_n = 0;
+        }
+    }
+    else if (_emu.px_n == 3) {
+        // RGB666, each color in the high 6 bits of a byte
+        _pixel_store(_emu.px[0] & 0xFC, _emu.px[1] & 0xFC, _emu.px[2] & 0xFC);
+        _emu.px_n = 0;
+    }
+}
+
+/*
+ * Set up the response to a register read.
+ */
+static void _read_setup(uint8_t cmd) {
+    uint8_t* rd = _emu.rd;
+    memset(rd, 0, sizeof(_emu.rd));
+    _emu.rd_pos = 0;
+    _emu.rd_len = 2;
+    switch (cmd) {
+        case ILI_RDMODE:
+            // Booster on, sleep out, normal mode, display on
+            rd[1] = 0x80 | (_emu.sleep ? 0 : 0x10) | (_emu.scroll_mode ? 0 : 0x08) | (_emu.display_on ? 0x04 : 0);
+            break;
+        case ILI_RDMADCTL:
+            rd[1] = _emu.madctl;
+            break;
+        case ILI_RDPIXFMT:
+            rd[1] = _emu.colmod;
+            break;
+        case ILI_EC_RDID4:
+            rd[2] = (_emu.controller == ILI_CONTROLLER_9341 ? ILI9341_ID_MODEL1 : ILI9488_ID_MODEL1);
+            rd[3] = (_emu.controller == ILI_CONTROLLER_9341 ? ILI9341_ID_MODEL2 : ILI9488_ID_MODEL2);
+            _emu.rd_len = 4;
+            break;
+        case ILI_RDDID:
+        case ILI_RDDST:
+            _emu.rd_len = (cmd == ILI_RDDID ? 4 : 5);
+            break;
+        case ILI_RDIMGFMT:
+        case ILI_RDSIGMODE:
+        case ILI_RDSELFDIAG:
+        case ILI_RDID1:
+        case ILI_RDID2:
+        case ILI_RDID3:
+            break;
+        default:
+            _emu.rd_len = 0;
+            break;
+    }
+}
+
+static void _command(uint8_t cmd) {
+    _emu.stats.commands++;
+    _emu.stats.cmd_cnt[cmd]++;
+    _emu.cmd = cmd;
+    _emu.param_n = 0;
+    _emu.writing = false;
+    _emu.rd_len = 0;
+    switch (cmd) {
+        case ILI_SWRESET:
+            _reset();
+            break;
+        case ILI_SLPIN:
+            _emu.sleep = true;
+            break;
+        case ILI_SLPOUT:
+            _emu.sleep = false;
+            break;
+        case ILI_NORON:
+            _emu.scroll_mode = false;
+            break;
+        case ILI_DISPOFF:
+            _emu.display_on = false;
+            break;
+        case ILI_DISPON:
+            _emu.display_on = true;
+            break;
+        case ILI_RAMWR:
+            _emu.col = _emu.sc;
+            _emu.page = _emu.sp;
+            // Fall through
+        case ILI_MEMWRCONT:
+            _emu.writing = true;
+            _emu.px_n = 0;
+            break;
+        default:
+            _read_setup(cmd);
+            break;
+    }
+}
+
+static void _param(uint8_t b) {
+    if (_emu.writing) {
+        _pixel_byte(b);
+        return;
+    }
+    if (_emu.param_n < sizeof(_emu.params)) {
+        _emu.params[_emu.param_n] = b;
+    }
+    _emu.param_n++;
+    switch (_emu.cmd) {
+        case ILI_CASET:
+            if (_emu.param_n == 4) {
+                _emu.sc = _param16(0);
+                _emu.ec = _param16(2);
+            }
+            break;
+        case ILI_PASET:
+            if (_emu.param_n == 4) {
+                _emu.sp = _param16(0);
+                _emu.ep = _param16(2);
+            }
+            break;
+        case ILI_MADCTL:
+            if (_emu.param_n == 1) {
+                _emu.madctl = b;
+            }
+            break;
+        case ILI_PIXFMT:
+            if (_emu.param_n == 1) {
+                _emu.colmod = b;
+            }
+            break;
+        case ILI_VSCRDEF:
+            if (_emu.param_n == 6) {
+                _emu.tfa = _param16(0);
+                _emu.vsa = _param16(2);
+                _emu.bfa = _param16(4);
+            }
+            break;
+        case ILI_VSCRSADD:
+            if (_emu.param_n == 2) {
+                _emu.vsp = _param16(0);
+                _emu.scroll_mode = true;
+            }
+            break;
+        default:
+            break;  // Not emulated
+    }
+}
+
+static void _byte(uint8_t b) {
+    if (_emu.fb == NULL || !_emu.selected) {
+        return;
+    }
+    if (_emu.cmd_mode) {
+        _command(b);
+    }
+    else {
+        _emu.stats.data_bytes++;
+        _param(b);
+    }
+}
+
+/*
+ * The frame memory row shown on a screen row.
+ */
+static uint16_t _shown_row(uint16_t y) {
+    if (!_emu.scroll_mode || y < _emu.tfa || y >= (_emu.tfa + _emu.vsa)) {
+        return (y);
+    }
+    uint32_t row = _emu.vsp + (y - _emu.tfa);
+    if (row >= (uint32_t)(_emu.tfa + _emu.vsa)) {
+        row -= _emu.vsa;
+    }
+    return ((uint16_t)row);
+}
+
+static const uint8_t* _shown_pixel(uint16_t x, uint16_t y) {
+    uint16_t row = _shown_row(y);
+    uint16_t col = _emu.width - 1 - x;
+    return (_emu.fb + (((size_t)row * _emu.width) + col) * 3);
+}
+
+// ======================================================================================
+// Public functions
+// ======================================================================================
+
+void ili_emu_select(bool sel) {
+    if (sel && !_emu.selected) {
+        _emu.stats.selects++;
+    }
+    _emu.selected = sel;
+    _emu.frame_bits = 0;    // A partial byte is lost
+}
+
+void ili_emu_command_mode(bool cmd) {
+    _emu.cmd_mode = cmd;
+}
+
+void ili_emu_write(const uint8_t* buf, size_t len) {
+    while (len--) {
+        _byte(*buf++);
+    }
+}
+
+void ili_emu_write_frames(const uint16_t* frames, size_t n, unsigned bits) {
+    uint32_t mask = (1u << bits) - 1;
+    for (size_t i = 0; i < n; i++) {
+        _emu.frame_acc = (_emu.frame_acc << bits) | (frames[i] & mask);
+        _emu.frame_bits += bits;
+        while (_emu.frame_bits >= 8) {
+            _emu.frame_bits -= 8;
+            _byte((uint8_t)(_emu.frame_acc >> _emu.frame_bits));
+        }
+    }
+}
+
+int ili_emu_read(uint8_t* dst, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = (_emu.rd_pos < _emu.rd_len ? _emu.rd[_emu.rd_pos++] : 0);
+    }
+    return ((int)len);
+}
+
+bool ili_emu_pixel_get(uint16_t x, uint16_t y, rgb18_t* rgb) {
+    if (_emu.fb == NULL || x >= _emu.width || y >= _emu.height) {
+        return (false);
+    }
+    const uint8_t* p = _shown_pixel(x, y);
+    rgb->r = p[0];
+    rgb->g = p[1];
+    rgb->b = p[2];
+    return (true);
+}
+
+uint32_t ili_emu_screen_hash(void) {
+    uint32_t h = 2166136261u;
+    if (_emu.fb == NULL) {
+        return (h);
+    }
+    for (uint16_t y = 0; y < _emu.height; y++) {
+        for (uint16_t x = 0; x < _emu.width; x++) {
+            const uint8_t* p = _shown_pixel(x, y);
+            for (int i = 0; i < 3; i++) {
+                h = (h ^ p[i]) * 16777619u;
+            }
+        }
+    }
+    return (h);
+}
+
+bool ili_emu_snapshot_ppm(ili_emu_write_fn write, void* ctx) {
+    if (_emu.fb == NULL) {
+        return (false);
+    }
+    char hdr[32];
+    int n = snprintf(hdr, sizeof(hdr), "P6\n%u %u\n255\n", _emu.width, _emu.height);
+    if (!write(ctx, (const uint8_t*)hdr, n)) {
+        return (false);
+    }
+    uint8_t* row = malloc((size_t)_emu.width * 3);
+    if (row == NULL) {
+        return (false);
+    }
+    bool ok = true;
+    for (uint16_t y = 0; y < _emu.height && ok; y++) {
+        for (uint16_t x = 0; x < _emu.width; x++) {
+            memcpy(row + (x * 3), _shown_pixel(x, y), 3);
+        }
+        ok = write(ctx, row, (size_t)_emu.width * 3);
+    }
+    free(row);
+    return (ok);
+}
+
+void ili_emu_stats(ili_emu_stats_t* stats) {
+    *stats = _emu.stats;
+}
+
+void ili_emu_stats_clear(void) {
+    memset(&_emu.stats, 0, sizeof(_emu.stats));
+}
+
+bool ili_emu_init(ili_controller_type controller) {
+    free(_emu.fb);
+    memset(&_emu, 0, sizeof(_emu));
+    _emu.controller = controller;
+    if (controller == ILI_CONTROLLER_9341) {
+        _emu.width = ILI9341_WIDTH;
+        _emu.height = ILI9341_HEIGHT;
+    }
+    else {
+        _emu.width = ILI9488_WIDTH;
+        _emu.height = ILI9488_HEIGHT;
+    }
+    _emu.fb = calloc((size_t)_emu.width * _emu.height, 3);
+    _reset();
+    return (_emu.fb != NULL);
+}
@@ -0,0 +1,194 @@
+/**
+ * @brief ILI9341/ILI9488 command stream emulator.
+ * @ingroup display
+ *
+ * A stand-in for the display controller and its frame memory. The host tests
+ * (test_host/ili_emu_test.c) run `ili_lcd_spi.c` against it, through a
+ * stand-in for the SPI operations, for both controllers. On the device it is
+ * an optional debugging aid: when `DISP_ILI_EMU` is set (CMake cache value,
+ * the controller to emulate), the SPI operations send the display commands
+ * and data here rather than to the SPI.
+ * The emulator decodes the command stream the way the controller does and keeps
+ * the frame memory, so what would be on the screen can be checked pixel for
+ * pixel, and what it cost to get it there (SPI bytes and commands) can be
+ * compared.
+ *
+ * The emulation covers what `ili_lcd_spi.c` uses:
+ *  - CASET/PASET windows, RAMWR and MEMWRCONT (with the window wrap).
+ *  - MADCTL MV/MX/MY addressing.
+ *  - COLMOD 16 bit (RGB565) and 18 bit (RGB666) pixels.
+ *  - VSCRDEF/VSCRSADD vertical scrolling (NORON leaves scroll mode).
+ *  - The register reads (power mode, MADCTL, pixel format, IDs).
+ *  - SPI frames of any size (a 12 bit frame pair is a 3 byte pixel).
+ * Other commands are counted and their data is ignored.
+ *
+ * The frame memory is 3 bytes a pixel. On the device that only fits in the
+ * SRAM for the ILI9341 (230KB), so that is the only controller a device build
+ * can emulate. The emulator doesn't use the SDK, and a host build
+ * (`ILI_EMU_HOST`) can emulate either controller.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _ILI_EMU_H_
+#define _ILI_EMU_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "display_rgb18.h"
+#include "ili_lcd_spi.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef DISP_ILI_EMU
+#define DISP_ILI_EMU 0      // The controller to emulate (0 = none, use the display)
+#endif
+#if DISP_ILI_EMU && DISP_ILI_EMU != 9341 && !defined(ILI_EMU_HOST)
+#error "DISP_ILI_EMU can only be 9341 (the frame memory for other controllers doesn't fit in the SRAM)"
+#endif
+
+/**
+ * @brief Counts of what was sent to the controller.
+ * @ingroup display
+ */
+typedef struct ILI_EMU_STATS_ {
+    uint32_t selects;       // Times the controller was selected (SPI operations)
+    uint32_t commands;      // Command bytes
+    uint64_t data_bytes;    // Data bytes (parameters and pixels)
+    uint64_t pixels;        // Pixels written to the frame memory
+    uint32_t cmd_cnt[256];  // Times each command was sent
+} ili_emu_stats_t;
+
+/**
+ * @brief Function prototype for writing snapshot bytes.
+ * @ingroup display
+ *
+ * @param ctx The context given to the snapshot function
+ * @param data The bytes
+ * @param len The number of bytes
+ * @return true The bytes were written
+ */
+typedef bool (*ili_emu_write_fn)(void* ctx, const uint8_t* data, size_t len);
+
+/**
+ * @brief Select/deselect the controller (chip select).
+ * @ingroup display
+ *
+ * @param sel True when selected
+ */
+extern void ili_emu_select(bool sel);
+
+/**
+ * @brief Set command or data mode (the D/C- line).
+ * @ingroup display
+ *
+ * @param cmd True for command mode
+ */
+extern void ili_emu_command_mode(bool cmd);
+
+/**
+ * @brief Write bytes (8 bit frames) to the controller.
+ * @ingroup display
+ *
+ * In command mode each byte is a command, otherwise they are the data for the
+ * current command.
+ *
+ * @param buf The bytes
+ * @param len The number of bytes
+ */
+extern void ili_emu_write(const uint8_t* buf, size_t len);
+
+/**
+ * @brief Write SPI frames of up to 16 bits to the controller.
+ * @ingroup display
+ *
+ * The frames are sent MSB first, so they are turned into the bytes the
+ * controller receives (two 12 bit frames are 3 bytes).
+ *
+ * @param frames The frames (right justified)
+ * @param n The number of frames
+ * @param bits The frame size (4 - 16)
+ */
+extern void ili_emu_write_frames(const uint16_t* frames, size_t n, unsigned bits);
+
+/**
+ * @brief Read bytes from the controller (the response to the last command).
+ * @ingroup display
+ *
+ * Like the controller, the first byte is a dummy.
+ *
+ * @param dst Buffer for the bytes
+ * @param len The number of bytes to read
+ * @return int The number of bytes read (len)
+ */
+extern int ili_emu_read(uint8_t* dst, size_t len);
+
+/**
+ * @brief Get a pixel as it is shown (through the scroll).
+ * @ingroup display
+ *
+ * @param x The screen column
+ * @param y The screen row
+ * @param rgb Set to the pixel's color
+ * @return true The position is on the screen
+ */
+extern bool ili_emu_pixel_get(uint16_t x, uint16_t y, rgb18_t* rgb);
+
+/**
+ * @brief Hash the screen as it is shown (FNV-1a of the pixels).
+ * @ingroup display
+ *
+ * Two screens with the same hash are the same, pixel for pixel (for all
+ * practical purposes), so it can be used to check a rendering change without
+ * keeping a snapshot.
+ *
+ * @return uint32_t The hash
+ */
+extern uint32_t ili_emu_screen_hash(void);
+
+/**
+ * @brief Write a snapshot of the screen as it is shown as a PPM (P6) image.
+ * @ingroup display
+ *
+ * The 6 bit colors are written as they are in an `rgb18_t` (in the high bits).
+ *
+ * @param write Function to write the image bytes (a row at a time)
+ * @param ctx Context passed to the write function
+ * @return true The snapshot was written
+ */
+extern bool ili_emu_snapshot_ppm(ili_emu_write_fn write, void* ctx);
+
+/**
+ * @brief Get the counts of what was sent.
+ * @ingroup display
+ *
+ * @param stats Set to the counts
+ */
+extern void ili_emu_stats(ili_emu_stats_t* stats);
+
+/**
+ * @brief Clear the counts.
+ * @ingroup display
+ */
+extern void ili_emu_stats_clear(void);
+
+/**
+ * @brief Initialize the emulator (allocate the frame memory and reset).
+ * @ingroup display
+ *
+ * The frame memory is 3 bytes a pixel (230KB for the ILI9341, 460KB for the
+ * ILI9488). Only the ILI9341 is supported by a device `DISP_ILI_EMU` build.
+ *
+ * @param controller The controller to emulate
+ * @return true The frame memory could be allocated
+ */
+extern bool ili_emu_init(ili_controller_type controller);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _ILI_EMU_H_
@@ -14,7 +14,10 @@
 #include "ili_lcd_spi.h"
 #include "ili9341_spi/ili9341_spi.h"
 #include "ili9488_spi/ili9488_spi.h"
+#include "ili_emu.h"
+#include "pal_expand.h"
 #include "board.h"
+#include "gfx/gfx.h"
 #include "spi_ops.h"
 
 #include "pico/stdlib.h"
@@ -23,17 +26,19 @@
 
 #include <string.h>
 
-#define DISP_OP_CMD 0       // Set the D/C- pin low for command mode
-#define DISP_OP_DATA 1      // Set the D/C- pin high for data mode
-
-static void _write_area(const rgb18_t* rgb_pixel_data, uint16_t pixels);
+static void _pixels_resume(void);
+static void _write_area(const uint8_t* pixel_data, uint16_t pixels);
 static void _set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
 static void _set_window_fullscreen(void);
 
 static uint16_t _screen_height = 0;
 static uint16_t _screen_width = 0;
 
-static rgb18_t *_ili_line_buf = NULL;
+static uint8_t *_ili_line_buf = NULL;
+
+// The pixel format being used (the init data for each controller sets it)
+static gfxd_pixfmt_t _pixel_format = GFXD_PIXFMT_RGB666;
+static uint8_t _pixel_bytes = 3;
 
 // Storage for last used screen window location
 static uint16_t _old_x1 = 0xffff, _old_x2 = 0xffff;
@@ -63,12 +68,7 @@ static void _cs(bool sel) {
  *
  */
 static void _command_mode(bool cmd) {
-    if (cmd) {
-        gpio_put(SPI_DISP_CD, DISP_OP_CMD);
-    }
-    else {
-        gpio_put(SPI_DISP_CD, DISP_OP_DATA);
-    }
+    spi_display_command_mode(cmd);
 }
 
 static void _op_begin() {
@@ -124,8 +124,7 @@ static void _set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
         _send_command(ILI_CASET); // Column address set
         words[0] = x;
         words[1] = x2;
-        spi_display_write16(words[0]);
-        spi_display_write16(words[1]);
+        spi_display_write16_buf(words, 2);
         _old_x1 = x;
         _old_x2 = x2;
     }
@@ -133,12 +132,21 @@ static void _set_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
         _send_command(ILI_PASET); // Page address set
         words[0] = y;
         words[1] = y2;
-        spi_display_write16(words[0]);
-        spi_display_write16(words[1]);
+        spi_display_write16_buf(words, 2);
         _old_y1 = y;
         _old_y2 = y2;
     }
     _send_command(ILI_RAMWR); // Set it up to write to RAM
+    spi_display_pixels_begin(_pixels_resume);
+}
+
+/**
+ * @brief Continue writing pixels after the display was deselected to let
+ * another SPI transaction go out. Called by the SPI ops with the display selected.
+ */
+static void _pixels_resume(void) {
+    _send_command(ILI_MEMWRCONT); // Continue from the last pixel written
+    spi_display_pixels_begin(_pixels_resume);
 }
 
 /** @brief Set window to fullscreen. MUST BE CALLED WITHIN `_op_begin` and `_op_end`!!! */
@@ -149,8 +157,17 @@ static void _set_window_fullscreen(void) {
 /**
  * @brief Paint a buffer onto the screen. MUST BE CALLED WITHIN AN OPERATION!
 */
-static void _write_area(const rgb18_t* rgb_pixel_data, uint16_t pixels) {
-    spi_display_write8_buf((const uint8_t*)rgb_pixel_data, pixels * sizeof(rgb18_t));
+static void _write_area(const uint8_t* pixel_data, uint16_t pixels) {
+    spi_display_write8_buf(pixel_data, pixels * _pixel_bytes);
+}
+
+/**
+ * @brief Send one pixel of a color. MUST BE CALLED WITHIN AN OPERATION!
+ */
+static void _write_pixel(rgb18_t rgb) {
+    uint8_t px[GFXD_PIXEL_BYTES_MAX];
+    gfxd_pixel_put(px, gfxd_pixel_from_rgb18(rgb), _pixel_bytes);
+    spi_display_write8_buf(px, _pixel_bytes);
 }
 
 /**
@@ -168,7 +185,7 @@ void ili_colors_show() {
             for (int r = 0; r < 64; r++) {
                 rgb.r = r << 2;
                 for (int col = 0; col < 2; col++) {
-                    spi_display_write8_buf((const uint8_t*)&rgb, sizeof(rgb18_t));
+                    _write_pixel(rgb);
                 }
             }
         }
@@ -179,7 +196,7 @@ void ili_colors_show() {
             for (int g = 0; g < 64; g++) {
                 rgb.g = g << 2;
                 for (int col = 0; col < 2; col++) {
-                    spi_display_write8_buf((const uint8_t*)&rgb, sizeof(rgb18_t));
+                    _write_pixel(rgb);
                 }
             }
         }
@@ -190,7 +207,7 @@ void ili_colors_show() {
             for (int b = 0; b < 64; b++) {
                 rgb.b = b << 2;
                 for (int col = 0; col < 2; col++) {
-                    spi_display_write8_buf((const uint8_t*)&rgb, sizeof(rgb18_t));
+                    _write_pixel(rgb);
                 }
             }
         }
@@ -220,10 +237,96 @@ void ili_send_command_wd(uint8_t cmd, uint8_t* data, size_t count) {
     _op_end();
 }
 
-rgb18_t* gfxd_get_line_buf() {
+void gfxd_area_paint(uint16_t x, uint16_t y, uint16_t w, uint16_t h, const uint8_t* pixel_data) {
+    _op_begin();
+    {
+        _set_window(x, y, w, h);
+        _write_area(pixel_data, w * h);
+    }
+    _op_end();
+    _screen_dirty = true;
+}
+
+void gfxd_area_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, rgb18_t color) {
+    if (w == 0 || h == 0) {
+        return;
+    }
+    uint8_t px[GFXD_PIXEL_BYTES_MAX];
+    gfxd_pixel_put(px, gfxd_pixel_from_rgb18(color), _pixel_bytes);
+    _op_begin();
+    {
+        _set_window(x, y, w, h);
+        spi_display_fill_dma(px, _pixel_bytes, (uint32_t)w * h);
+    }
+    _op_end();  // Waits for the fill to finish
+    _screen_dirty = true;
+}
+
+void gfxd_area_stream_begin(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    _op_begin();
+    _set_window(x, y, w, h);
+    _screen_dirty = true;
+}
+
+void gfxd_area_stream(const uint8_t* pixel_data, uint16_t pixels) {
+    spi_display_write8_buf_dma(pixel_data, pixels * _pixel_bytes);
+}
+
+void gfxd_area_stream_window(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+    _set_window(x, y, w, h);  // The commands wait for the data being sent
+}
+
+void gfxd_area_stream_pal4(const uint32_t* packed, uint16_t pixels) {
+    spi_display_dma_external(pal_expand_frame_bits(), pixels * _pixel_bytes, pal_expand_wait);
+    pal_expand_start(packed, pixels, &spi_get_hw(SPI_DISP_EXP_DEVICE)->dr, spi_get_dreq(SPI_DISP_EXP_DEVICE, true), false);
+}
+
+void gfxd_area_stream_end(void) {
+    _op_end();  // Waits for the last of the data to be sent
+}
+
+bool gfxd_pal4_ready(void) {
+    // The expansion DMA writes straight to the SPI, so it can't feed the emulator.
+    return (!DISP_ILI_EMU && pal_expand_ready());
+}
+
+uint8_t* gfxd_get_line_buf() {
     return (_ili_line_buf);
 }
 
+uint8_t gfxd_pixel_bytes(void) {
+    return (_pixel_bytes);
+}
+
+gfxd_pixfmt_t gfxd_pixel_format(void) {
+    return (_pixel_format);
+}
+
+bool gfxd_pixel_format_set(gfxd_pixfmt_t fmt) {
+    if (fmt == GFXD_PIXFMT_RGB565 && _ili_controller_type != ILI_CONTROLLER_9341) {
+        return (false);  // The ILI9488 only takes 18 bit color over SPI
+    }
+    uint8_t colmod = (uint8_t)fmt;
+    _op_begin();
+    {
+        _send_command_wd(ILI_PIXFMT, &colmod, 1);
+    }
+    _op_end();
+    _pixel_format = fmt;
+    _pixel_bytes = (fmt == GFXD_PIXFMT_RGB565 ? 2 : 3);
+
+    return (true);
+}
+
+gfxd_pixel_t gfxd_pixel_from_rgb18(rgb18_t rgb) {
+    if (_pixel_format == GFXD_PIXFMT_RGB565) {
+        // R5G6B5, sent high byte first
+        uint16_t rgb16 = ((rgb.r & 0xF8) << 8) | ((rgb.g & 0xFC) << 3) | (rgb.b >> 3);
+        return ((rgb16 >> 8) | ((rgb16 & 0xFF) << 8));
+    }
+    return (rgb.r | (rgb.g << 8) | (rgb.b << 16));
+}
+
 /**
  * Read information about the display status and the current configuration.
 */
@@ -297,10 +400,10 @@ void gfxd_screen_on(bool on) {
     _op_end();
 }
 
-void gfxd_screen_paint(const rgb18_t* rgb_pixel_data, uint16_t pixels) {
+void gfxd_screen_paint(const uint8_t* pixel_data, uint16_t pixels) {
     _op_begin();
     {
-        _write_area(rgb_pixel_data, pixels);
+        _write_area(pixel_data, pixels);
     }
     _op_end();
     _screen_dirty = true;
@@ -363,7 +466,7 @@ void gfxd_window_set_fullscreen(void) {
     _op_end();
 }
 
-void gfxd_line_paint(uint16_t line, rgb18_t* buf) {
+void gfxd_line_paint(uint16_t line, uint8_t* buf) {
     if (line >= _screen_height) {
         return;
     }
@@ -377,15 +480,7 @@ void gfxd_line_paint(uint16_t line, rgb18_t* buf) {
 
 void gfxd_screen_clr(rgb18_t color, bool force) {
     if (force || _screen_dirty) {
-        rgb18_buf_fill(_ili_line_buf, color, _screen_width);
-        _op_begin();
-        {
-            _set_window_fullscreen();
-            for (int i = 0; i < _screen_height; i++) {
-                _write_area(_ili_line_buf, _screen_width);
-            }
-        }
-        _op_end();
+        gfxd_area_fill(0, 0, _screen_width, _screen_height, color);
         _screen_dirty = false;
     }
     else {
@@ -402,6 +497,17 @@ void gfxd_screen_clr_c16(colorn16_t color, bool force) {
     gfxd_screen_clr(rgb18_from_color16(color), force);
 }
 
+static void _gfx_area_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, gfx_color_t color) {
+    gfxd_area_fill(x, y, w, h, (rgb18_t){ GFX_RED(color), GFX_GREEN(color), GFX_BLUE(color) });
+}
+
+/** @brief The operations for the graphics functions */
+static const gfx_driver_t _gfx_driver = {
+    .screen_width = gfxd_screen_width,
+    .screen_height = gfxd_screen_height,
+    .area_fill = _gfx_area_fill,
+};
+
 ili_controller_type ili_module_init(void) {
     // Take reset low, then high
     //ZZZ gpio_put(DISPLAY_RESET_OUT, DISPLAY_HW_RESET_OFF);
@@ -410,28 +516,35 @@ ili_controller_type ili_module_init(void) {
     //ZZZ sleep_ms(20);
     //ZZZ gpio_put(DISPLAY_RESET_OUT, DISPLAY_HW_RESET_OFF);
     sleep_ms(500);  // Wait for it to come up
-    // Do a software reset as well
-    _send_command(ILI_SWRESET);
+    // Do a software reset as well (the display has to be selected for it)
+    ili_send_command(ILI_SWRESET);
     sleep_ms(100);
 
     const uint8_t* init_cmd_data;
 
     // See which controller we have 9341 or 9488  (or none) so we can initialize appropriately.
     bool ZZZ = false; // Temp flag to force 9341 (true) or 9488 (false)
+#if DISP_ILI_EMU
+    ZZZ = (DISP_ILI_EMU == ILI_CONTROLLER_9341);   // Use the controller being emulated
+#endif
     ili_disp_info_t* info = ili_disp_info();
     if (ZZZ || (info->lcd_id4_ic_model1 == ILI9341_ID_MODEL1 && info->lcd_id4_ic_model2 == ILI9341_ID_MODEL2)) {
         _ili_controller_type = ILI_CONTROLLER_9341;
         init_cmd_data = ili9341_init_cmd_data;
         _screen_height = ILI9341_HEIGHT;
         _screen_width = ILI9341_WIDTH;
-        _ili_line_buf = malloc(_screen_width * sizeof(rgb18_t));
+        _ili_line_buf = malloc(_screen_width * GFXD_PIXEL_BYTES_MAX);
+        _pixel_format = GFXD_PIXFMT_RGB565;     // Set by the init data
+        _pixel_bytes = 2;
     }
     else if (!ZZZ || (info->lcd_id4_ic_model1 == ILI9488_ID_MODEL1 && info->lcd_id4_ic_model2 == ILI9488_ID_MODEL2)) {
         _ili_controller_type = ILI_CONTROLLER_9488;
         init_cmd_data = ili9488_init_cmd_data;
         _screen_height = ILI9488_HEIGHT;
         _screen_width = ILI9488_WIDTH;
-        _ili_line_buf = malloc(_screen_width * sizeof(rgb18_t));
+        _ili_line_buf = malloc(_screen_width * GFXD_PIXEL_BYTES_MAX);
+        _pixel_format = GFXD_PIXFMT_RGB666;     // Set by the init data
+        _pixel_bytes = 3;
     }
     else {
         warn_printf("Cannot determine display controller type (9341 or 9488)");
@@ -451,6 +564,7 @@ ili_controller_type ili_module_init(void) {
             }
         }
         _op_end();
+        gfx_driver_set(&_gfx_driver);
     }
     display_backlight_on(true);
 
@@ -0,0 +1,151 @@
+/**
+ * PIO palette expansion of 4 bit pixels.
+ *
+ * Three DMA channels and a PIO state machine:
+ *  data:    The packed pixels to the PIO TX FIFO.
+ *  addr:    A palette entry address from the PIO RX FIFO to the palette channel's
+ *           read address trigger (one at a time, restarted by the palette channel).
+ *  palette: The entry's frames to the destination, then restarts the addr channel.
+ *
+ * When all of the pixels are out, the addr channel is left waiting on the RX
+ * FIFO, so it is aborted.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "pal_expand.h"
+#include "pal_expand.pio.h"
+
+#include "board.h"
+#include "system_defs.h"
+
+#include "hardware/dma.h"
+#include "hardware/pio.h"
+#include "pico/stdlib.h"
+
+/** @brief The palette. 64 byte aligned, so the PIO can build the entry addresses. */
+static uint16_t _palette[PAL_EXPAND_COLORS][PAL_EXPAND_ENTRY_FRAMES] __attribute__((aligned(64)));
+static uint _frame_bits = 12;
+static uint32_t _frames_per_pixel = 2;
+
+static int _dma_data = -1;
+static int _dma_addr = -1;
+static int _dma_pal = -1;
+static uint _pio_offset;
+static bool _ready = false;
+static volatile bool _active = false;
+
+/*
+ * Check that everything has been sent: the PIO has used all of the data and is
+ * waiting for the next run, all of the addresses have been taken, and the
+ * palette channel has finished (and restarted the addr channel).
+ */
+static bool _done(void) {
+    return (!dma_channel_is_busy(_dma_data)
+        && pio_sm_is_tx_fifo_empty(PIO_PALX_BLOCK, PIO_PALX_SM)
+        && pio_sm_get_pc(PIO_PALX_BLOCK, PIO_PALX_SM) == (_pio_offset + pal_expand_offset_start)
+        && pio_sm_is_rx_fifo_empty(PIO_PALX_BLOCK, PIO_PALX_SM)
+        && !dma_channel_is_busy(_dma_pal)
+        && dma_channel_is_busy(_dma_addr));
+}
+
+bool pal_expand_ready(void) {
+    return (_ready);
+}
+
+void pal_expand_palette_set(const gfxd_pixel_t* pixels, uint8_t pixel_bytes) {
+    pal_expand_wait();
+    for (int i = 0; i < PAL_EXPAND_COLORS; i++) {
+        uint8_t px[GFXD_PIXEL_BYTES_MAX];
+        gfxd_pixel_put(px, pixels[i], pixel_bytes);
+        pal_expand_model_entry(px, pixel_bytes, _palette[i]);
+    }
+    _frame_bits = (pixel_bytes == 3 ? 12 : 16);
+    _frames_per_pixel = (pixel_bytes == 3 ? 2 : 1);
+}
+
+const uint16_t* pal_expand_palette(void) {
+    return (&_palette[0][0]);
+}
+
+uint pal_expand_frame_bits(void) {
+    return (_frame_bits);
+}
+
+uint32_t pal_expand_frames_per_pixel(void) {
+    return (_frames_per_pixel);
+}
+
+void pal_expand_start(const uint32_t* packed, uint32_t pixels, volatile void* dst, uint dreq, bool dst_increment) {
+    pal_expand_wait();
+    if (!_ready || pixels == 0) {
+        return;
+    }
+    dma_channel_config c = dma_channel_get_default_config(_dma_pal);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, dst_increment);
+    channel_config_set_dreq(&c, dreq);
+    channel_config_set_chain_to(&c, _dma_addr);
+    dma_channel_configure(_dma_pal, &c, dst, _palette, _frames_per_pixel, false);
+    _active = true;
+    pio_sm_put_blocking(PIO_PALX_BLOCK, PIO_PALX_SM, pixels - 1);
+    dma_channel_start(_dma_addr);
+    dma_channel_transfer_from_buffer_now(_dma_data, packed, PAL_EXPAND_WORDS(pixels));
+}
+
+void pal_expand_wait(void) {
+    if (!_active) {
+        return;
+    }
+    while (!_done()) {
+        tight_loop_contents();
+    }
+    dma_channel_abort(_dma_addr);
+    _active = false;
+}
+
+void pal_expand_module_init(void) {
+    static bool _initialized = false;
+    if (_initialized) {
+        board_panic("pal_expand_module_init already called");
+    }
+    _initialized = true;
+
+    if (!pio_can_add_program(PIO_PALX_BLOCK, &pal_expand_program)) {
+        warn_printf("Palette expansion not available - no room for the PIO program\n");
+        return;
+    }
+    _pio_offset = pio_add_program(PIO_PALX_BLOCK, &pal_expand_program);
+    pio_sm_claim(PIO_PALX_BLOCK, PIO_PALX_SM);
+    pio_sm_config smc = pal_expand_program_get_default_config(_pio_offset);
+    sm_config_set_out_shift(&smc, true, false, 32);     // Right, no auto-pull
+    sm_config_set_in_shift(&smc, true, false, 32);      // Right, no auto-push
+    pio_sm_init(PIO_PALX_BLOCK, PIO_PALX_SM, _pio_offset, &smc);
+    // Y holds the palette address >> 6
+    pio_sm_put_blocking(PIO_PALX_BLOCK, PIO_PALX_SM, (uint32_t)((uintptr_t)_palette >> 6));
+    pio_sm_exec(PIO_PALX_BLOCK, PIO_PALX_SM, pio_encode_pull(false, true));
+    pio_sm_exec(PIO_PALX_BLOCK, PIO_PALX_SM, pio_encode_mov(pio_y, pio_osr));
+    pio_sm_set_enabled(PIO_PALX_BLOCK, PIO_PALX_SM, true);
+
+    _dma_data = dma_claim_unused_channel(true);
+    _dma_addr = dma_claim_unused_channel(true);
+    _dma_pal = dma_claim_unused_channel(true);
+    // Packed pixels to the PIO
+    dma_channel_config c = dma_channel_get_default_config(_dma_data);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(PIO_PALX_BLOCK, PIO_PALX_SM, true));
+    dma_channel_configure(_dma_data, &c, &PIO_PALX_BLOCK->txf[PIO_PALX_SM], NULL, 0, false);
+    // Entry addresses to the palette channel (one each time it is started)
+    c = dma_channel_get_default_config(_dma_addr);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(PIO_PALX_BLOCK, PIO_PALX_SM, false));
+    dma_channel_configure(_dma_addr, &c, &dma_hw->ch[_dma_pal].al3_read_addr_trig, &PIO_PALX_BLOCK->rxf[PIO_PALX_SM], 1, false);
+    // The palette channel is configured for the destination when started.
+    _ready = true;
+}
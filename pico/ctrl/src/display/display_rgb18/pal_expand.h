@@ -0,0 +1,114 @@
+/**
+ * @brief PIO palette expansion of 4 bit pixels.
+ * @ingroup display
+ *
+ * Sends pixels given as 4 bit palette indexes (8 to a word) in the display's
+ * pixel format. A PIO state machine turns each index into the address of its
+ * palette entry, and DMA copies the entry's SPI frames to the destination
+ * (normally the display SPI). The CPU only writes the packed indexes, which is
+ * 1/6 of the bytes of RGB666 pixels.
+ *
+ * An entry is two SPI frames: an RGB666 pixel is two 12 bit frames, an RGB565
+ * pixel is one 16 bit frame (the second is not sent).
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _PAL_EXPAND_H_
+#define _PAL_EXPAND_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "display_rgb18.h"
+#include "pal_expand_model.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief The number of packed words for a number of pixels.
+ * @ingroup display
+ */
+#define PAL_EXPAND_WORDS(pixels) (((pixels) + 7) / 8)
+
+/**
+ * @brief Check if the expansion is available (the PIO program is loaded).
+ * @ingroup display
+ *
+ * @return true It is available
+ */
+extern bool pal_expand_ready(void);
+
+/**
+ * @brief Set the palette.
+ * @ingroup display
+ *
+ * Waits for an expansion that is being done.
+ *
+ * @param pixels The 16 pixel values (in the current pixel format)
+ * @param pixel_bytes The number of bytes in a pixel (2 or 3)
+ */
+extern void pal_expand_palette_set(const gfxd_pixel_t* pixels, uint8_t pixel_bytes);
+
+/**
+ * @brief Get the palette entries (the SPI frames for each index).
+ * @ingroup display
+ *
+ * @return const uint16_t* The 16 entries of 2 frames
+ */
+extern const uint16_t* pal_expand_palette(void);
+
+/**
+ * @brief The SPI frame size for the current palette.
+ * @ingroup display
+ *
+ * @return uint 12 (RGB666) or 16 (RGB565)
+ */
+extern uint pal_expand_frame_bits(void);
+
+/**
+ * @brief The number of frames sent for each pixel for the current palette.
+ * @ingroup display
+ *
+ * @return uint32_t 2 (RGB666) or 1 (RGB565)
+ */
+extern uint32_t pal_expand_frames_per_pixel(void);
+
+/**
+ * @brief Start expanding pixels to a destination.
+ * @ingroup display
+ *
+ * Returns once it is started. The packed pixels must not be changed until
+ * `pal_expand_wait` returns.
+ *
+ * @param packed The pixels, 8 to a word (first in the low nibble)
+ * @param pixels The number of pixels
+ * @param dst The destination (the SPI data register, or a buffer of 16 bit frames)
+ * @param dreq The DMA DREQ that paces the destination (DREQ_FORCE for a buffer)
+ * @param dst_increment True to increment the destination address (for a buffer)
+ */
+extern void pal_expand_start(const uint32_t* packed, uint32_t pixels, volatile void* dst, uint dreq, bool dst_increment);
+
+/**
+ * @brief Wait for the expansion to finish (if one was started).
+ * @ingroup display
+ *
+ * Returns once the last frame has been written to the destination (the SPI
+ * can still be sending it).
+ */
+extern void pal_expand_wait(void);
+
+/**
+ * @brief Initialize the palette expansion (load the PIO program and claim the DMA channels).
+ * @ingroup display
+ *
+ * If the PIO program can't be loaded the expansion isn't available.
+ */
+extern void pal_expand_module_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _PAL_EXPAND_H_
@@ -0,0 +1,56 @@
+/**
+ * Reference model of the PIO palette expansion.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "pal_expand_model.h"
+
+/*
+ * Shift bits into a 32 bit ISR to the right (like the PIO `in` with the IN
+ * shift direction set to right). The new bits go in at the top.
+ */
+static uint32_t _isr_in_right(uint32_t isr, uint32_t src, uint32_t bits) {
+    uint32_t data = (bits == 32 ? src : (src & ((1u << bits) - 1u)));
+    return ((bits == 32 ? 0 : (isr >> bits)) | (data << (32u - bits)));
+}
+
+void pal_expand_model_entry(const uint8_t* px, uint8_t pixel_bytes, uint16_t entry[PAL_EXPAND_ENTRY_FRAMES]) {
+    if (pixel_bytes == 3) {
+        // Two 12 bit frames
+        entry[0] = (px[0] << 4) | (px[1] >> 4);
+        entry[1] = ((px[1] & 0x0F) << 8) | px[2];
+    }
+    else {
+        entry[0] = (px[0] << 8) | px[1];
+        entry[1] = entry[0];
+    }
+}
+
+uint32_t pal_expand_model_addr(uint32_t palette_addr, uint32_t index) {
+    uint32_t y = palette_addr >> 6;
+    uint32_t isr = 0;
+    isr = _isr_in_right(isr, 0, 2);         // in null, 2
+    isr = _isr_in_right(isr, index, 4);     // in osr, 4
+    isr = _isr_in_right(isr, y, 26);        // in y, 26
+    return (isr);
+}
+
+uint32_t pal_expand_model(const uint16_t palette[PAL_EXPAND_COLORS][PAL_EXPAND_ENTRY_FRAMES], uint32_t frames_per_pixel,
+    const uint32_t* packed, uint32_t pixels, uint16_t* frames) {
+    uint32_t n = 0;
+    uint32_t osr = 0;
+    for (uint32_t i = 0; i < pixels; i++) {
+        if ((i & 7) == 0) {
+            osr = packed[i >> 3];           // pull block
+        }
+        // The address selects the entry. The palette channel copies its frames.
+        uint32_t entry = (pal_expand_model_addr(0, osr) >> 2) & (PAL_EXPAND_COLORS - 1);
+        for (uint32_t f = 0; f < frames_per_pixel; f++) {
+            frames[n++] = palette[entry][f];
+        }
+        osr >>= 4;                          // out null, 4
+    }
+    return (n);
+}
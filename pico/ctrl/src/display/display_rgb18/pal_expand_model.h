@@ -0,0 +1,70 @@
+/**
+ * @brief Reference model of the PIO palette expansion.
+ * @ingroup display
+ *
+ * Models what the `pal_expand` PIO program and its DMA channels produce, bit
+ * for bit, so the hardware output can be checked against it. The palette
+ * entries that `pal_expand` sends are made here too. It doesn't use the SDK,
+ * so the packing and the model are checked by the host tests
+ * (test_host/pal_expand_test.c).
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _PAL_EXPAND_MODEL_H_
+#define _PAL_EXPAND_MODEL_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define PAL_EXPAND_COLORS 16            // Entries in the palette
+#define PAL_EXPAND_ENTRY_FRAMES 2       // SPI frames in a palette entry
+
+/**
+ * @brief Make a palette entry (the SPI frames) for a pixel.
+ * @ingroup display
+ *
+ * An RGB666 pixel (3 bytes) is two 12 bit frames, the first has the first
+ * byte and the top of the second. An RGB565 pixel (2 bytes) is one 16 bit
+ * frame (put in both, the second isn't sent).
+ *
+ * @param px The pixel's bytes, in the order they are sent
+ * @param pixel_bytes The number of bytes in the pixel (2 or 3)
+ * @param entry The entry to fill in
+ */
+extern void pal_expand_model_entry(const uint8_t* px, uint8_t pixel_bytes, uint16_t entry[PAL_EXPAND_ENTRY_FRAMES]);
+
+/**
+ * @brief Build the address the PIO program pushes for a pixel.
+ * @ingroup display
+ *
+ * Follows the program's ISR shifts (right): 2 zero bits, the 4 bit index, then
+ * 26 bits of the palette address >> 6.
+ *
+ * @param palette_addr The palette address (64 byte aligned)
+ * @param index The palette index (low 4 bits are used)
+ * @return uint32_t The palette entry address
+ */
+extern uint32_t pal_expand_model_addr(uint32_t palette_addr, uint32_t index);
+
+/**
+ * @brief Expand packed 4 bit pixels into the SPI frames that are sent.
+ * @ingroup display
+ *
+ * @param palette The palette entries (each is 2 frames)
+ * @param frames_per_pixel The frames copied for each pixel (1 or 2)
+ * @param packed The pixels, 8 to a word (first in the low nibble)
+ * @param pixels The number of pixels
+ * @param frames Buffer for the frames (pixels * frames_per_pixel)
+ * @return uint32_t The number of frames
+ */
+extern uint32_t pal_expand_model(const uint16_t palette[PAL_EXPAND_COLORS][PAL_EXPAND_ENTRY_FRAMES], uint32_t frames_per_pixel,
+    const uint32_t* packed, uint32_t pixels, uint16_t* frames);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _PAL_EXPAND_MODEL_H_
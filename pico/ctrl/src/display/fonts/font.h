@@ -56,18 +56,53 @@ extern "C" {
 /**
  * @brief Information about a font.
  * @ingroup display
+ *
+ * The glyphs are laid out for rendering: each glyph is `height` rows, and
+ * each row is one word with the left pixel in bit `width - 1` (so a row is
+ * rendered by shifting a mask down from that bit). Fonts are generated from
+ * BDF sources by `src-py/bdf_font_gen.py`, which can also give them a 2 bit
+ * (coverage) anti-aliasing plane, and can leave out characters that aren't
+ * used (the index maps a character to its glyph).
  */
 typedef struct font_info_ {
     const char *name;
-    const int8_t width;
+    const int8_t width;                 // Cell width (1 - 16)
     const int8_t height;
-    const int8_t bytes_per_glyph_line;
     const int8_t suggested_cursor_line;
     const uint32_t bitmask;
     const bool has_lowercase;
-    const uint8_t *glyphs;
+    const uint16_t glyph_cnt;           // Number of glyphs
+    const uint8_t *index;               // Glyph for each character (0-127), NULL if the glyphs are the 128 characters in order
+    const uint16_t *rows;               // Glyph rows (`height` for each glyph)
+    const uint32_t *aa_rows;            // Anti-aliasing rows (NULL if none), 2 bits (coverage 0-3) for each pixel, left pixel in bits `(2 * width) - 1` and `(2 * width) - 2`
 } font_info_t;
 
+/**
+ * @brief Get the rows of a character's glyph.
+ * @ingroup display
+ *
+ * @param fi The font
+ * @param c The character (the top (invert) bit is ignored)
+ * @return const uint16_t* The `height` rows of the glyph
+ */
+static inline const uint16_t* font_glyph_rows(const font_info_t* fi, unsigned char c) {
+    unsigned int cl = c & 0x7F;
+    return (fi->rows + ((fi->index ? fi->index[cl] : cl) * fi->height));
+}
+
+/**
+ * @brief Get the anti-aliasing rows of a character's glyph.
+ * @ingroup display
+ *
+ * @param fi The font (must have `aa_rows`)
+ * @param c The character (the top (invert) bit is ignored)
+ * @return const uint32_t* The `height` coverage rows of the glyph
+ */
+static inline const uint32_t* font_glyph_aa_rows(const font_info_t* fi, unsigned char c) {
+    unsigned int cl = c & 0x7F;
+    return (fi->aa_rows + ((fi->index ? fi->index[cl] : cl) * fi->height));
+}
+
 #ifdef __cplusplus
 }
 #endif
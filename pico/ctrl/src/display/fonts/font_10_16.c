@@ -6,12 +6,13 @@
 #include "font_10_16.h"
 
 //
-// Font data for Terminal (fixed-pitch) 10 x 16
+// Font data for Block - 10 x 16
 //
-// 32 special/graphic characters, and standard ASCII
+// Generated by src-py/bdf_font_gen.py from font_10_16.bdf - do not edit.
+// 128 glyphs
 //
 
-const uint16_t _ft[] =
+static const uint16_t _rows[] =
 {
 	// 0x00 < μ (Mu) > (10 wide x 16 high cell)
 	//      // 9 8|7 6 5 4|3 2 1 0
@@ -26,7 +27,7 @@ const uint16_t _ft[] =
 	0x0104, //   #           #
 	0x0104, //   #           #
 	0x0104, //   #           #
-	0x010C, //   #           #
+	0x010C, //   #         # #
 	0x018C, //   # #       # #
 	0x0172, //   #   # # #     #
 	0x0100, //   #
@@ -73,7 +74,7 @@ const uint16_t _ft[] =
 	0x0000, //
 	0x0000, //
 
-	// 0x03 <  SAVE > (10 wide x 16 high cell)
+	// 0x03 < SAVE > (10 wide x 16 high cell)
 	//      // 9 8|7 6 5 4|3 2 1 0
 	//      // - -|- - - -|- - - -
 	0x0000, //
@@ -187,7 +188,7 @@ const uint16_t _ft[] =
 	0x0010, //           #
 	0x0010, //           #
 	0x0010, //           #
-	0x0090, //     #   #
+	0x0090, //     #     #
 	0x0060, //       # #
 	0x0020, //         #
 	0x0000, //
@@ -593,7 +594,7 @@ const uint16_t _ft[] =
 	0x0000, //
 	0x0000, //
 
-	// 0x1D <  > (10 wide x 16 high cell)
+	// 0x1D < blank1D > (10 wide x 16 high cell)
 	//      // 9 8|7 6 5 4|3 2 1 0
 	//      // - -|- - - -|- - - -
 	0x0000, //
@@ -613,7 +614,7 @@ const uint16_t _ft[] =
 	0x0000, //
 	0x0000, //
 
-	// 0x1E <  > (10 wide x 16 high cell)
+	// 0x1E < blank1E > (10 wide x 16 high cell)
 	//      // 9 8|7 6 5 4|3 2 1 0
 	//      // - -|- - - -|- - - -
 	0x0000, //
@@ -633,7 +634,7 @@ const uint16_t _ft[] =
 	0x0000, //
 	0x0000, //
 
-	// 0x1F 'DEL' (10 wide x 16 high cell)
+	// 0x1F < DEL > (10 wide x 16 high cell)
 	//      // 9 8|7 6 5 4|3 2 1 0
 	//      // - -|- - - -|- - - -
 	0x0000, //
@@ -724,11 +725,11 @@ const uint16_t _ft[] =
 	0x0044, //       #       #
 	0x01FE, //   # # # # # # # #
 	0x0044, //       #       #
-	0x0088, //     #        #
+	0x0088, //     #       #
 	0x01FE, //   # # # # # # # #
-	0x0088, //     #        #
-	0x0110, //   #        #
-	0x0110, //   #        #
+	0x0088, //     #       #
+	0x0110, //   #       #
+	0x0110, //   #       #
 	0x0000, //
 	0x0000, //
 	0x0000, //
@@ -743,7 +744,7 @@ const uint16_t _ft[] =
 	0x0120, //   #     #
 	0x0120, //   #     #
 	0x00A0, //     #   #
-	0x003C, //       # # # #
+	0x003C, //         # # # #
 	0x0024, //         #     #
 	0x0024, //         #     #
 	0x0024, //         #     #
@@ -2347,7 +2348,7 @@ const uint16_t _ft[] =
 	0x0040, //       #
 	0x0040, //       #
 	0x0040, //       #
-	0x0044, //       $       $
+	0x0044, //       #       #
 	0x0038, //         # # #
 	0x0000, //
 	0x0000, //
@@ -2446,7 +2447,7 @@ const uint16_t _ft[] =
 	0x0104, //   #           #
 	0x0084, //     #         #
 	0x0088, //     #       #
-	0x0044, //       #     #
+	0x0044, //       #       #
 	0x0028, //         #   #
 	0x0010, //           #
 	0x0020, //         #
@@ -2578,13 +2579,14 @@ const uint16_t _ft[] =
 
 const font_info_t font_10_16 =
 {
-	"Block - 10 x 16",  // name
+	"Block - 10 x 16",	// name
 	10,             	// width
 	16,             	// height
-	2,              	// bytes per glyph line
-	13,					// suggested cursor line
+	13,             	// suggested cursor line
 	0x000003FF,     	// bitmask
 	true,           	// has lowercase
-	(uint8_t*)_ft,  	// font/glyph table
+	128,            	// glyph count
+	NULL,           	// index
+	_rows,          	// glyph rows
+	NULL,           	// anti-aliasing rows
 };
-
@@ -13,7 +13,7 @@
 #include "font.h"
 
 /**
- * @brief Information for the 10x16 fixed font.
+ * @brief Information for the Block - 10 x 16 font.
  * @ingroup display
  */
 extern const font_info_t font_10_16;
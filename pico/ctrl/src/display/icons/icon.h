@@ -0,0 +1,56 @@
+/**
+ * @brief Run-length encoded icons.
+ * @ingroup display
+ *
+ * An icon is a small image with up to 16 colors (a palette), stored as runs
+ * of the same color, row by row. A run never goes past the end of a row. Each
+ * run is a byte:
+ *  - Bits 7-4: The palette index
+ *  - Bits 3-0: The length - 1 (1 to 15 pixels), or 15 for a long run, where
+ *              the next byte is the length - 16 (16 to 271 pixels)
+ *
+ * One palette index can be transparent. Those pixels aren't drawn, so what is
+ * on the screen (the text) shows through.
+ *
+ * The icon data is generated from PNG/PPM images by `src-py/icon_rle_gen.py`.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _ICON_H_
+#define _ICON_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "gfx/gfx.h"
+
+#include <stdint.h>
+
+#define ICON_COLORS_MAX 16          // Most colors in an icon's palette
+#define ICON_NO_TRANSPARENT 0xFF    // `transparent` value when all of the pixels are drawn
+
+#define ICON_RUN_INDEX(b) ((b) >> 4)
+#define ICON_RUN_LONG 0x0F          // Run length value for a long run (the next byte has the length)
+#define ICON_RUN_LONG_MIN 16        // Shortest long run
+
+/**
+ * @brief An icon.
+ * @ingroup display
+ */
+typedef struct icon_ {
+    const char* name;
+    uint16_t width;
+    uint16_t height;
+    uint8_t colors;                 // Colors in the palette
+    uint8_t transparent;            // Palette index that isn't drawn (or ICON_NO_TRANSPARENT)
+    const gfx_color_t* palette;
+    uint16_t rle_len;               // Bytes of run data
+    const uint8_t* rle;
+} icon_t;
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _ICON_H_
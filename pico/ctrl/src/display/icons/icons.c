@@ -0,0 +1,73 @@
+/**
+ * Icons (generated by src-py/icon_rle_gen.py - do not edit).
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "icons.h"
+
+static const gfx_color_t _battery_low_palette[] = {
+    0x000000, 0xC8C8C8, 0xE40000,
+};
+static const uint8_t _battery_low_rle[] = {
+    0x0F, 0x04, 0x0F, 0x04, 0x01, 0x1D, 0x03, 0x01, 0x10, 0x0B, 0x10, 0x03, 0x01, 0x10, 0x00, 0x22,
+    0x08, 0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x08, 0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x08, 0x11,
+    0x01, 0x01, 0x10, 0x00, 0x22, 0x08, 0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x08, 0x11, 0x01, 0x01,
+    0x10, 0x00, 0x22, 0x08, 0x11, 0x01, 0x01, 0x10, 0x0B, 0x10, 0x03, 0x01, 0x1D, 0x03, 0x0F, 0x04,
+    0x0F, 0x04, 0x0F, 0x04, 0x0F, 0x04,
+};
+const icon_t icon_battery_low = {
+    "battery_low", 20, 16, 3, 0,
+    _battery_low_palette, sizeof(_battery_low_rle), _battery_low_rle,
+};
+
+static const gfx_color_t _battery_ok_palette[] = {
+    0x000000, 0xC8C8C8, 0x00DC00,
+};
+static const uint8_t _battery_ok_rle[] = {
+    0x0F, 0x04, 0x0F, 0x04, 0x01, 0x1D, 0x03, 0x01, 0x10, 0x0B, 0x10, 0x03, 0x01, 0x10, 0x00, 0x22,
+    0x00, 0x22, 0x00, 0x22, 0x00, 0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x00, 0x22, 0x00, 0x22, 0x00,
+    0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x00, 0x22, 0x00, 0x22, 0x00, 0x11, 0x01, 0x01, 0x10, 0x00,
+    0x22, 0x00, 0x22, 0x00, 0x22, 0x00, 0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x00, 0x22, 0x00, 0x22,
+    0x00, 0x11, 0x01, 0x01, 0x10, 0x00, 0x22, 0x00, 0x22, 0x00, 0x22, 0x00, 0x11, 0x01, 0x01, 0x10,
+    0x0B, 0x10, 0x03, 0x01, 0x1D, 0x03, 0x0F, 0x04, 0x0F, 0x04, 0x0F, 0x04, 0x0F, 0x04,
+};
+const icon_t icon_battery_ok = {
+    "battery_ok", 20, 16, 3, 0,
+    _battery_ok_palette, sizeof(_battery_ok_rle), _battery_ok_rle,
+};
+
+static const gfx_color_t _servo_fault_palette[] = {
+    0x000000, 0xFCD000, 0x000000,
+};
+static const uint8_t _servo_fault_rle[] = {
+    0x08, 0x11, 0x08, 0x07, 0x13, 0x07, 0x07, 0x13, 0x07, 0x06, 0x11, 0x21, 0x11, 0x06, 0x06, 0x11,
+    0x21, 0x11, 0x06, 0x05, 0x12, 0x21, 0x12, 0x05, 0x05, 0x12, 0x21, 0x12, 0x05, 0x04, 0x13, 0x21,
+    0x13, 0x04, 0x04, 0x13, 0x21, 0x13, 0x04, 0x03, 0x1B, 0x03, 0x03, 0x14, 0x21, 0x14, 0x03, 0x02,
+    0x15, 0x21, 0x15, 0x02, 0x02, 0x1E, 0x01, 0x01, 0x1F, 0x01, 0x00, 0x01, 0x1F, 0x01, 0x00, 0x0F,
+    0x04,
+};
+const icon_t icon_servo_fault = {
+    "servo_fault", 20, 16, 3, 0,
+    _servo_fault_palette, sizeof(_servo_fault_rle), _servo_fault_rle,
+};
+
+static const gfx_color_t _switch_bank_palette[] = {
+    0xFCFCFC, 0x000000, 0xC8C8C8, 0x00DC00, 0xE40000,
+};
+static const uint8_t _switch_bank_rle[] = {
+    0x0F, 0x04, 0x00, 0x1F, 0x02, 0x00, 0x00, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10,
+    0x21, 0x10, 0x20, 0x10, 0x00, 0x00, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21,
+    0x10, 0x20, 0x10, 0x00, 0x00, 0x10, 0x31, 0x10, 0x21, 0x10, 0x31, 0x10, 0x21, 0x10, 0x31, 0x10,
+    0x20, 0x10, 0x00, 0x00, 0x10, 0x31, 0x10, 0x21, 0x10, 0x31, 0x10, 0x21, 0x10, 0x31, 0x10, 0x20,
+    0x10, 0x00, 0x00, 0x10, 0x31, 0x10, 0x41, 0x10, 0x31, 0x10, 0x41, 0x10, 0x31, 0x10, 0x40, 0x10,
+    0x00, 0x00, 0x10, 0x21, 0x10, 0x41, 0x10, 0x21, 0x10, 0x41, 0x10, 0x21, 0x10, 0x40, 0x10, 0x00,
+    0x00, 0x10, 0x21, 0x10, 0x41, 0x10, 0x21, 0x10, 0x41, 0x10, 0x21, 0x10, 0x40, 0x10, 0x00, 0x00,
+    0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10, 0x21, 0x10, 0x20, 0x10, 0x00, 0x00, 0x1F,
+    0x02, 0x00, 0x0F, 0x04, 0x1F, 0x04, 0x1F, 0x04, 0x1F, 0x04, 0x1F, 0x04,
+};
+const icon_t icon_switch_bank = {
+    "switch_bank", 20, 16, 5, 1,
+    _switch_bank_palette, sizeof(_switch_bank_rle), _switch_bank_rle,
+};
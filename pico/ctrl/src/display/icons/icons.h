@@ -0,0 +1,25 @@
+/**
+ * @brief Icons (generated by src-py/icon_rle_gen.py - do not edit).
+ * @ingroup display
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _ICONS_H_
+#define _ICONS_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "icon.h"
+
+extern const icon_t icon_battery_low;  // 20x16, 70 bytes
+extern const icon_t icon_battery_ok;  // 20x16, 94 bytes
+extern const icon_t icon_servo_fault;  // 20x16, 65 bytes
+extern const icon_t icon_switch_bank;  // 20x16, 140 bytes
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _ICONS_H_
@@ -77,58 +77,35 @@ static bool _initialized = false;
 /** @brief Last written Output Latch value (OLAT). Needed to OR-in new values. */
 static uint8_t _olat;
 
-/**
- * Set the chip select for the Expansion I/O.
- *
+/*
+ * Run a register read/write as an SPI transaction. The register accesses are
+ * short, so they are high priority and can go out between chunks of a display paint.
  */
-static void _cs(bool sel) {
-    if (sel) {
-        spi_expio_select();
-    }
-    else {
-        spi_none_select();
-    }
-}
-
-static void _op_begin() {
+static void _eio_txn_run(const uint8_t* tx, size_t tx_len, uint8_t* rx, size_t rx_len) {
     if (!_initialized) {
         board_panic("expio_module_init not called.");
     }
-    spi_expio_begin();
-    _cs(true);
-}
-
-static void _op_end() {
-    _cs(false);
-    spi_expio_end();
+    spi_txn_t txn = {
+        .device = SPI_EXPANSION_SELECT,
+        .pri = SPI_TXN_PRI_HIGH,
+        .tx = tx,
+        .tx_len = tx_len,
+        .rx = rx,
+        .rx_len = rx_len,
+    };
+    spi_txn_run(&txn);
 }
 
-
-/*
- * Runs _op_begin/_op_end
- */
 static uint8_t _eio_read(uint8_t reg) {
     uint8_t v;
     uint8_t buf[] = { EIO_CONTROL_BYTE | EIO_CONTROL_RD_EN, reg };
-    _op_begin();
-    {
-        spi_expio_write8_buf(buf, 2);
-        v = spi_expio_read8(0xff);
-    }
-    _op_end();
+    _eio_txn_run(buf, 2, &v, 1);
     return v;
 }
 
-/*
- * Runs _op_begin/_op_end
- */
 static void _eio_write(uint8_t reg, uint8_t val) {
     uint8_t buf[] = { EIO_CONTROL_BYTE | EIO_CONTROL_WR_EN, reg, val };
-    _op_begin();
-    {
-        spi_expio_write8_buf(buf, 3);
-    }
-    _op_end();
+    _eio_txn_run(buf, 3, NULL, 0);
 }
 
 uint8_t eio_board_addr(void) {
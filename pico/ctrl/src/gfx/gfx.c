@@ -4,12 +4,132 @@
  *
  * Provides graphics primatives and operations. It is independent of the display.
  *
+ * Each drawing function works out its clip area once, then sends its pixels
+ * to the driver as horizontal or vertical runs (spans), each clipped on its
+ * own. The pixels are the same as drawing and clipping them one at a time.
+ *
  * Copyright 2023-25 AESilky
  *
  * SPDX-License-Identifier: MIT
  */
 #include "gfx.h"
 
+#include <stddef.h>
+#include <stdlib.h>
+
+static const gfx_driver_t* _driver = NULL;
+
+static bool _clip_use = false;
+static gfx_rect _clip;
+
+// The clip area of the current drawing operation (inclusive)
+static int _cx1, _cy1, _cx2, _cy2;
+
+/*
+ * Set up the clip area for a drawing operation.
+ *
+ * Returns false if there isn't a driver or nothing can be drawn.
+ */
+static bool _clip_begin(void) {
+    if (!_driver) {
+        return (false);
+    }
+    _cx1 = 0;
+    _cy1 = 0;
+    _cx2 = _driver->screen_width() - 1;
+    _cy2 = _driver->screen_height() - 1;
+    if (_clip_use) {
+        _cx1 = _max(_cx1, _clip.p1.x);
+        _cy1 = _max(_cy1, _clip.p1.y);
+        _cx2 = _min(_cx2, _clip.p2.x);
+        _cy2 = _min(_cy2, _clip.p2.y);
+    }
+    return (_cx1 <= _cx2 && _cy1 <= _cy2);
+}
+
+/*
+ * Fill a (normalized) area, clipped.
+ */
+static bool _area(int x1, int y1, int x2, int y2, gfx_color_t color) {
+    x1 = _max(x1, _cx1);
+    y1 = _max(y1, _cy1);
+    x2 = _min(x2, _cx2);
+    y2 = _min(y2, _cy2);
+    if (x1 > x2 || y1 > y2) {
+        return (false);
+    }
+    _driver->area_fill(x1, y1, (x2 - x1) + 1, (y2 - y1) + 1, color);
+    return (true);
+}
+
+static bool _hspan(int x1, int x2, int y, gfx_color_t color) {
+    return (x1 <= x2 ? _area(x1, y, x2, y, color) : _area(x2, y, x1, y, color));
+}
+
+static bool _vspan(int x, int y1, int y2, gfx_color_t color) {
+    return (y1 <= y2 ? _area(x, y1, x, y2, color) : _area(x, y2, x, y1, color));
+}
+
+/*
+ * Draw the 8 runs of a circle for a run of x (xs to xe) at y, in the first octant.
+ */
+static bool _circle_runs(const gfx_point* c, int xs, int xe, int y, gfx_color_t color) {
+    bool drawn = false;
+    // Across the top and bottom
+    if (xs == 0) {
+        drawn |= _hspan(c->x - xe, c->x + xe, c->y - y, color);
+        if (y != 0) {
+            drawn |= _hspan(c->x - xe, c->x + xe, c->y + y, color);
+        }
+    }
+    else {
+        drawn |= _hspan(c->x + xs, c->x + xe, c->y - y, color);
+        drawn |= _hspan(c->x - xe, c->x - xs, c->y - y, color);
+        drawn |= _hspan(c->x + xs, c->x + xe, c->y + y, color);
+        drawn |= _hspan(c->x - xe, c->x - xs, c->y + y, color);
+    }
+    // Down the sides
+    if (xs == 0) {
+        drawn |= _vspan(c->x - y, c->y - xe, c->y + xe, color);
+        if (y != 0) {
+            drawn |= _vspan(c->x + y, c->y - xe, c->y + xe, color);
+        }
+    }
+    else {
+        drawn |= _vspan(c->x - y, c->y + xs, c->y + xe, color);
+        drawn |= _vspan(c->x - y, c->y - xe, c->y - xs, color);
+        drawn |= _vspan(c->x + y, c->y + xs, c->y + xe, color);
+        drawn |= _vspan(c->x + y, c->y - xe, c->y - xs, color);
+    }
+    return (drawn);
+}
+
+bool gfx_bitmap_draw(const gfx_point* p, const gfx_bitmap_t* bm, gfx_color_t fg, gfx_color_t bg) {
+    if (!_clip_begin()) {
+        return (false);
+    }
+    bool drawn = false;
+    int stride = GFX_BITMAP_STRIDE(bm->width);
+    int r1 = _max(0, _cy1 - p->y);
+    int r2 = _min(bm->height - 1, _cy2 - p->y);
+    for (int r = r1; r <= r2; r++) {
+        const uint8_t* row = bm->bits + (r * stride);
+        int col = 0;
+        while (col < bm->width) {
+            // Find the run of the same bit value
+            bool set = (row[col >> 3] & (0x80 >> (col & 7)));
+            int start = col;
+            while (++col < bm->width && (bool)(row[col >> 3] & (0x80 >> (col & 7))) == set) {
+            }
+            gfx_color_t color = (set ? fg : bg);
+            if (color != GFX_COLOR_NONE) {
+                drawn |= _hspan(p->x + start, p->x + col - 1, p->y + r, color);
+            }
+        }
+    }
+    return (drawn);
+}
+
 bool gfx_bounds_add_point(gfx_rect* bounds, gfx_point* p) {
     bool expanded = false;
     int smx, smy, lgx, lgy;
@@ -28,6 +148,170 @@ bool gfx_bounds_add_point(gfx_rect* bounds, gfx_point* p) {
     return (expanded);
 }
 
+bool gfx_circle_draw(const gfx_point* center, int radius, gfx_color_t color) {
+    if (radius < 0 || !_clip_begin()) {
+        return (false);
+    }
+    // Midpoint circle for the first octant (x from 0, y from the radius).
+    // The pixels with the same y are drawn as runs.
+    bool drawn = false;
+    int x = 0;
+    int y = radius;
+    int d = 1 - radius;
+    int xs = 0;
+    while (x <= y) {
+        int nx = x + 1;
+        int ny = y;
+        if (d < 0) {
+            d += (2 * x) + 3;
+        }
+        else {
+            d += (2 * (x - y)) + 5;
+            ny--;
+        }
+        if (ny != y || nx > ny) {
+            drawn |= _circle_runs(center, xs, x, y, color);
+            xs = nx;
+        }
+        x = nx;
+        y = ny;
+    }
+    return (drawn);
+}
+
+bool gfx_circle_fill(const gfx_point* center, int radius, gfx_color_t color) {
+    if (radius < 0 || !_clip_begin()) {
+        return (false);
+    }
+    // Midpoint circle, filling across. The rows at +/-x are filled for each x,
+    // the rows at +/-y once, for the widest x of that y.
+    bool drawn = false;
+    int cx = center->x;
+    int cy = center->y;
+    int x = 0;
+    int y = radius;
+    int d = 1 - radius;
+    while (x <= y) {
+        drawn |= _hspan(cx - y, cx + y, cy + x, color);
+        if (x != 0) {
+            drawn |= _hspan(cx - y, cx + y, cy - x, color);
+        }
+        int nx = x + 1;
+        int ny = y;
+        if (d < 0) {
+            d += (2 * x) + 3;
+        }
+        else {
+            d += (2 * (x - y)) + 5;
+            ny--;
+        }
+        if ((ny != y || nx > ny) && x != y) {
+            drawn |= _hspan(cx - x, cx + x, cy + y, color);
+            drawn |= _hspan(cx - x, cx + x, cy - y, color);
+        }
+        x = nx;
+        y = ny;
+    }
+    return (drawn);
+}
+
+void gfx_clip_clear(void) {
+    _clip_use = false;
+}
+
+void gfx_clip_set(const gfx_rect* rect) {
+    _clip = *rect;
+    gfx_rect_normalize(&_clip);
+    _clip_use = true;
+}
+
+const gfx_driver_t* gfx_driver_get(void) {
+    return (_driver);
+}
+
+void gfx_driver_set(const gfx_driver_t* driver) {
+    _driver = driver;
+}
+
+bool gfx_hline(int x1, int x2, int y, gfx_color_t color) {
+    if (!_clip_begin()) {
+        return (false);
+    }
+    return (_hspan(x1, x2, y, color));
+}
+
+bool gfx_line(const gfx_point* p1, const gfx_point* p2, gfx_color_t color) {
+    if (!_clip_begin()) {
+        return (false);
+    }
+    // Bresenham (all octants). The pixels are collected into runs along the
+    // major axis, which end when the minor axis steps.
+    bool drawn = false;
+    int x = p1->x;
+    int y = p1->y;
+    int dx = abs(p2->x - x);
+    int dy = -abs(p2->y - y);
+    int sx = (x < p2->x ? 1 : -1);
+    int sy = (y < p2->y ? 1 : -1);
+    int err = dx + dy;
+    bool xmajor = (dx >= -dy);
+    int rs = (xmajor ? x : y);  // Run start
+    while (true) {
+        bool last = (x == p2->x && y == p2->y);
+        int nx = x;
+        int ny = y;
+        if (!last) {
+            int e2 = 2 * err;
+            if (e2 >= dy) {
+                err += dy;
+                nx += sx;
+            }
+            if (e2 <= dx) {
+                err += dx;
+                ny += sy;
+            }
+        }
+        if (last || (xmajor ? (ny != y) : (nx != x))) {
+            drawn |= (xmajor ? _hspan(rs, x, y, color) : _vspan(x, rs, y, color));
+            rs = (xmajor ? nx : ny);
+        }
+        if (last) {
+            break;
+        }
+        x = nx;
+        y = ny;
+    }
+    return (drawn);
+}
+
+bool gfx_rect_draw(const gfx_rect* rect, gfx_color_t color) {
+    if (!_clip_begin()) {
+        return (false);
+    }
+    gfx_rect r = *rect;
+    gfx_rect_normalize(&r);
+    bool drawn = _hspan(r.p1.x, r.p2.x, r.p1.y, color);
+    if (r.p2.y != r.p1.y) {
+        drawn |= _hspan(r.p1.x, r.p2.x, r.p2.y, color);
+    }
+    if (r.p2.y - r.p1.y > 1) {
+        drawn |= _vspan(r.p1.x, r.p1.y + 1, r.p2.y - 1, color);
+        if (r.p2.x != r.p1.x) {
+            drawn |= _vspan(r.p2.x, r.p1.y + 1, r.p2.y - 1, color);
+        }
+    }
+    return (drawn);
+}
+
+bool gfx_rect_fill(const gfx_rect* rect, gfx_color_t color) {
+    if (!_clip_begin()) {
+        return (false);
+    }
+    gfx_rect r = *rect;
+    gfx_rect_normalize(&r);
+    return (_area(r.p1.x, r.p1.y, r.p2.x, r.p2.y, color));
+}
+
 void gfx_rect_normalize(gfx_rect* rect) {
     int smx, smy, lgx, lgy;
 
@@ -42,3 +326,19 @@ void gfx_rect_normalize(gfx_rect* rect) {
     rect->p2.x = lgx;
     rect->p2.y = lgy;
 }
+
+bool gfx_screen_clr(gfx_color_t color) {
+    if (!_driver) {
+        return (false);
+    }
+    _driver->area_fill(0, 0, _driver->screen_width(), _driver->screen_height(), color);
+
+    return (true);
+}
+
+bool gfx_vline(int x, int y1, int y2, gfx_color_t color) {
+    if (!_clip_begin()) {
+        return (false);
+    }
+    return (_vspan(x, y1, y2, color));
+}
@@ -4,6 +4,10 @@
  *
  * Provides graphics primatives and operations. It is independent of the display.
  *
+ * The drawing functions are clipped (to the screen, and the clip rectangle if
+ * one is set), and send runs of same-colored pixels to the display driver as
+ * area fills, rather than writing a pixel at a time.
+ *
  * Copyright 2023-25 AESilky
  *
  * SPDX-License-Identifier: MIT
@@ -37,6 +41,46 @@ typedef struct _gfx_rect_ {
     gfx_point p2;
 } gfx_rect;
 
+/**
+ * @brief A color as 8 bits each of red, green and blue (0x00RRGGBB).
+ * @ingroup gfx
+ */
+typedef uint32_t gfx_color_t;
+
+#define GFX_RGB(r, g, b) ((gfx_color_t)((((r) & 0xFF) << 16) | (((g) & 0xFF) << 8) | ((b) & 0xFF)))
+#define GFX_RED(c)   (((c) >> 16) & 0xFF)
+#define GFX_GREEN(c) (((c) >> 8) & 0xFF)
+#define GFX_BLUE(c)  ((c) & 0xFF)
+
+/** @brief No color. Used for the background of a bitmap to leave it transparent. */
+#define GFX_COLOR_NONE ((gfx_color_t)0xFF000000)
+
+/**
+ * @brief A 1 bit per pixel bitmap.
+ * @ingroup gfx
+ *
+ * Each row starts on a byte. The leftmost pixel is the high bit.
+ */
+typedef struct _gfx_bitmap_ {
+    uint16_t width;
+    uint16_t height;
+    const uint8_t* bits;
+} gfx_bitmap_t;
+
+/** @brief The bytes in a row of a bitmap. */
+#define GFX_BITMAP_STRIDE(width) (((width) + 7) / 8)
+
+/**
+ * @brief The operations a display driver provides for the graphics functions.
+ * @ingroup gfx
+ */
+typedef struct _gfx_driver_ {
+    uint16_t (*screen_width)(void);
+    uint16_t (*screen_height)(void);
+    /** @brief Fill an area (already clipped to the screen) with a color. */
+    void (*area_fill)(uint16_t x, uint16_t y, uint16_t w, uint16_t h, gfx_color_t color);
+} gfx_driver_t;
+
 static inline int _max(int a, int b) { return (a > b ? a : b); }
 static inline int _min(int a, int b) { return (a < b ? a : b); }
 
@@ -53,6 +97,119 @@ static inline int _min(int a, int b) { return (a < b ? a : b); }
  */
 extern bool gfx_bounds_add_point(gfx_rect *bounds, gfx_point *p);
 
+/**
+ * @brief Draw a bitmap.
+ * @ingroup gfx
+ *
+ * The set bits are drawn in the foreground color, and the clear bits in the
+ * background color (unless it is `GFX_COLOR_NONE`).
+ *
+ * @param p The upper left corner
+ * @param bm The bitmap
+ * @param fg The foreground color
+ * @param bg The background color (or GFX_COLOR_NONE)
+ * @return true If anything was drawn
+ */
+extern bool gfx_bitmap_draw(const gfx_point* p, const gfx_bitmap_t* bm, gfx_color_t fg, gfx_color_t bg);
+
+/**
+ * @brief Draw a circle.
+ * @ingroup gfx
+ *
+ * @param center The center
+ * @param radius The radius
+ * @param color The color
+ * @return true If anything was drawn
+ */
+extern bool gfx_circle_draw(const gfx_point* center, int radius, gfx_color_t color);
+
+/**
+ * @brief Draw a filled circle.
+ * @ingroup gfx
+ *
+ * @param center The center
+ * @param radius The radius
+ * @param color The color
+ * @return true If anything was drawn
+ */
+extern bool gfx_circle_fill(const gfx_point* center, int radius, gfx_color_t color);
+
+/**
+ * @brief Remove the clip rectangle (draw on the whole screen).
+ * @ingroup gfx
+ */
+extern void gfx_clip_clear(void);
+
+/**
+ * @brief Set a clip rectangle. Nothing is drawn outside of it.
+ * @ingroup gfx
+ *
+ * @param rect The rectangle (includes both corner points)
+ */
+extern void gfx_clip_set(const gfx_rect* rect);
+
+/**
+ * @brief Get the display driver used by the drawing functions.
+ * @ingroup gfx
+ *
+ * @return const gfx_driver_t* The driver (NULL if none has been set)
+ */
+extern const gfx_driver_t* gfx_driver_get(void);
+
+/**
+ * @brief Set the display driver used by the drawing functions.
+ * @ingroup gfx
+ *
+ * @param driver The driver operations (must stay valid)
+ */
+extern void gfx_driver_set(const gfx_driver_t* driver);
+
+/**
+ * @brief Draw a horizontal line.
+ * @ingroup gfx
+ *
+ * @param x1 One end
+ * @param x2 The other end
+ * @param y The row
+ * @param color The color
+ * @return true If anything was drawn
+ */
+extern bool gfx_hline(int x1, int x2, int y, gfx_color_t color);
+
+/**
+ * @brief Draw a line between two points (Bresenham).
+ * @ingroup gfx
+ *
+ * @param p1 One end
+ * @param p2 The other end
+ * @param color The color
+ * @return true If anything was drawn
+ */
+extern bool gfx_line(const gfx_point* p1, const gfx_point* p2, gfx_color_t color);
+
+/**
+ * @brief Draw the outline of a rectangle.
+ * @ingroup gfx
+ *
+ * @param rect The rectangle (includes both corner points)
+ * @param color The color
+ * @return true If anything was drawn
+ */
+extern bool gfx_rect_draw(const gfx_rect* rect, gfx_color_t color);
+
+/**
+ * @brief Fill a rectangle on the screen with a color.
+ * @ingroup gfx
+ *
+ * The rectangle includes both corner points, and is clipped.
+ *
+ * @param rect The rectangle
+ * @param color The color
+ * @return true If anything was filled
+ * @return false If the rectangle is off the screen (or there isn't a driver)
+ */
+extern bool gfx_rect_fill(const gfx_rect* rect, gfx_color_t color);
+
 /**
  * @brief Order the corner points such that `p1` is to the upper left.
  * @ingroup gfx
@@ -61,6 +218,28 @@ extern bool gfx_bounds_add_point(gfx_rect *bounds, gfx_point *p);
  */
 extern void gfx_rect_normalize(gfx_rect *rect);
 
+/**
+ * @brief Clear the whole screen to a color.
+ * @ingroup gfx
+ *
+ * @param color The color
+ * @return true If the screen was cleared
+ * @return false If there isn't a driver
+ */
+extern bool gfx_screen_clr(gfx_color_t color);
+
+/**
+ * @brief Draw a vertical line.
+ * @ingroup gfx
+ *
+ * @param x The column
+ * @param y1 One end
+ * @param y2 The other end
+ * @param color The color
+ * @return true If anything was drawn
+ */
+extern bool gfx_vline(int x, int y1, int y2, gfx_color_t color);
+
 #ifdef __cplusplus
     }
 #endif
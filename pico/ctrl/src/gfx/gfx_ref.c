@@ -0,0 +1,148 @@
+/**
+ * @brief Reference rasterizer for the graphics functions.
+ * @ingroup gfx
+ *
+ * Everything is drawn with `gfx_ref_pixel`.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "gfx_ref.h"
+
+#include <stdlib.h>
+
+void gfx_ref_bitmap_draw(gfx_ref_canvas_t* cv, const gfx_point* p, const gfx_bitmap_t* bm, gfx_color_t fg, gfx_color_t bg) {
+    int stride = GFX_BITMAP_STRIDE(bm->width);
+    for (int r = 0; r < bm->height; r++) {
+        for (int c = 0; c < bm->width; c++) {
+            bool set = (bm->bits[(r * stride) + (c >> 3)] & (0x80 >> (c & 7)));
+            gfx_color_t color = (set ? fg : bg);
+            if (color != GFX_COLOR_NONE) {
+                gfx_ref_pixel(cv, p->x + c, p->y + r, color);
+            }
+        }
+    }
+}
+
+void gfx_ref_circle_draw(gfx_ref_canvas_t* cv, const gfx_point* center, int radius, gfx_color_t color) {
+    if (radius < 0) {
+        return;
+    }
+    int cx = center->x;
+    int cy = center->y;
+    int x = 0;
+    int y = radius;
+    int d = 1 - radius;
+    while (x <= y) {
+        gfx_ref_pixel(cv, cx + x, cy + y, color);
+        gfx_ref_pixel(cv, cx - x, cy + y, color);
+        gfx_ref_pixel(cv, cx + x, cy - y, color);
+        gfx_ref_pixel(cv, cx - x, cy - y, color);
+        gfx_ref_pixel(cv, cx + y, cy + x, color);
+        gfx_ref_pixel(cv, cx - y, cy + x, color);
+        gfx_ref_pixel(cv, cx + y, cy - x, color);
+        gfx_ref_pixel(cv, cx - y, cy - x, color);
+        if (d < 0) {
+            d += (2 * x) + 3;
+        }
+        else {
+            d += (2 * (x - y)) + 5;
+            y--;
+        }
+        x++;
+    }
+}
+
+void gfx_ref_circle_fill(gfx_ref_canvas_t* cv, const gfx_point* center, int radius, gfx_color_t color) {
+    if (radius < 0) {
+        return;
+    }
+    int cx = center->x;
+    int cy = center->y;
+    int x = 0;
+    int y = radius;
+    int d = 1 - radius;
+    while (x <= y) {
+        gfx_ref_hline(cv, cx - x, cx + x, cy + y, color);
+        gfx_ref_hline(cv, cx - x, cx + x, cy - y, color);
+        gfx_ref_hline(cv, cx - y, cx + y, cy + x, color);
+        gfx_ref_hline(cv, cx - y, cx + y, cy - x, color);
+        if (d < 0) {
+            d += (2 * x) + 3;
+        }
+        else {
+            d += (2 * (x - y)) + 5;
+            y--;
+        }
+        x++;
+    }
+}
+
+void gfx_ref_hline(gfx_ref_canvas_t* cv, int x1, int x2, int y, gfx_color_t color) {
+    int step = (x1 <= x2 ? 1 : -1);
+    for (int x = x1; x != x2 + step; x += step) {
+        gfx_ref_pixel(cv, x, y, color);
+    }
+}
+
+void gfx_ref_line(gfx_ref_canvas_t* cv, const gfx_point* p1, const gfx_point* p2, gfx_color_t color) {
+    int x = p1->x;
+    int y = p1->y;
+    int dx = abs(p2->x - x);
+    int dy = -abs(p2->y - y);
+    int sx = (x < p2->x ? 1 : -1);
+    int sy = (y < p2->y ? 1 : -1);
+    int err = dx + dy;
+    while (true) {
+        gfx_ref_pixel(cv, x, y, color);
+        if (x == p2->x && y == p2->y) {
+            break;
+        }
+        int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += sx;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += sy;
+        }
+    }
+}
+
+void gfx_ref_pixel(gfx_ref_canvas_t* cv, int x, int y, gfx_color_t color) {
+    if (x < 0 || y < 0 || x >= cv->width || y >= cv->height
+        || x < cv->clip.p1.x || y < cv->clip.p1.y || x > cv->clip.p2.x || y > cv->clip.p2.y) {
+        return;
+    }
+    cv->px[(y * cv->width) + x] = (uint8_t)color;
+}
+
+void gfx_ref_rect_draw(gfx_ref_canvas_t* cv, const gfx_rect* rect, gfx_color_t color) {
+    gfx_rect r = *rect;
+    gfx_rect_normalize(&r);
+    for (int x = r.p1.x; x <= r.p2.x; x++) {
+        gfx_ref_pixel(cv, x, r.p1.y, color);
+        gfx_ref_pixel(cv, x, r.p2.y, color);
+    }
+    for (int y = r.p1.y; y <= r.p2.y; y++) {
+        gfx_ref_pixel(cv, r.p1.x, y, color);
+        gfx_ref_pixel(cv, r.p2.x, y, color);
+    }
+}
+
+void gfx_ref_rect_fill(gfx_ref_canvas_t* cv, const gfx_rect* rect, gfx_color_t color) {
+    gfx_rect r = *rect;
+    gfx_rect_normalize(&r);
+    for (int y = r.p1.y; y <= r.p2.y; y++) {
+        gfx_ref_hline(cv, r.p1.x, r.p2.x, y, color);
+    }
+}
+
+void gfx_ref_vline(gfx_ref_canvas_t* cv, int x, int y1, int y2, gfx_color_t color) {
+    int step = (y1 <= y2 ? 1 : -1);
+    for (int y = y1; y != y2 + step; y += step) {
+        gfx_ref_pixel(cv, x, y, color);
+    }
+}
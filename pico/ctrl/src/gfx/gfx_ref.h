@@ -0,0 +1,94 @@
+/**
+ * @brief Reference rasterizer for the graphics functions.
+ * @ingroup gfx
+ *
+ * Draws the same shapes as the `gfx` drawing functions, a pixel at a time into
+ * a memory canvas, each pixel clipped on its own. It is written to be simple
+ * rather than fast, so the span drawing in `gfx` can be checked against it,
+ * pixel for pixel. It doesn't use the SDK. It is built for the host tests
+ * (test_host/gfx_test.c), not the firmware.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef _GFX_REF_H_
+#define _GFX_REF_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "gfx.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief A canvas to draw on. Holds the low 8 bits of each pixel's color.
+ * @ingroup gfx
+ */
+typedef struct _gfx_ref_canvas_ {
+    uint16_t width;
+    uint16_t height;
+    uint8_t* px;        // width * height pixels, by row
+    gfx_rect clip;      // Clip rectangle (normalized, includes both corners)
+} gfx_ref_canvas_t;
+
+/**
+ * @brief Draw a bitmap (like `gfx_bitmap_draw`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_bitmap_draw(gfx_ref_canvas_t* cv, const gfx_point* p, const gfx_bitmap_t* bm, gfx_color_t fg, gfx_color_t bg);
+
+/**
+ * @brief Draw a circle (like `gfx_circle_draw`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_circle_draw(gfx_ref_canvas_t* cv, const gfx_point* center, int radius, gfx_color_t color);
+
+/**
+ * @brief Draw a filled circle (like `gfx_circle_fill`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_circle_fill(gfx_ref_canvas_t* cv, const gfx_point* center, int radius, gfx_color_t color);
+
+/**
+ * @brief Draw a horizontal line (like `gfx_hline`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_hline(gfx_ref_canvas_t* cv, int x1, int x2, int y, gfx_color_t color);
+
+/**
+ * @brief Draw a line (like `gfx_line`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_line(gfx_ref_canvas_t* cv, const gfx_point* p1, const gfx_point* p2, gfx_color_t color);
+
+/**
+ * @brief Plot a pixel, if it is in the clip rectangle and on the canvas.
+ * @ingroup gfx
+ */
+extern void gfx_ref_pixel(gfx_ref_canvas_t* cv, int x, int y, gfx_color_t color);
+
+/**
+ * @brief Draw the outline of a rectangle (like `gfx_rect_draw`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_rect_draw(gfx_ref_canvas_t* cv, const gfx_rect* rect, gfx_color_t color);
+
+/**
+ * @brief Fill a rectangle (like `gfx_rect_fill`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_rect_fill(gfx_ref_canvas_t* cv, const gfx_rect* rect, gfx_color_t color);
+
+/**
+ * @brief Draw a vertical line (like `gfx_vline`).
+ * @ingroup gfx
+ */
+extern void gfx_ref_vline(gfx_ref_canvas_t* cv, int x, int y1, int y2, gfx_color_t color);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // _GFX_REF_H_
@@ -13,6 +13,8 @@
 
 #include "board.h"
 #include "display/display.h"
+#include "display/disp_render.h"
+#include "display/disp_widget.h"
 #include "display/fonts/font.h"
 #include "neopix/neopix.h"
 #include "term/term.h"
@@ -28,18 +30,28 @@
 #define HID_SENSBANK_COL 1
 #define HID_SENSBANK_CHG_COLOR      C16_MAGENTA
 #define HID_SENSBANK_UNCHG_COLOR    C16_LT_BLUE
+#define HID_STATUS_PERIOD_MS 1000   // The status panel is checked each second (only changes are painted)
+#define HID_STATUS_ROW 8
+#define HID_STATUS_COLOR            C16_LT_GREEN
+#define HID_TEMP_COL 18
 
 // ############################################################################
 // Function Declarations
 // ############################################################################
 //
 static void _show_psa(proc_status_accum_t* psa, int corenum);
+static void _status_panel_update(void* data);
 
 
 // ############################################################################
 // Data
 // ############################################################################
 //
+static disp_widget_t _sensbank_ind[8];
+static disp_widget_t _core_busy_bar[2];
+static disp_widget_t _core_busy[2];
+static disp_widget_t _core_temp;
+static int16_t _core_temp_c10;     // Last temperature from core 0 (the ADC is read there)
 
 
 // ############################################################################
@@ -58,6 +70,16 @@ static void _disp_proc_status(void* data) {
     }
 }
 
+static void _status_panel_update(void* data) {
+    cmt_sleep_ms(HID_STATUS_PERIOD_MS, _status_panel_update, NULL);
+    for (int i = 0; i < 2; i++) {
+        proc_status_accum_t psa;
+        cmt_proc_status_sec(&psa, i);
+        disp_widget_set(&_core_busy_bar[i], psa.t_active);
+        disp_widget_set(&_core_busy[i], psa.t_active / 1000);  // Tenths of a percent
+    }
+}
+
 // ############################################################################
 // Internal Functions
 // ############################################################################
@@ -69,7 +91,7 @@ static void _show_psa(proc_status_accum_t* psa, int corenum) {
     long msg_t = psa->t_msg_longest;
     int interrupt_status = psa->interrupt_status;
     float busy = (float)active / 10000.0f; // Divide by 10,000 rather than 1,000,000 for percent
-    float core_temp = onboard_temp_c();
+    float core_temp = (float)_core_temp_c10 / 10.0f;
     printf("PSA %d: Active: % 3.2f%%\t At:%ld\tMR:%d\t Temp: %3.1f\t Msg: %03X Msgt: %ld\t Int:%08x\n", corenum, busy, active, retrieved, core_temp, msg_id, msg_t, interrupt_status);
 }
 
@@ -77,19 +99,23 @@ static void _show_psa(proc_status_accum_t* psa, int corenum) {
 // Public Functions
 // ############################################################################
 //
+void hid_update_core_temp(int16_t temp_c10) {
+    _core_temp_c10 = temp_c10;
+    disp_widget_set(&_core_temp, temp_c10);
+}
+
 void hid_update_sensbank(sensbank_chg_t sb) {
     // SensBank has 8 sensor bits. Display each as an open box if sensor off
     // or filled box if sensor on. Display as orange is the sensor has changed,
-    // display it as blue if it hasn't changed.
+    // display it as blue if it hasn't changed. Only the indicators that are
+    // different from what is shown are painted.
     uint8_t csv = sb.bits;
     uint8_t psv = sb.prev_bits;
     uint8_t bs = 0x80;
     for (int i = 0; i < 8; i++) {
         bool senson = (csv & bs) == 0;
-        uint8_t ind = senson ? CHKBOX_CHECKED_CHR : CHKBOX_UNCHECKED_CHR;
         colorn16_t fg = (csv & bs) == (psv & bs) ? HID_SENSBANK_UNCHG_COLOR : HID_SENSBANK_CHG_COLOR;
-        paint_control_t pc = i == 7 ? Paint : No_Paint;
-        disp_char_color(HID_SENSBANK_ROW, HID_SENSBANK_COL + (i * 2), ind, fg, HID_DISPLAY_BG, pc);
+        disp_widget_set_color(&_sensbank_ind[i], senson, fg, HID_DISPLAY_BG);
         bs = bs >> 1;
     }
 }
@@ -102,11 +128,23 @@ void hid_update_sensbank(sensbank_chg_t sb) {
 
 void hid_start(void) {
     // Setup the screen for the status display and a scroll area for messages.
-    disp_scroll_area_define(0, 0);
-    disp_text_colors_set(C16_LT_GREEN, C16_BLACK);
-    disp_clear(Paint);
-    disp_scroll_area_define(10, 5);
-    disp_cursor_home();
+    disp_render_scroll_area(0, 0);
+    disp_render_clear(C16_LT_GREEN, C16_BLACK);
+    disp_render_scroll_area(10, 5);
+    disp_render_cursor_set(0, 0);
+    //
+    // The status panel
+    for (int i = 0; i < 8; i++) {
+        disp_widget_indicator_init(&_sensbank_ind[i], HID_SENSBANK_ROW, HID_SENSBANK_COL + (i * 2),
+            CHKBOX_CHECKED_CHR, CHKBOX_UNCHECKED_CHR, HID_SENSBANK_UNCHG_COLOR, HID_DISPLAY_BG);
+    }
+    disp_widget_field_init(&_core_temp, HID_SENSBANK_ROW, HID_TEMP_COL, "T ", 5, 1, "C", HID_STATUS_COLOR, HID_DISPLAY_BG);
+    for (int i = 0; i < 2; i++) {
+        char label[] = "C0 ";
+        label[1] += i;
+        disp_widget_bar_init(&_core_busy_bar[i], HID_STATUS_ROW + i, HID_SENSBANK_COL, label, 10, 0, 1000000, HID_STATUS_COLOR, HID_DISPLAY_BG);
+        disp_widget_field_init(&_core_busy[i], HID_STATUS_ROW + i, HID_SENSBANK_COL + 14, NULL, 5, 1, "%", HID_STATUS_COLOR, HID_DISPLAY_BG);
+    }
     //
     // Start the Terminal
     term_start();
@@ -116,6 +154,8 @@ void hid_start(void) {
     //
     // Output status every 7 seconds
     cmt_sleep_ms(7000, _disp_proc_status, NULL);
+    // Keep the status panel up to date
+    cmt_sleep_ms(HID_STATUS_PERIOD_MS, _status_panel_update, NULL);
 }
 
 
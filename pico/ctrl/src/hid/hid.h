@@ -25,6 +25,14 @@ extern "C" {
  */
 extern void hid_update_sensbank(sensbank_chg_t sb);
 
+/**
+ * @brief Show the onboard temperature (as read on core 0).
+ * @ingroup hid
+ *
+ * @param temp_c10 The temperature in tenths of a degree Celsius
+ */
+extern void hid_update_core_temp(int16_t temp_c10);
+
 /**
  * @brief Starts the status display.
  * @ingroup hid
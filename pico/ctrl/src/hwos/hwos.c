@@ -31,6 +31,7 @@
 #include "pico/printf.h"
 
 #define _HWOS_STATUS_PULSE_PERIOD 6999
+#define _HWOS_TEMP_PERIOD 62    // Housekeeping ticks between onboard temperature reads (~1 second)
 
 static switch_id_t _sw_pressed = SW_NONE;
 static cmt_msg_t _sw_longpress_msg = { MSG_SW_LONGPRESS_DELAY, MSG_PRI_NORM };
@@ -76,6 +77,9 @@ static const msg_handler_entry_t* _hwos_handler_entries[] = {
     & _hwos_housekeeping,
     & cmt_sm_sleep_handler_entry,    // CMT Scheduled Message 'Sleep' handler
     & servo_rxd_handler_entry,
+    & servo_tx_done_handler_entry,
+    & servos_status_rcvd_handler_entry,
+    & servos_read_error_handler_entry,
     & _sensbank_chg_handler_entry,
     & _switch_action_handler_entry,
     & _switch_longpress_handler_entry,
@@ -116,6 +120,16 @@ static void _handle_hwos_housekeeping(cmt_msg_t* msg) {
     // Do cleanup, status updates, heartbeat, etc.
     if (_dcs_started) {
         curswitch_trigger_read();  // Read the switch banks
+        // The temperature is read here, as the ADC is shared with the switch
+        // banks, and posted to DCS for the status panel.
+        static int temp_cnt = 0;
+        if (++temp_cnt >= _HWOS_TEMP_PERIOD) {
+            temp_cnt = 0;
+            cmt_msg_t msg;
+            cmt_msg_init(&msg, MSG_CORE_TEMP);
+            msg.data.temp_c10 = (int16_t)(onboard_temp_c() * 10.0f);
+            postDCSMsgDiscardable(&msg);
+        }
     }
     servos_housekeeping();
     rover_housekeeping();
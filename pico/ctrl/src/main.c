@@ -21,6 +21,7 @@
 #include "hwos/hwos.h"
 //
 #include "display/display.h"
+#include "display/disp_render.h"
 #include"tests.h"
 
 //
@@ -90,10 +91,10 @@ int main()
 
     // How did we get here?!
     error_printf("hwctrl - Somehow we are out of our endless message loop in `main()`!!!");
-    disp_clear(true);
-    disp_string(1, 0, "!!!!!!!!!!!!!!!!", false, true);
-    disp_string(2, 0, "! OS LOOP EXIT !", false, true);
-    disp_string(3, 0, "!!!!!!!!!!!!!!!!", false, true);
+    disp_render_clear(C16_RED, C16_BLACK);
+    disp_render_string_color(1, 0, "!!!!!!!!!!!!!!!!", C16_RED, C16_BLACK);
+    disp_render_string_color(2, 0, "! OS LOOP EXIT !", C16_RED, C16_BLACK);
+    disp_render_string_color(3, 0, "!!!!!!!!!!!!!!!!", C16_RED, C16_BLACK);
     // ZZZ Reboot!!!
     return 0;
 }
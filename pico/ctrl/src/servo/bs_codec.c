@@ -0,0 +1,241 @@
+/**
+ * @brief Serial Bus Servo protocol codec.
+ * @ingroup servo
+ *
+ * The format of a Bus Servo command and a Bus Servo reply is:
+ * +------+------+------+------+------+------+------+------+-------|
+ * |   0  |   1  |   2  |   3  |   4  |  5     ...    LEN+2| LEN+3 |
+ * +------+------+------+------+------+------+------+------+-------|
+ * | 0x55 | 0x55 |  ID  |  LEN |  CMD | pd1    ...    pdN  |  CSUM |
+ * +------+------+------+------+------+------+------+------+-------|
+ * LEN = The length of the entire packet minus the 2 header bytes and the ID.
+ * CSUM = ~(ID + LEN + CMD + pd1 + ... + pdN) (low byte)
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "bs_codec.h"
+
+#include <string.h>
+
+#define BS_CMD_MAX_ BS_LED_ERROR_READ
+
+// ############################################################################
+// Data
+// ############################################################################
+//
+static const bs_cmd_desc_t _cmd_descs[BS_CMD_MAX_ + 1] = {
+    [BS_MOVE_TIME_WRITE]            = { BS_MOVE_TIME_WRITE,             BSL_MOVE,   BSL_NONE,   "MOVE_TIME_WRITE" },
+    [BS_MOVE_TIME_READ]             = { BS_MOVE_TIME_READ,              BSL_NONE,   BSL_MOVE,   "MOVE_TIME_READ" },
+    [BS_MOVE_TIME_WAIT_WRITE]       = { BS_MOVE_TIME_WAIT_WRITE,        BSL_MOVE,   BSL_NONE,   "MOVE_TIME_WAIT_WRITE" },
+    [BS_MOVE_TIME_WAIT_READ]        = { BS_MOVE_TIME_WAIT_READ,         BSL_NONE,   BSL_MOVE,   "MOVE_TIME_WAIT_READ" },
+    [BS_MOVE_START]                 = { BS_MOVE_START,                  BSL_NONE,   BSL_NONE,   "MOVE_START" },
+    [BS_MOVE_STOP]                  = { BS_MOVE_STOP,                   BSL_NONE,   BSL_NONE,   "MOVE_STOP" },
+    [BS_ID_WRITE]                   = { BS_ID_WRITE,                    BSL_U8,     BSL_NONE,   "ID_WRITE" },
+    [BS_ID_READ]                    = { BS_ID_READ,                     BSL_NONE,   BSL_U8,     "ID_READ" },
+    [BS_ANGLE_OFFSET_ADJUST]        = { BS_ANGLE_OFFSET_ADJUST,         BSL_S8,     BSL_NONE,   "ANGLE_OFFSET_ADJUST" },
+    [BS_ANGLE_OFFSET_WRITE]         = { BS_ANGLE_OFFSET_WRITE,          BSL_NONE,   BSL_NONE,   "ANGLE_OFFSET_WRITE" },
+    [BS_ANGLE_OFFSET_READ]          = { BS_ANGLE_OFFSET_READ,           BSL_NONE,   BSL_S8,     "ANGLE_OFFSET_READ" },
+    [BS_ANGLE_LIMIT_WRITE]          = { BS_ANGLE_LIMIT_WRITE,           BSL_LIMIT,  BSL_NONE,   "ANGLE_LIMIT_WRITE" },
+    [BS_ANGLE_LIMIT_READ]           = { BS_ANGLE_LIMIT_READ,            BSL_NONE,   BSL_LIMIT,  "ANGLE_LIMIT_READ" },
+    [BS_VIN_LIMIT_WRITE]            = { BS_VIN_LIMIT_WRITE,             BSL_LIMIT,  BSL_NONE,   "VIN_LIMIT_WRITE" },
+    [BS_VIN_LIMIT_READ]             = { BS_VIN_LIMIT_READ,              BSL_NONE,   BSL_LIMIT,  "VIN_LIMIT_READ" },
+    [BS_TEMP_MAX_LIMIT_WRITE]       = { BS_TEMP_MAX_LIMIT_WRITE,        BSL_U8,     BSL_NONE,   "TEMP_MAX_LIMIT_WRITE" },
+    [BS_TEMP_MAX_LIMIT_READ]        = { BS_TEMP_MAX_LIMIT_READ,         BSL_NONE,   BSL_U8,     "TEMP_MAX_LIMIT_READ" },
+    [BS_TEMP_READ]                  = { BS_TEMP_READ,                   BSL_NONE,   BSL_U8,     "TEMP_READ" },
+    [BS_VIN_READ]                   = { BS_VIN_READ,                    BSL_NONE,   BSL_U16,    "VIN_READ" },
+    [BS_POS_READ]                   = { BS_POS_READ,                    BSL_NONE,   BSL_S16,    "POS_READ" },
+    [BS_SERVO_OR_MOTOR_MODE_WRITE]  = { BS_SERVO_OR_MOTOR_MODE_WRITE,   BSL_MODE,   BSL_NONE,   "SERVO_OR_MOTOR_MODE_WRITE" },
+    [BS_SERVO_OR_MOTOR_MODE_READ]   = { BS_SERVO_OR_MOTOR_MODE_READ,    BSL_NONE,   BSL_MODE,   "SERVO_OR_MOTOR_MODE_READ" },
+    [BS_LOAD_OR_UNLOAD_WRITE]       = { BS_LOAD_OR_UNLOAD_WRITE,        BSL_U8,     BSL_NONE,   "LOAD_OR_UNLOAD_WRITE" },
+    [BS_LOAD_OR_UNLOAD_READ]        = { BS_LOAD_OR_UNLOAD_READ,         BSL_NONE,   BSL_U8,     "LOAD_OR_UNLOAD_READ" },
+    [BS_LED_CTRL_WRITE]             = { BS_LED_CTRL_WRITE,              BSL_U8,     BSL_NONE,   "LED_CTRL_WRITE" },
+    [BS_LED_CTRL_READ]              = { BS_LED_CTRL_READ,               BSL_NONE,   BSL_U8,     "LED_CTRL_READ" },
+    [BS_LED_ERROR_WRITE]            = { BS_LED_ERROR_WRITE,             BSL_U8,     BSL_NONE,   "LED_ERROR_WRITE" },
+    [BS_LED_ERROR_READ]             = { BS_LED_ERROR_READ,              BSL_NONE,   BSL_U8,     "LED_ERROR_READ" },
+};
+
+static const uint8_t _layout_lens[] = {
+    [BSL_NONE]  = 0,
+    [BSL_U8]    = 1,
+    [BSL_S8]    = 1,
+    [BSL_S16]   = 2,
+    [BSL_U16]   = 2,
+    [BSL_MOVE]  = 4,
+    [BSL_LIMIT] = 4,
+    [BSL_MODE]  = 4,
+};
+
+
+// ############################################################################
+// Local Routines
+// ############################################################################
+//
+
+/**
+ * @brief Encode a packet with the parameters in a layout.
+ */
+static size_t _encode(uint8_t* buf, size_t buf_len, uint8_t id, uint8_t cmd, bs_layout_t layout, const bs_params_t* params) {
+    uint8_t plen = _layout_lens[layout];
+    size_t len = BSPKT_LEN_FOR(plen);
+    if (len > buf_len || (plen && !params)) {
+        return (0);
+    }
+    uint8_t* p = &buf[BSPKT_DATA];
+    switch (layout) {
+        case BSL_NONE:
+            break;
+        case BSL_U8:
+            p[0] = params->u8;
+            break;
+        case BSL_S8:
+            p[0] = (uint8_t)params->s8;
+            break;
+        case BSL_S16:
+            p[0] = GET_LOW_BYTE((uint16_t)params->s16);
+            p[1] = GET_HIGH_BYTE((uint16_t)params->s16);
+            break;
+        case BSL_U16:
+            p[0] = GET_LOW_BYTE(params->u16);
+            p[1] = GET_HIGH_BYTE(params->u16);
+            break;
+        case BSL_MOVE:
+            p[0] = GET_LOW_BYTE((uint16_t)params->move.pos);
+            p[1] = GET_HIGH_BYTE((uint16_t)params->move.pos);
+            p[2] = GET_LOW_BYTE(params->move.time);
+            p[3] = GET_HIGH_BYTE(params->move.time);
+            break;
+        case BSL_LIMIT:
+            p[0] = GET_LOW_BYTE(params->limit.min);
+            p[1] = GET_HIGH_BYTE(params->limit.min);
+            p[2] = GET_LOW_BYTE(params->limit.max);
+            p[3] = GET_HIGH_BYTE(params->limit.max);
+            break;
+        case BSL_MODE:
+            p[0] = params->mode.mode;
+            p[1] = 0;
+            p[2] = GET_LOW_BYTE((uint16_t)params->mode.speed);
+            p[3] = GET_HIGH_BYTE((uint16_t)params->mode.speed);
+            break;
+    }
+    buf[BSPKT_HEADER1] = BS_FRAME_HEADER;
+    buf[BSPKT_HEADER2] = BS_FRAME_HEADER;
+    buf[BSPKT_ID] = id;
+    buf[BSPKT_LEN] = plen + 3;
+    buf[BSPKT_CMD] = cmd;
+    buf[BSPKT_DATA + plen] = bs_checksum(buf);
+
+    return (len);
+}
+
+/**
+ * @brief Validate a packet and unpack its parameters using the layout for the
+ * command from the descriptor (command or reply side).
+ */
+static bs_decode_status_t _decode(const uint8_t* pkt, size_t len, bool reply, bs_packet_t* out) {
+    if (len < BSPKT_LEN_FOR(0)) {
+        return (BSD_SHORT);
+    }
+    if (pkt[BSPKT_HEADER1] != BS_FRAME_HEADER || pkt[BSPKT_HEADER2] != BS_FRAME_HEADER) {
+        return (BSD_HEADER);
+    }
+    const bs_cmd_desc_t* desc = bs_cmd_desc(pkt[BSPKT_CMD]);
+    if (!desc || (reply && desc->reply_layout == BSL_NONE)) {
+        return (BSD_CMD);
+    }
+    bs_layout_t layout = (reply ? desc->reply_layout : desc->cmd_layout);
+    uint8_t plen = _layout_lens[layout];
+    if (pkt[BSPKT_LEN] != plen + 3) {
+        return (BSD_LEN);
+    }
+    if (len < BSPKT_LEN_FOR(plen)) {
+        return (BSD_SHORT);
+    }
+    if (bs_checksum(pkt) != pkt[BSPKT_DATA + plen]) {
+        return (BSD_CSUM);
+    }
+    const uint8_t* p = &pkt[BSPKT_DATA];
+    out->id = pkt[BSPKT_ID];
+    out->cmd = pkt[BSPKT_CMD];
+    memset(&out->params, 0, sizeof(bs_params_t));
+    switch (layout) {
+        case BSL_NONE:
+            break;
+        case BSL_U8:
+            out->params.u8 = p[0];
+            break;
+        case BSL_S8:
+            out->params.s8 = (int8_t)p[0];
+            break;
+        case BSL_S16:
+            out->params.s16 = (int16_t)BYTES_TO_WORD(p[1], p[0]);
+            break;
+        case BSL_U16:
+            out->params.u16 = BYTES_TO_WORD(p[1], p[0]);
+            break;
+        case BSL_MOVE:
+            out->params.move.pos = (int16_t)BYTES_TO_WORD(p[1], p[0]);
+            out->params.move.time = BYTES_TO_WORD(p[3], p[2]);
+            break;
+        case BSL_LIMIT:
+            out->params.limit.min = BYTES_TO_WORD(p[1], p[0]);
+            out->params.limit.max = BYTES_TO_WORD(p[3], p[2]);
+            break;
+        case BSL_MODE:
+            out->params.mode.mode = p[0];
+            out->params.mode.speed = (int16_t)BYTES_TO_WORD(p[3], p[2]);
+            break;
+    }
+
+    return (BSD_OK);
+}
+
+
+// ############################################################################
+// Public Methods
+// ############################################################################
+//
+
+const bs_cmd_desc_t* bs_cmd_desc(uint8_t cmd) {
+    if (cmd > BS_CMD_MAX_ || !_cmd_descs[cmd].name) {
+        return (NULL);
+    }
+    return (&_cmd_descs[cmd]);
+}
+
+uint8_t bs_layout_len(bs_layout_t layout) {
+    return (_layout_lens[layout]);
+}
+
+uint8_t bs_checksum(const uint8_t* pkt) {
+    uint16_t sum = 0;
+    for (int i = BSPKT_ID; i < pkt[BSPKT_LEN] + 2; i++) {
+        sum += pkt[i];
+    }
+    return ((uint8_t)~GET_LOW_BYTE(sum));
+}
+
+size_t bs_encode_cmd(uint8_t* buf, size_t buf_len, uint8_t id, uint8_t cmd, const bs_params_t* params) {
+    const bs_cmd_desc_t* desc = bs_cmd_desc(cmd);
+    if (!desc) {
+        return (0);
+    }
+    return (_encode(buf, buf_len, id, cmd, desc->cmd_layout, params));
+}
+
+size_t bs_encode_reply(uint8_t* buf, size_t buf_len, uint8_t id, uint8_t cmd, const bs_params_t* params) {
+    const bs_cmd_desc_t* desc = bs_cmd_desc(cmd);
+    if (!desc || desc->reply_layout == BSL_NONE) {
+        return (0);
+    }
+    return (_encode(buf, buf_len, id, cmd, desc->reply_layout, params));
+}
+
+bs_decode_status_t bs_decode_cmd(const uint8_t* pkt, size_t len, bs_packet_t* out) {
+    return (_decode(pkt, len, false, out));
+}
+
+bs_decode_status_t bs_decode_reply(const uint8_t* pkt, size_t len, bs_packet_t* out) {
+    return (_decode(pkt, len, true, out));
+}
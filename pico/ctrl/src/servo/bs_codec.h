@@ -0,0 +1,147 @@
+/**
+ * @brief Serial Bus Servo protocol codec.
+ * @ingroup servo
+ *
+ * Table driven encoding and decoding of the HiWonder Serial Bus Servo packets.
+ * Each command has a descriptor with the layout of the parameters it sends,
+ * and the layout of the parameters in its reply (for read commands).
+ *
+ * Encoding fills a caller supplied buffer. Decoding validates a packet
+ * (headers, length for the command, checksum) and unpacks the parameters
+ * into a `bs_params_t`.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef BS_CODEC_H_
+#define BS_CODEC_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "servo_t.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief The layouts of command and reply parameters.
+ *
+ * Multi-byte values are little-endian.
+ */
+typedef enum BS_LAYOUT_ {
+    BSL_NONE = 0,   // No parameters (for a reply: the command doesn't have one)
+    BSL_U8,         // params.u8
+    BSL_S8,         // params.s8
+    BSL_S16,        // params.s16
+    BSL_U16,        // params.u16
+    BSL_MOVE,       // params.move (pos, time)
+    BSL_LIMIT,      // params.limit (min, max)
+    BSL_MODE,       // params.mode (mode, 0, speed)
+} bs_layout_t;
+
+/**
+ * @brief Descriptor for a command.
+ */
+typedef struct BS_CMD_DESC_ {
+    uint8_t cmd;
+    bs_layout_t cmd_layout;     // Parameters sent
+    bs_layout_t reply_layout;   // Parameters in the reply (BSL_NONE = no reply)
+    const char* name;
+} bs_cmd_desc_t;
+
+/**
+ * @brief Result of decoding a packet.
+ */
+typedef enum BS_DECODE_STATUS_ {
+    BSD_OK = 0,
+    BSD_SHORT,      // Fewer bytes than the packet length says
+    BSD_HEADER,     // Missing the header bytes
+    BSD_LEN,        // LEN is wrong for the command
+    BSD_CMD,        // Unknown command, or a reply to a command that doesn't have one
+    BSD_CSUM,       // Bad checksum
+} bs_decode_status_t;
+
+/**
+ * @brief Get the descriptor for a command.
+ * @ingroup servo
+ *
+ * @param cmd The command (BS_xxx)
+ * @return const bs_cmd_desc_t* The descriptor or NULL if it isn't a valid command
+ */
+extern const bs_cmd_desc_t* bs_cmd_desc(uint8_t cmd);
+
+/**
+ * @brief Get the number of parameter bytes for a layout.
+ * @ingroup servo
+ *
+ * @param layout The layout
+ * @return uint8_t Bytes
+ */
+extern uint8_t bs_layout_len(bs_layout_t layout);
+
+/**
+ * @brief Generate the checksum for a packet.
+ * @ingroup servo
+ *
+ * The ID, LEN, CMD and parameters must be filled in.
+ *
+ * @param pkt The packet
+ * @return uint8_t The checksum
+ */
+extern uint8_t bs_checksum(const uint8_t* pkt);
+
+/**
+ * @brief Encode a command packet.
+ * @ingroup servo
+ *
+ * @param buf The buffer to encode into (BSPKT_PAYLOAD_MAX_LEN is always enough)
+ * @param buf_len The size of the buffer
+ * @param id The servo ID (or BS_BROADCAST_ID)
+ * @param cmd The command (BS_xxx)
+ * @param params The parameters (can be NULL for commands without parameters)
+ * @return size_t The length of the packet or 0 if the command is invalid or the buffer is too small
+ */
+extern size_t bs_encode_cmd(uint8_t* buf, size_t buf_len, uint8_t id, uint8_t cmd, const bs_params_t* params);
+
+/**
+ * @brief Encode a reply packet (as a servo would send it).
+ * @ingroup servo
+ *
+ * @param buf The buffer to encode into (BSPKT_PAYLOAD_MAX_LEN is always enough)
+ * @param buf_len The size of the buffer
+ * @param id The servo ID
+ * @param cmd The read command being replied to
+ * @param params The parameters
+ * @return size_t The length of the packet or 0 if the command doesn't have a reply or the buffer is too small
+ */
+extern size_t bs_encode_reply(uint8_t* buf, size_t buf_len, uint8_t id, uint8_t cmd, const bs_params_t* params);
+
+/**
+ * @brief Validate and decode a command packet (as a servo would receive it).
+ * @ingroup servo
+ *
+ * @param pkt The packet
+ * @param len The number of bytes available
+ * @param out The decoded packet (filled in if BSD_OK)
+ * @return bs_decode_status_t BSD_OK or the reason the packet isn't valid
+ */
+extern bs_decode_status_t bs_decode_cmd(const uint8_t* pkt, size_t len, bs_packet_t* out);
+
+/**
+ * @brief Validate and decode a reply packet.
+ * @ingroup servo
+ *
+ * @param pkt The packet
+ * @param len The number of bytes available
+ * @param out The decoded packet (filled in if BSD_OK)
+ * @return bs_decode_status_t BSD_OK or the reason the packet isn't valid
+ */
+extern bs_decode_status_t bs_decode_reply(const uint8_t* pkt, size_t len, bs_packet_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // BS_CODEC_H_
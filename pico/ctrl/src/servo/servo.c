@@ -19,319 +19,629 @@
  * +------+------+------+------+------+------+------+------+-------|
  * LEN = The length of the entire packet minus the 2 header bytes and the ID.
  *
+ * There can be more than one servo bus (SERVO_BUS_CNT). Bus 0 uses UART-1 and
+ * bus 1 uses a PIO UART. Each servo is assigned to a bus, and each bus has its
+ * own command queue, so commands on different buses are sent concurrently.
+ *
  * Copyright 2023-25 AESilky
  *
  * SPDX-License-Identifier: MIT
  */
 #include "servo.h"
+#include "bs_codec.h"
+#include "servo_sim.h"
 
 #include "board.h"
 #include "cmt/cmt.h"
 #include "system_defs.h"
 
-#include <string.h>
+#include "hardware/pio.h"
+#if !SERVO_BUS_SIM   // The simulated bus has no UART or PIO
+#include "servo_uart.pio.h"
+#endif
 
-//Macro function  get lower 8 bits of A
-#define GET_LOW_BYTE(A) (uint8_t)((A))
-//Macro function  get higher 8 bits of A
-#define GET_HIGH_BYTE(A) (uint8_t)((A) >> 8)
-//Macro Function  put A as higher 8 bits   B as lower 8 bits   which amalgamated into 16 bits integer
-#define BYTES_TO_WORD(A, B) ((((uint16_t)(A)) << 8) | (uint8_t)(B))
+#include <string.h>
 
 #define BS_BAUDRATE         115200
-#define BS_RXD_TIMEOUT_MS   20  // Timeout if no data received in 20ms (typ=600µs)
+#define BS_BYTE_US          87  // Time to send one byte (10 bits at 115200)
+#define BS_RXD_TIMEOUT_MS   20  // Max (and initial) reply timeout (typ reply=600µs)
+#define BS_RXD_TIMEOUT_MIN_MS 3 // Min reply timeout (the reply takes ~0.7ms to send)
+#define BS_OFFLINE_FAILS    3   // Consecutive timeouts before a servo is considered offline
+#define BS_OFFLINE_PROBE_MS 1000 // How often an offline servo is tried again
+#define BS_PING_TIMEOUT_MS  3   // Reply timeout for a ping (ID read of a servo that might not be there)
+#define BS_TXN_QUEUE_SIZE_  32  // Transactions that can be queued for a bus (start-up queues up to 3 per servo at once, a full queue is retried)
+#define BS_TX_POLL_US_      20  // Recheck time when the last byte is still being shifted out
 #define INPUT_BUF_SIZE_     16  // Needs to be a power of 2
 
-// ############################################################################
-// Bus Servo Commands
-// ############################################################################
-//
-#define BS_FRAME_HEADER                 0x55
-#define BS_MOVE_TIME_WRITE               1
-#define BS_MOVE_TIME_READ                2
-#define BS_MOVE_TIME_WAIT_WRITE          7
-#define BS_MOVE_TIME_WAIT_READ           8
-#define BS_MOVE_START                   11
-#define BS_MOVE_STOP                    12
-#define BS_ID_WRITE                     13
-#define BS_ID_READ                      14
-#define BS_ANGLE_OFFSET_ADJUST          17
-#define BS_ANGLE_OFFSET_WRITE           18
-#define BS_ANGLE_OFFSET_READ            19
-#define BS_ANGLE_LIMIT_WRITE            20
-#define BS_ANGLE_LIMIT_READ             21
-#define BS_VIN_LIMIT_WRITE              22
-#define BS_VIN_LIMIT_READ               23
-#define BS_TEMP_MAX_LIMIT_WRITE         24
-#define BS_TEMP_MAX_LIMIT_READ          25
-#define BS_TEMP_READ                    26
-#define BS_VIN_READ                     27
-#define BS_POS_READ                     28
-#define BS_SERVO_OR_MOTOR_MODE_WRITE    29
-#define BS_SERVO_OR_MOTOR_MODE_READ     30
-#define BS_LOAD_OR_UNLOAD_WRITE         31
-#define BS_LOAD_OR_UNLOAD_READ          32
-#define BS_LED_CTRL_WRITE               33
-#define BS_LED_CTRL_READ                34
-#define BS_LED_ERROR_WRITE              35
-#define BS_LED_ERROR_READ               36
-
-#define BSS_CHKSUM_OFF 3  // 3 more than the data length
+/**
+ * @brief State of a servo bus.
+ */
+typedef enum BS_BUS_STATE_ {
+    BSBUS_IDLE,     // Nothing is being sent or received
+    BSBUS_TX,       // A command is being sent
+    BSBUS_RX,       // Waiting for the reply to a read command
+} bs_bus_state_t;
+
+/**
+ * @brief A command to be sent on a servo bus.
+ */
+typedef struct BS_TXN_ {
+    servo_t* servo;                 // Servo to receive the reply into (SERVO_NONE for an action command)
+    uint8_t timeout_ms;             // Reply timeout for a ping (0 = the servo's adaptive timeout)
+    uint8_t len;
+    uint8_t pkt[BSPKT_PAYLOAD_MAX_LEN];
+} bs_txn_t;
+
+/**
+ * @brief A servo bus.
+ *
+ * Each bus is a half-duplex line with its own UART (hardware or PIO), TX
+ * enable, transaction queue and receive buffer, so the buses run
+ * independently of each other. Sending is done without blocking - the
+ * UART/PIO FIFO is filled and an alarm checks for the command having been
+ * sent, at which point TX is disabled and RX is enabled (if a reply is
+ * expected).
+ */
+typedef struct SERVO_BUS_ {
+    uint8_t num;
+    uart_inst_t* uart;              // Hardware UART (NULL if the bus uses a PIO UART)
+    PIO pio;
+    uint sm_tx;
+    uint sm_rx;
+    uint tx_en_gpio;
+    uint irq;
+    volatile bs_bus_state_t state;
+    bs_txn_t queue[BS_TXN_QUEUE_SIZE_];
+    uint8_t q_in;
+    uint8_t q_out;
+    bs_txn_t cur;                   // The transaction in progress
+    uint8_t tx_off;                 // Bytes of the current command put in the FIFO
+    uint8_t reads_queued;
+    servo_t* in_proc;               // Servo a reply is being received for
+    uint16_t seq;                   // Transaction sequence number
+    volatile uint8_t input_buf[INPUT_BUF_SIZE_];
+    volatile uint16_t input_buf_in;
+    volatile uint16_t input_buf_out;
+    volatile bool input_buf_overflow;
+    volatile bool rx_enabled;
+    volatile uint64_t rxd_last_us;  // Time the last byte was received
+    volatile uint64_t txd_done_us;  // Time the last command finished sending
+    cmt_msg_t msg_rxd_to;
+    servo_bus_stats_t stats;
+} servo_bus_t;
 
 
 // ############################################################################
 // Function Declarations
 // ############################################################################
 //
-typedef void (*servo_vv_func)(void);
-inline static bool _rxd_input_available(void);
-static void _rxd_discard();
-static void _rxd_stash(uint8_t ch);
-static void _rxd_status_asm_cont();
+static void _bus_next(servo_bus_t* bus);
+static void _latency_fail(servo_bus_t* bus, servo_t* servo);
+static void _latency_sample(servo_bus_t* bus, servo_t* servo, int32_t latency_us);
+static void _rx_disable(servo_bus_t* bus);
+static void _rx_drain(servo_bus_t* bus);
+static void _rx_enable(servo_bus_t* bus);
+static void _rxd_clear(servo_bus_t* bus);
+inline static bool _rxd_input_available(servo_bus_t* bus);
+static void _rxd_stash(servo_bus_t* bus, uint8_t ch);
 static void _rxd_status_clr(servo_t* rxs);
-static bs_rx_status_t* _store_bs_status(bs_rx_status_t* bs_status);
-static void _uart_drain();
-static void _uart_intr_disable();
-static void _uart_intr_enable();
-static void _write_bs(const uint8_t* buf);
+static int64_t _tx_done_alarm(alarm_id_t id, void* user_data);
 
 // ############################################################################
 // Data
 // ############################################################################
 //
-auto_init_mutex(tx_mutex);
-
-static char _input_buf[INPUT_BUF_SIZE_];
-static bool _input_buf_overflow = false;
-static uint16_t _input_buf_in = 0;
-static uint16_t _input_buf_out = 0;
+static servo_bus_t _buses[SERVO_BUS_CNT];
 
-static servo_t *_servo_in_proc;
+/** @brief Scheduled message IDs for the bus reply timeouts (cancelled by ID) */
+static const msg_id_t _rxd_to_msg_ids[] = { MSG_SERVO_DATA_RX_TO, MSG_SERVO_DATA_RX_TO_B1 };
 
-static cmt_msg_t _msg_rxd_to;
-static servo_vv_func _rxd_handler;
+#if SERVO_BUS_CNT > 1 && !SERVO_BUS_SIM
+static uint _pio_irq;
+#endif
 
-static bool _tx_enabled;
 
 // ############################################################################
 // Interrupt Service Routines
 // ############################################################################
 //
+/**
+ * @brief Hardware UART receive ISR (bus 0 is the only bus with a hardware UART).
+ */
 void _on_uart_rx() {
-    while (uart_is_readable(SERVO_CTRL_UART)) {
-        uint8_t c = uart_getc(SERVO_CTRL_UART);
-        _rxd_stash(c);
+    servo_bus_t* bus = &_buses[0];
+    while (uart_is_readable(bus->uart)) {
+        uint8_t c = uart_getc(bus->uart);
+        _rxd_stash(bus, c);
     }
 }
 
+#if SERVO_BUS_CNT > 1
+static void _on_pio_rx() {
+    for (int i = 0; i < SERVO_BUS_CNT; i++) {
+        servo_bus_t* bus = &_buses[i];
+        if (bus->uart) {
+            continue;
+        }
+        while (!pio_sm_is_rx_fifo_empty(bus->pio, bus->sm_rx)) {
+            // The PIO UART puts the byte in the upper 8 bits
+            uint8_t c = (uint8_t)(pio_sm_get(bus->pio, bus->sm_rx) >> 24);
+            if (bus->rx_enabled) {
+                _rxd_stash(bus, c);
+            }
+        }
+    }
+}
+#endif
+
+#if SERVO_BUS_SIM
+/**
+ * @brief Receive a byte from the simulated bus (called from the sim alarm).
+ *
+ * Bytes that arrive while 'interrupts' are disabled are dropped, the same as
+ * the UART drain does with the FIFO before receive is enabled.
+ */
+static void _on_sim_rx(uint8_t busnum, uint8_t ch) {
+    if (busnum < SERVO_BUS_CNT && _buses[busnum].rx_enabled) {
+        _rxd_stash(&_buses[busnum], ch);
+    }
+}
+#endif
+
 
 // ############################################################################
 // Local Routines
 // ############################################################################
 //
 
-static uint8_t _gen_checksum(uint8_t buf[]) {
-    uint8_t i;
-    uint16_t sum = 0;
-    for (i = 2; i < buf[3] + 2; i++) {
-        sum += buf[i];
+/**
+ * @brief Indicates that the bus hardware is still sending.
+ *
+ * True until the last bit of the last byte has been shifted out (the FIFO
+ * being empty isn't enough, as the shift register still holds a byte).
+ */
+static bool _bus_tx_busy(servo_bus_t* bus) {
+#if SERVO_BUS_SIM
+    return (servo_sim_bus_sending(bus->num));
+#else
+    if (bus->uart) {
+        return (uart_get_hw(bus->uart)->fr & UART_UARTFR_BUSY_BITS);
     }
-    i = GET_LOW_BYTE(sum);
-    i = ~i;
+    // The PIO TX program stalls on its 'pull' once the FIFO is empty and the
+    // last byte is out.
+    return (!pio_sm_is_tx_fifo_empty(bus->pio, bus->sm_tx)
+        || !(bus->pio->fdebug & (1u << (PIO_FDEBUG_TXSTALL_LSB + bus->sm_tx))));
+#endif
+}
 
-    return i;
+/**
+ * @brief Put as much of the current command into the bus TX FIFO as will fit.
+ */
+static void _bus_tx_fill(servo_bus_t* bus) {
+#if SERVO_BUS_SIM
+    servo_sim_bus_write(bus->num, &bus->cur.pkt[bus->tx_off], bus->cur.len - bus->tx_off);
+    bus->tx_off = bus->cur.len;
+#else
+    while (bus->tx_off < bus->cur.len) {
+        uint8_t b = bus->cur.pkt[bus->tx_off];
+        if (bus->uart) {
+            if (!uart_is_writable(bus->uart)) {
+                break;
+            }
+            uart_putc_raw(bus->uart, (char)b);
+        }
+        else {
+            if (pio_sm_is_tx_fifo_full(bus->pio, bus->sm_tx)) {
+                break;
+            }
+            pio_sm_put(bus->pio, bus->sm_tx, b);
+        }
+        bus->tx_off++;
+    }
+#endif
 }
 
-static void _post_servo_error_msg(servo_t *servo) {
+/**
+ * @brief Start the next queued transaction on a bus, if there is one and the
+ * bus is idle.
+ *
+ * The TX driver is enabled, the command is put into the FIFO, and an alarm is
+ * set for when it should have been sent. Nothing waits here, unless an alarm
+ * can't be had - then the end of the command is waited for here, so the bus
+ * doesn't stay in TX.
+ *
+ * @param bus The bus
+ */
+static void _bus_next(servo_bus_t* bus) {
+    if (bus->state != BSBUS_IDLE || bus->q_out == bus->q_in) {
+        return;
+    }
+    bus->cur = bus->queue[bus->q_out];
+    bus->q_out = (bus->q_out + 1) % BS_TXN_QUEUE_SIZE_;
+    bus->tx_off = 0;
+    bus->seq++;
+    servo_t* servo = bus->cur.servo;
+    if (servo) {
+        bus->reads_queued--;
+        _rxd_status_clr(servo);
+        servo->_rxstatus.pending = true;
+        bus->in_proc = servo;
+        bus->stats.reads++;
+    }
+    else {
+        bus->stats.actions++;
+    }
+    bus->state = BSBUS_TX;
+    _rx_disable(bus);
+    gpio_put(bus->tx_en_gpio, SERVO_CTRL_TX_EN);  // Enable the TX output to the bus.
+    if (!SERVO_BUS_SIM && !bus->uart) {
+        // Clear the 'TX stalled' flag so it indicates the end of this command.
+        bus->pio->fdebug = (1u << (PIO_FDEBUG_TXSTALL_LSB + bus->sm_tx));
+    }
+    _bus_tx_fill(bus);
+    // A result of 0 is the alarm having been done (it was already time).
+    if (add_alarm_in_us(bus->cur.len * BS_BYTE_US, _tx_done_alarm, bus, true) < 0) {
+        bus->stats.tx_inline++;
+        int64_t us = bus->cur.len * BS_BYTE_US;
+        do {
+            busy_wait_us((uint64_t)us);
+        } while ((us = _tx_done_alarm(0, bus)) > 0);
+    }
+}
+
+/**
+ * @brief Queue a command to be sent on a bus.
+ *
+ * The command packet is encoded directly into the queue entry.
+ *
+ * @param bus The bus
+ * @param servo The servo to receive the reply into, or SERVO_NONE for an action
+ * @param id The servo ID the command is for
+ * @param cmd The command
+ * @param params The command parameters (NULL if the command doesn't have any)
+ * @param timeout_ms Reply timeout to use instead of the servo's adaptive timeout (0 = adaptive)
+ * @return true The command was queued
+ * @return false The bus queue is full (or the command is invalid)
+ */
+static bool _bus_submit(servo_bus_t* bus, servo_t* servo, uint8_t id, uint8_t cmd, const bs_params_t* params, uint8_t timeout_ms) {
+    uint8_t next = (bus->q_in + 1) % BS_TXN_QUEUE_SIZE_;
+    if (next == bus->q_out) {
+        bus->stats.queue_full++;
+        return false;
+    }
+    bs_txn_t* txn = &bus->queue[bus->q_in];
+    txn->len = (uint8_t)bs_encode_cmd(txn->pkt, sizeof(txn->pkt), id, cmd, params);
+    if (txn->len == 0) {
+        return false;
+    }
+    txn->servo = servo;
+    txn->timeout_ms = timeout_ms;
+    bus->q_in = next;
+    if (servo) {
+        servo->_rxstatus.queued = true;
+        bus->reads_queued++;
+    }
+    _bus_next(bus);
+
+    return true;
+}
+
+/**
+ * @brief Finish the transaction in progress on a bus and start the next.
+ */
+static void _bus_txn_done(servo_bus_t* bus) {
+    scheduled_msg_cancel(bus->msg_rxd_to.id);
+    _rx_disable(bus);
+    _rxd_clear(bus);
+    if (bus->in_proc) {
+        bus->in_proc->_rxstatus.queued = false;
+    }
+    bus->in_proc = SERVO_NONE;
+    bus->state = BSBUS_IDLE;
+    _bus_next(bus);
+}
+
+static void _post_servo_error_msg(servo_bus_t* bus, servo_t *servo) {
     if (servo) {
         _rxd_status_clr(servo);
         // Indicate that we encountered an error with this servo
-        uint8_t id = servo->id;
         cmt_msg_t msg;
         cmt_msg_init(&msg, MSG_SERVO_READ_ERROR);
-        msg.data.servo_params.servo_id = id;
+        msg.data.servo_params.servo_id = servo->id;
+        msg.data.servo_params.bus = bus->num;
         postHWCtrlMsg(&msg);
-        _servo_in_proc = SERVO_NONE;
     }
 }
 
-static void _rxd_clear() {
-    _input_buf_in = _input_buf_out = 0;
-    _input_buf_overflow = false;
+/**
+ * @brief Record a failure of a servo to reply.
+ *
+ * The timeout is backed off (doubled) in case the servo is just slow, and after
+ * several failures in a row the servo is marked offline so that reads to it are
+ * skipped, other than an occasional probe. A servo that doesn't answer a ping
+ * is marked offline right away.
+ *
+ * @param bus The bus the servo is on
+ * @param servo The servo that didn't reply
+ */
+static void _latency_fail(servo_bus_t* bus, servo_t* servo) {
+    bs_latency_t* lat = &servo->_latency;
+    lat->timeouts++;
+    bus->stats.timeouts++;
+    if (bus->cur.timeout_ms) {
+        // A ping. The servo isn't there, so don't wait for it to fail a few more times.
+        bus->stats.timeout_wait_ms += bus->cur.timeout_ms;
+        lat->fails = BS_OFFLINE_FAILS;
+        lat->offline = true;
+        lat->probe_ms = now_ms() + BS_OFFLINE_PROBE_MS;
+        return;
+    }
+    bus->stats.timeout_wait_ms += servo_reply_timeout_ms(servo);
+    if (lat->fails < UINT8_MAX) {
+        lat->fails++;
+    }
+    uint16_t to = servo_reply_timeout_ms(servo) * 2;
+    lat->timeout_ms = (to > BS_RXD_TIMEOUT_MS ? BS_RXD_TIMEOUT_MS : to);
+    if (lat->fails >= BS_OFFLINE_FAILS) {
+        if (!lat->offline) {
+            warn_printf("Servo %hhu is not replying - marked offline.\n", servo->id);
+        }
+        lat->offline = true;
+        lat->probe_ms = now_ms() + BS_OFFLINE_PROBE_MS;
+    }
 }
 
-static int _rxd_getc(void) {
-    if (!_rxd_input_available()) {
-        return (-1);
+/**
+ * @brief Add a reply latency measurement for a servo and update its timeout.
+ *
+ * Keeps a moving average of the latency and of its mean deviation
+ * (gain 1/8 and 1/4) and sets the timeout to the average plus four times the
+ * deviation, bounded by the floor and ceiling. The timeout is in whole
+ * milliseconds (the scheduled message resolution), rounded up plus one to
+ * cover the scheduler's tick granularity.
+ *
+ * @param bus The bus the servo is on
+ * @param servo The servo that replied
+ * @param latency_us The time from the end of the command to the end of the reply
+ */
+static void _latency_sample(servo_bus_t* bus, servo_t* servo, int32_t latency_us) {
+    bs_latency_t* lat = &servo->_latency;
+    if (lat->replies == 0) {
+        lat->srtt_x8 = latency_us << 3;
+        lat->rttvar_x4 = (latency_us >> 1) << 2;
+    }
+    else {
+        int32_t err = latency_us - (lat->srtt_x8 >> 3);
+        lat->srtt_x8 += err;
+        if (err < 0) {
+            err = -err;
+        }
+        lat->rttvar_x4 += err - (lat->rttvar_x4 >> 2);
+    }
+    int32_t to_us = (lat->srtt_x8 >> 3) + lat->rttvar_x4;
+    int32_t to_ms = ((to_us + 999) / 1000) + 1;
+    if (to_ms < BS_RXD_TIMEOUT_MIN_MS) {
+        to_ms = BS_RXD_TIMEOUT_MIN_MS;
+    }
+    if (to_ms > BS_RXD_TIMEOUT_MS) {
+        to_ms = BS_RXD_TIMEOUT_MS;
     }
-    int c = (int)_input_buf[_input_buf_out];
-    _input_buf_out = (_input_buf_out + 1) % INPUT_BUF_SIZE_;
+    lat->timeout_ms = (uint16_t)to_ms;
+    lat->replies++;
+    lat->fails = 0;
+    if (lat->offline) {
+        info_printf("Servo %hhu is replying - back online.\n", servo->id);
+    }
+    lat->offline = false;
+    bus->stats.replies++;
+}
 
-    return (c);
+/**
+ * @brief Disable receiving on a bus.
+ */
+static void _rx_disable(servo_bus_t* bus) {
+    bus->rx_enabled = false;
+#if !SERVO_BUS_SIM   // The simulated bus has no UART or PIO
+    if (bus->uart) {
+        uart_set_irq_enables(bus->uart, false, false);
+    }
+#if SERVO_BUS_CNT > 1
+    else {
+        pio_set_irqn_source_enabled(bus->pio, _pio_irq - pio_get_irq_num(bus->pio, 0),
+            pio_get_rx_fifo_not_empty_interrupt_source(bus->sm_rx), false);
+    }
+#endif
+#endif
 }
 
-inline static bool _rxd_input_available() {
-    return (_input_buf_in != _input_buf_out);
+/**
+ * @brief Read all available data from the bus UART and discard it.
+ */
+static void _rx_drain(servo_bus_t* bus) {
+#if !SERVO_BUS_SIM   // The simulated bus has no UART or PIO
+    // Clear any 'junk' (our own command echoed back) out of the UART.
+    if (bus->uart) {
+        while (uart_is_readable(bus->uart)) {
+            uart_getc(bus->uart);
+        }
+    }
+    else {
+        while (!pio_sm_is_rx_fifo_empty(bus->pio, bus->sm_rx)) {
+            pio_sm_get(bus->pio, bus->sm_rx);
+        }
+    }
+#endif
 }
 
-static bool _rxd_overflowed() {
-    bool retval = _input_buf_overflow;
-    _input_buf_overflow = false;
+/**
+ * @brief Enable receiving on a bus. This first drains the RX FIFO.
+ *
+ * Can be called from interrupt context.
+ */
+static void _rx_enable(servo_bus_t* bus) {
+    _rx_drain(bus); // Remove all data before enabling interrupts
+    bus->rx_enabled = true;
+#if !SERVO_BUS_SIM   // The simulated bus has no UART or PIO
+    if (bus->uart) {
+        // Enable the UART to send interrupts - RX only
+        uart_set_irq_enables(bus->uart, true, false);
+    }
+#if SERVO_BUS_CNT > 1
+    else {
+        pio_set_irqn_source_enabled(bus->pio, _pio_irq - pio_get_irq_num(bus->pio, 0),
+            pio_get_rx_fifo_not_empty_interrupt_source(bus->sm_rx), true);
+    }
+#endif
+#endif
+}
 
-    return (retval);
+static void _rxd_clear(servo_bus_t* bus) {
+    bus->input_buf_in = bus->input_buf_out = 0;
+    bus->input_buf_overflow = false;
 }
 
-static void _rxd_stash(uint8_t ch) {
+static int _rxd_getc(servo_bus_t* bus) {
+    if (!_rxd_input_available(bus)) {
+        return (-1);
+    }
+    int c = (int)bus->input_buf[bus->input_buf_out];
+    bus->input_buf_out = (bus->input_buf_out + 1) % INPUT_BUF_SIZE_;
+
+    return (c);
+}
+
+inline static bool _rxd_input_available(servo_bus_t* bus) {
+    return (bus->input_buf_in != bus->input_buf_out);
+}
+
+static void _rxd_stash(servo_bus_t* bus, uint8_t ch) {
     // Called from an ISR - make it quick!
     //
+    bus->rxd_last_us = now_us();
     // See if we have room for it in the input buffer
-    if (((_input_buf_in + 1) % INPUT_BUF_SIZE_) == _input_buf_out) {
+    if (((bus->input_buf_in + 1) % INPUT_BUF_SIZE_) == bus->input_buf_out) {
         // No room. Just throw it away.
-        _input_buf_overflow = true;
+        bus->input_buf_overflow = true;
     }
     else {
         bool post_msg = false;
         // If this is the first character going into the buffer
         // post a message so others know that data is available.
-        if (_input_buf_in == _input_buf_out) {
+        if (bus->input_buf_in == bus->input_buf_out) {
             post_msg = true;
         }
         // Store it, then continue reading
-        _input_buf[_input_buf_in] = (char)ch;
-        _input_buf_in = (_input_buf_in + 1) % INPUT_BUF_SIZE_;
+        bus->input_buf[bus->input_buf_in] = ch;
+        bus->input_buf_in = (bus->input_buf_in + 1) % INPUT_BUF_SIZE_;
         // Post a message?
         if (post_msg) {
             cmt_msg_t msg;
             cmt_msg_init(&msg, MSG_SERVO_DATA_RCVD);
+            msg.data.servo_params.bus = bus->num;
             postHWCtrlMsg(&msg);
         }
     }
 }
 
 /**
- * @brief Begin a Status Read Operation if possible.
- * @ingroup servo
- * 
- * This checks to see if we are already waiting for an inbound message,
- * and if so, it returns `false`. If not, it enters into the 'tx_mutex'
- * and sets everything up to be ready to receive the response.
- * 
- * !!! Enters the 'tx_mutex' and doesn't exit it if successful !!!
- * 
- * @param servo The servo to collect the response into.
- * @return true Ready to receive a response.
- * @return false Already waiting for a response.
+ * @brief Assemble the reply to a read from the received data.
+ *
+ * When a complete packet (good or bad) has been received, the result is
+ * posted and the next transaction on the bus is started.
+ *
+ * @param bus The bus data was received on
  */
-static bool _rxd_status_asm_bgn(servo_t *servo) {
-    // If we are waiting for a status data packet, indicate that we can't begin...
-    if (servo_status_inbound_pending()) {
-        return false;
+static void _rxd_status_asm_cont(servo_bus_t* bus) {
+    servo_t* servo = bus->in_proc;
+    if (bus->state == BSBUS_TX && servo) {
+        return;  // The reply is early. The TX done handler will take it from here.
     }
-    // Enter into Mutex protected area!
-    mutex_enter_blocking(&tx_mutex);
-
-    // Clear any pending Status Read timeout message.
-    servo_t* pending = _servo_in_proc;
-    _servo_in_proc = SERVO_NONE;
-    if (pending) {
-        _rxd_status_clr(pending);
-    }
-    _rxd_status_clr(servo);
-    servo->_rxstatus.pending = true;
-    _servo_in_proc = servo;
-    scheduled_msg_cancel(MSG_SERVO_DATA_RX_TO);
-    _rxd_clear();
-    _rxd_handler = _rxd_status_asm_cont;
-    schedule_core0_msg_in_ms(BS_RXD_TIMEOUT_MS, &_msg_rxd_to);
-
-    return (true);
-}
-
-static void _rxd_status_asm_cont() {
-    // We have been notified that data has been received from the servos.
-    if (!servo_status_inbound_pending()) {
-        // We aren't expecting anything. Set our receive function
-        // to discard and slurp up any inbound data.
-        _uart_intr_disable();
-        _rxd_handler = _rxd_discard;
-        _rxd_clear();
+    if (bus->state != BSBUS_RX || !servo) {
+        // We aren't expecting anything. Discard any inbound data.
+        _rxd_clear(bus);
         return;
     }
+    bs_rx_status_t* rxs = &servo->_rxstatus;
     int ch;
-    while ((ch = _rxd_getc()) >= 0) {
+    while ((ch = _rxd_getc(bus)) >= 0) {
         // Put the data into the status packet
-        _servo_in_proc->_rxstatus.buf[_servo_in_proc->_rxstatus.data_off++] = ch;
-        if (!_servo_in_proc->_rxstatus.frame_started) {
+        if (rxs->data_off >= BSPKT_PAYLOAD_MAX_LEN) {
+            // Something was wrong with this packet.
+            _post_servo_error_msg(bus, servo);
+            _bus_txn_done(bus);
+            return;
+        }
+        rxs->buf[rxs->data_off++] = ch;
+        if (!rxs->frame_started) {
             // We are looking for the HEADER bytes
             if (ch == BS_FRAME_HEADER) {
                 // Receiving 2 header bytes in a row signals the start of a frame.
-                if (_servo_in_proc->_rxstatus.data_off == 2) {
-                    _servo_in_proc->_rxstatus.frame_started = true;
-                    scheduled_msg_cancel(MSG_SERVO_DATA_RX_TO);
+                if (rxs->data_off == 2) {
+                    rxs->frame_started = true;
                 }
             }
             else {
-                _servo_in_proc->_rxstatus.frame_started = false;
-                _servo_in_proc->_rxstatus.data_off = 0;
+                rxs->frame_started = false;
+                rxs->data_off = 0;
             }
         }
         else {
-            if (_servo_in_proc->_rxstatus.data_off == BSPKT_LEN + 1) {
-                _servo_in_proc->_rxstatus.len = ch;
-                if (ch < 3) {
+            if (rxs->data_off == BSPKT_LEN + 1) {
+                rxs->len = ch;
+                if (ch < 3 || ch > BSPKT_PARAMS_MAX + 3) {
                     // Something was wrong with this packet.
-                    _rxd_status_clr(_servo_in_proc);
-                    break;
+                    _post_servo_error_msg(bus, servo);
+                    _bus_txn_done(bus);
+                    return;
                 }
             }
-            else if (_servo_in_proc->_rxstatus.data_off > BSPKT_LEN) {
-                if (_servo_in_proc->_rxstatus.data_off > BSPKT_PAYLOAD_MAX_LEN) {
-                    // Something was wrong with this packet.
-                    _rxd_status_clr(_servo_in_proc);
-                    break;
-                }
-                if (_servo_in_proc->_rxstatus.data_off == (_servo_in_proc->_rxstatus.len + BSS_CHKSUM_OFF)) {
-                    // Compare the checksums
-                    if (_gen_checksum(_servo_in_proc->_rxstatus.buf) == _servo_in_proc->_rxstatus.buf[_servo_in_proc->_rxstatus.data_off - 1]) {
+            else if (rxs->data_off > BSPKT_LEN) {
+                if (rxs->data_off == (rxs->len + 3)) {
+                    // Validate and unpack it. It must be the reply to the command sent.
+                    bs_packet_t reply;
+                    if (bs_decode_reply(rxs->buf, rxs->data_off, &reply) == BSD_OK
+                        && reply.cmd == bus->cur.pkt[BSPKT_CMD]
+                        && (reply.id == servo->id || servo->id == BS_BROADCAST_ID)) {
                         // All is good.
-                        _rxd_handler = _rxd_discard;  // Discard any additional received data
-                        _servo_in_proc->_rxstatus.pending = false;
+                        rxs->reply = reply;
+                        rxs->pending = false;
+                        _latency_sample(bus, servo, (int32_t)(bus->rxd_last_us - bus->txd_done_us));
                         // Post a message with the status
                         cmt_msg_t msg;
                         cmt_msg_init(&msg, MSG_SERVO_STATUS_RCVD);
-                        msg.data.servo_params.servo_id = _servo_in_proc->id;
+                        msg.data.servo_params.servo_id = servo->id;
+                        msg.data.servo_params.bus = bus->num;
                         postHWCtrlMsg(&msg);
                     }
                     else {
-                        _post_servo_error_msg(_servo_in_proc);
+                        _post_servo_error_msg(bus, servo);
                     }
-                    break;
+                    _bus_txn_done(bus);
+                    return;
                 }
             }
         }
     }
-    _servo_in_proc = SERVO_NONE;
-    _uart_intr_disable();
-    _rxd_handler = _rxd_discard;
-    _rxd_clear();
-    mutex_exit(&tx_mutex);  // Exit out of the 'tx_mutex' protected area!
 }
 
 /**
  * @brief Handle a timeout waiting for a servo response.
  * @ingroup servo
  *
+ * The timeout is cancelled when the reply is received, but it could already
+ * have been posted, so the transaction sequence number is checked.
+ *
  * @param msg Message
  */
-static void _rxd_status_asm_to(cmt_msg_t *msg) { 
-    servo_t* servo = _servo_in_proc;
-    _post_servo_error_msg(servo);
-    mutex_exit(&tx_mutex);  // Exit out of the 'tx_mutex' protected area!
-}
-
-static void _rxd_discard() {
-    // Just clear out any received data.
-    _rxd_clear();
+static void _rxd_status_asm_to(cmt_msg_t *msg) {
+    servo_bus_t* bus = &_buses[msg->data.servo_params.bus];
+    servo_t* servo = bus->in_proc;
+    if (bus->state != BSBUS_RX || !servo || msg->data.servo_params.seq != bus->seq) {
+        return;
+    }
+    _latency_fail(bus, servo);
+    _post_servo_error_msg(bus, servo);
+    _bus_txn_done(bus);
 }
 
 static void _rxd_status_clr(servo_t *servo) {
@@ -352,23 +662,18 @@ static void _rxd_status_clr(servo_t *servo) {
  * and we are waiting for a response, we can't send out a command, as we
  * would *step on* the response coming back.
  *
- * This function checks to see if we are waiting for a response, and if so
- * it returns false and doesn't send the command. In this case, the command
- * needs to be retried after waiting.
+ * The command is queued on the servo's bus and sent once the transactions
+ * ahead of it are complete. If the bus queue is full it returns false and
+ * the command needs to be retried after waiting.
  *
- * @param buf A buffer containing a read status command packet.
- * @return true The buffer was able to be sent
- * @return false The buffer could not be sent
+ * @param servo The servo the command is for (selects the bus)
+ * @param cmd The command
+ * @param params The command parameters (NULL if the command doesn't have any)
+ * @return true The command was queued to be sent
+ * @return false The command could not be queued
  */
-static bool _send_action_cmd(uint8_t *buf) {
-    if (servo_status_inbound_pending()) {
-        return false;
-    }
-    mutex_enter_blocking(&tx_mutex);
-    _write_bs(buf);
-    mutex_exit(&tx_mutex);
-
-    return true;
+static bool _send_action_cmd(servo_t* servo, uint8_t cmd, const bs_params_t* params) {
+    return (_bus_submit(&_buses[servo->bus], SERVO_NONE, servo->id, cmd, params, 0));
 }
 
 /**
@@ -376,91 +681,126 @@ static bool _send_action_cmd(uint8_t *buf) {
  * @ingroup servo
  *
  * The servos use a single line to transmit and receive using half-duplex
- * communication. Because of this, once we know that we can send the
- * command we enter into the 'tx_mutex'. The 'tx_mutex' blocks other use
- * of the tx/rx data line. The 'tx_mutex' is held until we receive the
- * response, or timeout.
+ * communication. Because of this, the bus is held from the time the command
+ * is sent until we receive the response, or timeout. Reads to different
+ * servos can be queued back-to-back on a bus, but only one read can be
+ * outstanding (queued or in progress) for a servo, as the reply is received
+ * into the servo.
  *
  * @param servo The servo the command is for (response will be read into)
- * @param buf A buffer containing a read status command packet.
- * @return true The buffer was able to be sent
- * @return false The buffer could not be sent
+ * @param cmd The read command
+ * @return true The command was queued to be sent
+ * @return false The command could not be queued
  */
-static bool _send_rd_status_cmd(servo_t *servo, uint8_t *buf) {
-    if (_rxd_status_asm_bgn(servo)) { // Enters the 'tx_mutex' if successful.
-        _write_bs(buf);
-        _uart_intr_enable();
-        return true;
+static bool _send_rd_status_cmd(servo_t *servo, uint8_t cmd) {
+    servo_bus_t* bus = &_buses[servo->bus];
+    if (servo->_latency.offline) {
+        // Don't tie up the bus waiting on a servo that isn't answering,
+        // other than to probe it once in a while.
+        if ((int32_t)(now_ms() - servo->_latency.probe_ms) < 0) {
+            bus->stats.reads_skipped++;
+            return false;
+        }
+        servo->_latency.probe_ms = now_ms() + BS_OFFLINE_PROBE_MS;
     }
-    return false;
+    if (servo->_rxstatus.queued) {
+        return false;
+    }
+    return (_bus_submit(bus, servo, servo->id, cmd, NULL, 0));
 }
 
-
 /**
- * @brief Disable transmitting to the servo bus.
- * @ingroup servo
+ * @brief Alarm callback for the command on a bus having been sent.
  *
- * The servo bus communication is half-duplex, therefore the transmit driver
- * must be enabled to send data to the servo bus. Once a command is sent the
- * transmit driver must be disabled to allow the servo to transmit a reply.
- */
-static void _tx_disable(void) {
-    gpio_put(SERVO_CTRL_TX_EN_GPIO, SERVO_CTRL_TX_DIS);     // Bus-Servo TX Disabled
-    _tx_enabled = false;
-}
-
-/**
- * @brief Enable transmitting to the servo bus.
- * @ingroup servo
+ * Called in interrupt context. Tops up the FIFO if the command didn't all fit,
+ * and re-checks until the last byte is out. Then the TX driver is disabled,
+ * receive is enabled if a reply is expected, and a message is posted to
+ * continue the transaction (things that can't be done in an ISR).
  *
- * The servo bus communication is half-duplex, therefore the transmit driver
- * must be enabled to send data to the servo bus. Once a command is sent the
- * transmit driver must be disabled to allow the servo to transmit a reply.
+ * @return int64_t 0 when done, or the time until the next check
  */
-static void _tx_enable(void) {
-    gpio_put(SERVO_CTRL_TX_EN_GPIO, SERVO_CTRL_TX_EN);     // Bus-Servo TX Enabled
-    _tx_enabled = true;
-}
-
-/**
- * @brief Read all available data from the UART and discard it.
- * @ingroup servo
- */
-static void _uart_drain() {
-    // Clear any 'junk' out of the UART.
-    while (uart_is_readable(SERVO_CTRL_UART)) {
-        uart_getc(SERVO_CTRL_UART);
+static int64_t _tx_done_alarm(alarm_id_t id, void* user_data) {
+    servo_bus_t* bus = (servo_bus_t*)user_data;
+    if (bus->tx_off < bus->cur.len) {
+        uint8_t off = bus->tx_off;
+        _bus_tx_fill(bus);
+        return ((bus->tx_off - off) * BS_BYTE_US + BS_TX_POLL_US_);
+    }
+    if (_bus_tx_busy(bus)) {
+        return (BS_TX_POLL_US_);
+    }
+    gpio_put(bus->tx_en_gpio, SERVO_CTRL_TX_DIS);  // Disable the TX output so that we can read.
+    bus->txd_done_us = now_us();
+    if (bus->cur.servo) {
+        _rx_enable(bus);
     }
+    cmt_msg_t msg;
+    cmt_msg_init(&msg, MSG_SERVO_TX_DONE);
+    msg.data.servo_params.bus = bus->num;
+    postHWCtrlMsg(&msg);
+
+    return (0);
 }
 
 /**
- * @brief Disable UART receive interrupts.
+ * @brief Initialize a bus that uses a hardware UART.
  */
-static void _uart_intr_disable() {
-    irq_set_enabled(SERVO_CTRL_IRQ, false);
-    // Disable the UART from sendint interrupts
-    uart_set_irq_enables(SERVO_CTRL_UART, false, false);
+static void _bus_init_uart(servo_bus_t* bus, uart_inst_t* uart, uint tx, uint rx, uint irq) {
+    bus->uart = uart;
+    bus->irq = irq;
+#if !SERVO_BUS_SIM   // The simulated bus has no UART or PIO
+    // Set up our UART with the required speed.
+    uart_init(uart, BS_BAUDRATE);
+    uart_set_hw_flow(uart, false, false);  // CTS/RTS off
+    uart_set_format(uart, 8, 1, UART_PARITY_NONE);
+    uart_set_fifo_enabled(uart, true);
+    uart_set_translate_crlf(uart, false);
+    // Set the TX and RX pins by using the function select on the GPIO
+    gpio_set_function(tx, GPIO_FUNC_UART);
+    gpio_set_function(rx, GPIO_FUNC_UART);
+    // Set up the interrupt handler
+    irq_set_exclusive_handler(irq, _on_uart_rx);
+    uart_set_irq_enables(uart, false, false);
+    irq_set_enabled(irq, true);
+#endif
 }
 
+#if SERVO_BUS_CNT > 1
 /**
- * @brief Enable UART receive interrupts. This first drains the UART RX FIFO.
+ * @brief Initialize a bus that uses a PIO UART (a TX and an RX state machine).
  */
-static void _uart_intr_enable() {
-    _uart_drain(); // Remove all data before enabling interrupts
-    // Now enable the UART to send interrupts - RX only
-    uart_set_irq_enables(SERVO_CTRL_UART, true, false);
-    // Main enable
-    irq_set_enabled(SERVO_CTRL_IRQ, true);
-}
-
-static void _write_bs(const uint8_t* buf) {
-    size_t len = (size_t)(buf[BSPKT_LEN] + 3);
-    _uart_intr_disable();
-    _tx_enable();  // Enable the TX output to the bus.
-    uart_write_blocking(SERVO_CTRL_UART, buf, len);
-    uart_tx_wait_blocking(SERVO_CTRL_UART);  // Wait for all data to be sent.
-    _tx_disable();  // Disable the TX output so that we can read.
+static void _bus_init_pio(servo_bus_t* bus, PIO pio, uint sm_tx, uint sm_rx, uint tx, uint rx) {
+    bus->uart = NULL;
+    bus->pio = pio;
+    bus->sm_tx = sm_tx;
+    bus->sm_rx = sm_rx;
+#if !SERVO_BUS_SIM   // The simulated bus has no UART or PIO
+    int offset = pio_add_program(pio, &servo_uart_tx_program);
+    if (offset < 0) {
+        board_panic("servo_module_init - Unable to load PIO UART TX program");
+    }
+    pio_sm_claim(pio, sm_tx);
+    servo_uart_tx_program_init(pio, sm_tx, offset, tx, BS_BAUDRATE);
+    offset = pio_add_program(pio, &servo_uart_rx_program);
+    if (offset < 0) {
+        board_panic("servo_module_init - Unable to load PIO UART RX program");
+    }
+    pio_sm_claim(pio, sm_rx);
+    servo_uart_rx_program_init(pio, sm_rx, offset, rx, BS_BAUDRATE);
+    // Find a free irq
+    _pio_irq = pio_get_irq_num(pio, 0);
+    if (irq_get_exclusive_handler(_pio_irq)) {
+        _pio_irq++;
+        if (irq_get_exclusive_handler(_pio_irq)) {
+            board_panic("servo_module_init - All PIO IRQs are in use");
+        }
+    }
+    bus->irq = _pio_irq;
+    irq_add_shared_handler(_pio_irq, _on_pio_rx, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(_pio_irq, true);
+#endif
 }
+#endif
 
 
 // ############################################################################
@@ -470,10 +810,32 @@ static void _write_bs(const uint8_t* buf) {
 
 static void _handle_servo_rxd(cmt_msg_t* msg) {
     // Data has been received from the servos
-    _rxd_handler();
+    _rxd_status_asm_cont(&_buses[msg->data.servo_params.bus]);
+}
+
+static void _handle_servo_tx_done(cmt_msg_t* msg) {
+    // A command has been sent. If it was a read, wait for the reply (with a
+    // timeout), otherwise go on to the next command.
+    servo_bus_t* bus = &_buses[msg->data.servo_params.bus];
+    servo_t* servo = bus->in_proc;
+    if (servo) {
+        bus->state = BSBUS_RX;
+        bus->msg_rxd_to.data.servo_params.seq = bus->seq;
+        uint16_t to = (bus->cur.timeout_ms ? bus->cur.timeout_ms : servo_reply_timeout_ms(servo));
+        schedule_core0_msg_in_ms(to, &bus->msg_rxd_to);
+        // Anything received while the state was TX is the reply
+        if (_rxd_input_available(bus)) {
+            _rxd_status_asm_cont(bus);
+        }
+    }
+    else {
+        bus->state = BSBUS_IDLE;
+        _bus_next(bus);
+    }
 }
 
 const msg_handler_entry_t servo_rxd_handler_entry = { MSG_SERVO_DATA_RCVD, _handle_servo_rxd };
+const msg_handler_entry_t servo_tx_done_handler_entry = { MSG_SERVO_TX_DONE, _handle_servo_tx_done };
 
 // ############################################################################
 // Public Methods
@@ -481,126 +843,130 @@ const msg_handler_entry_t servo_rxd_handler_entry = { MSG_SERVO_DATA_RCVD, _hand
 //
 
 bool servo_load(servo_t* servo) {
-    uint8_t buf[7];
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 4;
-    buf[4] = BS_LOAD_OR_UNLOAD_WRITE;
-    buf[5] = 1;
-    buf[6] = _gen_checksum(buf);
-    return (_send_action_cmd(buf));
+    bs_params_t params = { .u8 = 1 };
+    return (_send_action_cmd(servo, BS_LOAD_OR_UNLOAD_WRITE, &params));
 }
 
 bool servo_move(servo_t *servo, int16_t position, uint16_t time) {
-    uint8_t buf[10];
     if (position < 0)
         position = 0;
     if (position > 1000)
         position = 1000;
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 7;
-    buf[4] = BS_MOVE_TIME_WRITE;
-    buf[5] = GET_LOW_BYTE(position);
-    buf[6] = GET_HIGH_BYTE(position);
-    buf[7] = GET_LOW_BYTE(time);
-    buf[8] = GET_HIGH_BYTE(time);
-    buf[9] = _gen_checksum(buf);
-    return (_send_action_cmd(buf));
+    bs_params_t params = { .move = { .pos = position, .time = time } };
+    return (_send_action_cmd(servo, BS_MOVE_TIME_WRITE, &params));
 }
 
 int16_t servo_position(servo_t *servo) {
     // Make sure this is a position packet.
-    if (servo->_rxstatus.buf[BSPKT_CMD] != BS_POS_READ) {
+    if (servo->_rxstatus.reply.cmd != BS_POS_READ) {
         return (-1);
     }
-    return ((int16_t)BYTES_TO_WORD(servo->_rxstatus.buf[BSPKT_DATA + 2], servo->_rxstatus.buf[BSPKT_DATA + 1]));
+    return (servo->_rxstatus.reply.params.s16);
+}
+
+void servo_bus_stats(uint8_t bus, servo_bus_stats_t* stats) {
+    if (bus < SERVO_BUS_CNT) {
+        *stats = _buses[bus].stats;
+    }
+}
+
+bool servo_bus_reads_pending(uint8_t bus) {
+    if (bus >= SERVO_BUS_CNT) {
+        return false;
+    }
+    return (_buses[bus].in_proc != SERVO_NONE || _buses[bus].reads_queued > 0);
+}
+
+bool servo_online(servo_t* servo) {
+    return (!servo->_latency.offline);
+}
+
+bool servo_ping(servo_t* servo) {
+    if (servo->_rxstatus.queued) {
+        return false;
+    }
+    // Pings go out even if the servo is offline (that's what they are for).
+    return (_bus_submit(&_buses[servo->bus], servo, servo->id, BS_ID_READ, NULL, BS_PING_TIMEOUT_MS));
 }
 
 bool servo_position_read(servo_t *servo) {
-    uint8_t buf[6];
+    return (_send_rd_status_cmd(servo, BS_POS_READ));
+}
+
+bool servo_read(servo_t* servo, uint8_t cmd) {
+    const bs_cmd_desc_t* desc = bs_cmd_desc(cmd);
+    if (!desc || desc->reply_layout == BSL_NONE) {
+        return false;
+    }
+    return (_send_rd_status_cmd(servo, cmd));
+}
+
+const bs_packet_t* servo_reply(servo_t* servo) {
+    return (&servo->_rxstatus.reply);
+}
 
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 3;
-    buf[4] = BS_POS_READ;
-    buf[5] = _gen_checksum(buf);
+uint32_t servo_reply_latency_us(servo_t* servo) {
+    return ((uint32_t)(servo->_latency.srtt_x8 >> 3));
+}
 
-    return (_send_rd_status_cmd(servo, buf));
+uint16_t servo_reply_timeout_ms(servo_t* servo) {
+    uint16_t to = servo->_latency.timeout_ms;
+    return (to ? to : BS_RXD_TIMEOUT_MS);
 }
 
 bool servo_run(servo_t *servo, int16_t speed) {
     return (servo_set_mode(servo, BS_MOTOR_MODE, speed));
 }
 
-bool servo_set_id(uint8_t oldID, uint8_t newID) {
-    uint8_t buf[7];
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = oldID;
-    buf[3] = 4;
-    buf[4] = BS_ID_WRITE;
-    buf[5] = newID;
-    buf[6] = _gen_checksum(buf);
-    return (_send_action_cmd(buf));
+bool servo_set_id(uint8_t bus, uint8_t oldID, uint8_t newID) {
+    if (bus >= SERVO_BUS_CNT) {
+        return false;
+    }
+    bs_params_t params = { .u8 = newID };
+    return (_bus_submit(&_buses[bus], SERVO_NONE, oldID, BS_ID_WRITE, &params, 0));
 }
 
 bool servo_set_mode(servo_t *servo, servo_mode_t mode, int16_t speed) {
-    uint8_t buf[10];
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 7;
-    buf[4] = BS_SERVO_OR_MOTOR_MODE_WRITE;
-    buf[5] = mode;
-    buf[6] = 0;
-    buf[7] = GET_LOW_BYTE((uint16_t)speed);
-    buf[8] = GET_HIGH_BYTE((uint16_t)speed);
-    buf[9] = _gen_checksum(buf);
-    return (_send_action_cmd(buf));
+    bs_params_t params = { .mode = { .mode = (uint8_t)mode, .speed = speed } };
+    return (_send_action_cmd(servo, BS_SERVO_OR_MOTOR_MODE_WRITE, &params));
 }
 
 bool servo_status_inbound_pending(void) {
-    return (_servo_in_proc != SERVO_NONE);
+    for (uint8_t i = 0; i < SERVO_BUS_CNT; i++) {
+        if (servo_bus_reads_pending(i)) {
+            return true;
+        }
+    }
+    return false;
 }
 
 bool servo_stop_move(servo_t *servo) {
-    uint8_t buf[6];
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 3;
-    buf[4] = BS_MOVE_STOP;
-    buf[5] = _gen_checksum(buf);
-    return (_send_action_cmd(buf));
+    return (_send_action_cmd(servo, BS_MOVE_STOP, NULL));
+}
+
+bool servo_write(servo_t* servo, uint8_t cmd, const bs_params_t* params) {
+    const bs_cmd_desc_t* desc = bs_cmd_desc(cmd);
+    if (!desc || desc->reply_layout != BSL_NONE) {
+        return false;
+    }
+    return (_send_action_cmd(servo, cmd, params));
 }
 
 bool servo_unload(servo_t* servo) {
-    uint8_t buf[7];
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 4;
-    buf[4] = BS_LOAD_OR_UNLOAD_WRITE;
-    buf[5] = 0;
-    buf[6] = _gen_checksum(buf);
-    return (_send_action_cmd(buf));
+    bs_params_t params = { .u8 = 0 };
+    return (_send_action_cmd(servo, BS_LOAD_OR_UNLOAD_WRITE, &params));
 }
 
 int16_t servo_vin(servo_t *servo) {
-    // Make sure this is a position packet.
-    if (servo->_rxstatus.buf[BSPKT_CMD] != BS_VIN_READ) {
+    // Make sure this is a voltage packet.
+    if (servo->_rxstatus.reply.cmd != BS_VIN_READ) {
         return (-1);
     }
-    return ((int16_t)BYTES_TO_WORD(servo->_rxstatus.buf[BSPKT_DATA + 2], servo->_rxstatus.buf[BSPKT_DATA + 1]));
+    return ((int16_t)servo->_rxstatus.reply.params.u16);
 }
 
 bool servo_vin_read(servo_t *servo) {
-    uint8_t buf[6];
-
-    buf[0] = buf[1] = BS_FRAME_HEADER;
-    buf[2] = servo->id;
-    buf[3] = 3;
-    buf[4] = BS_VIN_READ;
-    buf[5] = _gen_checksum(buf);
-
-    return (_send_rd_status_cmd(servo, buf));
+    return (_send_rd_status_cmd(servo, BS_VIN_READ));
 }
 
 void servo_module_init() {
@@ -610,30 +976,36 @@ void servo_module_init() {
         board_panic("servo_module_init already called");
     }
     _initialized = true;
-    _tx_disable();
-    //
-    // Clear out the servo in progress.
-    _servo_in_proc = SERVO_NONE;
-    _rxd_handler = _rxd_discard;
-    cmt_msg_init(&_msg_rxd_to, MSG_SERVO_DATA_RX_TO);
-    _msg_rxd_to.hdlr = _rxd_status_asm_to;  // Handler for RX receive timeout
-    // Set up our UART with the required speed.
-    uart_init(SERVO_CTRL_UART, BS_BAUDRATE);
-    uart_set_hw_flow(SERVO_CTRL_UART, false, false);  // CTS/RTS off
-    uart_set_format(SERVO_CTRL_UART, 8, 1, UART_PARITY_NONE);
-    uart_set_fifo_enabled(SERVO_CTRL_UART, true);
-    uart_set_translate_crlf(SERVO_CTRL_UART, false);
-    // Set the TX and RX pins by using the function select on the GPIO
-    gpio_set_function(SERVO_CTRL_TX, GPIO_FUNC_UART);
-    gpio_set_function(SERVO_CTRL_RX, GPIO_FUNC_UART);
-    // Set up the interrupt handler
-    irq_set_exclusive_handler(SERVO_CTRL_IRQ, _on_uart_rx);
-    irq_set_enabled(SERVO_CTRL_IRQ, false);
-    // Now enable the UART to send interrupts - RX only
-    uart_set_irq_enables(SERVO_CTRL_UART, true, false);
+    for (uint8_t i = 0; i < SERVO_BUS_CNT; i++) {
+        servo_bus_t* bus = &_buses[i];
+        memset(bus, 0, sizeof(servo_bus_t));
+        bus->num = i;
+        bus->state = BSBUS_IDLE;
+        bus->in_proc = SERVO_NONE;
+        cmt_msg_init(&bus->msg_rxd_to, _rxd_to_msg_ids[i]);
+        bus->msg_rxd_to.hdlr = _rxd_status_asm_to;  // Handler for RX receive timeout
+        bus->msg_rxd_to.data.servo_params.bus = i;
+    }
+    // Bus 0 - UART 1
+    _buses[0].tx_en_gpio = SERVO_CTRL_TX_EN_GPIO;
+    _bus_init_uart(&_buses[0], SERVO_CTRL_UART, SERVO_CTRL_TX, SERVO_CTRL_RX, SERVO_CTRL_IRQ);
+#if SERVO_BUS_CNT > 1
+    // Bus 1 - PIO UART
+    _buses[1].tx_en_gpio = SERVO_B1_TX_EN_GPIO;
+    _bus_init_pio(&_buses[1], PIO_SERVO_B1_BLOCK, PIO_SERVO_B1_TX_SM, PIO_SERVO_B1_RX_SM, SERVO_B1_TX, SERVO_B1_RX);
+#endif
+    for (uint8_t i = 0; i < SERVO_BUS_CNT; i++) {
+        gpio_put(_buses[i].tx_en_gpio, SERVO_CTRL_TX_DIS);
+    }
+#if SERVO_BUS_SIM
+    // Use the simulated bus in place of the UARTs.
+    servo_sim_module_init(_on_sim_rx, SERVO_BUS_SIM_SEED);
+#endif
 }
 
 void servo_module_start() {
-    _uart_drain();
+    for (uint8_t i = 0; i < SERVO_BUS_CNT; i++) {
+        _rx_drain(&_buses[i]);
+    }
 }
 
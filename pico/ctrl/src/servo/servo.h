@@ -58,6 +58,106 @@ extern int16_t servo_position(servo_t* servo);
  */
 extern bool servo_position_read(servo_t* servo);
 
+/**
+ * @brief Check that a servo is on its bus.
+ * @ingroup servo
+ *
+ * Reads the servo's ID with a short (fixed) timeout, as the servo's reply
+ * latency isn't known yet. The result is a MSG_SERVO_STATUS_RCVD or a
+ * MSG_SERVO_READ_ERROR message. A servo that doesn't reply is marked offline
+ * right away (rather than after several failed reads).
+ *
+ * Pings to the servos on a bus can all be queued at once, and are sent
+ * back-to-back.
+ *
+ * @param servo The servo to ping
+ * @return true The ping was queued to be sent
+ * @return false The ping could not be queued (a read is already pending for the servo)
+ */
+extern bool servo_ping(servo_t* servo);
+
+/**
+ * @brief Send a read command to a servo.
+ * @ingroup servo
+ *
+ * The result is a MSG_SERVO_STATUS_RCVD message, after which the decoded
+ * values are available from `servo_reply`, or a MSG_SERVO_READ_ERROR message.
+ *
+ * @param servo The servo to read from
+ * @param cmd The read command (BS_xxx_READ)
+ * @return true The read command was queued to be sent
+ * @return false The read could not be sent (not a read command, the servo is
+ *      offline or already has a read pending, or the bus queue is full)
+ */
+extern bool servo_read(servo_t* servo, uint8_t cmd);
+
+/**
+ * @brief Get the last good reply received from a servo.
+ * @ingroup servo
+ *
+ * @param servo The servo
+ * @return const bs_packet_t* The reply (the `cmd` is the read it was for)
+ */
+extern const bs_packet_t* servo_reply(servo_t* servo);
+
+/**
+ * @brief Indicates if a read (status) command is queued or in progress on a bus.
+ * @ingroup servo
+ *
+ * Reads to different servos queue back-to-back on a bus (one per servo). Reads
+ * on different buses are independent.
+ *
+ * @param bus The servo bus
+ * @return true A read is pending on the bus
+ * @return false The bus can accept a read
+ */
+extern bool servo_bus_reads_pending(uint8_t bus);
+
+/**
+ * @brief Get (a copy of) a servo bus' statistics.
+ * @ingroup servo
+ *
+ * @param bus The servo bus
+ * @param stats Pointer to the structure to fill in
+ */
+extern void servo_bus_stats(uint8_t bus, servo_bus_stats_t* stats);
+
+/**
+ * @brief Indicates if the servo is replying to reads.
+ * @ingroup servo
+ *
+ * A servo that fails to reply several times in a row is marked offline. Reads
+ * to an offline servo are not sent (they return false), other than a probe
+ * about once a second. A good reply puts the servo back online.
+ *
+ * @param servo The servo
+ * @return true The servo is online
+ * @return false The servo is offline
+ */
+extern bool servo_online(servo_t* servo);
+
+/**
+ * @brief Get the smoothed reply latency for a servo.
+ * @ingroup servo
+ *
+ * @param servo The servo
+ * @return uint32_t Microseconds from the end of a read command to the end of the reply
+ */
+extern uint32_t servo_reply_latency_us(servo_t* servo);
+
+/**
+ * @brief Get the current reply timeout for a servo.
+ * @ingroup servo
+ *
+ * The timeout is derived from the servo's measured reply latency (average
+ * plus four mean deviations), bounded to 3-20ms. Until the servo has replied
+ * it is the 20ms maximum.
+ *
+ * @param servo The servo
+ * @return uint16_t The timeout in milliseconds
+ */
+extern uint16_t servo_reply_timeout_ms(servo_t* servo);
+
 /**
  * @brief Shortcut for setting the servo mode to 'motor' and setting the speed.
  * @ingroup servo
@@ -67,15 +167,23 @@ extern bool servo_position_read(servo_t* servo);
  */
 extern bool servo_run(servo_t* servo, int16_t speed);
 
-extern bool servo_set_id(uint8_t oldID, uint8_t newID);
+/**
+ * @brief Change the ID of a servo.
+ * @ingroup servo
+ *
+ * @param bus The servo bus the servo is connected to
+ * @param oldID The servo's current ID
+ * @param newID The ID to change it to
+ */
+extern bool servo_set_id(uint8_t bus, uint8_t oldID, uint8_t newID);
 
 /**
  * @brief Indicates if a servo status (a command that reads servo data) is
- * pending the status data being received.
+ * pending the status data being received on any of the servo buses.
  *
  * When a servo command that expects data to be received from the servo is
  * executed, this status will become true until the complete data packet
- * has been received, or another command is sent.
+ * has been received, or the read times out.
  *
  * @return true Incoming servo data is pending
  * @return false No incoming data is pending
@@ -96,6 +204,21 @@ extern bool servo_set_mode(servo_t* servo, servo_mode_t mode, int16_t speed);
 
 extern bool servo_stop_move(servo_t* servo);
 
+/**
+ * @brief Send an action (write) command to a servo.
+ * @ingroup servo
+ *
+ * For commands that don't have a dedicated function (angle limits, offset,
+ * LED error mask, etc.).
+ *
+ * @param servo The servo
+ * @param cmd The command (a BS_xxx command that doesn't have a reply)
+ * @param params The command parameters (NULL if the command doesn't have any)
+ * @return true The command was queued to be sent
+ * @return false The command could not be queued
+ */
+extern bool servo_write(servo_t* servo, uint8_t cmd, const bs_params_t* params);
+
 /**
  * @brief Disable the motor of the servo (it will not drive the control arm)
  *
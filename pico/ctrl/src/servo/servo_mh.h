@@ -19,6 +19,12 @@ extern "C" {
 
 extern const msg_handler_entry_t servo_rxd_handler_entry;
 
+extern const msg_handler_entry_t servo_tx_done_handler_entry;
+
+extern const msg_handler_entry_t servos_read_error_handler_entry;
+
+extern const msg_handler_entry_t servos_status_rcvd_handler_entry;
+
 #ifdef __cplusplus
     }
 #endif
@@ -0,0 +1,580 @@
+/**
+ * @brief Simulated Serial Bus Servo bus.
+ * @ingroup servo
+ *
+ * Stands in for the servo UARTs and a set of HiWonder servos. See `servo_sim.h`.
+ *
+ * The controller side (`servo_sim_bus_write`) runs in the servo module's
+ * (core 0) context. Replies are delivered by a timer alarm per bus, one byte
+ * per alarm, so the servo module sees them exactly as it would from its UART
+ * ISR.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "servo_sim.h"
+
+#if SERVO_BUS_SIM
+
+#include "servo_t.h"
+#include "bs_codec.h"
+
+#include "board.h"
+
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "hardware/sync.h"
+
+#include <string.h>
+
+// ############################################################################
+// Constants, Enumerations and Structures
+// ############################################################################
+//
+#define SIM_FRAME_MAX_      16  // Largest frame we will assemble
+#define SIM_POS_CENTER_     500
+#define SIM_TEMP_C_         32  // Constant temperature reported
+#define SIM_VIN_MV_         7400
+#define SIM_VIN_LOADED_DROP_MV_ 60
+
+/** @brief Bus time for `n` bytes in microseconds. */
+#define SIM_WIRE_US_(n) (((uint64_t)(n) * SERVO_SIM_BYTE_NS) / 1000)
+/** @brief Bus time for one byte, rounded to whole microseconds (for the alarm). */
+#define SIM_BYTE_US_ ((SERVO_SIM_BYTE_NS + 500) / 1000)
+
+/**
+ * @brief State of a simulated servo.
+ */
+typedef struct SIM_SERVO_ {
+    uint8_t bus;
+    uint8_t id;
+    bool present;
+    uint16_t latency_us;
+    uint16_t jitter_us;
+    servo_mode_t mode;
+    int16_t speed;
+    bool loaded;
+    uint8_t led_ctrl;
+    uint8_t led_err_mask;
+    int8_t offset;
+    uint16_t limit_min;
+    uint16_t limit_max;
+    uint16_t vin_min;
+    uint16_t vin_max;
+    uint8_t temp_max;
+    // Move state
+    int16_t pos_from;
+    int16_t pos_to;
+    uint16_t move_time;
+    uint64_t move_start_us;
+    // Move staged by MOVE_TIME_WAIT_WRITE, started by MOVE_START
+    bool wait_pending;
+    int16_t wait_pos;
+    uint16_t wait_time;
+} sim_servo_t;
+
+/**
+ * @brief State of a simulated bus.
+ */
+typedef struct SIM_BUS_ {
+    uint8_t num;
+    uint64_t tx_end_us;         // When the controller's last write finishes sending
+    // Command packet being assembled from what the controller writes.
+    uint8_t cmd_buf[SIM_FRAME_MAX_];
+    uint8_t cmd_off;
+    // Reply on (or waiting to go on) the bus.
+    uint8_t reply_buf[BSPKT_PAYLOAD_MAX_LEN];
+    volatile uint8_t reply_len;
+    volatile uint8_t reply_idx;
+    volatile bool reply_active;
+    volatile bool reply_garbled;
+    alarm_id_t reply_alarm;
+    uint64_t reply_start_us;
+    servo_sim_stats_t stats;
+} sim_bus_t;
+
+
+// ############################################################################
+// Function Declarations
+// ############################################################################
+//
+static int64_t _reply_alarm_cb(alarm_id_t id, void* user_data);
+
+
+// ############################################################################
+// Data
+// ############################################################################
+//
+static sim_servo_t _servos[SERVO_SIM_MAX_SERVOS];
+static uint8_t _servo_cnt;
+
+static sim_bus_t _buses[SERVO_SIM_MAX_BUSES];
+
+static servo_sim_rx_fn _rx_fn;
+static uint32_t _rand_state;
+static uint16_t _noise_per_10k;
+
+
+// ############################################################################
+// Internal Functions
+// ############################################################################
+//
+
+static sim_servo_t* _find_servo(uint8_t id) {
+    for (int i = 0; i < _servo_cnt; i++) {
+        if (_servos[i].id == id) {
+            return (&_servos[i]);
+        }
+    }
+    return (NULL);
+}
+
+/**
+ * @brief Simple xorshift PRNG. Repeatable for a given seed.
+ */
+static uint32_t _rand_next(void) {
+    uint32_t x = _rand_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    _rand_state = x;
+    return (x);
+}
+
+static int16_t _pos_now(const sim_servo_t* s) {
+    if (s->move_time == 0) {
+        return (s->pos_to);
+    }
+    uint64_t elapsed_ms = (now_us() - s->move_start_us) / 1000;
+    if (elapsed_ms >= s->move_time) {
+        return (s->pos_to);
+    }
+    int32_t delta = (int32_t)s->pos_to - s->pos_from;
+    return ((int16_t)(s->pos_from + ((delta * (int32_t)elapsed_ms) / s->move_time)));
+}
+
+static void _move_start(sim_servo_t* s, int16_t pos, uint16_t time) {
+    if (pos < (int16_t)s->limit_min) {
+        pos = s->limit_min;
+    }
+    if (pos > (int16_t)s->limit_max) {
+        pos = s->limit_max;
+    }
+    s->pos_from = _pos_now(s);
+    s->pos_to = pos;
+    s->move_time = time;
+    s->move_start_us = now_us();
+}
+
+/**
+ * @brief Put a reply on the bus after the command has finished sending plus
+ * the servo's latency.
+ *
+ * If a reply is already waiting or on the wire, the two servos are driving
+ * the bus at the same time. Count a collision and garble the new one.
+ */
+static void _reply_send(sim_bus_t* bus, const sim_servo_t* s, uint8_t cmd, const bs_params_t* params, bool garbled) {
+    uint32_t irqs = save_and_disable_interrupts();
+    if (bus->reply_active) {
+        cancel_alarm(bus->reply_alarm);
+        bus->stats.collisions++;
+        garbled = true;
+    }
+    bus->reply_len = (uint8_t)bs_encode_reply(bus->reply_buf, sizeof(bus->reply_buf), s->id, cmd, params);
+    bus->reply_idx = 0;
+    bus->reply_garbled = garbled;
+    bus->reply_active = true;
+    uint64_t now = now_us();
+    uint64_t delay = (bus->tx_end_us > now ? bus->tx_end_us - now : 0) + s->latency_us;
+    if (s->jitter_us) {
+        delay += _rand_next() % (s->jitter_us + 1u);
+    }
+    bus->reply_start_us = now + delay;
+    bus->stats.replies++;
+    // A byte is received once its stop bit is in, a byte time after it starts.
+    bus->reply_alarm = add_alarm_in_us(delay + SIM_BYTE_US_, _reply_alarm_cb, bus, true);
+    restore_interrupts(irqs);
+}
+
+/**
+ * @brief Build the reply parameters for a read command.
+ */
+static void _reply_params(const sim_servo_t* s, uint8_t cmd, bs_params_t* p) {
+    switch (cmd) {
+        case BS_MOVE_TIME_READ:
+            p->move.pos = s->pos_to;
+            p->move.time = s->move_time;
+            break;
+        case BS_MOVE_TIME_WAIT_READ:
+            p->move.pos = s->wait_pos;
+            p->move.time = s->wait_time;
+            break;
+        case BS_ID_READ:
+            p->u8 = s->id;
+            break;
+        case BS_ANGLE_OFFSET_READ:
+            p->s8 = s->offset;
+            break;
+        case BS_ANGLE_LIMIT_READ:
+            p->limit.min = s->limit_min;
+            p->limit.max = s->limit_max;
+            break;
+        case BS_VIN_LIMIT_READ:
+            p->limit.min = s->vin_min;
+            p->limit.max = s->vin_max;
+            break;
+        case BS_TEMP_MAX_LIMIT_READ:
+            p->u8 = s->temp_max;
+            break;
+        case BS_TEMP_READ:
+            p->u8 = SIM_TEMP_C_;
+            break;
+        case BS_VIN_READ:
+            p->u16 = SIM_VIN_MV_ - (s->loaded ? SIM_VIN_LOADED_DROP_MV_ : 0);
+            break;
+        case BS_POS_READ:
+            p->s16 = _pos_now(s);
+            break;
+        case BS_SERVO_OR_MOTOR_MODE_READ:
+            p->mode.mode = (uint8_t)s->mode;
+            p->mode.speed = s->speed;
+            break;
+        case BS_LOAD_OR_UNLOAD_READ:
+            p->u8 = s->loaded ? 1 : 0;
+            break;
+        case BS_LED_CTRL_READ:
+            p->u8 = s->led_ctrl;
+            break;
+        case BS_LED_ERROR_READ:
+            p->u8 = s->led_err_mask;
+            break;
+    }
+}
+
+static void _servo_write_cmd(sim_servo_t* s, uint8_t cmd, const bs_params_t* p) {
+    switch (cmd) {
+        case BS_MOVE_TIME_WRITE:
+            if (s->mode == BS_POSITION_MODE) {
+                _move_start(s, p->move.pos, p->move.time);
+            }
+            break;
+        case BS_MOVE_TIME_WAIT_WRITE:
+            s->wait_pos = p->move.pos;
+            s->wait_time = p->move.time;
+            s->wait_pending = true;
+            break;
+        case BS_MOVE_START:
+            if (s->wait_pending && s->mode == BS_POSITION_MODE) {
+                _move_start(s, s->wait_pos, s->wait_time);
+            }
+            s->wait_pending = false;
+            break;
+        case BS_MOVE_STOP:
+            s->pos_to = s->pos_from = _pos_now(s);
+            s->move_time = 0;
+            break;
+        case BS_ID_WRITE:
+            if (p->u8 < BS_BROADCAST_ID) {
+                s->id = p->u8;
+            }
+            break;
+        case BS_ANGLE_OFFSET_ADJUST:
+            s->offset = p->s8;
+            break;
+        case BS_ANGLE_LIMIT_WRITE:
+            if (p->limit.min < p->limit.max && p->limit.max <= 1000) {
+                s->limit_min = p->limit.min;
+                s->limit_max = p->limit.max;
+            }
+            break;
+        case BS_VIN_LIMIT_WRITE:
+            s->vin_min = p->limit.min;
+            s->vin_max = p->limit.max;
+            break;
+        case BS_TEMP_MAX_LIMIT_WRITE:
+            s->temp_max = p->u8;
+            break;
+        case BS_SERVO_OR_MOTOR_MODE_WRITE:
+            s->mode = (p->mode.mode ? BS_MOTOR_MODE : BS_POSITION_MODE);
+            s->speed = p->mode.speed;
+            break;
+        case BS_LOAD_OR_UNLOAD_WRITE:
+            s->loaded = (p->u8 != 0);
+            break;
+        case BS_LED_CTRL_WRITE:
+            s->led_ctrl = p->u8;
+            break;
+        case BS_LED_ERROR_WRITE:
+            s->led_err_mask = p->u8;
+            break;
+        default:
+            // ANGLE_OFFSET_WRITE (save to flash) needs nothing done.
+            break;
+    }
+}
+
+/**
+ * @brief Handle a complete command frame, as the servos on the bus would.
+ */
+static void _cmd_dispatch(sim_bus_t* bus, const uint8_t* frame, size_t len) {
+    bs_packet_t pkt;
+    if (bs_decode_cmd(frame, len, &pkt) != BSD_OK) {
+        // The servos ignore commands they don't understand (or that are corrupt).
+        bus->stats.cmds_bad++;
+        return;
+    }
+    bus->stats.cmds++;
+    uint8_t cmd = pkt.cmd;
+    bool is_read = (bs_cmd_desc(cmd)->reply_layout != BSL_NONE);
+    bs_params_t rp = { 0 };
+    if (pkt.id == BS_BROADCAST_ID) {
+        // Every servo acts on it. If it's a read, they all answer at once.
+        sim_servo_t* responder = NULL;
+        int responders = 0;
+        for (int i = 0; i < _servo_cnt; i++) {
+            sim_servo_t* s = &_servos[i];
+            if (!s->present || s->bus != bus->num) {
+                continue;
+            }
+            if (is_read) {
+                responder = s;
+                responders++;
+            }
+            else {
+                _servo_write_cmd(s, cmd, &pkt.params);
+            }
+        }
+        if (responders == 0) {
+            if (is_read) {
+                bus->stats.unanswered++;
+            }
+            return;
+        }
+        if (responders > 1) {
+            bus->stats.collisions++;
+        }
+        _reply_params(responder, cmd, &rp);
+        _reply_send(bus, responder, cmd, &rp, (responders > 1));
+        return;
+    }
+    sim_servo_t* s = _find_servo(pkt.id);
+    if (!s || !s->present || s->bus != bus->num) {
+        if (is_read) {
+            bus->stats.unanswered++;
+        }
+        return;
+    }
+    if (is_read) {
+        _reply_params(s, cmd, &rp);
+        _reply_send(bus, s, cmd, &rp, false);
+    }
+    else {
+        _servo_write_cmd(s, cmd, &pkt.params);
+    }
+}
+
+/**
+ * @brief Run a byte written by the controller through the servos' frame parser.
+ */
+static void _cmd_byte(sim_bus_t* bus, uint8_t ch) {
+    if (bus->cmd_off < BSPKT_ID) {
+        // Looking for the two header bytes
+        if (ch == BS_FRAME_HEADER) {
+            bus->cmd_buf[bus->cmd_off++] = ch;
+        }
+        else {
+            bus->cmd_off = 0;
+        }
+        return;
+    }
+    bus->cmd_buf[bus->cmd_off++] = ch;
+    if (bus->cmd_off == BSPKT_LEN + 1) {
+        if (ch < 3 || ch > (SIM_FRAME_MAX_ - 3)) {
+            bus->stats.cmds_bad++;
+            bus->cmd_off = 0;
+        }
+        return;
+    }
+    if (bus->cmd_off > BSPKT_LEN && bus->cmd_off == bus->cmd_buf[BSPKT_LEN] + 3) {
+        size_t len = bus->cmd_off;
+        bus->cmd_off = 0;
+        _cmd_dispatch(bus, bus->cmd_buf, len);
+    }
+}
+
+
+// ############################################################################
+// Interrupt Handlers
+// ############################################################################
+//
+
+/**
+ * @brief Clock the next reply byte off of the bus (into the receiver).
+ *
+ * Runs at the byte rate until the reply has been sent. Returning a negative
+ * value reschedules relative to when this alarm was due, so the byte timing
+ * doesn't drift with interrupt latency.
+ */
+static int64_t _reply_alarm_cb(alarm_id_t id, void* user_data) {
+    sim_bus_t* bus = (sim_bus_t*)user_data;
+    if (!bus->reply_active) {
+        return (0);
+    }
+    uint8_t ch = bus->reply_buf[bus->reply_idx++];
+    if (bus->reply_garbled) {
+        ch ^= (uint8_t)(_rand_next() | 0x01);
+    }
+    else if (_noise_per_10k && (_rand_next() % 10000u) < _noise_per_10k) {
+        ch ^= (uint8_t)(1u << (_rand_next() & 0x07));
+        bus->stats.noise_hits++;
+    }
+    bus->stats.bytes_out++;
+    if (_rx_fn) {
+        _rx_fn(bus->num, ch);
+    }
+    if (bus->reply_idx >= bus->reply_len) {
+        bus->reply_active = false;
+        bus->stats.busy_us += SIM_WIRE_US_(bus->reply_len);
+        return (0);
+    }
+    return (-(int64_t)SIM_BYTE_US_);
+}
+
+
+// ############################################################################
+// Public Functions
+// ############################################################################
+//
+
+bool servo_sim_servo_add(uint8_t bus, uint8_t id, uint16_t latency_us, uint16_t jitter_us) {
+    if (_servo_cnt >= SERVO_SIM_MAX_SERVOS || bus >= SERVO_SIM_MAX_BUSES || id >= BS_BROADCAST_ID || _find_servo(id)) {
+        return (false);
+    }
+    sim_servo_t* s = &_servos[_servo_cnt++];
+    memset(s, 0, sizeof(sim_servo_t));
+    s->bus = bus;
+    s->id = id;
+    s->present = true;
+    s->latency_us = latency_us;
+    s->jitter_us = jitter_us;
+    s->mode = BS_POSITION_MODE;
+    s->led_err_mask = 0x07;
+    s->limit_min = 0;
+    s->limit_max = 1000;
+    s->vin_min = 4500;
+    s->vin_max = 12000;
+    s->temp_max = 85;
+    s->pos_from = s->pos_to = SIM_POS_CENTER_;
+
+    return (true);
+}
+
+int16_t servo_sim_servo_position(uint8_t id) {
+    sim_servo_t* s = _find_servo(id);
+    return (s ? _pos_now(s) : -1);
+}
+
+void servo_sim_servo_present(uint8_t id, bool present) {
+    sim_servo_t* s = _find_servo(id);
+    if (s) {
+        s->present = present;
+    }
+}
+
+bool servo_sim_bus_busy(uint8_t bus) {
+    if (bus >= SERVO_SIM_MAX_BUSES) {
+        return (false);
+    }
+    return (_buses[bus].reply_active && now_us() >= _buses[bus].reply_start_us);
+}
+
+bool servo_sim_bus_sending(uint8_t bus) {
+    if (bus >= SERVO_SIM_MAX_BUSES) {
+        return (false);
+    }
+    return (now_us() < _buses[bus].tx_end_us);
+}
+
+void servo_sim_bus_write(uint8_t busnum, const uint8_t* buf, size_t len) {
+    if (busnum >= SERVO_SIM_MAX_BUSES) {
+        return;
+    }
+    sim_bus_t* bus = &_buses[busnum];
+    uint64_t now = now_us();
+    uint64_t wire_us = SIM_WIRE_US_(len);
+    bool collided = false;
+
+    uint32_t irqs = save_and_disable_interrupts();
+    // If the controller is still sending, the new bytes queue behind the old (FIFO).
+    uint64_t tx_start = (bus->tx_end_us > now ? bus->tx_end_us : now);
+    bus->tx_end_us = tx_start + wire_us;
+    if (bus->reply_active && bus->reply_start_us < bus->tx_end_us) {
+        // A servo is (or will be, before we finish) driving the bus.
+        bus->reply_garbled = true;
+        collided = true;
+        bus->stats.collisions++;
+    }
+    restore_interrupts(irqs);
+
+    bus->stats.bytes_in += len;
+    bus->stats.busy_us += wire_us;
+    if (collided) {
+        // The servos won't have seen a valid frame.
+        bus->stats.cmds_bad++;
+        bus->cmd_off = 0;
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        _cmd_byte(bus, buf[i]);
+    }
+}
+
+void servo_sim_noise_set(uint16_t per_10k) {
+    _noise_per_10k = (per_10k > 10000 ? 10000 : per_10k);
+}
+
+void servo_sim_stats(uint8_t bus, servo_sim_stats_t* stats) {
+    if (bus >= SERVO_SIM_MAX_BUSES) {
+        memset(stats, 0, sizeof(servo_sim_stats_t));
+        return;
+    }
+    uint32_t irqs = save_and_disable_interrupts();
+    *stats = _buses[bus].stats;
+    restore_interrupts(irqs);
+}
+
+void servo_sim_stats_clear(uint8_t bus) {
+    if (bus >= SERVO_SIM_MAX_BUSES) {
+        return;
+    }
+    uint32_t irqs = save_and_disable_interrupts();
+    memset(&_buses[bus].stats, 0, sizeof(servo_sim_stats_t));
+    restore_interrupts(irqs);
+}
+
+
+// ############################################################################
+// Initialization and Maintainence Functions
+// ############################################################################
+//
+
+void servo_sim_module_init(servo_sim_rx_fn rx_fn, uint32_t seed) {
+    static bool _initialized = false;
+
+    if (_initialized) {
+        board_panic("servo_sim_module_init already called");
+    }
+    _initialized = true;
+
+    _rx_fn = rx_fn;
+    _rand_state = (seed ? seed : 0x2545F491);
+    _servo_cnt = 0;
+    _noise_per_10k = 0;
+    memset(_buses, 0, sizeof(_buses));
+    for (int i = 0; i < SERVO_SIM_MAX_BUSES; i++) {
+        _buses[i].num = i;
+    }
+}
+
+#endif // SERVO_BUS_SIM
@@ -0,0 +1,192 @@
+/**
+ * @brief Simulated Serial Bus Servo bus.
+ * @ingroup servo
+ *
+ * A stand-in for the servo UARTs and the HiWonder servos attached to them.
+ * When `SERVO_BUS_SIM` is set (CMake option), the servo module writes command
+ * packets here rather than to the UARTs, and replies are clocked back into the
+ * servo module's receive path one byte at a time, at 115200 8N1 byte timing,
+ * from a timer alarm (interrupt context, the same as the UART ISR). Each bus
+ * is simulated independently, so buses run concurrently as they do on the
+ * hardware.
+ *
+ * The simulation models:
+ *  - Wire time for both directions (10 bit times per byte).
+ *  - Per-servo reply latency with jitter (seeded, so a run is repeatable).
+ *  - Servo IDs, missing/unplugged servos, and the broadcast ID.
+ *  - The HiWonder command set, including move-time position interpolation.
+ *  - Half-duplex collisions (writing while a reply is on the wire, or a
+ *    broadcast read that makes every servo answer at once).
+ *  - Random line noise (corrupts reply bytes at a set rate).
+ *
+ * This allows exercising the servo throughput and timeout handling without
+ * the rover hardware attached. The host tests (`test_host/servo_sim_test.c`)
+ * also build it, with `servo.c` and `servos.c`, on a simulated clock.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef SERVO_SIM_H_
+#define SERVO_SIM_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SERVO_BUS_SIM
+#define SERVO_BUS_SIM 0
+#endif
+#ifndef SERVO_BUS_SIM_SEED
+#define SERVO_BUS_SIM_SEED 1
+#endif
+#ifndef SERVO_BUS_SIM_MISSING
+#define SERVO_BUS_SIM_MISSING 0
+#endif
+
+/** @brief Maximum number of servos that can be on the simulated buses. */
+#define SERVO_SIM_MAX_SERVOS 16
+/** @brief Maximum number of simulated buses. */
+#define SERVO_SIM_MAX_BUSES 2
+
+/** @brief Bus time for one byte (8N1 = 10 bits) at 115200 baud, in nanoseconds. */
+#define SERVO_SIM_BYTE_NS 86806
+
+/**
+ * @brief Function prototype for receiving a byte from the simulated bus.
+ * @ingroup servo
+ *
+ * Called from interrupt context, the same as a UART RX ISR.
+ *
+ * @param bus The bus the byte was received on
+ * @param ch The byte 'received'
+ */
+typedef void (*servo_sim_rx_fn)(uint8_t bus, uint8_t ch);
+
+/**
+ * @brief Statistics for the simulated bus.
+ * @ingroup servo
+ */
+typedef struct SERVO_SIM_STATS_ {
+    uint32_t cmds;          // Valid command packets seen by the servos
+    uint32_t cmds_bad;      // Packets with a bad checksum/length, or lost to a collision
+    uint32_t replies;       // Replies put on the bus
+    uint32_t unanswered;    // Read commands sent to missing servos
+    uint32_t collisions;    // Times two drivers were on the bus at once
+    uint32_t noise_hits;    // Reply bytes corrupted by line noise
+    uint32_t bytes_in;      // Bytes written to the bus by the controller
+    uint32_t bytes_out;     // Bytes written to the bus by the servos
+    uint64_t busy_us;       // Total time the bus was being driven
+} servo_sim_stats_t;
+
+/**
+ * @brief Add a servo to a simulated bus.
+ * @ingroup servo
+ *
+ * The servo starts out present, in position mode, unloaded, at the center
+ * position (500) with default limits.
+ *
+ * @param bus The bus the servo is connected to
+ * @param id The servo ID (0-253)
+ * @param latency_us The time from the end of a command to the start of the reply
+ * @param jitter_us Random additional latency (0 to jitter_us)
+ * @return true The servo was added
+ * @return false The bus is full or the ID is already in use
+ */
+extern bool servo_sim_servo_add(uint8_t bus, uint8_t id, uint16_t latency_us, uint16_t jitter_us);
+
+/**
+ * @brief Get the current (interpolated) position of a simulated servo.
+ * @ingroup servo
+ *
+ * @param id The servo ID
+ * @return int16_t The position or -1 if there isn't a servo with the ID
+ */
+extern int16_t servo_sim_servo_position(uint8_t id);
+
+/**
+ * @brief Mark a simulated servo as present or missing (unplugged).
+ * @ingroup servo
+ *
+ * A missing servo ignores all commands, so reads to it time out.
+ *
+ * @param id The servo ID
+ * @param present True if the servo should respond
+ */
+extern void servo_sim_servo_present(uint8_t id, bool present);
+
+/**
+ * @brief Indicates that a servo is driving a simulated bus (a reply is on
+ * the wire).
+ * @ingroup servo
+ *
+ * @param bus The bus
+ */
+extern bool servo_sim_bus_busy(uint8_t bus);
+
+/**
+ * @brief Indicates that the controller is still sending on a simulated bus
+ * (the bytes of the last write are still on the wire).
+ * @ingroup servo
+ *
+ * @param bus The bus
+ */
+extern bool servo_sim_bus_sending(uint8_t bus);
+
+/**
+ * @brief Write a command packet to a simulated bus.
+ * @ingroup servo
+ *
+ * Like writing a packet into the UART TX FIFO, this returns immediately. The
+ * bytes are on the wire for their 115200 baud time, and a reply starts after
+ * the last byte plus the servo's latency. If a reply is on the bus while
+ * the packet is being sent, a collision is recorded and both the command and
+ * the reply are garbled.
+ *
+ * @param bus The bus to write to
+ * @param buf The bytes to write
+ * @param len The number of bytes
+ */
+extern void servo_sim_bus_write(uint8_t bus, const uint8_t* buf, size_t len);
+
+/**
+ * @brief Set the rate at which line noise corrupts reply bytes.
+ * @ingroup servo
+ *
+ * @param per_10k Corrupted bytes per 10,000 bytes (0 = no noise)
+ */
+extern void servo_sim_noise_set(uint16_t per_10k);
+
+/**
+ * @brief Get (a copy of) a simulated bus' statistics.
+ * @ingroup servo
+ *
+ * @param bus The bus
+ * @param stats Pointer to the structure to fill in
+ */
+extern void servo_sim_stats(uint8_t bus, servo_sim_stats_t* stats);
+
+/**
+ * @brief Clear a simulated bus' statistics.
+ * @ingroup servo
+ *
+ * @param bus The bus
+ */
+extern void servo_sim_stats_clear(uint8_t bus);
+
+/**
+ * @brief Initialize the simulated servo bus.
+ * @ingroup servo
+ *
+ * @param rx_fn The function to call with each byte the servos put on the bus
+ * @param seed The seed for the latency jitter and noise generator
+ */
+extern void servo_sim_module_init(servo_sim_rx_fn rx_fn, uint32_t seed);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // SERVO_SIM_H_
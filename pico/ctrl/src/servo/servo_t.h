@@ -35,6 +35,47 @@ typedef enum BUS_SERVO_MODE_ {
 
 #define BS_BROADCAST_ID 254
 
+//Macro function  get lower 8 bits of A
+#define GET_LOW_BYTE(A) (uint8_t)((A))
+//Macro function  get higher 8 bits of A
+#define GET_HIGH_BYTE(A) (uint8_t)((A) >> 8)
+//Macro Function  put A as higher 8 bits   B as lower 8 bits   which amalgamated into 16 bits integer
+#define BYTES_TO_WORD(A, B) ((((uint16_t)(A)) << 8) | (uint8_t)(B))
+
+// ############################################################################
+// Bus Servo Commands
+// ############################################################################
+//
+#define BS_FRAME_HEADER                 0x55
+#define BS_MOVE_TIME_WRITE               1
+#define BS_MOVE_TIME_READ                2
+#define BS_MOVE_TIME_WAIT_WRITE          7
+#define BS_MOVE_TIME_WAIT_READ           8
+#define BS_MOVE_START                   11
+#define BS_MOVE_STOP                    12
+#define BS_ID_WRITE                     13
+#define BS_ID_READ                      14
+#define BS_ANGLE_OFFSET_ADJUST          17
+#define BS_ANGLE_OFFSET_WRITE           18
+#define BS_ANGLE_OFFSET_READ            19
+#define BS_ANGLE_LIMIT_WRITE            20
+#define BS_ANGLE_LIMIT_READ             21
+#define BS_VIN_LIMIT_WRITE              22
+#define BS_VIN_LIMIT_READ               23
+#define BS_TEMP_MAX_LIMIT_WRITE         24
+#define BS_TEMP_MAX_LIMIT_READ          25
+#define BS_TEMP_READ                    26
+#define BS_VIN_READ                     27
+#define BS_POS_READ                     28
+#define BS_SERVO_OR_MOTOR_MODE_WRITE    29
+#define BS_SERVO_OR_MOTOR_MODE_READ     30
+#define BS_LOAD_OR_UNLOAD_WRITE         31
+#define BS_LOAD_OR_UNLOAD_READ          32
+#define BS_LED_CTRL_WRITE               33
+#define BS_LED_CTRL_READ                34
+#define BS_LED_ERROR_WRITE              35
+#define BS_LED_ERROR_READ               36
+
 
 enum BS_STATUS_PACKET_OFFSETS_ {
     BSPKT_HEADER1 = 0,
@@ -44,7 +85,45 @@ enum BS_STATUS_PACKET_OFFSETS_ {
     BSPKT_CMD,
     BSPKT_DATA
 };
-#define BSPKT_PAYLOAD_MAX_LEN 8
+/** @brief Most parameters in a command or a reply */
+#define BSPKT_PARAMS_MAX 4
+/** @brief Packet length for a number of parameters (header, ID, LEN, CMD, params, checksum) */
+#define BSPKT_LEN_FOR(nparams) (BSPKT_DATA + (nparams) + 1)
+/** @brief Length of the largest command or reply packet */
+#define BSPKT_PAYLOAD_MAX_LEN BSPKT_LEN_FOR(BSPKT_PARAMS_MAX)
+
+/**
+ * @brief Parameter values of a command or a reply, unpacked.
+ *
+ * Which member is used depends on the command (see `bs_codec.h`).
+ */
+typedef union BS_PARAMS_ {
+    uint8_t u8;             // ID, temperature (°C), temperature limit, load, LED control, LED error mask
+    int8_t s8;              // Angle offset
+    int16_t s16;            // Position
+    uint16_t u16;           // Input voltage (mV)
+    struct {
+        int16_t pos;
+        uint16_t time;      // ms
+    } move;                 // MOVE_TIME, MOVE_TIME_WAIT
+    struct {
+        uint16_t min;
+        uint16_t max;
+    } limit;                // ANGLE_LIMIT, VIN_LIMIT (mV)
+    struct {
+        uint8_t mode;       // servo_mode_t
+        int16_t speed;
+    } mode;                 // SERVO_OR_MOTOR_MODE
+} bs_params_t;
+
+/**
+ * @brief A decoded (validated) command or reply packet.
+ */
+typedef struct BS_PACKET_ {
+    uint8_t id;
+    uint8_t cmd;
+    bs_params_t params;
+} bs_packet_t;
 
 typedef struct BS_RX_STATUS_ {
     uint8_t buf[BSPKT_PAYLOAD_MAX_LEN]; // Control bytes and payload of the largest response (plus checksum)
@@ -52,19 +131,57 @@ typedef struct BS_RX_STATUS_ {
     bool frame_started;
     uint8_t len;
     bool pending;
+    bool queued;                        // A read for the servo is queued or in progress
+    bs_packet_t reply;                  // The last good reply
 } bs_rx_status_t;
 
+/**
+ * @brief Reply latency tracking for a servo.
+ *
+ * The smoothed latency and its mean deviation are kept scaled (x8 and x4)
+ * so that the moving averages can be done with shifts and no loss of
+ * resolution (the same as TCP round-trip time estimation).
+ */
+typedef struct BS_LATENCY_ {
+    int32_t srtt_x8;        // Smoothed reply latency (µs) x 8
+    int32_t rttvar_x4;      // Smoothed latency mean deviation (µs) x 4
+    uint16_t timeout_ms;    // Current reply timeout (0 = not yet set)
+    uint8_t fails;          // Consecutive failures to reply
+    bool offline;           // Servo has stopped replying
+    uint32_t probe_ms;      // When an offline servo can next be probed
+    uint32_t replies;       // Successful replies
+    uint32_t timeouts;      // Reply timeouts
+} bs_latency_t;
+
 typedef struct BUS_SERVO_ {
     uint8_t id;     // Servo ID
+    uint8_t bus;    // Servo bus the servo is connected to (0 - SERVO_BUS_CNT-1)
     servo_mode_t mode;
     bs_rx_status_t _rxstatus;
+    bs_latency_t _latency;
 } servo_t;
 #define SERVO_NONE ((servo_t*)0)
 
+/**
+ * @brief Servo bus statistics.
+ */
+typedef struct SERVO_BUS_STATS_ {
+    uint32_t actions;           // Action (write) commands sent
+    uint32_t queue_full;        // Commands not sent because the bus queue was full
+    uint32_t reads;             // Read commands sent
+    uint32_t replies;           // Good replies received
+    uint32_t timeouts;          // Reads that timed out
+    uint32_t reads_skipped;     // Reads not sent because the servo is offline
+    uint32_t timeout_wait_ms;   // Bus time spent waiting for replies that didn't come
+    uint32_t tx_inline;         // Commands sent waiting here (no alarm was free for the end of TX)
+} servo_bus_stats_t;
+
 typedef struct SERVO_PARAMS_ {
     uint8_t servo_id;
+    uint8_t bus;      // Servo bus
     uint16_t pos;     // Servo ID
     uint16_t time;
+    uint16_t seq;     // Bus transaction sequence number
 } servo_params_t;
 
 
@@ -27,6 +27,16 @@
  * RR_DIR   : Turns the Right-Rear drive wheel
  * BOGIE_PIVOT : Reads, and can drive, the bogie pivot arm angle
  *
+ * With two servo buses (SERVO_BUS_CNT=2) the drive servos are on bus 0 and the
+ * directional (steering) servos are on bus 1, so steering and drive commands,
+ * and the status polling of each, don't wait on each other.
+ *
+ * At start-up all of the servos are pinged (back-to-back on each bus) to find
+ * the ones that are present. The mode of each present servo is then read back,
+ * and only written if it differs from what is needed. The angle limits, offset
+ * (trim) and LED alarms kept in a servo are its own calibration, and are left
+ * alone. Servos that are missing only cost the short ping timeout.
+ *
  * Copyright 2023-25 AESilky
  *
  * SPDX-License-Identifier: MIT
@@ -34,11 +44,15 @@
 
 #include "servos.h"
 #include "servo.h"
+#include "servo_mh.h"
+#include "servo_sim.h"
 
 #include "board.h"
 #include "rover_info.h"
 #include "cmt/cmt.h"
 
+#include "system_defs.h"
+
 #include "pico/stdlib.h"
 
 
@@ -48,11 +62,27 @@
 // ############################################################################
 //
 #define DIRECTIONAL_SERVO_POS_CENTER 500
+#define SERVO_CNT (DIRECTIONAL_SERVO_CNT + DRIVE_SERVO_CNT)
+#define POLL_REPORT_HK_CNT 625  // Report the poll rate every 10 seconds (625 x 16ms)
+#ifndef SERVO_POLL_PERIOD_MS
+#define SERVO_POLL_PERIOD_MS 50 // Shortest time from the start of one status poll cycle of a bus to the next (20Hz)
+#endif
+/** @brief Times a start-up configuration read is retried before writing the setting anyway */
+#define SERVO_START_RETRIES 2
 /** @brief Left-Front and Right-Rear position for Rotate-In-Place */
 #define RIP_LFRR_POS ((uint16_t)(DIRECTIONAL_SERVO_POS_CENTER - 400))  // SERVO_POS_RIP
 /** @brief Right-Front and Left-Rear position for Rotate-In-Place */
 #define RIP_RFLR_POS ((uint16_t)(DIRECTIONAL_SERVO_POS_CENTER + 400))  // SERVO_POS_RIP
 
+/** @brief Bus for the drive servos */
+#define SERVO_BUS_DRIVE 0
+/** @brief Bus for the directional servos */
+#if SERVO_BUS_CNT > 1
+#define SERVO_BUS_DIR 1
+#else
+#define SERVO_BUS_DIR 0
+#endif
+
 typedef enum DIRECTIONAL_SERVOS_ID_ {
     SRVDIR_LF = 0,
     SRVDIR_LR,
@@ -91,6 +121,65 @@ typedef struct DRIVE_SERVO_CTRL_ {
     int16_t speed;
 } drv_servo_ctrl_t;
 
+/**
+ * @brief Start-up steps for a servo.
+ *
+ * The reads are done in order, and the settings are written once all of them
+ * have been read.
+ */
+typedef enum SERVO_START_STEP_ {
+    SSS_PING = 0,       // Find out if it's there
+    SSS_MODE_RD,        // Read the mode (and motor speed)
+    SSS_CONFIG,         // Write the settings that differ, and power up
+    SSS_READY,          // Configured and powered up
+    SSS_MISSING,        // Didn't answer the ping
+} servo_start_step_t;
+
+/**
+ * @brief The settings kept in a servo that are configured at start-up.
+ */
+typedef struct SERVO_CFG_ {
+    servo_mode_t mode;
+    int16_t speed;
+} servo_cfg_t;
+
+/**
+ * @brief The start-up commands (bits of `servo_start_t.sent`).
+ */
+typedef enum SERVO_START_CMD_ {
+    SSC_MODE = 0,       // Set the mode (and motor speed)
+    SSC_MOVE,           // Move a directional servo to the middle
+    SSC_LOAD,           // Power on
+} servo_start_cmd_t;
+
+/**
+ * @brief Start-up state of a servo.
+ */
+typedef struct SERVO_START_ {
+    servo_t* servo;
+    dir_servo_ctrl_t* dirscs;       // The directional servo control (NULL for a drive servo)
+    servo_start_step_t step;
+    bool waiting;                   // A read has been sent and we are waiting for the result
+    uint8_t retries;
+    uint8_t read_ok;                // Bit for each step that was read successfully
+    uint8_t sent;                   // Bit for each start-up command that has been queued
+    servo_cfg_t want;               // The settings it needs
+    servo_cfg_t have;               // The settings read back from it
+} servo_start_t;
+
+/**
+ * @brief Status polling for a servo bus.
+ */
+typedef struct SERVO_POLL_ {
+    servo_t* servos[SERVO_CNT];     // The servos on the bus, in the order they are polled
+    uint8_t cnt;
+    uint8_t next;
+    uint32_t cycles;                // Times all of the servos on the bus have been polled
+    uint64_t cycle_start_us;        // When the current cycle started
+    bool scheduled;                 // The next cycle is waiting for its time
+    cmt_msg_t msg_next;             // Scheduled message to start the next cycle
+} servo_poll_t;
+
 
 // ############################################################################
 // Data
@@ -99,11 +188,36 @@ typedef struct DRIVE_SERVO_CTRL_ {
 static dir_servo_ctrl_t _dir_servos[4];
 static drv_servo_ctrl_t _drv_servos[6];
 
+/** @brief Status polling for each bus */
+static servo_poll_t _polls[SERVO_BUS_CNT];
+static bool _polling;
+
+/** @brief Start-up state of each servo */
+static servo_start_t _starts[SERVO_CNT];
+static bool _starting;
+static uint64_t _start_us;
+
+/** @brief The read command for each of the start-up read steps */
+static const uint8_t _start_reads[] = {
+    BS_ID_READ,                     // SSS_PING
+    BS_SERVO_OR_MOTOR_MODE_READ,    // SSS_MODE_RD
+};
+
 
 // ############################################################################
 // Function Declarations
 // ############################################################################
 //
+static void _handle_servo_read_error(cmt_msg_t* msg);
+static void _handle_servo_status_rcvd(cmt_msg_t* msg);
+static void _poll(uint8_t bus);
+static void _poll_next_mh(cmt_msg_t* msg);
+static bool _start_config(servo_start_t* st);
+static void _start_done_check(void);
+static servo_start_t* _start_find(uint8_t bus, uint8_t id);
+static void _start_read(servo_start_t* st);
+static void _start_read_error(servo_start_t* st);
+static void _start_reply(servo_start_t* st);
 static void _position_lf_mh(cmt_msg_t* msg);
 static bool _position_lf(uint16_t pos, uint16_t time);
 static void _position_lr_mh(cmt_msg_t* msg);
@@ -118,6 +232,51 @@ static bool _position_rr(uint16_t pos, uint16_t time);
 // Message Handlers
 // ############################################################################
 //
+static void _handle_servo_read_error(cmt_msg_t* msg) {
+    if (_starting) {
+        servo_start_t* st = _start_find(msg->data.servo_params.bus, msg->data.servo_params.servo_id);
+        if (st) {
+            _start_read_error(st);
+        }
+        return;
+    }
+    // The servo didn't reply (or the reply was bad). Go on to the next one.
+    _poll(msg->data.servo_params.bus);
+}
+
+static void _handle_servo_status_rcvd(cmt_msg_t* msg) {
+    uint8_t id = msg->data.servo_params.servo_id;
+    if (_starting) {
+        servo_start_t* st = _start_find(msg->data.servo_params.bus, id);
+        if (st) {
+            _start_reply(st);
+        }
+        return;
+    }
+    // Save the position if it's one of the directional servos, then read the next.
+    for (int i = 0; i < DIRECTIONAL_SERVO_CNT; i++) {
+        dir_servo_ctrl_t* dirscs = &_dir_servos[i];
+        if (dirscs->servo.id == id) {
+            int16_t pos = servo_position(&dirscs->servo);
+            if (pos >= 0) {
+                dirscs->pos = (uint16_t)pos;
+            }
+            break;
+        }
+    }
+    _poll(msg->data.servo_params.bus);
+}
+
+static void _poll_next_mh(cmt_msg_t* msg) {
+    // The time for the next poll cycle of the bus.
+    uint8_t bus = msg->data.servo_params.bus;
+    _polls[bus].scheduled = false;
+    _poll(bus);
+}
+
+const msg_handler_entry_t servos_read_error_handler_entry = { MSG_SERVO_READ_ERROR, _handle_servo_read_error };
+const msg_handler_entry_t servos_status_rcvd_handler_entry = { MSG_SERVO_STATUS_RCVD, _handle_servo_status_rcvd };
+
 static void _position_lf_mh(cmt_msg_t* msg) {
     // Try positioning the left-front again.
     _position_lf(msg->data.servo_params.pos, msg->data.servo_params.time);
@@ -144,6 +303,236 @@ static void _position_rr_mh(cmt_msg_t* msg) {
 // ############################################################################
 //
 
+/**
+ * @brief Read the status (position) of the next servo on a bus.
+ *
+ * Within a poll cycle each reply (or error/timeout) triggers the read of the
+ * next servo, so a servo that isn't replying only costs its (adaptive)
+ * timeout. A cycle starts no sooner than SERVO_POLL_PERIOD_MS after the one
+ * before it (the next one is scheduled), which leaves the bus free for move
+ * and mode commands, and core 0 free of reply handling, in between. Offline
+ * servos are skipped by the servo layer, in which case we go on to the
+ * following one.
+ *
+ * @param bus The servo bus
+ */
+static void _poll(uint8_t bus) {
+    if (!_polling || bus >= SERVO_BUS_CNT) {
+        return;
+    }
+    servo_poll_t* poll = &_polls[bus];
+    if (poll->scheduled) {
+        return;  // The next cycle will start when its message is handled.
+    }
+    for (int i = 0; i < poll->cnt; i++) {
+        if (servo_bus_reads_pending(bus)) {
+            return;  // A read is in progress. Its completion will call us.
+        }
+        if (poll->next == 0) {
+            // Starting a cycle. Wait for the period if the last one was quick.
+            uint64_t now = now_us();
+            uint64_t elapsed = now - poll->cycle_start_us;
+            if (poll->cycle_start_us != 0 && elapsed < (SERVO_POLL_PERIOD_MS * 1000)) {
+                poll->scheduled = true;
+                schedule_core0_msg_in_ms((int32_t)(((SERVO_POLL_PERIOD_MS * 1000) - elapsed + 999) / 1000), &poll->msg_next);
+                return;
+            }
+            poll->cycle_start_us = now;
+        }
+        servo_t* servo = poll->servos[poll->next];
+        poll->next++;
+        if (poll->next >= poll->cnt) {
+            poll->next = 0;
+            poll->cycles++;
+        }
+        if (servo_position_read(servo)) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Queue a start-up command for a servo, if it hasn't been already.
+ *
+ * @return true The command has been queued (now or before)
+ */
+static bool _start_cmd(servo_start_t* st, servo_start_cmd_t cmd) {
+    if (st->sent & (1 << cmd)) {
+        return (true);
+    }
+    servo_t* servo = st->servo;
+    bool ok = false;
+    switch (cmd) {
+        case SSC_MODE:
+            ok = servo_set_mode(servo, st->want.mode, st->want.speed);
+            break;
+        case SSC_MOVE:
+            ok = servo_move(servo, (int16_t)(st->dirscs->max_pos / 2), 1000);  // Move to the middle and take 1 second to do it.
+            break;
+        case SSC_LOAD:
+            ok = servo_load(servo);
+            break;
+    }
+    if (ok) {
+        st->sent |= (1 << cmd);
+    }
+    return (ok);
+}
+
+/**
+ * @brief Write the mode of a servo if it differs from what it has, then power
+ * it up.
+ *
+ * If the mode couldn't be read it is written. Drive servos are put in motor
+ * mode (at their speed). Directional servos are put in position mode and moved
+ * to the middle slowly, so as to not cause undue force or movement.
+ *
+ * Each command is only queued once. If the bus queue is full, the commands
+ * that were queued are kept and the rest are sent when this is tried again.
+ *
+ * @param st The servo start-up state
+ * @return true The commands were queued
+ * @return false A command couldn't be queued (it will be tried again)
+ */
+static bool _start_config(servo_start_t* st) {
+    servo_cfg_t* want = &st->want;
+    servo_cfg_t* have = &st->have;
+
+    if (!(st->read_ok & (1 << SSS_MODE_RD)) || have->mode != want->mode
+        || (want->mode == BS_MOTOR_MODE && have->speed != want->speed)) {
+        if (!(st->sent & (1 << SSC_MODE))) {
+            debug_printf("Servo %hhu: Setting mode.\n", st->servo->id);
+        }
+        if (!_start_cmd(st, SSC_MODE)) {
+            return false;
+        }
+    }
+    if (st->dirscs && !_start_cmd(st, SSC_MOVE)) {
+        return false;
+    }
+    if (!_start_cmd(st, SSC_LOAD)) {
+        return false;
+    }
+    *have = *want;
+    st->step = SSS_READY;
+    _start_done_check();
+    return true;
+}
+
+/**
+ * @brief Check for all of the servos having been started. When they have,
+ * report the time it took and start polling the servo status.
+ */
+static void _start_done_check(void) {
+    int present = 0;
+    for (int i = 0; i < SERVO_CNT; i++) {
+        if (_starts[i].step < SSS_READY) {
+            return;
+        }
+        if (_starts[i].step == SSS_READY) {
+            present++;
+        }
+    }
+    _starting = false;
+    info_printf("Servos ready in %lums (%d of %d present).\n",
+        (uint32_t)((now_us() - _start_us + 500) / 1000), present, SERVO_CNT);
+    // Start polling the servo status
+    _polling = true;
+    for (uint8_t b = 0; b < SERVO_BUS_CNT; b++) {
+        _poll(b);
+    }
+}
+
+static servo_start_t* _start_find(uint8_t bus, uint8_t id) {
+    for (int i = 0; i < SERVO_CNT; i++) {
+        servo_start_t* st = &_starts[i];
+        if (st->servo->id == id && st->servo->bus == bus) {
+            return (st);
+        }
+    }
+    return (NULL);
+}
+
+/**
+ * @brief Send the read for the start-up step a servo is on.
+ *
+ * If it can't be sent (bus queue full) it is tried again by housekeeping.
+ */
+static void _start_read(servo_start_t* st) {
+    bool sent;
+    if (st->step == SSS_PING) {
+        sent = servo_ping(st->servo);
+    }
+    else {
+        sent = servo_read(st->servo, _start_reads[st->step]);
+    }
+    st->waiting = sent;
+}
+
+/**
+ * @brief A start-up read of a servo failed.
+ *
+ * A servo that doesn't answer the ping is missing. Other reads are retried, and
+ * if they keep failing the setting is written without knowing what it was.
+ */
+static void _start_read_error(servo_start_t* st) {
+    if (!st->waiting) {
+        return;
+    }
+    st->waiting = false;
+    if (st->step == SSS_PING) {
+        warn_printf("Servo %hhu not found on bus %hhu.\n", st->servo->id, st->servo->bus);
+        st->step = SSS_MISSING;
+        _start_done_check();
+        return;
+    }
+    if (st->retries++ >= SERVO_START_RETRIES) {
+        st->retries = 0;
+        st->step++;
+    }
+    if (st->step == SSS_CONFIG) {
+        _start_config(st);
+    }
+    else {
+        _start_read(st);
+    }
+}
+
+/**
+ * @brief A start-up read of a servo completed. Save the value and go on to the
+ * next step.
+ */
+static void _start_reply(servo_start_t* st) {
+    if (!st->waiting) {
+        return;
+    }
+    const bs_packet_t* reply = servo_reply(st->servo);
+    if (reply->cmd != _start_reads[st->step]) {
+        _start_read_error(st);
+        return;
+    }
+    st->waiting = false;
+    servo_cfg_t* have = &st->have;
+    switch (st->step) {
+        case SSS_MODE_RD:
+            have->mode = (servo_mode_t)reply->params.mode.mode;
+            have->speed = reply->params.mode.speed;
+            break;
+        default:
+            break;
+    }
+    st->read_ok |= (1 << st->step);
+    st->retries = 0;
+    st->step++;
+    if (st->step == SSS_CONFIG) {
+        _start_config(st);
+    }
+    else {
+        _start_read(st);
+    }
+}
+
+
 /**
  * @brief Dedicated function to control the Left-Front servo.
  *
@@ -210,7 +599,7 @@ static bool _position_lr(uint16_t pos, uint16_t time) {
  * @return false The operation couldn't be performed (will keep trying)
  */
 static bool _position_rf(uint16_t pos, uint16_t time) {
-    if (servo_move(&_dir_servos[SRVDIR_LF].servo, pos, time)) {
+    if (servo_move(&_dir_servos[SRVDIR_RF].servo, pos, time)) {
         return true;
     }
     // Command couldn't be sent, post ourself a message to try again.
@@ -236,7 +625,7 @@ static bool _position_rf(uint16_t pos, uint16_t time) {
  * @return false The operation couldn't be performed (will keep trying)
  */
 static bool _position_rr(uint16_t pos, uint16_t time) {
-    if (servo_move(&_dir_servos[SRVDIR_LR].servo, pos, time)) {
+    if (servo_move(&_dir_servos[SRVDIR_RR].servo, pos, time)) {
         return true;
     }
     // Command couldn't be sent, post ourself a message to try again.
@@ -274,45 +663,72 @@ void servos_zero_position() {
 //
 
 void servos_housekeeping(void) {
-    // ZZZ - Temp, exercise the position servos
-    static uint8_t hk_count = 0;
-    static uint8_t hk_srvo = 0;
-    if (++hk_count % (62 * 3) == 0) {
-        switch (hk_srvo++ & 0x03) {
-            case 0:
-                servo_position_read(&_dir_servos[SRVDIR_LF].servo);
-                break;
-            case 1:
-                servo_position_read(&_dir_servos[SRVDIR_LR].servo);
-                break;
-            case 2:
-                servo_position_read(&_dir_servos[SRVDIR_RF].servo);
-                break;
-            case 3:
-                servo_position_read(&_dir_servos[SRVDIR_RR].servo);
-                break;
+    static uint16_t hk_count = 0;
+    static servo_bus_stats_t last[SERVO_BUS_CNT];
+    static uint32_t last_cycles[SERVO_BUS_CNT];
+
+    if (_starting) {
+        // Send the start-up reads, and settings, that couldn't be sent before.
+        for (int i = 0; i < SERVO_CNT; i++) {
+            servo_start_t* st = &_starts[i];
+            if (st->step == SSS_CONFIG) {
+                _start_config(st);
+            }
+            else if (st->step < SSS_CONFIG && !st->waiting) {
+                _start_read(st);
+            }
+        }
+    }
+    for (uint8_t b = 0; b < SERVO_BUS_CNT; b++) {
+        // Restart polling if it stalled (all offline, or a read couldn't be sent)
+        if (!servo_bus_reads_pending(b)) {
+            _poll(b);
+        }
+    }
+    if (++hk_count % POLL_REPORT_HK_CNT == 0) {
+        // Report the throughput of each bus, and the rate that all of the servos
+        // get a status read (the slowest bus).
+        uint32_t secs = (POLL_REPORT_HK_CNT * 16) / 1000;
+        uint32_t update_rate = UINT32_MAX;
+        for (uint8_t b = 0; b < SERVO_BUS_CNT; b++) {
+            servo_bus_stats_t bs;
+            servo_bus_stats(b, &bs);
+            uint32_t cycles = _polls[b].cycles;
+            uint32_t rate = (cycles - last_cycles[b]) / secs;
+            if (_polls[b].cnt > 0 && rate < update_rate) {
+                update_rate = rate;
+            }
+            debug_printf("Servo bus %hhu: %lu reads/s  %lu cmds/s  %lu timeouts (%lums)  %lu skipped  %lu full  %lu tx inline\n",
+                b,
+                (bs.replies - last[b].replies) / secs,
+                (bs.actions - last[b].actions) / secs,
+                bs.timeouts - last[b].timeouts,
+                bs.timeout_wait_ms - last[b].timeout_wait_ms,
+                bs.reads_skipped - last[b].reads_skipped,
+                bs.queue_full - last[b].queue_full,
+                bs.tx_inline - last[b].tx_inline);
+            last[b] = bs;
+            last_cycles[b] = cycles;
         }
+        debug_printf("Servo status update rate (all servos): %luHz\n", (update_rate == UINT32_MAX ? 0 : update_rate));
     }
 }
 
 void servos_start(void) {
     servo_module_start();
-    // Read and set all of the servos and then power them up.
-    //  Initialize all of the drive servos to DRIVE mode at 0 speed.
-    for (int i = 0; i < DRIVE_SERVO_CNT; i++) {
-        drv_servo_ctrl_t* drvscs = &_drv_servos[i];
-        int16_t speed = drvscs->speed;
-        servo_run(&drvscs->servo, speed);  // Mode to 'Motor' with a speed of 0
-        servo_load(&drvscs->servo);        // Power on
-    }
-    // For the positional servos, move them to neutral positions slowly, so as
-    // to not cause undue force or movement.
-    for (int i = 0; i < DIRECTIONAL_SERVO_CNT; i++) {
-        dir_servo_ctrl_t* dirscs = &_dir_servos[i];
-        int16_t pos = (int16_t)(dirscs->max_pos / 2);
-        servo_set_mode(&dirscs->servo, BS_POSITION_MODE, 0);  // Mode to 'Position' with a speed of 0
-        servo_move(&dirscs->servo, pos, 1000);  // Move to the middle and take 1 seconds to do it.
-        servo_load(&dirscs->servo);  // Power on
+    // Ping all of the servos. The pings are queued on each bus and go out
+    // back-to-back. Each reply moves that servo on to reading its settings
+    // (in parallel with the other servos), then writing the ones that differ
+    // and powering it up. Status polling starts once they are all done.
+    _start_us = now_us();
+    _starting = true;
+    for (int i = 0; i < SERVO_CNT; i++) {
+        servo_start_t* st = &_starts[i];
+        st->step = SSS_PING;
+        st->read_ok = 0;
+        st->sent = 0;
+        st->retries = 0;
+        _start_read(st);
     }
 }
 
@@ -331,43 +747,103 @@ void servos_module_init(void) {
     drvscs->loc = SRVDRV_LF;
     drvscs->speed = 0;
     drvscs->servo.id = 10;
+    drvscs->servo.bus = SERVO_BUS_DRIVE;
     drvscs = &_drv_servos[SRVDRV_LM];
     drvscs->loc = SRVDRV_LM;
     drvscs->speed = 0;
     drvscs->servo.id = 11;
+    drvscs->servo.bus = SERVO_BUS_DRIVE;
     drvscs = &_drv_servos[SRVDRV_LR];
     drvscs->loc = SRVDRV_LR;
     drvscs->speed = 0;
     drvscs->servo.id = 12;
+    drvscs->servo.bus = SERVO_BUS_DRIVE;
     drvscs = &_drv_servos[SRVDRV_RF];
     drvscs->loc = SRVDRV_RF;
     drvscs->speed = 0;
     drvscs->servo.id = 13;
+    drvscs->servo.bus = SERVO_BUS_DRIVE;
     drvscs = &_drv_servos[SRVDRV_RM];
     drvscs->loc = SRVDRV_RM;
     drvscs->speed = 0;
     drvscs->servo.id = 14;
+    drvscs->servo.bus = SERVO_BUS_DRIVE;
     drvscs = &_drv_servos[SRVDRV_RR];
     drvscs->loc = SRVDRV_RR;
     drvscs->speed = 0;
     drvscs->servo.id = 15;
+    drvscs->servo.bus = SERVO_BUS_DRIVE;
     //  Directional
     dir_servo_ctrl_t* dirscs = &_dir_servos[SRVDIR_LF];
     dirscs->loc = SRVDIR_LF;
     dirscs->max_pos = 1000;
     dirscs->servo.id = 50;
+    dirscs->servo.bus = SERVO_BUS_DIR;
     dirscs = &_dir_servos[SRVDIR_LR];
     dirscs->loc = SRVDIR_LR;
     dirscs->max_pos = 1000;
     dirscs->servo.id = 51;
+    dirscs->servo.bus = SERVO_BUS_DIR;
     dirscs = &_dir_servos[SRVDIR_RF];
     dirscs->loc = SRVDIR_RF;
     dirscs->max_pos = 1000;
     dirscs->servo.id = 52;
+    dirscs->servo.bus = SERVO_BUS_DIR;
     dirscs = &_dir_servos[SRVDIR_RR];
     dirscs->loc = SRVDIR_RR;
     dirscs->max_pos = 1000;
     dirscs->servo.id = 53;
+    dirscs->servo.bus = SERVO_BUS_DIR;
+
+    // Set up the status polling for each bus. Interleave the steering and drive
+    // servos if they share a bus.
+    for (int i = 0; i < DRIVE_SERVO_CNT; i++) {
+        servo_t* servo = &_drv_servos[i].servo;
+        _polls[servo->bus].servos[_polls[servo->bus].cnt++] = servo;
+        if (i < DIRECTIONAL_SERVO_CNT) {
+            servo = &_dir_servos[i].servo;
+            _polls[servo->bus].servos[_polls[servo->bus].cnt++] = servo;
+        }
+    }
+    for (uint8_t b = 0; b < SERVO_BUS_CNT; b++) {
+        cmt_msg_init3(&_polls[b].msg_next, (b == 0 ? MSG_SERVO_POLL : MSG_SERVO_POLL_B1), MSG_PRI_NORM, _poll_next_mh);
+        _polls[b].msg_next.data.servo_params.bus = b;
+    }
+    _polling = false;
+
+    // Set up the start-up state, with the settings each servo needs.
+    for (int i = 0; i < SERVO_CNT; i++) {
+        servo_start_t* st = &_starts[i];
+        if (i < DRIVE_SERVO_CNT) {
+            drv_servo_ctrl_t* drvscs = &_drv_servos[i];
+            st->servo = &drvscs->servo;
+            st->dirscs = NULL;
+            st->want.mode = BS_MOTOR_MODE;
+            st->want.speed = drvscs->speed;
+        }
+        else {
+            dir_servo_ctrl_t* dirscs = &_dir_servos[i - DRIVE_SERVO_CNT];
+            st->servo = &dirscs->servo;
+            st->dirscs = dirscs;
+            st->want.mode = BS_POSITION_MODE;
+            st->want.speed = 0;
+        }
+        st->step = SSS_PING;
+    }
+    _starting = false;
 
     servo_module_init();
+#if SERVO_BUS_SIM
+    // Put the rover's servos on the simulated buses (typical reply latency).
+    for (int i = 0; i < DRIVE_SERVO_CNT; i++) {
+        servo_sim_servo_add(_drv_servos[i].servo.bus, _drv_servos[i].servo.id, 300, 200);
+    }
+    for (int i = 0; i < DIRECTIONAL_SERVO_CNT; i++) {
+        servo_sim_servo_add(_dir_servos[i].servo.bus, _dir_servos[i].servo.id, 300, 200);
+    }
+    // Unplug some of them (the last ones) to check the start-up with servos missing.
+    for (int i = 0; i < SERVO_BUS_SIM_MISSING && i < SERVO_CNT; i++) {
+        servo_sim_servo_present(_starts[SERVO_CNT - 1 - i].servo->id, false);
+    }
+#endif
 }
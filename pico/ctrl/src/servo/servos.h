@@ -69,8 +69,10 @@ extern void servos_housekeeping(void);
  * @ingroup servo
  *
  * This should be called after the messaging system is up and running.
- * This reads the position, sets the position, and powers up all of the
- * servos on the rover.
+ * This finds the servos that are present, reads back their settings, writes
+ * the ones that differ, and powers them up. It doesn't wait - the start-up is
+ * driven by the servo replies, and status polling starts once all of the
+ * servos are ready (or found to be missing).
  */
 extern void servos_start(void);
 
@@ -4,6 +4,14 @@
  * The SPI is used by 3 devices, so this provides routines
  * to read/write to them in a coordinated way.
  *
+ * Short transactions (like the Expansion I/O register writes) can be
+ * submitted to be run when the bus is available. Long display pixel writes
+ * are split into chunks, and waiting transactions are run between them, so
+ * they don't wait for a whole screen to be painted.
+ *
+ * When `DISP_ILI_EMU` is set, the display commands and data go to the display
+ * controller emulator rather than the SPI.
+ *
  * Copyright 2023-25 AESilky
  * SPDX-License-Identifier: MIT License
  *
@@ -11,10 +19,21 @@
 #include "system_defs.h"
 #include "spi_ops.h"
 #include "board.h"
+#include "display/display_rgb18/ili_emu.h"
 
+#include "hardware/dma.h"
 #include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "pico/critical_section.h"
 #include "pico/sem.h"
 
+#define DISP_OP_CMD 0       // Set the D/C- pin low for command mode
+#define DISP_OP_DATA 1      // Set the D/C- pin high for data mode
+
+#define DISP_CHUNK_BYTES 960    // Most pixel data written between checks for waiting transactions
+                                // (a multiple of 2 and 3, so a chunk ends on a pixel)
+#define DISP_FILL_CHUNK_FRAMES 4096 // Most fill frames sent between checks for waiting transactions (even)
+
 typedef struct _Spi_Dev_Sem_ {
     volatile spi_device_sel_t device;
     volatile uint corenum;
@@ -23,6 +42,78 @@ typedef struct _Spi_Dev_Sem_ {
 
 static spi_dev_sem_t _dev_passkey;     // Passkey used to control singular access to the SPI device select
 
+/** @brief DMA channel used to send display data (-1 until initialized) */
+static int _dma_disp = -1;
+/** @brief DMA channel used to fill the display with a pixel (-1 until initialized) */
+static int _dma_fill = -1;
+static int _dma_disp_active_ch;        // The channel of the active transfer
+static spi_display_dma_wait_fn _dma_disp_ext_wait;  // Set when the active transfer is another module's
+static volatile bool _dma_disp_active;
+/** @brief A fill pixel as two SPI frames. The fill DMA reads it as a 4 byte ring. */
+static uint16_t _fill_frames[2] __attribute__((aligned(4)));
+static uint64_t _dma_disp_wait_us;     // Total time spent waiting for display DMA to finish
+static uint64_t _disp_bytes;           // Total bytes sent to the display
+static uint _disp_frame_bits = 8;      // Current frame size of the Display/Expansion SPI
+
+/** @brief Transactions waiting for the bus (protected by `_txn_cs`) */
+static spi_txn_t* _txn_pending[SPI_TXN_PENDING_MAX];
+static volatile uint _txn_pending_cnt;
+static critical_section_t _txn_cs;
+static uint32_t _txn_latency_max_us;
+static uint32_t _txn_preempt_cnt;
+static uint32_t _txn_inline_cnt;        // Transactions run from within an operation on the same core
+static uint32_t _txn_full_cnt;          // Times a submit waited for room in the queue
+/** @brief Set while display pixel data is being written (and can be interrupted) */
+static spi_display_resume_fn _disp_resume;
+static spi_device_sel_t _selected = SPI_NONE_SELECT;  // The device that is selected
+
+// The old display paths can only be switched back to in an A/B benchmark build.
+#if DISP_AB_BENCH
+static bool _dma_disp_use = true;
+static bool _disp_frame16_use = true;
+static bool _disp_preempt_use = true;
+#else
+static const bool _dma_disp_use = true;
+static const bool _disp_frame16_use = true;
+static const bool _disp_preempt_use = true;
+#endif
+
+/**
+ * @brief Wait for a display DMA transfer to finish (if one is active).
+ *
+ * Waits for the last bit to be shifted out, then drains the data received
+ * while sending (DMA only feeds the TX side) and clears the RX overrun.
+ * The time spent waiting is accumulated, so the CPU time freed up by the DMA
+ * can be measured.
+ */
+static void _dma_disp_wait(void) {
+    if (!_dma_disp_active) {
+        return;
+    }
+    uint64_t t0 = time_us_64();
+    spi_inst_t* spi = SPI_DISP_EXP_DEVICE;
+    if (_dma_disp_ext_wait) {
+        _dma_disp_ext_wait();
+        _dma_disp_ext_wait = NULL;
+    }
+    else {
+        dma_channel_wait_for_finish_blocking(_dma_disp_active_ch);
+    }
+    while (spi_is_busy(spi)) {
+        tight_loop_contents();
+    }
+    while (spi_is_readable(spi)) {
+        (void)spi_get_hw(spi)->dr;
+    }
+    spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+    _dma_disp_active = false;
+    _dma_disp_wait_us += (time_us_64() - t0);
+}
+
+static void _device_select(spi_device_sel_t device);
+static int _read_buf(spi_inst_t* spi, uint8_t txv, uint8_t* dst, size_t len);
+static int _write8_buf(spi_inst_t* spi, const uint8_t* buf, size_t len);
+
 static void _owns_passkey(spi_device_sel_t device) {
     // Check that the device owns the Passkey.
     if (!(device == _dev_passkey.device && get_core_num() == _dev_passkey.corenum && sem_available(&_dev_passkey.sem) == 0)) {
@@ -31,14 +122,157 @@ static void _owns_passkey(spi_device_sel_t device) {
     }
 }
 
+/**
+ * @brief Take the highest priority waiting transaction (the oldest of equals).
+ *
+ * @return spi_txn_t* The transaction, or NULL if none are waiting
+ */
+static spi_txn_t* _txn_take(void) {
+    spi_txn_t* txn = NULL;
+    critical_section_enter_blocking(&_txn_cs);
+    if (_txn_pending_cnt > 0) {
+        uint sel = 0;
+        for (uint i = 1; i < _txn_pending_cnt; i++) {
+            if (_txn_pending[i]->pri > _txn_pending[sel]->pri) {
+                sel = i;
+            }
+        }
+        txn = _txn_pending[sel];
+        for (uint i = sel + 1; i < _txn_pending_cnt; i++) {
+            _txn_pending[i - 1] = _txn_pending[i];
+        }
+        _txn_pending_cnt--;
+    }
+    critical_section_exit(&_txn_cs);
+    return (txn);
+}
+
+/**
+ * @brief Run a transaction.
+ *
+ * MUST BE CALLED HOLDING THE PASSKEY, WITH NO DEVICE SELECTED!
+ */
+static void _txn_do(spi_txn_t* txn) {
+    spi_inst_t* spi = (txn->device == SPI_TOUCH_SELECT ? SPI_TOUCH_DEVICE : SPI_DISP_EXP_DEVICE);
+    _dev_passkey.device = txn->device;
+    _device_select(txn->device);
+    if (txn->tx_len) {
+        _write8_buf(spi, txn->tx, txn->tx_len);
+    }
+    if (txn->rx_len) {
+        _read_buf(spi, SPI_HIGH_TXD_FOR_READ, txn->rx, txn->rx_len);
+    }
+    _device_select(SPI_NONE_SELECT);
+    uint32_t latency = (uint32_t)(time_us_64() - txn->submit_us);
+    if (latency > _txn_latency_max_us) {
+        _txn_latency_max_us = latency;
+    }
+    __dmb();  // The read data must be visible before `done` (on the other core)
+    txn->done = true;
+}
+
+/**
+ * @brief Run the waiting transactions.
+ *
+ * MUST BE CALLED HOLDING THE PASSKEY, WITH NO DEVICE SELECTED!
+ */
+static void _txns_run(void) {
+    spi_txn_t* txn;
+    spi_device_sel_t owner = _dev_passkey.device;
+    while ((txn = _txn_take()) != NULL) {
+        _txn_do(txn);
+    }
+    _dev_passkey.device = owner;
+}
+
+/**
+ * @brief Check if transactions can be run from within an operation on this core.
+ *
+ * They can be run where display pixel data can be interrupted (it is resumed
+ * afterwards), or when nothing is selected. Anywhere else (a command and its
+ * parameters, for instance) deselecting would lose the device's context.
+ */
+static bool _txn_inline_ok(void) {
+    return (_disp_resume != NULL || _selected == SPI_NONE_SELECT);
+}
+
+/**
+ * @brief Run the waiting transactions (and one more, if not NULL) from within
+ * an operation on this core.
+ *
+ * The current transfer is finished and the device deselected (like a
+ * preempt point), the transactions are run, then the device is selected
+ * again and display pixel data that was paused is resumed.
+ *
+ * MUST BE CALLED HOLDING THE PASSKEY, WHERE `_txn_inline_ok`!
+ */
+static void _txn_inline(spi_txn_t* txn) {
+    spi_device_sel_t owner = _dev_passkey.device;
+    spi_display_resume_fn resume = _disp_resume;
+    _disp_resume = NULL;
+    spi_device_sel_t selected = _selected;
+    _device_select(SPI_NONE_SELECT);  // Waits for the DMA
+    _txns_run();
+    if (txn) {
+        _txn_do(txn);
+    }
+    _dev_passkey.device = owner;
+    _txn_inline_cnt++;
+    if (selected != SPI_NONE_SELECT) {
+        _device_select(selected);
+    }
+    if (resume) {
+        resume();
+    }
+}
+
+/**
+ * @brief If the bus is free, take it and run the waiting transactions.
+ *
+ * @param wait_us Time to wait for the bus
+ */
+static void _txns_run_if_free(uint32_t wait_us) {
+    if (sem_acquire_timeout_us(&_dev_passkey.sem, wait_us)) {
+        _dev_passkey.device = SPI_NONE_SELECT;
+        _dev_passkey.corenum = get_core_num();
+        _txns_run();
+        _dev_passkey.corenum = -1;
+        sem_release(&_dev_passkey.sem);
+    }
+}
+
+/**
+ * @brief Let waiting transactions run between chunks of display pixel data.
+ *
+ * The display is deselected, the transactions are run, and the display
+ * driver resumes the pixel data.
+ */
+static void _disp_preempt_point(void) {
+    if (_disp_resume == NULL || _txn_pending_cnt == 0) {
+        return;
+    }
+    spi_display_resume_fn resume = _disp_resume;
+    _disp_resume = NULL;
+    _device_select(SPI_NONE_SELECT);  // Waits for the DMA
+    _txns_run();
+    _txn_preempt_cnt++;
+    _device_select(SPI_DISPLAY_SELECT);
+    resume();
+}
+
 static void _begin(spi_device_sel_t device) {
     sem_acquire_blocking(&_dev_passkey.sem);
     _dev_passkey.device = device;
     _dev_passkey.corenum = get_core_num();
+    // Transactions that were waiting go first (nothing is selected yet).
+    _txns_run();
 }
 
 static void _end(spi_device_sel_t device) {
     _owns_passkey(device);
+    _dma_disp_wait();
+    _disp_resume = NULL;
+    _txns_run();
     _dev_passkey.device = SPI_NONE_SELECT;
     _dev_passkey.corenum = -1;
     sem_release(&_dev_passkey.sem);
@@ -55,18 +289,42 @@ static void _device_select(spi_device_sel_t device) {
     if (device != SPI_NONE_SELECT) {
         _owns_passkey(_dev_passkey.device);
     }
+    // Any display data being sent needs to be out before changing the select.
+    _dma_disp_wait();
     uint8_t hbit = (device & 0x0002) >> 1;
     uint8_t lbit = (device & 0x0001);
     uint32_t value = (hbit << SPI_ADDR_1) | (lbit << SPI_ADDR_0);
     gpio_put_masked(SPI_ADDR_MASK, value);
+    _selected = device;
+#if DISP_ILI_EMU
+    ili_emu_select(device == SPI_DISPLAY_SELECT);
+#endif
+}
+
+/**
+ * @brief Set the frame size of the Display/Expansion SPI (if it isn't already).
+ *
+ * The SPI must not be busy. The blocking operations wait for the data to be
+ * out before returning, and `_dma_disp_wait` is done before any operation.
+ *
+ * @param spi The SPI that is going to be used
+ * @param bits 8 or 16
+ */
+static void _frame_bits(spi_inst_t* spi, uint bits) {
+    if (spi == SPI_DISP_EXP_DEVICE && bits != _disp_frame_bits) {
+        spi_set_format(spi, bits, SPI_CPOL_0, SPI_CPHA_0, SPI_MSB_FIRST);
+        _disp_frame_bits = bits;
+    }
 }
 
 static int _read_buf(spi_inst_t* spi, uint8_t txv, uint8_t* dst, size_t len) {
+    _frame_bits(spi, 8);
     return (spi_read_blocking(spi, txv, dst, len));
 }
 
 static uint8_t _read8(spi_inst_t* spi, uint8_t txv) {
     uint8_t v;
+    _frame_bits(spi, 8);
     int r = spi_read_blocking(spi, txv, &v, 1);
     if (r != 1) {
         v = 0;
@@ -75,26 +333,50 @@ static uint8_t _read8(spi_inst_t* spi, uint8_t txv) {
 }
 
 static int _write8(spi_inst_t* spi, uint8_t data) {
+    _frame_bits(spi, 8);
     return (spi_write_blocking(spi, &data, 1));
 }
 
 static int _write8_buf(spi_inst_t* spi, const uint8_t* buf, size_t len) {
+    _frame_bits(spi, 8);
     return (spi_write_blocking(spi, buf, len));
 }
 
 static int _write16(spi_inst_t* spi, uint16_t data) {
     size_t len = sizeof(uint16_t);
+    if (_disp_frame16_use) {
+        _frame_bits(spi, 16);
+        spi_write16_blocking(spi, &data, 1);
+        return (len);
+    }
     uint8_t bytes[] = {(data & 0xff00) >> 8, data & 0xff};
+    _frame_bits(spi, 8);
     spi_write_blocking(spi, bytes, len);
     return (len);
 }
 
 static int _write16_buf(spi_inst_t* spi, const uint16_t* buf, size_t len) {
+    if (_disp_frame16_use) {
+        // A 16 bit frame is sent MSB first, so the words go out as they are.
+        _frame_bits(spi, 16);
+        spi_write16_blocking(spi, buf, len);
+        return (len);
+    }
+    // Send the words high byte first, a chunk at a time rather than a transfer per word.
+    _frame_bits(spi, 8);
+    uint8_t bytes[64];
+    size_t chunk_words = sizeof(bytes) / sizeof(uint16_t);
     int written = 0;
-    while (len--) {
-        _write16(spi, *buf);
-        buf++;
-        written++;
+    while (len) {
+        size_t words = (len < chunk_words ? len : chunk_words);
+        for (size_t i = 0; i < words; i++) {
+            bytes[2 * i] = (buf[i] & 0xff00) >> 8;
+            bytes[(2 * i) + 1] = buf[i] & 0xff;
+        }
+        spi_write_blocking(spi, bytes, words * sizeof(uint16_t));
+        buf += words;
+        len -= words;
+        written += words;
     }
     return (written);
 }
@@ -103,17 +385,60 @@ void spi_display_begin(void) {
     _begin(SPI_DISPLAY_SELECT);
 }
 
+void spi_display_command_mode(bool cmd) {
+    // The D/C- line can't change until the data being sent is out.
+    _dma_disp_wait();
+    if (cmd) {
+        _disp_resume = NULL;  // A command ends the pixel data
+    }
+    gpio_put(SPI_DISP_CD, (cmd ? DISP_OP_CMD : DISP_OP_DATA));
+#if DISP_ILI_EMU
+    ili_emu_command_mode(cmd);
+#endif
+}
+
+#if DISP_AB_BENCH
+void spi_display_dma_enable(bool use) {
+    _dma_disp_wait();
+    _dma_disp_use = use;
+}
+#endif
+
+void spi_display_dma_wait(void) {
+    _dma_disp_wait();
+}
+
+uint64_t spi_display_dma_wait_us(void) {
+    return (_dma_disp_wait_us);
+}
+
+uint64_t spi_display_bytes(void) {
+    return (_disp_bytes);
+}
+
 void spi_display_end(void) {
     _end(SPI_DISPLAY_SELECT);
 }
 
 int spi_display_read_buf(uint8_t txval, uint8_t* dst, size_t len) {
+    _dma_disp_wait();
+#if DISP_ILI_EMU
+    return (ili_emu_read(dst, len));
+#else
     int r = _read_buf(SPI_DISP_EXP_DEVICE, txval, dst, len);
     return r;
+#endif
 }
 
 uint8_t spi_display_read8(uint8_t txval) {
+    _dma_disp_wait();
+#if DISP_ILI_EMU
+    uint8_t v;
+    ili_emu_read(&v, 1);
+    return (v);
+#else
     return (_read8(SPI_DISP_EXP_DEVICE, txval));
+#endif
 }
 
 void spi_display_select() {
@@ -121,25 +446,165 @@ void spi_display_select() {
 }
 
 int spi_display_write8(uint8_t data) {
+    _dma_disp_wait();
+    _disp_bytes++;
+#if DISP_ILI_EMU
+    ili_emu_write(&data, 1);
+    return (1);
+#else
     int r = _write8(SPI_DISP_EXP_DEVICE, data);
     return r;
+#endif
 }
 
 int spi_display_write8_buf(const uint8_t* buf, size_t len) {
-    int r = _write8_buf(SPI_DISP_EXP_DEVICE, buf, len);
+    _dma_disp_wait();
+    _disp_bytes += len;
+#if DISP_ILI_EMU
+    ili_emu_write(buf, len);
+    return (len);
+#else
+    if (_disp_resume == NULL) {
+        return (_write8_buf(SPI_DISP_EXP_DEVICE, buf, len));
+    }
+    int r = 0;
+    while (len) {
+        _disp_preempt_point();
+        size_t chunk = (len < DISP_CHUNK_BYTES ? len : DISP_CHUNK_BYTES);
+        r += _write8_buf(SPI_DISP_EXP_DEVICE, buf, chunk);
+        buf += chunk;
+        len -= chunk;
+    }
     return r;
+#endif
+}
+
+void spi_display_write8_buf_dma(const uint8_t* buf, size_t len) {
+    _dma_disp_wait();
+    _owns_passkey(SPI_DISPLAY_SELECT);
+    _disp_preempt_point();
+    _disp_bytes += len;
+#if DISP_ILI_EMU
+    ili_emu_write(buf, len);
+#else
+    if (!_dma_disp_use || _dma_disp < 0) {
+        _write8_buf(SPI_DISP_EXP_DEVICE, buf, len);
+        return;
+    }
+    _frame_bits(SPI_DISP_EXP_DEVICE, 8);  // The DMA transfers bytes
+    _dma_disp_active_ch = _dma_disp;
+    _dma_disp_active = true;
+    dma_channel_transfer_from_buffer_now(_dma_disp, buf, len);
+#endif
+}
+
+#if DISP_AB_BENCH
+void spi_display_frame16_enable(bool use) {
+    _dma_disp_wait();
+    _disp_frame16_use = use;
+}
+#endif
+
+void spi_display_dma_external(uint frame_bits, size_t bytes, spi_display_dma_wait_fn wait) {
+    _dma_disp_wait();
+    _owns_passkey(SPI_DISPLAY_SELECT);
+    _disp_preempt_point();
+    _disp_bytes += bytes;
+    _frame_bits(SPI_DISP_EXP_DEVICE, frame_bits);
+    _dma_disp_ext_wait = wait;
+    _dma_disp_active = true;
+}
+
+void spi_display_fill_dma(const uint8_t* pixel, uint8_t pixel_bytes, uint32_t pixels) {
+    _dma_disp_wait();
+    _owns_passkey(SPI_DISPLAY_SELECT);
+    _disp_bytes += ((uint64_t)pixels * pixel_bytes);
+    spi_inst_t* spi = SPI_DISP_EXP_DEVICE;
+    // A 3 byte pixel is sent as two 12 bit frames. A 2 byte pixel is one 16 bit
+    // frame (repeated, so the pattern is two frames either way).
+    uint bits;
+    uint32_t frames;
+    if (pixel_bytes == 3) {
+        _fill_frames[0] = (pixel[0] << 4) | (pixel[1] >> 4);
+        _fill_frames[1] = ((pixel[1] & 0x0F) << 8) | pixel[2];
+        bits = 12;
+        frames = pixels * 2;
+    }
+    else {
+        _fill_frames[0] = (pixel[0] << 8) | pixel[1];
+        _fill_frames[1] = _fill_frames[0];
+        bits = 16;
+        frames = pixels;
+    }
+    if (DISP_ILI_EMU || !_dma_disp_use || _dma_fill < 0) {
+        uint16_t fbuf[32];
+        for (int i = 0; i < 32; i++) {
+            fbuf[i] = _fill_frames[i & 1];
+        }
+        _frame_bits(spi, bits);
+        while (frames) {
+            uint32_t n = (frames < 32 ? frames : 32);
+#if DISP_ILI_EMU
+            ili_emu_write_frames(fbuf, n, bits);
+#else
+            spi_write16_blocking(spi, fbuf, n);
+#endif
+            frames -= n;
+        }
+        return;
+    }
+    while (frames) {
+        _disp_preempt_point();
+        uint32_t n = frames;
+        if (_disp_resume != NULL && n > DISP_FILL_CHUNK_FRAMES) {
+            n = DISP_FILL_CHUNK_FRAMES;
+        }
+        _frame_bits(spi, bits);
+        _dma_disp_active_ch = _dma_fill;
+        _dma_disp_active = true;
+        dma_channel_transfer_from_buffer_now(_dma_fill, _fill_frames, n);
+        frames -= n;
+        if (frames) {
+            _dma_disp_wait();
+        }
+    }
 }
 
 int spi_display_write16(uint16_t data) {
+    _dma_disp_wait();
+    _disp_bytes += sizeof(uint16_t);
+#if DISP_ILI_EMU
+    ili_emu_write_frames(&data, 1, 16);
+    return (sizeof(uint16_t));
+#else
     int r = _write16(SPI_DISP_EXP_DEVICE, data);
     return r;
+#endif
 }
 
 int spi_display_write16_buf(const uint16_t* buf, size_t len) {
+    _dma_disp_wait();
+    _disp_bytes += (len * sizeof(uint16_t));
+#if DISP_ILI_EMU
+    ili_emu_write_frames(buf, len, 16);
+    return (len);
+#else
     int r = _write16_buf(SPI_DISP_EXP_DEVICE, buf, len);
     return r;
+#endif
+}
+
+void spi_display_pixels_begin(spi_display_resume_fn resume) {
+    _owns_passkey(SPI_DISPLAY_SELECT);
+    _disp_resume = (_disp_preempt_use ? resume : NULL);
 }
 
+#if DISP_AB_BENCH
+void spi_display_preempt_enable(bool enable) {
+    _disp_preempt_use = enable;
+}
+#endif
+
 
 void spi_expio_begin(void) {
     _begin(SPI_EXPANSION_SELECT);
@@ -210,10 +675,124 @@ int spi_touch_write8_buf(const uint8_t* buf, size_t len) {
 }
 
 
+void spi_txn_submit(spi_txn_t* txn) {
+    txn->done = false;
+    txn->submit_us = time_us_64();
+    bool this_core = (_dev_passkey.corenum == get_core_num());
+    if (this_core && _txn_inline_ok()) {
+        // This core has the bus (it's from within an operation) and it can be
+        // interrupted here, so run it now.
+        _txn_inline(txn);
+        return;
+    }
+    for (;;) {
+        critical_section_enter_blocking(&_txn_cs);
+        bool full = (_txn_pending_cnt >= SPI_TXN_PENDING_MAX);
+        if (!full) {
+            _txn_pending[_txn_pending_cnt++] = txn;
+        }
+        critical_section_exit(&_txn_cs);
+        if (!full) {
+            break;
+        }
+        if (this_core) {
+            // Only this core can make room, and it's within a command.
+            board_panic("SPI transaction queue full within an operation on the same core");
+        }
+        // Wait for room. The waiting ones are run here if the bus is free,
+        // otherwise by the owner.
+        _txn_full_cnt++;
+        _txns_run_if_free(100);
+    }
+    if (this_core) {
+        return;  // `_end` (or the next preempt point) runs it
+    }
+    // Run it now if the bus is free. Otherwise the owner runs it.
+    _txns_run_if_free(0);
+}
+
+void spi_txn_wait(spi_txn_t* txn) {
+    if (!txn->done && _dev_passkey.corenum == get_core_num()) {
+        // The operation this core is in can't go on until this returns.
+        if (!_txn_inline_ok()) {
+            board_panic("spi_txn_wait within a command on the core using the bus (use spi_txn_submit)");
+        }
+        _txn_inline(NULL);
+    }
+    while (!txn->done) {
+        // The owner could have ended just before the transaction was added.
+        _txns_run_if_free(100);
+    }
+    __dmb();
+}
+
+void spi_txn_run(spi_txn_t* txn) {
+    spi_txn_submit(txn);
+    spi_txn_wait(txn);
+}
+
+uint32_t spi_txn_latency_max_us(void) {
+    return (_txn_latency_max_us);
+}
+
+uint32_t spi_txn_preempt_cnt(void) {
+    return (_txn_preempt_cnt);
+}
+
+uint32_t spi_txn_inline_cnt(void) {
+    return (_txn_inline_cnt);
+}
+
+uint32_t spi_txn_full_cnt(void) {
+    return (_txn_full_cnt);
+}
+
+void spi_txn_stats_clear(void) {
+    _txn_latency_max_us = 0;
+    _txn_preempt_cnt = 0;
+    _txn_inline_cnt = 0;
+    _txn_full_cnt = 0;
+}
+
+
 void spi_ops_module_init() {
+#if DISP_ILI_EMU
+    if (!ili_emu_init(DISP_ILI_EMU)) {
+        board_panic("spi_ops_module_init - No memory for the ILI%d emulator frame memory", DISP_ILI_EMU);
+    }
+#endif
     _device_select(SPI_NONE_SELECT);
     sem_init(&_dev_passkey.sem, 1, 1);
+    critical_section_init(&_txn_cs);
     _dev_passkey.device = SPI_NONE_SELECT;
     _dev_passkey.corenum = -1;
+    // DMA channel to feed the display data to the SPI TX FIFO (paced by the SPI)
+    _dma_disp = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(_dma_disp);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(SPI_DISP_EXP_DEVICE, true));
+    dma_channel_configure(_dma_disp, &c,
+        &spi_get_hw(SPI_DISP_EXP_DEVICE)->dr,   // Write to the SPI data register
+        NULL,                                   // Read address set for each transfer
+        0,
+        false);
+    // DMA channel to fill the display with a pixel. The frames are 16 bits
+    // (or 12) and the read wraps around the two frames of the pixel.
+    _dma_fill = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(_dma_fill);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_ring(&c, false, 2);      // Wrap the read address at 4 bytes
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, spi_get_dreq(SPI_DISP_EXP_DEVICE, true));
+    dma_channel_configure(_dma_fill, &c,
+        &spi_get_hw(SPI_DISP_EXP_DEVICE)->dr,   // Write to the SPI data register
+        _fill_frames,
+        0,
+        false);
+    _dma_disp_active_ch = _dma_disp;
+    _dma_disp_active = false;
 }
 
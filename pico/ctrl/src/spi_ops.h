@@ -38,6 +38,47 @@ typedef enum _SPI_DEVICE_SEL_ {
 #define SPI_HIGH_TXD_FOR_READ 0xFF
 #define SPI_LOW_TXD_FOR_READ 0x00
 
+#define SPI_TXN_PENDING_MAX 8       // Transactions that can be waiting for the bus
+
+/**
+ * @brief Transaction priorities. When several are waiting, the highest goes first.
+ */
+typedef enum _SPI_TXN_PRI_ {
+    SPI_TXN_PRI_LOW,
+    SPI_TXN_PRI_NORM,
+    SPI_TXN_PRI_HIGH,
+} spi_txn_pri_t;
+
+/**
+ * @brief A short SPI transaction (write some bytes, then optionally read some).
+ *
+ * The transaction must stay valid until it is done.
+ */
+typedef struct _SPI_TXN_ {
+    spi_device_sel_t device;
+    spi_txn_pri_t pri;
+    const uint8_t* tx;              // Bytes to write
+    size_t tx_len;
+    uint8_t* rx;                    // Buffer for bytes read after the write (can be NULL)
+    size_t rx_len;
+    volatile bool done;             // Set once the transaction is done
+    uint64_t submit_us;             // Time it was submitted (set by `spi_txn_submit`)
+} spi_txn_t;
+
+/**
+ * @brief Function the display driver provides to continue writing pixels after
+ * the display was deselected for another transaction.
+ *
+ * Called with the display selected. It must send a continue command (like
+ * MEMWRCONT) and call `spi_display_pixels_begin` again.
+ */
+typedef void (*spi_display_resume_fn)(void);
+
+/**
+ * @brief Function that waits for display data sent by another module's DMA.
+ */
+typedef void (*spi_display_dma_wait_fn)(void);
+
 /**
  * @brief Take control of the SPI bus for use by the display.
  * @ingroup spi_ops
@@ -59,6 +100,57 @@ extern void spi_display_begin(void);
  */
 extern void spi_display_end(void);
 
+/**
+ * @brief Set the display D/C- line for a command or for data.
+ * @ingroup spi_ops
+ *
+ * Waits for any display data being sent by DMA to be out first.
+ *
+ * @param cmd True for command mode, false for data mode
+ */
+extern void spi_display_command_mode(bool cmd);
+
+/**
+ * @brief Enable/disable the use of DMA for `spi_display_write8_buf_dma`.
+ * @ingroup spi_ops
+ *
+ * When disabled the data is written (blocking) by the CPU. This allows the
+ * two to be compared. Only in an A/B benchmark build (`DISP_AB_BENCH`).
+ *
+ * @param use True to use DMA
+ */
+#if DISP_AB_BENCH
+extern void spi_display_dma_enable(bool use);
+#endif
+
+/**
+ * @brief Wait for display data being sent by DMA to be out.
+ * @ingroup spi_ops
+ *
+ * All of the other display operations do this first, so this is only needed
+ * before changing a buffer that was passed to `spi_display_write8_buf_dma`
+ * (when there isn't another operation to do).
+ */
+extern void spi_display_dma_wait(void);
+
+/**
+ * @brief The total time spent waiting for display DMA transfers to finish.
+ * @ingroup spi_ops
+ *
+ * @return uint64_t Microseconds
+ */
+extern uint64_t spi_display_dma_wait_us(void);
+
+/**
+ * @brief The total number of bytes written to the display.
+ * @ingroup spi_ops
+ *
+ * Counts commands, parameters and pixel data (blocking and DMA).
+ *
+ * @return uint64_t Bytes
+ */
+extern uint64_t spi_display_bytes(void);
+
 extern int spi_display_read_buf(uint8_t txval, uint8_t* dst, size_t len);
 
 extern uint8_t spi_display_read8(uint8_t txval);
@@ -80,10 +172,114 @@ extern int spi_display_write8(uint8_t data);
 
 extern int spi_display_write8_buf(const uint8_t* buf, size_t len);
 
+/**
+ * @brief Start sending a buffer to the display using DMA.
+ * @ingroup spi_ops
+ *
+ * Returns once the transfer is started (after waiting for the previous one to
+ * finish). The buffer must not be changed until the next display operation
+ * (including another `spi_display_write8_buf_dma`) returns, so alternating
+ * between two buffers lets one be filled while the other is being sent.
+ * The display must stay selected until the data is out - `spi_none_select`
+ * and `spi_display_end` wait for it.
+ *
+ * @param buf The data to send
+ * @param len The number of bytes
+ */
+extern void spi_display_write8_buf_dma(const uint8_t* buf, size_t len);
+
+/**
+ * @brief Get ready for display data sent by another module's DMA.
+ * @ingroup spi_ops
+ *
+ * Waits for the previous transfer, lets waiting transactions run (if the pixel
+ * data can be interrupted), sets the SPI frame size, and counts the bytes.
+ * The caller then starts its DMA to the SPI. It is treated like a transfer
+ * started by `spi_display_write8_buf_dma` - `wait` is called to wait for it
+ * before the next display operation.
+ *
+ * @param frame_bits The SPI frame size for the data (4 to 16)
+ * @param bytes The number of bytes of pixel data (for the count)
+ * @param wait Function that waits for the DMA to finish
+ */
+extern void spi_display_dma_external(uint frame_bits, size_t bytes, spi_display_dma_wait_fn wait);
+
+/**
+ * @brief Start sending one pixel value repeatedly to the display using DMA.
+ * @ingroup spi_ops
+ *
+ * The DMA reads a small repeating pattern (the pixel as two SPI frames), so
+ * the CPU doesn't fill a buffer. Returns once the transfer is started (like
+ * `spi_display_write8_buf_dma`). When the pixel data can be interrupted
+ * (see `spi_display_pixels_begin`) it is sent in chunks, waiting between them.
+ *
+ * @param pixel The pixel (in the display's pixel format)
+ * @param pixel_bytes The number of bytes in a pixel (2 or 3)
+ * @param pixels The number of pixels to send
+ */
+extern void spi_display_fill_dma(const uint8_t* pixel, uint8_t pixel_bytes, uint32_t pixels);
+
+/**
+ * @brief Enable/disable sending words to the display in 16 bit SPI frames.
+ * @ingroup spi_ops
+ *
+ * When disabled each word is split into two 8 bit frames. This allows the
+ * two to be compared. Only in an A/B benchmark build (`DISP_AB_BENCH`).
+ *
+ * @param use True to use 16 bit frames
+ */
+#if DISP_AB_BENCH
+extern void spi_display_frame16_enable(bool use);
+#endif
+
+/**
+ * @brief Write a word to the display (high byte first).
+ * @ingroup spi_ops
+ *
+ * @param data The word
+ * @return int The number of bytes written
+ */
 extern int spi_display_write16(uint16_t data);
 
+/**
+ * @brief Write words to the display (high byte first).
+ * @ingroup spi_ops
+ *
+ * The SPI is switched to 16 bit frames, so the words are sent as they are,
+ * back to back.
+ *
+ * @param buf The words
+ * @param len The number of words
+ * @return int The number of words written
+ */
 extern int spi_display_write16_buf(const uint16_t* buf, size_t len);
 
+/**
+ * @brief Indicate that pixel data is being written and can be interrupted.
+ * @ingroup spi_ops
+ *
+ * Until the next command (or the end of the display operation) the display
+ * writes are split into chunks. Between chunks, transactions that are waiting
+ * for the bus are run, then `resume` is called to continue the pixel data.
+ * The display data must be written in whole pixels.
+ *
+ * @param resume Function that continues the pixel data
+ */
+extern void spi_display_pixels_begin(spi_display_resume_fn resume);
+
+/**
+ * @brief Enable/disable running waiting transactions between chunks of pixel data.
+ * @ingroup spi_ops
+ *
+ * When disabled they wait for the display operation to end. This allows the
+ * two to be compared. Only in an A/B benchmark build (`DISP_AB_BENCH`).
+ *
+ * @param enable True to let transactions interrupt the pixel data
+ */
+#if DISP_AB_BENCH
+extern void spi_display_preempt_enable(bool enable);
+#endif
+
 
 /**
  * @brief Take control of the SPI bus for use by the Expansion I/O.
@@ -181,6 +377,85 @@ extern int spi_touch_write8(uint8_t data);
 extern int spi_touch_write8_buf(const uint8_t* buf, size_t len);
 
 
+/**
+ * @brief Submit a transaction to be run when the bus is available.
+ * @ingroup spi_ops
+ *
+ * If the bus is free the transaction is run immediately. If it is in use on
+ * the other core, the transaction is run between chunks of display pixel
+ * data, or at the end of the current operation, whichever comes first.
+ * `done` is set once it has been run.
+ *
+ * If the queue is full this waits for room. If it is called between a
+ * `begin` and `end` on the same core (from an interrupt handler), it is run
+ * immediately where the operation can be interrupted (display pixel data,
+ * which is then resumed, or with nothing selected). Within a command it is
+ * queued, and run by `end` or the next point that can be interrupted.
+ *
+ * @param txn The transaction
+ */
+extern void spi_txn_submit(spi_txn_t* txn);
+
+/**
+ * @brief Wait for a submitted transaction to be done.
+ * @ingroup spi_ops
+ *
+ * On the core that is using the bus (from an interrupt handler), this can
+ * only be used where the operation can be interrupted (see
+ * `spi_txn_submit`), as the operation can't end while it waits. Elsewhere it
+ * panics.
+ *
+ * @param txn The transaction
+ */
+extern void spi_txn_wait(spi_txn_t* txn);
+
+/**
+ * @brief Submit a transaction and wait for it to be done.
+ * @ingroup spi_ops
+ *
+ * @param txn The transaction
+ */
+extern void spi_txn_run(spi_txn_t* txn);
+
+/**
+ * @brief The longest time from submitting a transaction to it being done.
+ * @ingroup spi_ops
+ *
+ * @return uint32_t Microseconds
+ */
+extern uint32_t spi_txn_latency_max_us(void);
+
+/**
+ * @brief The number of times pixel data was interrupted to run transactions.
+ * @ingroup spi_ops
+ *
+ * @return uint32_t The count
+ */
+extern uint32_t spi_txn_preempt_cnt(void);
+
+/**
+ * @brief The number of transactions run from within an operation on the same core.
+ * @ingroup spi_ops
+ *
+ * @return uint32_t The count
+ */
+extern uint32_t spi_txn_inline_cnt(void);
+
+/**
+ * @brief The number of times a submit waited for room in the queue.
+ * @ingroup spi_ops
+ *
+ * @return uint32_t The count
+ */
+extern uint32_t spi_txn_full_cnt(void);
+
+/**
+ * @brief Clear the transaction latency, interrupt, inline and queue full counts.
+ * @ingroup spi_ops
+ */
+extern void spi_txn_stats_clear(void);
+
+
 /**
  * @brief Initialize the SPI Operations module.
  * @ingroup spi_ops
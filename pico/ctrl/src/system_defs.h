@@ -52,6 +52,15 @@ extern "C" {
 #define SPI_DISP_CD             17              // DP-22
 #define SPI_DISP_EXP_SPEED      (5500 * 1000)   // 5.5MHz
 
+// The old display paths (blocking writes, 8 bit word frames, whole operations,
+// no glyph cache, whole line repaints and pixel rendered text), and the
+// switches to go back to them, are only built for the A/B benchmarks in
+// tests.c (DISP_AB_BENCH=1).
+//
+#ifndef DISP_AB_BENCH
+#define DISP_AB_BENCH            0
+#endif
+
 // SPI 1 is used for the Touch Panel. Touch Panel SCL-RD 2.5MHz(400ns)
 // 2MHz will be used to provide margin.
 //
@@ -85,6 +94,21 @@ extern "C" {
 #define SERVO_CTRL_TX_EN         0              // TX enable is active low
 #define SERVO_CTRL_TX_DIS        1              // TX disable is active high
 
+// Servo Buses
+//
+// Bus 0 is the UART-1 bus above. A second bus can be added (SERVO_BUS_CNT=2) using
+// a PIO UART. There aren't any free GPIO, so bus 1 uses the external I2C connector
+// for its TX/RX and the RC receiver input for its TX enable (I2C and RC are not
+// available when it is used). The drive servos stay on bus 0 and the steering
+// servos move to bus 1.
+//
+#ifndef SERVO_BUS_CNT
+#define SERVO_BUS_CNT            1              // Number of servo buses (1 or 2)
+#endif
+#define SERVO_B1_TX              6              // DP-9  (I2C connector SDA)
+#define SERVO_B1_RX              7              // DP-10 (I2C connector SCL)
+#define SERVO_B1_TX_EN_GPIO      9              // DP-12 (RC receiver connector)
+
 // Multiplexed Sensor - SENSBANK - Functionality
 //
 // Three GPIO (outputs) enable 1 of 8 devices. The result is read on another GPIO (input).
@@ -109,6 +133,11 @@ extern "C" {
 #define PIO_NEOPIX_BLOCK        pio1            // PIO Block 1 is used for the Neopixel display
 #define PIO_NEOPIX_SM            1              // State Machine 1 is used to drive the Neopixel display
 #define PIO_NEOPIX_DREQ         DREQ_PIO1_TX1   // DMA DREQ trigger from PIO1-SM1
+#define PIO_SERVO_B1_BLOCK      pio2            // PIO Block 2 is used for the servo bus 1 UART
+#define PIO_SERVO_B1_TX_SM       0              // State Machine 0 is the servo bus 1 UART TX
+#define PIO_SERVO_B1_RX_SM       1              // State Machine 1 is the servo bus 1 UART RX
+#define PIO_PALX_BLOCK          pio2            // PIO Block 2 is also used for the display palette expansion
+#define PIO_PALX_SM              2              // State Machine 2 makes the palette entry addresses
 
 // I2C is brought out to connectors to allow external devices like Spektrum XBUS, ADC Devices, NeoPixel, etc.
 #define I2C_EXTERN              i2c0
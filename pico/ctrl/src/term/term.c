@@ -19,6 +19,16 @@
  * It is possible that *SIGKILL* will be needed:
  * `kill -9 772`
  *
+ * Input from the host is received by a DMA channel that writes the UART's
+ * received bytes into a ring buffer without the CPU. A timer checks the ring
+ * and posts a single input message (with the count of bytes available) when
+ * the line goes idle or enough bytes have come in. The receive path doesn't
+ * take an interrupt per byte (or per FIFO), so it keeps up at high baud rates.
+ *
+ * The Up and Down switches page the view back and forward through the
+ * history. Home puts the terminal back on the screen (from the history, or
+ * after messages were printed over it). A key from the touch keyboard also
+ * goes back to the terminal, so what is typed can be seen.
  *
  * Copyright 2023-25 AESilky
  *
@@ -26,16 +36,25 @@
  */
 #include "term.h"
 #include "term_ctrlchrs.h"
+#include "term_hist.h"
+#include "term_vt.h"
 #include "tkbd.h"
 
+#include "system_defs.h"
+
 #undef putc     // Use the function, not the macro
 #undef putchar  // Use the function, not the macro
 
 #include "cmt/cmt.h"
 #include "curswitch/curswitch_t.h"
 #include "display/display.h"
+#include "display/disp_render.h"
 #include "touch_panel/touch.h"
 
+#include "hardware/dma.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+#include "pico/critical_section.h"
 #include "pico/printf.h"
 #include "pico/stdio.h"
 #include "pico/stdlib.h"
@@ -62,13 +81,24 @@ static void _handle_touch(cmt_msg_t* msg);
 // Data
 // ############################################################################
 //
-#define INPUT_BUF_SIZE_        4096 // Make this a power of 2
+#define INPUT_BUF_SIZE_BITS_     12 // The DMA ring size is 2^bits (the buffer is aligned to it)
+#define INPUT_BUF_SIZE_        (1u << INPUT_BUF_SIZE_BITS_)
+#define INPUT_BUF_MASK_        (INPUT_BUF_SIZE_ - 1)
+#define INPUT_BUF_GUARD_        512 // Unread bytes are dropped to leave this much room for the DMA
 #define BURST_MAX_SIZE_         100 // The maximum input burst to process at once
+#define RENDER_ROOM_MIN_        (TERM_VT_LINES_MAX + 8) // Render queue room for a byte (clearing the screen erases each line)
 
-static char _input_buf[INPUT_BUF_SIZE_];
+static char _input_buf[INPUT_BUF_SIZE_] __attribute__((aligned(INPUT_BUF_SIZE_)));
 static bool _input_buf_overflow = false;
-static uint16_t _input_buf_in = 0;
-static uint16_t _input_buf_out = 0;
+static int _rx_dma = -1;                    // DMA channel for the receive ring
+static uint16_t _rx_last_pos;               // Ring position of the DMA at the last update
+static volatile uint32_t _rx_total;         // Bytes received (as of the last update)
+static uint32_t _rx_read;                   // Bytes taken from the ring (and dropped)
+static uint32_t _rx_tick_total;             // Bytes received as of the last timer tick
+static volatile bool _rx_msg_posted;        // An input message is waiting to be handled
+static critical_section_t _rx_cs;           // The timer (core 1) and the reader (core 0) update the counts
+static repeating_timer_t _rx_timer;
+static term_rx_stats_t _rx_stats;
 
 static msg_handler_fn _term_notify_on_input; // Holds a function pointer for a message when input is available
 
@@ -84,7 +114,8 @@ const msg_handler_entry_t term_touch_handler_entry = { MSG_TOUCH_PANEL, _handle_
 
 static void _handle_switch_action(cmt_msg_t* msg) {
     //
-    // Handle switch actions so we can send 'canned' sequences to the host.
+    // Handle switch actions to page through the history, and to send 'canned'
+    // sequences to the host.
     //
     switch_id_t sw_id = msg->data.sw_action.switch_id;
     bool pressed = msg->data.sw_action.pressed;
@@ -97,13 +128,18 @@ static void _handle_switch_action(cmt_msg_t* msg) {
             stdio_puts_raw("asecret1\r");
             break;
         case SW_HOME:
-            stdio_putchar_raw('\r');
+            if (term_vt_history_view_get() > 0) {
+                term_vt_history_view(0);
+            }
+            else {
+                term_vt_repaint();
+            }
             break;
         case SW_DOWN:
-            stdio_puts_raw("ls -al\r");
+            term_vt_history_page(-1);
             break;
         case SW_UP:
-            stdio_puts_raw("cd ..\r");
+            term_vt_history_page(1);
             break;
         case SW_ENTER:
             stdio_puts_raw("cd ~\r");
@@ -119,6 +155,9 @@ static void _handle_touch(cmt_msg_t* msg) {
     if (dp) {
         scr_position_t sp = disp_lc_from_point(dp);
         uint8_t kv = tkbd_get_csk(sp.column, sp.line);
+        if (kv != KSK_NONE && term_vt_history_view_get() > 0) {
+            term_vt_history_view(0);    // Back to the terminal to see what is typed
+        }
         if ((kv & KBD_SPECIAL_KEY_FLAG) == 0) {
             // It's a normal character
             //  See if we are in Control mode
@@ -164,75 +203,166 @@ static void _handle_touch(cmt_msg_t* msg) {
 // ############################################################################
 //
 
+/**
+ * @brief Bring the received count up to where the DMA is.
+ *
+ * This is used by the timer (an interrupt on the core that started the
+ * terminal, core 1) and by the reader (core 0), so it is done holding a
+ * spin lock (interrupts alone don't keep the other core out).
+ *
+ * @return uint32_t The bytes received.
+ */
+static uint32_t _rx_update(void) {
+    if (_rx_dma < 0) {
+        return (_rx_total);
+    }
+    critical_section_enter_blocking(&_rx_cs);
+    uint16_t pos = (uint16_t)(((uintptr_t)dma_channel_hw_addr(_rx_dma)->write_addr - (uintptr_t)_input_buf) & INPUT_BUF_MASK_);
+    uint32_t total = _rx_total + ((pos - _rx_last_pos) & INPUT_BUF_MASK_);
+    _rx_total = total;
+    _rx_last_pos = pos;
+    critical_section_exit(&_rx_cs);
+
+    return (total);
+}
+
+/**
+ * @brief Drop the oldest unread bytes if the DMA is about to write over them.
+ */
+static void _rx_overrun_check(void) {
+    uint32_t unread = _rx_total - _rx_read;
+    if (unread > INPUT_BUF_SIZE_ - INPUT_BUF_GUARD_) {
+        uint32_t drop = unread - (INPUT_BUF_SIZE_ - INPUT_BUF_GUARD_);
+        _rx_read += drop;
+        _rx_stats.dropped += drop;
+        _input_buf_overflow = true;
+    }
+}
+
+/**
+ * @brief Claim posting the input message (only one is waiting at a time).
+ *
+ * @return true The message should be posted.
+ */
+static bool _rx_msg_claim(void) {
+    critical_section_enter_blocking(&_rx_cs);
+    bool claimed = !_rx_msg_posted;
+    _rx_msg_posted = true;
+    critical_section_exit(&_rx_cs);
+
+    return (claimed);
+}
+
+static void _rx_msg_init(cmt_msg_t* msg, uint32_t available) {
+    cmt_msg_init(msg, MSG_TERM_CHAR_RCVD);
+    msg->hdlr = _term_notify_on_input;  // Load a handler (or NULL)
+    msg->data.term_rx_cnt = (available > UINT16_MAX ? UINT16_MAX : (uint16_t)available);
+}
+
 static void _post_msg_if_chars_available() {
-    if (term_input_available()) {
+    if (term_input_available() && _rx_msg_claim()) {
         cmt_msg_t msg;
-        cmt_msg_init(&msg, MSG_TERM_CHAR_RCVD);
-        msg.hdlr = _term_notify_on_input;  // Load a handler (or NULL)
+        _rx_msg_init(&msg, _rx_total - _rx_read);
         // Post the message.
         postHWCtrlMsg(&msg);
+        _rx_stats.msgs++;
     }
 }
 
-static bool _recv_buf_full(void) {
-    bool full = ((_input_buf_in + 1) % INPUT_BUF_SIZE_) == _input_buf_out;
-    return (full);
-}
-
 /**
- * @brief Callback function that is registered with the STDIO handler to be notified when characters become available.
+ * @brief Timer callback that checks the receive ring.
  *
- * @param param Value that is passed to us that we registered with.
+ * A message is posted when bytes have come in and the line is idle (nothing
+ * new since the last tick), or when the bytes waiting reach the threshold
+ * (so a steady stream is handled as it comes in). There is no idle (receive
+ * timeout) interrupt to use, as the DMA keeps the UART's FIFO empty.
  */
-static void _stdio_chars_available(void* param) {
-    // Read the character
-    int ci;
-    int burst = 0;
-    while (burst++ < BURST_MAX_SIZE_ && !_recv_buf_full() && (ci = getchar_timeout_us(0)) >= 0) {
-        // Store it, then continue reading
-        _input_buf[_input_buf_in] = (char)ci;
-        _input_buf_in = (_input_buf_in + 1) % INPUT_BUF_SIZE_;
-    }
-    if (_recv_buf_full()) {
-        // Flag that we are full.
-        _input_buf_overflow = true;
+static bool _rx_poll(repeating_timer_t* rt) {
+    uint64_t t0 = time_us_64();
+    uint32_t total = _rx_update();
+    bool idle = (total == _rx_tick_total);
+    _rx_tick_total = total;
+    uint32_t available = total - _rx_read;
+    if (available > 0 && !_rx_msg_posted && (idle || available >= TERM_RX_THRESHOLD)) {
+        if (_rx_msg_claim()) {
+            cmt_msg_t msg;
+            _rx_msg_init(&msg, available);
+            if (postHWCtrlMsgDiscardable(&msg)) {
+                _rx_stats.msgs++;
+            }
+            else {
+                _rx_msg_posted = false; // Try again on the next tick
+            }
+        }
     }
-    _post_msg_if_chars_available();
+    _rx_stats.poll_us += (uint32_t)(time_us_64() - t0);
+
+    return (true);
 }
 
-static void _stdio_drain(void) {
-    int ci;
-    while ((ci = getchar_timeout_us(0)) >= 0);
+/**
+ * @brief Start the DMA receiving into the ring.
+ *
+ * The channel reads the UART's data register when it has a byte (DREQ) and
+ * writes into the buffer, wrapping at its size. It doesn't stop.
+ */
+static void _rx_dma_start(void) {
+    critical_section_init(&_rx_cs);
+    uart_hw_t* uart_hw = uart_get_hw(HOST_COMM_UART);
+    // Drop what is in the FIFO from before the terminal was started.
+    while (uart_is_readable(HOST_COMM_UART)) {
+        (void)uart_hw->dr;
+    }
+    _rx_dma = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(_rx_dma);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, INPUT_BUF_SIZE_BITS_);
+    channel_config_set_dreq(&c, uart_get_dreq(HOST_COMM_UART, false));
+    _rx_last_pos = 0;
+    _rx_total = _rx_read = _rx_tick_total = 0;
+    dma_channel_configure(_rx_dma, &c, _input_buf, &uart_hw->dr,
+#if PICO_RP2350
+        (DMA_CH0_TRANS_COUNT_MODE_VALUE_ENDLESS << DMA_CH0_TRANS_COUNT_MODE_LSB),
+#else
+        UINT32_MAX,
+#endif
+        true);
+    hw_set_bits(&uart_hw->dmacr, UART_UARTDMACR_RXDMAE_BITS);
+    add_repeating_timer_us(-TERM_RX_POLL_US, _rx_poll, NULL, &_rx_timer);
 }
 
 /**
  * @brief Pulls the available data from the input buffer and displays it.
  *
  * This is a CMT Message handler, as it is called in response to a
- * MSG_TERM_CHARS_AVALABLE. There isn't anything important in the message.
+ * MSG_TERM_CHAR_RCVD. The message has the count of bytes that were available
+ * when it was posted (more may have come in since).
+ *
+ * The data goes through the VT parser, which puts the cells. The cursor is
+ * put on the screen (and the cells painted) once for the burst. If there is
+ * more input than a burst, another message is posted for it, so the other
+ * messages get to run in between.
+ *
+ * The burst also stops when the render queue is low on room, rather than
+ * waiting in here for the render core. The rest is left for the receive timer
+ * to post (by then the render core will have made room).
  */
 static void _rcv_disp(cmt_msg_t *msg) {
+    _rx_msg_posted = false;
     int c;
     int burst = 0;
-    while (burst++ < BURST_MAX_SIZE_ && (c = term_getc()) >= 0) {
-        if (c < ' ') {
-            switch (c) {
-                case CBOL:
-                    disp_cursor_bol();
-                    break;
-                case '\n':
-                    disp_print_crlf(0, Paint);
-                    break;
-                default:
-                    // It is another CTRL character
-                    // We'll need to handle these... ZZZ
-                    break;
-            }
-        }
-        else {
-            disp_printc((char)c, Paint);
-        }
+    bool room = true;
+    while (burst++ < BURST_MAX_SIZE_ && (room = (disp_render_room() >= RENDER_ROOM_MIN_)) && (c = term_getc()) >= 0) {
+        term_vt_putc((char)c);
+    }
+    term_vt_flush();
+    if (!room) {
+        _rx_stats.deferred++;
+        return;
     }
+    _post_msg_if_chars_available();
 }
 
 // ############################################################################
@@ -241,21 +371,25 @@ static void _rcv_disp(cmt_msg_t *msg) {
 //
 
 int term_getc(void) {
+    // Always bring the count up to the DMA, so the overrun check sees bytes
+    // that arrived since the last call, even with unread bytes still waiting.
     if (!term_input_available()) {
         return (-1);
     }
-    int c = _input_buf[_input_buf_out];
-    _input_buf_out = (_input_buf_out + 1) % INPUT_BUF_SIZE_;
+    int c = (uint8_t)_input_buf[_rx_read & INPUT_BUF_MASK_];
+    _rx_read++;
 
     return (c);
 }
 
 bool term_input_available() {
-    return (_input_buf_in != _input_buf_out);
+    _rx_update();
+    _rx_overrun_check();
+    return (_rx_total != _rx_read);
 }
 
 void term_input_buf_clear(void) {
-    _input_buf_in = _input_buf_out = 0;
+    _rx_read = _rx_update();
     _input_buf_overflow = false;
 }
 
@@ -266,6 +400,11 @@ bool term_input_overflow() {
     return (retval);
 }
 
+void term_rx_stats_get(term_rx_stats_t* stats) {
+    *stats = _rx_stats;
+    stats->bytes = _rx_update();
+}
+
 void term_register_notify_on_input(msg_handler_fn notify_fn) {
     _term_notify_on_input = notify_fn;
     // If the function is not NULL, post a message if anything is currently available.
@@ -283,14 +422,14 @@ void term_register_notify_on_input(msg_handler_fn notify_fn) {
 
 void term_start() {
     // Set the display to make wrap nicer (for now)
-    disp_print_wrap_len_set(0);
+    disp_render_wrap_len_set(0);
     uint16_t kb_line_top = disp_info_lines() - KB_LINES;
     tkbd_module_init(kb_line_top, 0, KS_LETTERS_LC, KSS_NORMAL);
-    disp_cursor_show(true);
+    // The terminal is the scroll area (between the status and the keyboard).
+    term_vt_area_set(disp_info_fixed_top_lines(), disp_info_scroll_lines());
     //
-    _stdio_drain();
-    // Input handler...
-    stdio_set_chars_available_callback(_stdio_chars_available, NULL);   // We can pass a parameter if we want
+    // Input is received into the ring by DMA...
+    _rx_dma_start();
     // Register our 'received -> display' function to start
     term_register_notify_on_input(_rcv_disp);
     //
@@ -298,4 +437,6 @@ void term_start() {
 }
 
 void term_module_init() {
+    term_hist_module_init();
+    term_vt_module_init();
 }
@@ -26,6 +26,25 @@ extern "C" {
 #include <stddef.h>
 #include <stdint.h>
 
+#ifndef TERM_RX_POLL_US
+#define TERM_RX_POLL_US 1000        // How often the receive ring is checked (idle is a tick with nothing new)
+#endif
+#ifndef TERM_RX_THRESHOLD
+#define TERM_RX_THRESHOLD 256       // Bytes waiting that post an input message without the line going idle
+#endif
+
+/**
+ * @brief Counts for the terminal's input.
+ * @ingroup term
+ */
+typedef struct term_rx_stats_ {
+    uint32_t bytes;                 // Bytes received
+    uint32_t dropped;               // Bytes lost (not read before the ring came around)
+    uint32_t msgs;                  // Input messages posted
+    uint32_t deferred;              // Bursts cut short to wait for room in the render queue
+    uint32_t poll_us;               // Time spent in the receive timer
+} term_rx_stats_t;
+
 
 // ############################################################################
 // Structure and Enum Definitions and Function Prototypes
@@ -43,8 +62,8 @@ extern "C" {
  * @ingroup term
  *
  * Once the terminal has been initialized, this should be used rather than
- * getchar/getchar_timeout_us as the terminal support installs a handler
- * and implements an input buffer.
+ * getchar/getchar_timeout_us as the terminal receives the input (by DMA)
+ * into its own input buffer.
  *
  * @see getchar()
  * @see getchar_timeout_us(us)
@@ -83,6 +102,16 @@ extern void term_input_buf_clear(void);
  */
 extern bool term_input_overflow(void);
 
+/**
+ * @brief Get the counts for the terminal's input.
+ * @ingroup term
+ *
+ * The counts are from when the terminal was started.
+ *
+ * @param stats Where to put the counts
+ */
+extern void term_rx_stats_get(term_rx_stats_t* stats);
+
 /**
  * @brief Register a function to be called when input data becomes available.
  * @ingroup term
@@ -0,0 +1,168 @@
+/**
+ * @brief Terminal functionality - Scrollback history.
+ * @ingroup terminal
+ *
+ * The lines are records in a ring of bytes:
+ * `text length, run count, text..., (cells, color)...`
+ * A record can wrap around the end of the ring. An index (also a ring) has
+ * where each record starts, so any line can be got without walking the
+ * records. Positions in the data ring are running counts (masked to index
+ * the ring), so the bytes used are `head - tail`.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "term_hist.h"
+
+#include "board.h"
+
+#include <string.h>
+
+#if (TERM_HIST_BYTES & (TERM_HIST_BYTES - 1)) != 0 || TERM_HIST_BYTES > 65536
+#error "TERM_HIST_BYTES must be a power of 2 (up to 65536)"
+#endif
+
+#define HIST_MASK_ (TERM_HIST_BYTES - 1)
+#define HIST_REC_HDR_ 2             // Text length, run count
+#define HIST_LINE_CELLS_MAX_ 255    // Most cells in a line (the lengths are bytes)
+
+
+// ############################################################################
+// Data
+// ############################################################################
+//
+
+static uint8_t _data[TERM_HIST_BYTES];
+static uint16_t _index[TERM_HIST_LINES_MAX];    // Where each record starts (masked)
+static uint32_t _head;                          // Where the next record goes
+static uint32_t _tail;                          // Where the oldest record starts
+static uint16_t _first;                         // Index entry of the oldest record
+static uint16_t _count;                         // Records stored
+static term_hist_stats_t _stats;
+
+
+// ############################################################################
+// Internal Functions
+// ############################################################################
+//
+
+static inline uint8_t _byte(uint32_t pos) {
+    return (_data[pos & HIST_MASK_]);
+}
+
+static inline void _byte_put(uint8_t b) {
+    _data[_head & HIST_MASK_] = b;
+    _head++;
+}
+
+static uint32_t _rec_size(uint32_t pos) {
+    return (HIST_REC_HDR_ + _byte(pos) + (2 * _byte(pos + 1)));
+}
+
+static void _drop_oldest(void) {
+    _tail += _rec_size(_tail);
+    _first = (_first + 1) % TERM_HIST_LINES_MAX;
+    _count--;
+    _stats.dropped++;
+}
+
+
+// ############################################################################
+// Public Functions
+// ############################################################################
+//
+
+void term_hist_clear(void) {
+    _head = _tail = 0;
+    _first = _count = 0;
+}
+
+bool term_hist_line_get(uint16_t back, char* text, colorbyte_t* color, uint16_t cols) {
+    if (back >= _count) {
+        return (false);
+    }
+    uint32_t pos = _index[(_first + (_count - 1 - back)) % TERM_HIST_LINES_MAX];
+    uint8_t tlen = _byte(pos);
+    uint8_t runs = _byte(pos + 1);
+    pos += HIST_REC_HDR_;
+    for (uint16_t i = 0; i < cols; i++) {
+        text[i] = (i < tlen ? (char)_byte(pos + i) : ' ');
+    }
+    pos += tlen;
+    uint16_t col = 0;
+    colorbyte_t cb = 0;
+    for (uint8_t r = 0; r < runs && col < cols; r++, pos += 2) {
+        uint8_t n = _byte(pos);
+        cb = _byte(pos + 1);
+        for (uint8_t i = 0; i < n && col < cols; i++) {
+            color[col++] = cb;
+        }
+    }
+    while (col < cols) {
+        color[col++] = cb;
+    }
+    return (true);
+}
+
+uint16_t term_hist_lines(void) {
+    return (_count);
+}
+
+void term_hist_push(const char* text, const colorbyte_t* color, uint16_t cols) {
+    if (cols > HIST_LINE_CELLS_MAX_) {
+        cols = HIST_LINE_CELLS_MAX_;
+    }
+    uint16_t tlen = cols;
+    while (tlen > 0 && text[tlen - 1] == ' ') {
+        tlen--;
+    }
+    // Count the color runs. The last run covers the rest of the line.
+    uint16_t runs = 0;
+    for (uint16_t i = 0; i < cols; i++) {
+        if (i == 0 || color[i] != color[i - 1]) {
+            runs++;
+        }
+    }
+    uint32_t size = HIST_REC_HDR_ + tlen + (2 * runs);
+    while (_count > 0 && (_count == TERM_HIST_LINES_MAX || (TERM_HIST_BYTES - (_head - _tail)) < size)) {
+        _drop_oldest();
+    }
+    _index[(_first + _count) % TERM_HIST_LINES_MAX] = (uint16_t)(_head & HIST_MASK_);
+    _count++;
+    _byte_put((uint8_t)tlen);
+    _byte_put((uint8_t)runs);
+    for (uint16_t i = 0; i < tlen; i++) {
+        _byte_put((uint8_t)text[i]);
+    }
+    uint16_t start = 0;
+    for (uint16_t i = 1; i <= cols; i++) {
+        if (i == cols || color[i] != color[start]) {
+            _byte_put((uint8_t)(i - start));
+            _byte_put(color[start]);
+            start = i;
+        }
+    }
+    _stats.pushed++;
+}
+
+void term_hist_stats_get(term_hist_stats_t* stats) {
+    *stats = _stats;
+    stats->lines = _count;
+    stats->bytes = (_head - _tail) + (_count * sizeof(_index[0]));
+}
+
+
+// ############################################################################
+// Initialization and Maintainence Functions
+// ############################################################################
+//
+
+void term_hist_module_init(void) {
+    static bool _initialized = false;
+    if (_initialized) {
+        board_panic("term_hist_module_init already called");
+    }
+    _initialized = true;
+    term_hist_clear();
+}
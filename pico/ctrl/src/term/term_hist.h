@@ -0,0 +1,105 @@
+/**
+ * @brief Terminal functionality - Scrollback history.
+ * @ingroup terminal
+ *
+ * Lines that scroll off the top of the terminal are kept here, so they can be
+ * paged back to. A line is stored as its text (without the trailing spaces)
+ * and its colors as runs (a count of cells and a color byte), so a line of
+ * text in one or two colors takes little more than its characters. The
+ * lines are kept in a fixed amount of RAM, and the oldest are dropped to make
+ * room for new ones.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef TERMINAL_HIST_H_
+#define TERMINAL_HIST_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "display/display.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TERM_HIST_BYTES
+#define TERM_HIST_BYTES 16384       // RAM for the stored lines (a power of 2, up to 65536)
+#endif
+#ifndef TERM_HIST_LINES_MAX
+#define TERM_HIST_LINES_MAX 1024    // Most lines stored (each also takes 2 bytes of index)
+#endif
+
+/**
+ * @brief Counts for the scrollback history.
+ * @ingroup terminal
+ */
+typedef struct term_hist_stats_ {
+    uint16_t lines;                 // Lines stored
+    uint32_t bytes;                 // Bytes used by the stored lines (including their index)
+    uint32_t pushed;                // Lines that have been stored
+    uint32_t dropped;               // Lines dropped to make room
+} term_hist_stats_t;
+
+/**
+ * @brief Remove all of the lines.
+ * @ingroup terminal
+ */
+extern void term_hist_clear(void);
+
+/**
+ * @brief Get a stored line.
+ * @ingroup terminal
+ *
+ * The line is expanded to `cols` cells. Cells past the end of the stored text
+ * are spaces, and cells past the end of the stored colors are the last color.
+ *
+ * @param back The line to get (0 is the newest)
+ * @param text Where to put the characters
+ * @param color Where to put the colors
+ * @param cols The number of cells to get
+ * @return true The line was got
+ * @return false There aren't that many lines
+ */
+extern bool term_hist_line_get(uint16_t back, char* text, colorbyte_t* color, uint16_t cols);
+
+/**
+ * @brief Get the number of lines stored.
+ * @ingroup terminal
+ *
+ * @return uint16_t The count
+ */
+extern uint16_t term_hist_lines(void);
+
+/**
+ * @brief Store a line (as the newest).
+ * @ingroup terminal
+ *
+ * The oldest lines are dropped if there isn't room.
+ *
+ * @param text The characters of the line
+ * @param color The colors of the line
+ * @param cols The number of cells (up to 255)
+ */
+extern void term_hist_push(const char* text, const colorbyte_t* color, uint16_t cols);
+
+/**
+ * @brief Get the counts for the history.
+ * @ingroup terminal
+ *
+ * @param stats Where to put the counts
+ */
+extern void term_hist_stats_get(term_hist_stats_t* stats);
+
+/**
+ * @brief Initialize the scrollback history.
+ * @ingroup terminal
+ */
+extern void term_hist_module_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // TERMINAL_HIST_H_
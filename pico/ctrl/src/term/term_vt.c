@@ -0,0 +1,746 @@
+/**
+ * @brief Terminal functionality - VT100/ANSI escape sequences.
+ * @ingroup terminal
+ *
+ * The parser is a small state machine (ground, escape, control sequence, and
+ * strings that are skipped). Its cursor, colors, and scroll region are kept
+ * here, so nothing needs to be read back from the display (which may be
+ * rendering on the other core). Lines are terminal lines (0 is the top of the
+ * terminal area) until they are put on the screen.
+ *
+ * The cells are kept as well (text and color byte), for the history and to
+ * put the terminal back on the screen. The screen is only changed when the
+ * view is the terminal (`view_back` is 0).
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#include "term_vt.h"
+#include "term_ctrlchrs.h"
+#include "term_hist.h"
+
+#include "board.h"
+#include "display/display.h"
+#include "display/disp_render.h"
+
+#include "pico/stdio.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+// ############################################################################
+// Structure and Enum Definitions and Function Prototypes (internal)
+// ############################################################################
+//
+
+typedef enum _VT_STATE_ {
+    VTS_GROUND,
+    VTS_ESC,                        // ESC received
+    VTS_ESC_INTER,                  // ESC with an intermediate (like 'ESC ( B'), skip the final
+    VTS_CSI,                        // Control sequence (ESC [), collecting parameters
+    VTS_STRING,                     // OSC/DCS/APC/PM string, skipped
+    VTS_STRING_ESC,                 // ESC within a string (ST is 'ESC \')
+} vt_state_t;
+
+#define VT_PARAM_LIMIT_ 9999        // Largest parameter value kept
+#define VT_TAB_ 8                   // Tab stops
+
+
+// ############################################################################
+// Data
+// ############################################################################
+//
+
+// The 16 terminal colors (term_color_t) as Color16 numbers. The bright
+// colors are the closest in the display palette.
+static const colorn16_t _color_map[16] = {
+    C16_BLACK, C16_RED, C16_GREEN, C16_BROWN, C16_BLUE, C16_MAGENTA, C16_CYAN, C16_WHITE,
+    C16_GREY, C16_ORANGE, C16_LT_GREEN, C16_YELLOW, C16_LT_BLUE, C16_VIOLET, C16_LT_CYAN, C16_BR_WHITE,
+};
+
+static struct {
+    vt_state_t state;
+    uint16_t params[TERM_VT_PARAMS_MAX];
+    uint8_t nparams;
+    char priv;                      // Private marker ('?', '>', ...) or 0
+    bool intermediate;              // The sequence had an intermediate (none are supported)
+    // Area
+    uint16_t top;                   // Screen line of terminal line 0
+    uint16_t lines;
+    uint16_t cols;
+    uint16_t screen_lines;
+    uint16_t region_top;            // Scroll region (terminal lines, inclusive)
+    uint16_t region_bottom;
+    // Cursor
+    uint16_t line;
+    uint16_t col;
+    bool wrap_pending;              // The last column was printed, wrap before the next character
+    bool autowrap;
+    uint16_t saved_line;
+    uint16_t saved_col;
+    // Colors
+    int8_t fg;                      // term_color_t, -1 for the default
+    int8_t bg;
+    bool bold;
+    bool reverse;
+    colorn16_t fg_default;
+    colorn16_t bg_default;
+    colorn16_t cell_fg;             // The colors for cells (from the above)
+    colorn16_t cell_bg;
+    colorbyte_t cell_color;
+    bool cursor_shown;              // The host wants the cursor shown
+    // View
+    uint16_t view_back;             // Lines the view is back in the history (0 for the terminal)
+} _vt;
+
+// The terminal's cells
+static char _text[TERM_VT_LINES_MAX][TERM_VT_COLS_MAX];
+static colorbyte_t _color[TERM_VT_LINES_MAX][TERM_VT_COLS_MAX];
+
+static term_vt_stats_t _stats;
+
+
+// ############################################################################
+// Internal Functions
+// ############################################################################
+//
+
+static uint16_t _param(int i, uint16_t dflt) {
+    return ((i < _vt.nparams && _vt.params[i] != 0) ? _vt.params[i] : dflt);
+}
+
+static void _colors_update(void) {
+    int fg = _vt.fg;
+    if (fg >= 0 && fg < 8 && _vt.bold) {
+        fg += 8;
+    }
+    colorn16_t fgc = (fg < 0 ? _vt.fg_default : _color_map[fg]);
+    colorn16_t bgc = (_vt.bg < 0 ? _vt.bg_default : _color_map[_vt.bg]);
+    _vt.cell_fg = (_vt.reverse ? bgc : fgc);
+    _vt.cell_bg = (_vt.reverse ? fgc : bgc);
+    _vt.cell_color = colorbyte(_vt.cell_fg, _vt.cell_bg);
+}
+
+static void _cursor_to(int line, int col) {
+    _vt.line = (line < 0 ? 0 : (line >= _vt.lines ? _vt.lines - 1 : line));
+    _vt.col = (col < 0 ? 0 : (col >= _vt.cols ? _vt.cols - 1 : col));
+    _vt.wrap_pending = false;
+}
+
+static void _erase(uint16_t line, uint16_t col, uint16_t n) {
+    if (n > 0) {
+        memset(&_text[line][col], ' ', n);
+        memset(&_color[line][col], _vt.cell_color, n);
+        if (_vt.view_back == 0) {
+            disp_render_erase(_vt.top + line, col, n, _vt.cell_fg, _vt.cell_bg);
+        }
+        _stats.cells += n;
+    }
+}
+
+/*
+ * Put the view on the screen. Each line is from the history or the
+ * terminal's cells. All of the cells are put, then painted once (the display
+ * only sends the cells that are different from what it has painted).
+ */
+static void _view_put(void) {
+    char text[TERM_VT_COLS_MAX];
+    colorbyte_t color[TERM_VT_COLS_MAX];
+    uint16_t back = _vt.view_back;
+    for (uint16_t l = 0; l < _vt.lines; l++) {
+        const char* lt = text;
+        const colorbyte_t* lc = color;
+        if (l < back) {
+            // From the history (the line just above the terminal is 0 back)
+            term_hist_line_get(back - l - 1, text, color, _vt.cols);
+        }
+        else {
+            lt = _text[l - back];
+            lc = _color[l - back];
+        }
+        for (uint16_t c = 0; c < _vt.cols; c++) {
+            disp_render_char_color(_vt.top + l, c, lt[c], fg_from_cb(lc[c]), bg_from_cb(lc[c]), No_Paint);
+        }
+    }
+    if (back == 0) {
+        disp_render_cursor_show(_vt.cursor_shown);
+        term_vt_flush();
+    }
+    else {
+        disp_render_cursor_show(false);
+        disp_render_paint();
+    }
+}
+
+/*
+ * Scroll the region up a line. The region is the display's scroll area, so
+ * the display scrolls the text (and clears the new line). A line scrolled off
+ * the top of the terminal goes into the history.
+ */
+static void _scroll_up(void) {
+    if (_vt.region_top == 0) {
+        term_hist_push(_text[0], _color[0], _vt.cols);
+        if (_vt.view_back > 0) {
+            // Keep the view on the same lines (unless they were dropped)
+            uint16_t hist = term_hist_lines();
+            _vt.view_back = (_vt.view_back < hist ? _vt.view_back + 1 : hist);
+        }
+    }
+    for (uint16_t l = _vt.region_top; l < _vt.region_bottom; l++) {
+        memcpy(_text[l], _text[l + 1], _vt.cols);
+        memcpy(_color[l], _color[l + 1], _vt.cols);
+    }
+    memset(_text[_vt.region_bottom], ' ', _vt.cols);
+    memset(_color[_vt.region_bottom], colorbyte(_vt.fg_default, _vt.bg_default), _vt.cols);
+    if (_vt.view_back == 0) {
+        disp_render_cursor_set(_vt.region_bottom - _vt.region_top, 0);
+        disp_render_crlf();
+    }
+    if (_vt.cell_bg != _vt.bg_default) {
+        _erase(_vt.region_bottom, 0, _vt.cols);
+    }
+    _stats.scrolls++;
+}
+
+static void _linefeed(void) {
+    if (_vt.line == _vt.region_bottom) {
+        _scroll_up();
+    }
+    else if (_vt.line + 1 < _vt.lines) {
+        _vt.line++;
+    }
+    _vt.wrap_pending = false;
+}
+
+static void _print(char c) {
+    if (_vt.wrap_pending) {
+        _vt.col = 0;
+        _linefeed();
+    }
+    _text[_vt.line][_vt.col] = c;
+    _color[_vt.line][_vt.col] = _vt.cell_color;
+    if (_vt.view_back == 0) {
+        disp_render_char_color(_vt.top + _vt.line, _vt.col, c, _vt.cell_fg, _vt.cell_bg, No_Paint);
+    }
+    _stats.cells++;
+    if (_vt.col + 1 < _vt.cols) {
+        _vt.col++;
+    }
+    else {
+        _vt.wrap_pending = _vt.autowrap;
+    }
+}
+
+static void _reply(const char* s) {
+    // Not `stdio_puts_raw`, as it adds a newline (the host would take it as Enter).
+    while (*s) {
+        stdio_putchar_raw(*s++);
+    }
+}
+
+static void _region_set(uint16_t top, uint16_t bottom) {
+    _vt.region_top = top;
+    _vt.region_bottom = bottom;
+    disp_render_scroll_area(_vt.top + top, _vt.screen_lines - (_vt.top + bottom + 1));
+}
+
+static void _control(char c) {
+    switch (c) {
+        case BS:
+            if (_vt.col > 0) {
+                _vt.col--;
+            }
+            _vt.wrap_pending = false;
+            break;
+        case '\t':
+            _cursor_to(_vt.line, ((_vt.col / VT_TAB_) + 1) * VT_TAB_);
+            break;
+        case '\n':
+        case '\v':
+        case '\f':
+            _linefeed();
+            break;
+        case CR:
+            _vt.col = 0;
+            _vt.wrap_pending = false;
+            break;
+        case ESC:
+            _vt.state = VTS_ESC;
+            return;
+        default:
+            // BEL, SO/SI, and the others have nothing to do.
+            break;
+    }
+    _stats.sequences++;
+}
+
+static void _sgr(void) {
+    if (_vt.nparams == 0) {
+        _vt.nparams = 1;
+        _vt.params[0] = 0;
+    }
+    for (int i = 0; i < _vt.nparams; i++) {
+        uint16_t p = _vt.params[i];
+        if (p == 0) {
+            _vt.fg = _vt.bg = -1;
+            _vt.bold = _vt.reverse = false;
+        }
+        else if (p == 1) {
+            _vt.bold = true;
+        }
+        else if (p == 7) {
+            _vt.reverse = true;
+        }
+        else if (p == 22) {
+            _vt.bold = false;
+        }
+        else if (p == 27) {
+            _vt.reverse = false;
+        }
+        else if (p >= 30 && p <= 37) {
+            _vt.fg = p - 30;
+        }
+        else if (p == 39) {
+            _vt.fg = -1;
+        }
+        else if (p >= 40 && p <= 47) {
+            _vt.bg = p - 40;
+        }
+        else if (p == 49) {
+            _vt.bg = -1;
+        }
+        else if (p >= 90 && p <= 97) {
+            _vt.fg = (p - 90) + 8;
+        }
+        else if (p >= 100 && p <= 107) {
+            _vt.bg = (p - 100) + 8;
+        }
+        else if (p == 38 || p == 48) {
+            // Extended color: 5;n (256 colors) or 2;r;g;b. Only the first 16 are used.
+            if (i + 2 < _vt.nparams && _vt.params[i + 1] == 5) {
+                if (_vt.params[i + 2] < 16) {
+                    if (p == 38) {
+                        _vt.fg = _vt.params[i + 2];
+                    }
+                    else {
+                        _vt.bg = _vt.params[i + 2];
+                    }
+                }
+                i += 2;
+            }
+            else if (i + 1 < _vt.nparams && _vt.params[i + 1] == 2) {
+                i += 4;
+            }
+        }
+        // else - other attributes (underline, blink, ...) aren't supported
+    }
+    _colors_update();
+}
+
+static bool _csi_private(char final) {
+    if (_vt.priv != '?' || (final != 'h' && final != 'l')) {
+        return (false);
+    }
+    bool set = (final == 'h');
+    for (int i = 0; i < _vt.nparams; i++) {
+        switch (_vt.params[i]) {
+            case 7:
+                _vt.autowrap = set;
+                break;
+            case 25:
+                _vt.cursor_shown = set;
+                if (_vt.view_back == 0) {
+                    disp_render_cursor_show(set);
+                }
+                break;
+            default:
+                return (false);
+        }
+    }
+    return (true);
+}
+
+static void _csi(char final) {
+    bool supported = true;
+    int n = _param(0, 1);
+    int line = _vt.line;
+    int col = _vt.col;
+    bool in_region = (line >= _vt.region_top && line <= _vt.region_bottom);
+    if (_vt.intermediate) {
+        supported = false;
+    }
+    else if (_vt.priv) {
+        supported = _csi_private(final);
+    }
+    else {
+        switch (final) {
+            case 'A':   // CUU
+            case 'F':   // CPL
+                line -= n;
+                if (in_region && line < _vt.region_top) {
+                    line = _vt.region_top;
+                }
+                _cursor_to(line, (final == 'F' ? 0 : col));
+                break;
+            case 'B':   // CUD
+            case 'E':   // CNL
+                line += n;
+                if (in_region && line > _vt.region_bottom) {
+                    line = _vt.region_bottom;
+                }
+                _cursor_to(line, (final == 'E' ? 0 : col));
+                break;
+            case 'C':   // CUF
+                _cursor_to(line, col + n);
+                break;
+            case 'D':   // CUB
+                _cursor_to(line, col - n);
+                break;
+            case 'G':   // CHA
+            case '`':   // HPA
+                _cursor_to(line, n - 1);
+                break;
+            case 'H':   // CUP
+            case 'f':   // HVP
+                _cursor_to(n - 1, _param(1, 1) - 1);
+                break;
+            case 'd':   // VPA
+                _cursor_to(n - 1, col);
+                break;
+            case 'J':   // ED
+                switch (_param(0, 0)) {
+                    case 0:
+                        _erase(line, col, _vt.cols - col);
+                        for (int l = line + 1; l < _vt.lines; l++) {
+                            _erase(l, 0, _vt.cols);
+                        }
+                        break;
+                    case 1:
+                        for (int l = 0; l < line; l++) {
+                            _erase(l, 0, _vt.cols);
+                        }
+                        _erase(line, 0, col + 1);
+                        break;
+                    case 3:
+                        term_hist_clear();
+                        if (_vt.view_back > 0) {
+                            _vt.view_back = 0;
+                            _view_put();
+                        }
+                        // fall through - and clear the terminal
+                    case 2:
+                        for (int l = 0; l < _vt.lines; l++) {
+                            _erase(l, 0, _vt.cols);
+                        }
+                        break;
+                    default:
+                        supported = false;
+                        break;
+                }
+                break;
+            case 'K':   // EL
+                switch (_param(0, 0)) {
+                    case 0:
+                        _erase(line, col, _vt.cols - col);
+                        break;
+                    case 1:
+                        _erase(line, 0, col + 1);
+                        break;
+                    case 2:
+                        _erase(line, 0, _vt.cols);
+                        break;
+                    default:
+                        supported = false;
+                        break;
+                }
+                break;
+            case 'X':   // ECH
+                _erase(line, col, (n < _vt.cols - col ? n : _vt.cols - col));
+                break;
+            case 'm':   // SGR
+                _sgr();
+                break;
+            case 'r':   // DECSTBM
+            {
+                int top = _param(0, 1) - 1;
+                int bottom = _param(1, _vt.lines) - 1;
+                if (top < bottom && bottom < _vt.lines) {
+                    _region_set(top, bottom);
+                    _cursor_to(0, 0);
+                }
+                else {
+                    supported = false;
+                }
+                break;
+            }
+            case 's':   // SCOSC
+                _vt.saved_line = _vt.line;
+                _vt.saved_col = _vt.col;
+                break;
+            case 'u':   // SCORC
+                _cursor_to(_vt.saved_line, _vt.saved_col);
+                break;
+            case 'n':   // DSR
+                if (_param(0, 0) == 5) {
+                    _reply(CSI "0n");
+                }
+                else if (_param(0, 0) == 6) {
+                    char buf[16];
+                    snprintf(buf, sizeof(buf), CSI "%d;%dR", _vt.line + 1, _vt.col + 1);
+                    _reply(buf);
+                }
+                else {
+                    supported = false;
+                }
+                break;
+            case 'c':   // DA
+                _reply(CSI "?1;2c");
+                break;
+            default:
+                supported = false;
+                break;
+        }
+    }
+    if (supported) {
+        _stats.sequences++;
+    }
+    else {
+        _stats.unsupported++;
+    }
+}
+
+static void _esc(char c) {
+    _vt.state = VTS_GROUND;
+    switch (c) {
+        case '[':
+            memset(_vt.params, 0, sizeof(_vt.params));
+            _vt.nparams = 0;
+            _vt.priv = 0;
+            _vt.intermediate = false;
+            _vt.state = VTS_CSI;
+            return;
+        case ']':   // OSC
+        case 'P':   // DCS
+        case '_':   // APC
+        case '^':   // PM
+            _vt.state = VTS_STRING;
+            return;
+        case '7':   // DECSC
+            _vt.saved_line = _vt.line;
+            _vt.saved_col = _vt.col;
+            break;
+        case '8':   // DECRC
+            _cursor_to(_vt.saved_line, _vt.saved_col);
+            break;
+        case 'D':   // IND
+            _linefeed();
+            break;
+        case 'E':   // NEL
+            _vt.col = 0;
+            _linefeed();
+            break;
+        case 'M':   // RI
+            if (_vt.line == _vt.region_top) {
+                _stats.unsupported++;   // The display can't scroll down
+                return;
+            }
+            _cursor_to(_vt.line - 1, _vt.col);
+            break;
+        case 'c':   // RIS
+            term_vt_reset();
+            break;
+        case '=':   // DECKPAM
+        case '>':   // DECKPNM
+            break;
+        default:
+            if (c >= 0x20 && c <= 0x2F) {
+                // Intermediate (character set selection and such), skip the final.
+                _vt.state = VTS_ESC_INTER;
+                return;
+            }
+            _stats.unsupported++;
+            return;
+    }
+    _stats.sequences++;
+}
+
+
+// ############################################################################
+// Public Functions
+// ############################################################################
+//
+
+void term_vt_area_set(uint16_t top_line, uint16_t lines) {
+    _vt.top = top_line;
+    _vt.lines = (lines > TERM_VT_LINES_MAX ? TERM_VT_LINES_MAX : lines);
+    _vt.cols = disp_info_columns();
+    if (_vt.cols > TERM_VT_COLS_MAX) {
+        _vt.cols = TERM_VT_COLS_MAX;
+    }
+    _vt.screen_lines = disp_info_lines();
+    text_color_pair_t cp;
+    disp_text_colors_get(&cp);
+    _vt.fg_default = cp.fg;
+    _vt.bg_default = cp.bg;
+    _vt.region_top = 0;
+    _vt.region_bottom = _vt.lines - 1;
+    term_hist_clear();
+    term_vt_reset();
+}
+
+void term_vt_flush(void) {
+    if (_vt.view_back > 0) {
+        return;     // The screen has the history
+    }
+    if (_vt.line >= _vt.region_top && _vt.line <= _vt.region_bottom) {
+        disp_render_cursor_set(_vt.line - _vt.region_top, _vt.col);
+    }
+    disp_render_paint();
+}
+
+void term_vt_putc(char c) {
+    unsigned char uc = (unsigned char)c;
+    _stats.bytes++;
+    switch (_vt.state) {
+        case VTS_GROUND:
+            if (uc < ' ') {
+                _control(c);
+            }
+            else if (uc < DEL) {
+                _print(c);
+            }
+            else if (uc >= 0xC0) {
+                _print('?');    // The start of a UTF-8 character that isn't in the font
+            }
+            // else - DEL and UTF-8 continuation bytes are ignored
+            break;
+        case VTS_ESC:
+            _esc(c);
+            break;
+        case VTS_ESC_INTER:
+            _vt.state = VTS_GROUND;
+            _stats.sequences++;
+            break;
+        case VTS_CSI:
+            if (uc >= '0' && uc <= '9') {
+                if (_vt.nparams == 0) {
+                    _vt.nparams = 1;
+                }
+                if (_vt.nparams <= TERM_VT_PARAMS_MAX) {
+                    uint16_t* p = &_vt.params[_vt.nparams - 1];
+                    *p = (*p * 10) + (uc - '0');
+                    if (*p > VT_PARAM_LIMIT_) {
+                        *p = VT_PARAM_LIMIT_;
+                    }
+                }
+            }
+            else if (uc == ';' || uc == ':') {
+                // An empty first parameter still counts.
+                if (_vt.nparams <= TERM_VT_PARAMS_MAX) {
+                    _vt.nparams = (_vt.nparams == 0 ? 2 : _vt.nparams + 1);
+                }
+            }
+            else if (uc >= '<' && uc <= '?') {
+                _vt.priv = c;
+            }
+            else if (uc >= 0x20 && uc <= 0x2F) {
+                _vt.intermediate = true;
+            }
+            else if (uc >= 0x40 && uc <= 0x7E) {
+                if (_vt.nparams > TERM_VT_PARAMS_MAX) {
+                    _vt.nparams = TERM_VT_PARAMS_MAX;
+                }
+                _vt.state = VTS_GROUND;
+                _csi(c);
+            }
+            else if (uc < ' ') {
+                // Controls are done within a sequence (ESC starts a new one).
+                _control(c);
+            }
+            break;
+        case VTS_STRING:
+            if (c == BEL) {
+                _vt.state = VTS_GROUND;
+            }
+            else if (c == ESC) {
+                _vt.state = VTS_STRING_ESC;
+            }
+            break;
+        case VTS_STRING_ESC:
+            _vt.state = (c == '\\' ? VTS_GROUND : VTS_STRING);
+            break;
+    }
+}
+
+void term_vt_history_view(uint16_t lines_back) {
+    uint16_t hist = term_hist_lines();
+    _vt.view_back = (lines_back > hist ? hist : lines_back);
+    _view_put();
+}
+
+uint16_t term_vt_history_view_get(void) {
+    return (_vt.view_back);
+}
+
+void term_vt_history_page(int pages) {
+    int page = (_vt.lines > 1 ? _vt.lines - 1 : 1);
+    int back = _vt.view_back + (pages * page);
+    term_vt_history_view(back < 0 ? 0 : (back > UINT16_MAX ? UINT16_MAX : back));
+}
+
+void term_vt_repaint(void) {
+    _view_put();
+}
+
+void term_vt_puts(const char* s) {
+    char c;
+    while ((c = *s++) != 0) {
+        term_vt_putc(c);
+    }
+}
+
+void term_vt_reset(void) {
+    _vt.state = VTS_GROUND;
+    _vt.fg = _vt.bg = -1;
+    _vt.bold = _vt.reverse = false;
+    _vt.autowrap = true;
+    _colors_update();
+    if (_vt.region_top != 0 || _vt.region_bottom != _vt.lines - 1) {
+        _region_set(0, _vt.lines - 1);
+    }
+    _vt.view_back = 0;
+    for (uint16_t l = 0; l < _vt.lines; l++) {
+        _erase(l, 0, _vt.cols);
+    }
+    _cursor_to(0, 0);
+    _vt.saved_line = _vt.saved_col = 0;
+    _vt.cursor_shown = true;
+    disp_render_cursor_show(true);
+    term_vt_flush();
+}
+
+void term_vt_stats_get(term_vt_stats_t* stats) {
+    *stats = _stats;
+}
+
+void term_vt_stats_clear(void) {
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+
+// ############################################################################
+// Initialization and Maintainence Functions
+// ############################################################################
+//
+
+void term_vt_module_init(void) {
+    static bool _initialized = false;
+    if (_initialized) {
+        board_panic("term_vt_module_init already called");
+    }
+    _initialized = true;
+    _vt.state = VTS_GROUND;
+    _vt.autowrap = true;
+}
@@ -0,0 +1,184 @@
+/**
+ * @brief Terminal functionality - VT100/ANSI escape sequences.
+ * @ingroup terminal
+ *
+ * An incremental parser for the output from the host. Characters are fed
+ * to it as they are received (a sequence can be split across bursts). The
+ * terminal has its own cursor within its area of the screen (the display's
+ * scroll area when it is started), and each printed character or erase is put
+ * straight into the screen cells through the render service. Only the cells
+ * that changed get painted, so a host can update a field of a status screen
+ * by sending the position and the new value.
+ *
+ * Supported:
+ * - C0: BS, HT, LF/VT/FF (line feed, the host's tty adds the CR), CR
+ * - ESC: 7/8 (save/restore cursor), D (index), E (next line), M (reverse
+ *   index, without scrolling down), c (reset)
+ * - CSI: A/B/C/D/E/F/G/`/H/f/d (cursor movement), J/K (erase in display/line,
+ *   `3 J` also clears the history),
+ *   X (erase characters), m (SGR, mapped to the 16 colors), r (scroll region),
+ *   s/u (save/restore cursor), n (status/cursor position report), c (device
+ *   attributes), ?25 h/l (show/hide cursor), ?7 h/l (auto wrap)
+ * - OSC/DCS/APC/PM strings are skipped (to BEL or ST)
+ *
+ * SGR supports reset, bold (as the bright colors), reverse, 30-37/39,
+ * 40-47/49, 90-97, 100-107, and 38;5/48;5 with the first 16 colors. Other
+ * colors are ignored.
+ *
+ * The scroll region is made the display's scroll area (the lines of the
+ * terminal above and below it are fixed), so scrolling the region is done by
+ * the display.
+ *
+ * The cells of the terminal are also kept here, and lines that scroll off the
+ * top of the terminal go into the scrollback history (`term_hist`). The view
+ * can be moved back through the history a line or page at a time. While it
+ * is back, output from the host updates the terminal (and history) without
+ * changing the screen. A view (or the terminal after the screen was used by
+ * something else) is put on the screen as all of its cells with one paint.
+ *
+ * Copyright 2023-25 AESilky
+ *
+ * SPDX-License-Identifier: MIT
+ */
+#ifndef TERMINAL_VT_H_
+#define TERMINAL_VT_H_
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "pico/types.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TERM_VT_PARAMS_MAX
+#define TERM_VT_PARAMS_MAX 16       // Most parameters of a control sequence (more are ignored)
+#endif
+#define TERM_VT_COLS_MAX (480 / 10)     // Most columns (the largest display with the 10x16 font)
+#define TERM_VT_LINES_MAX (480 / 16)    // Most lines
+
+/**
+ * @brief Counts of what the parser has done.
+ * @ingroup terminal
+ */
+typedef struct term_vt_stats_ {
+    uint32_t bytes;                 // Bytes received
+    uint32_t sequences;             // Escape and control sequences done
+    uint32_t unsupported;           // Sequences that were ignored
+    uint32_t cells;                 // Cells put (characters and erased cells)
+    uint32_t scrolls;               // Lines scrolled
+} term_vt_stats_t;
+
+/**
+ * @brief Set the area of the screen that the terminal uses.
+ * @ingroup terminal
+ *
+ * This should be the display's scroll area. The terminal is reset and the
+ * history is cleared.
+ *
+ * @param top_line The first screen line of the terminal
+ * @param lines The number of lines
+ */
+extern void term_vt_area_set(uint16_t top_line, uint16_t lines);
+
+/**
+ * @brief Put the cursor on the screen and paint.
+ * @ingroup terminal
+ *
+ * Call this after a burst of characters has been fed to the parser.
+ */
+extern void term_vt_flush(void);
+
+/**
+ * @brief Feed a character to the parser.
+ * @ingroup terminal
+ *
+ * @param c The character
+ */
+extern void term_vt_putc(char c);
+
+/**
+ * @brief Feed a string to the parser.
+ * @ingroup terminal
+ *
+ * @param s The string
+ */
+extern void term_vt_puts(const char* s);
+
+/**
+ * @brief Move the view back into the history.
+ * @ingroup terminal
+ *
+ * The view is put on the screen (all of its cells, with one paint). The
+ * cursor is hidden while the view is back.
+ *
+ * @param lines_back Lines back from the terminal (0 is the terminal, more than
+ * the history has is the oldest)
+ */
+extern void term_vt_history_view(uint16_t lines_back);
+
+/**
+ * @brief Get how far back the view is.
+ * @ingroup terminal
+ *
+ * The view stays on the same lines as more are added to the history, so this
+ * goes up as the host's output scrolls.
+ *
+ * @return uint16_t Lines back from the terminal (0 is the terminal)
+ */
+extern uint16_t term_vt_history_view_get(void);
+
+/**
+ * @brief Move the view by pages.
+ * @ingroup terminal
+ *
+ * A page is the lines of the terminal, less one (so a line is kept from the
+ * last page).
+ *
+ * @param pages Pages to move back (negative to move forward)
+ */
+extern void term_vt_history_page(int pages);
+
+/**
+ * @brief Put the view on the screen again.
+ * @ingroup terminal
+ *
+ * Use this after the screen was used by something else (like another
+ * screen). All of the cells are put with one paint.
+ */
+extern void term_vt_repaint(void);
+
+/**
+ * @brief Reset the terminal (like `ESC c`).
+ * @ingroup terminal
+ *
+ * The colors, scroll region, and cursor are reset, the view is the terminal,
+ * and the terminal area is cleared. The history is kept.
+ */
+extern void term_vt_reset(void);
+
+/**
+ * @brief Get the counts of what the parser has done.
+ * @ingroup terminal
+ *
+ * @param stats Where to put the counts
+ */
+extern void term_vt_stats_get(term_vt_stats_t* stats);
+
+/**
+ * @brief Clear the counts.
+ * @ingroup terminal
+ */
+extern void term_vt_stats_clear(void);
+
+/**
+ * @brief Initialize the VT parser.
+ * @ingroup terminal
+ */
+extern void term_vt_module_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif // TERMINAL_VT_H_
@@ -13,6 +13,7 @@
 #include "tkbd.h"
 
 #include "display/display.h"
+#include "display/disp_render.h"
 
 
 #define KB_LINES 5
@@ -169,14 +170,11 @@ static const key_value_t _get_key_value(uint16_t col, uint16_t row) {
 }
 
 static void _kb_draw_bank(const key_bank_t* bank) {
-    text_color_pair_t cp;
-    disp_text_colors_get(&cp);
-    disp_text_colors_set(C16_BLACK, C16_BLACK);
     for (uint16_t r = 0; r < bank->row_count; r++) {
         uint16_t arow = _kb_line_top + bank->start_row + r;
         key_row_t kr = bank->rows[r];
         char line[(3 * kr.key_count) + 1];
-        disp_line_clear(arow, No_Paint);
+        disp_render_erase(arow, 0, disp_info_columns(), C16_BLACK, C16_BLACK);
         // Build up the line
         const key_value_t* kvs = kr.keys;
         for (uint16_t c = 0; c < kr.key_count; c++) {
@@ -198,9 +196,8 @@ static void _kb_draw_bank(const key_bank_t* bank) {
             line[i2] = cap;
             line[i3+1] = '\000';
         }
-        disp_string_color(arow, _kb_col_left + kr.start_col, line, C16_BLACK, C16_WHITE, Paint);
+        disp_render_string_color(arow, _kb_col_left + kr.start_col, line, C16_BLACK, C16_WHITE);
     }
-    disp_text_colors_set(cp.fg, cp.bg);
 }
 
 static void _kb_draw_digits(void) {
@@ -261,15 +258,12 @@ uint8_t tkbd_get_csk(uint16_t col, uint16_t row) {
 }
 
 void tkbd_redraw(void) {
-    // Erase the keyboard area
-    text_color_pair_t cp;
-    disp_text_colors_get(&cp);
-    disp_text_colors_set(C16_BLACK, C16_BLACK);
+    // Erase the keyboard area. This is drawn from the HWOS touch handler as
+    // well as at start, so it goes through the render service.
     uint16_t line = _kb_line_top;
     for (int i = 0; i < KB_LINES; i++) {
-        disp_line_clear(line + i, Paint);
+        disp_render_erase(line + i, 0, disp_info_columns(), C16_BLACK, C16_BLACK);
     }
-    disp_text_colors_set(cp.fg, cp.bg);
     switch (_kb_state) {
     case KS_LETTERS_LC:
         _kb_draw_digits();
@@ -8,8 +8,36 @@
 */
 #include "tests.h"
 
+#include "board.h"
+#include "cmt/cmt.h"
 #include "display/display.h"
+#include "display/disp_render.h"
+#include "display/disp_widget.h"
+#include "display/display_rgb18/display_rgb18.h"
+#include "display/display_rgb18/glyph_cache.h"
+#include "display/display_rgb18/icon_blit.h"
+#include "display/display_rgb18/ili_emu.h"
+#include "display/display_rgb18/pal_expand.h"
+#include "display/fonts/font_10_16.h"
+#include "display/icons/icons.h"
 #include "expio/expio.h"
+#include "gfx/gfx.h"
+#include "hid/hid.h"
+#include "term/term.h"
+#include "term/term_ctrlchrs.h"
+#include "term/term_hist.h"
+#include "term/term_vt.h"
+#include "spi_ops.h"
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/uart.h"
+#include "pico/time.h"
+
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 static const colorn16_t colors[] = {
     C16_BLACK,
@@ -98,3 +126,889 @@ void test_display_1(int loops) {
         //disp_scroll_area_clear(Paint);
     }
 }
+
+// The A/B benchmarks run the old path (0) and then the new one (1). The old
+// paths are only built with DISP_AB_BENCH, otherwise just the new one is run.
+#define AB_FIRST_ (DISP_AB_BENCH ? 0 : 1)
+#if DISP_AB_BENCH
+#define AB_SWITCH_(call) call
+#else
+#define AB_SWITCH_(call)
+#endif
+
+/*
+ * Fill the screen with text in various colors (without painting it).
+ */
+static void _screen_fill(void) {
+    uint16_t lines = disp_info_lines();
+    uint16_t cols = disp_info_columns();
+    for (uint16_t l = 0; l < lines; l++) {
+        for (uint16_t c = 0; c < cols; c++) {
+            disp_char_color(l, c, (char)('!' + ((l * cols + c) % 94)), C16_BR_WHITE, colors[(l + c) % 15], No_Paint);
+        }
+    }
+}
+
+/*
+ * Paint the full screen `loops` times. Returns the total time, and adds the
+ * time spent waiting on display DMA to `wait_us` (when not NULL).
+ */
+static uint64_t _screen_paint_time(int loops, uint64_t* wait_us) {
+    uint64_t total_us = 0;
+    for (int i = 0; i < loops; i++) {
+        disp_update(No_Paint);  // Mark every line dirty
+        uint64_t w0 = spi_display_dma_wait_us();
+        uint64_t t0 = time_us_64();
+        disp_paint();
+        total_us += time_us_64() - t0;
+        if (wait_us) {
+            *wait_us += spi_display_dma_wait_us() - w0;
+        }
+    }
+    return (total_us);
+}
+
+void test_disp_paint_timing(int loops) {
+    if (loops < 1) {
+        loops = 1;
+    }
+    _screen_fill();
+    for (int dma = AB_FIRST_; dma < 2; dma++) {
+        AB_SWITCH_(spi_display_dma_enable(dma));
+        uint64_t wait_us = 0;
+        uint64_t total_us = _screen_paint_time(loops, &wait_us);
+        // Without DMA the CPU is busy for all of it. With DMA, the time spent
+        // waiting on the transfer is free.
+        uint32_t busy_pct = (uint32_t)(((total_us - wait_us) * 100) / (total_us ? total_us : 1));
+        info_printf("Display paint (%s): %luus per full screen, CPU busy %lu%%\n",
+            (dma ? "DMA" : "blocking"), (uint32_t)(total_us / loops), busy_pct);
+    }
+    AB_SWITCH_(spi_display_dma_enable(true));
+}
+
+void test_disp_clear_timing(int loops) {
+    if (loops < 1) {
+        loops = 1;
+    }
+    static const char* methods[] = { "line buffer", "blocking fill", "DMA fill" };
+    uint16_t w = gfxd_screen_width();
+    uint16_t h = gfxd_screen_height();
+    uint32_t sys_mhz = clock_get_hz(clk_sys) / 1000000;
+    for (int m = 0; m < 3; m++) {
+        if (m == 1 && !DISP_AB_BENCH) {
+            continue;  // The blocking fill is the old path
+        }
+        AB_SWITCH_(spi_display_dma_enable(m != 1));
+        uint64_t total_us = 0;
+        uint64_t wait_us = 0;
+        for (int i = 0; i < loops; i++) {
+            rgb18_t color = rgb18_from_color16(colors[i % 15]);
+            uint64_t w0 = spi_display_dma_wait_us();
+            uint64_t t0 = time_us_64();
+            if (m == 0) {
+                uint8_t* line_buf = gfxd_get_line_buf();
+                rgb18_buf_fill(line_buf, color, w);
+                gfxd_area_stream_begin(0, 0, w, h);
+                for (uint16_t y = 0; y < h; y++) {
+                    gfxd_area_stream(line_buf, w);
+                }
+                gfxd_area_stream_end();
+            }
+            else {
+                gfxd_area_fill(0, 0, w, h, color);
+            }
+            total_us += time_us_64() - t0;
+            wait_us += spi_display_dma_wait_us() - w0;
+        }
+        uint32_t cpu_us = (uint32_t)((total_us - wait_us) / loops);
+        info_printf("Screen clear (%s): %luus per clear, %lu CPU cycles\n",
+            methods[m], (uint32_t)(total_us / loops), cpu_us * sys_mhz);
+    }
+    AB_SWITCH_(spi_display_dma_enable(true));
+    disp_update(Paint);
+}
+
+void test_disp_pixel_formats(int loops) {
+    if (loops < 1) {
+        loops = 1;
+    }
+    static const gfxd_pixfmt_t formats[] = { GFXD_PIXFMT_RGB666, GFXD_PIXFMT_RGB565 };
+    gfxd_pixfmt_t original = gfxd_pixel_format();
+    _screen_fill();
+    for (int f = 0; f < 2; f++) {
+        bool rgb565 = (formats[f] == GFXD_PIXFMT_RGB565);
+        if (!disp_pixel_format_set(formats[f])) {
+            info_printf("Display pixel format %s: not supported by the controller\n", (rgb565 ? "RGB565" : "RGB666"));
+            continue;
+        }
+        uint64_t b0 = spi_display_bytes();
+        uint64_t total_us = _screen_paint_time(loops, NULL);
+        uint64_t bytes = spi_display_bytes() - b0;
+        info_printf("Display pixel format %s: %luus and %lu bytes per full screen\n",
+            (rgb565 ? "RGB565" : "RGB666"), (uint32_t)(total_us / loops), (uint32_t)(bytes / loops));
+    }
+    disp_pixel_format_set(original);
+}
+
+void test_disp_char_paint(int chars) {
+    if (chars < 1) {
+        chars = 1;
+    }
+    uint16_t lines = disp_info_lines();
+    uint16_t cols = disp_info_columns();
+    for (int frame16 = AB_FIRST_; frame16 < 2; frame16++) {
+        AB_SWITCH_(spi_display_frame16_enable(frame16));
+        uint64_t total_us = 0;
+        for (int i = 0; i < chars; i++) {
+            // Step diagonally, so the column and the row both change.
+            uint16_t l = (i % lines);
+            uint16_t c = ((i * 7) % cols);
+            char ch = (char)('!' + (i % 94));
+            uint64_t t0 = time_us_64();
+            disp_char_color(l, c, ch, C16_BR_WHITE, colors[i % 15], Paint);
+            total_us += time_us_64() - t0;
+        }
+        info_printf("Character paint (%s): %luns per character\n",
+            (frame16 ? "16 bit frames" : "8 bit frames"), (uint32_t)((total_us * 1000) / chars));
+    }
+    AB_SWITCH_(spi_display_frame16_enable(true));
+}
+
+#define PALX_TEST_WORDS_ 64
+
+bool test_pal_expand(int loops) {
+    static uint32_t packed[PALX_TEST_WORDS_];
+    static uint16_t got[PALX_TEST_WORDS_ * 8 * PAL_EXPAND_ENTRY_FRAMES + 1];  // +1 to catch an overrun
+    static uint16_t want[PALX_TEST_WORDS_ * 8 * PAL_EXPAND_ENTRY_FRAMES];
+    if (loops < 1) {
+        loops = 1;
+    }
+    if (!gfxd_pal4_ready()) {
+        info_printf("Palette expansion: not available\n");
+        return (false);
+    }
+    int fails = 0;
+    uint32_t x = 0x2545F491;
+    const uint16_t (*palette)[PAL_EXPAND_ENTRY_FRAMES] = (const uint16_t (*)[PAL_EXPAND_ENTRY_FRAMES])pal_expand_palette();
+    uint32_t fpp = pal_expand_frames_per_pixel();
+    spi_display_dma_wait();  // The expansion isn't being used for the display
+    for (int n = 0; n < loops; n++) {
+        for (int i = 0; i < PALX_TEST_WORDS_; i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            packed[i] = x;
+        }
+        uint32_t pixels = 1 + (x % (PALX_TEST_WORDS_ * 8));
+        memset(got, 0, sizeof(got));
+        pal_expand_start(packed, pixels, got, DREQ_FORCE, true);
+        pal_expand_wait();
+        uint32_t frames = pal_expand_model(palette, fpp, packed, pixels, want);
+        // Nothing past the last pixel may be written.
+        if (memcmp(got, want, frames * sizeof(uint16_t)) != 0 || got[frames] != 0) {
+            error_printf("Palette expansion: run %d (%lu pixels) doesn't match the model\n", n, pixels);
+            fails++;
+        }
+    }
+    info_printf("Palette expansion: %d runs checked, %d mismatches\n", loops, fails);
+
+    _screen_fill();
+    for (int pal4 = AB_FIRST_; pal4 < 2; pal4++) {
+        AB_SWITCH_(disp_pal4_enable(pal4));
+        uint64_t wait_us = 0;
+        uint64_t total_us = _screen_paint_time(loops, &wait_us);
+        info_printf("Display paint (%s): %luus per full screen, %luus CPU\n",
+            (pal4 ? "palette indexes" : "pixels"), (uint32_t)(total_us / loops), (uint32_t)((total_us - wait_us) / loops));
+    }
+    AB_SWITCH_(disp_pal4_enable(true));
+
+    return (fails == 0);
+}
+
+void test_glyph_cache(int loops) {
+    if (loops < 1) {
+        loops = 1;
+    }
+    uint16_t lines = disp_info_lines();
+    uint16_t cols = disp_info_columns();
+    // A typical terminal screen: mostly text in one color, with a status line.
+    static const char* text = "The quick brown fox jumps over the lazy dog. 0123456789 ";
+    size_t text_len = strlen(text);
+    for (uint16_t l = 0; l < lines; l++) {
+        for (uint16_t c = 0; c < cols; c++) {
+            bool status = (l == lines - 1);
+            char ch = text[(l * 7 + c) % text_len];
+            disp_char_color(l, c, ch, (status ? C16_BLACK : C16_GREEN), (status ? C16_WHITE : C16_BLACK), No_Paint);
+        }
+    }
+    for (int cached = AB_FIRST_; cached < 2; cached++) {
+        AB_SWITCH_(glyph_cache_enable(cached));
+        glyph_cache_stats_clear();
+        uint64_t wait_us = 0;
+        uint64_t cpu_us = _screen_paint_time(loops, &wait_us) - wait_us;
+        glyph_cache_stats_t stats;
+        glyph_cache_stats(&stats);
+        uint32_t hit_pct = (stats.lookups ? (uint32_t)(((uint64_t)stats.hits * 100) / stats.lookups) : 0);
+        info_printf("Glyph cache %s: %luus CPU per full screen, %lu%% hits, %lu evictions, %u of %u entries used\n",
+            (cached ? "on" : "off"), (uint32_t)(cpu_us / loops), hit_pct, (uint32_t)stats.evictions, stats.used, stats.entries);
+    }
+    AB_SWITCH_(glyph_cache_enable(true));
+}
+
+void test_disp_status_traffic(int updates, uint32_t interval_ms) {
+    if (updates < 1) {
+        updates = 1;
+    }
+    sensbank_chg_t sb = { 0xFF, 0xFF };
+    for (int cells = AB_FIRST_; cells < 2; cells++) {
+        AB_SWITCH_(disp_cell_repaint_enable(cells));
+        disp_update(Paint);  // Start with the screen matching the text
+        uint64_t b0 = spi_display_bytes();
+        uint64_t t0 = time_us_64();
+        for (int i = 0; i < updates; i++) {
+            // Flip one sensor each update, the way they normally change.
+            sb.prev_bits = sb.bits;
+            sb.bits ^= (1u << (i & 7));
+            hid_update_sensbank(sb);
+            disp_paint();
+            sleep_ms(interval_ms);
+        }
+        uint64_t bytes = spi_display_bytes() - b0;
+        uint64_t us = time_us_64() - t0;
+        info_printf("Display status updates (%s): %lu bytes per update, %lu bytes/s\n",
+            (cells ? "changed cells" : "whole lines"), (uint32_t)(bytes / updates), (uint32_t)((bytes * 1000000) / (us ? us : 1)));
+    }
+    AB_SWITCH_(disp_cell_repaint_enable(true));
+}
+
+void test_disp_screen_switch(int loops) {
+    if (loops < 1) {
+        loops = 1;
+    }
+    disp_render_offload(false);  // The screens are switched on this core
+    struct mallinfo m0 = mallinfo();
+    // Create and close a screen each time
+    uint64_t t0 = time_us_64();
+    for (int i = 0; i < loops; i++) {
+        if (!disp_screen_new()) {
+            error_printf("Screen switch: couldn't create a screen\n");
+            break;
+        }
+        disp_string(0, 0, "New screen", false, Paint);
+        disp_screen_close();
+    }
+    uint64_t new_us = time_us_64() - t0;
+    // Park a screen and switch back and forth to it
+    disp_screen_t parked = NULL;
+    if (disp_screen_new()) {
+        disp_string(0, 0, "Parked screen", false, Paint);
+        parked = disp_screen_park();
+    }
+    t0 = time_us_64();
+    for (int i = 0; i < loops && parked; i++) {
+        disp_screen_restore(parked);
+        parked = disp_screen_park();
+    }
+    uint64_t park_us = time_us_64() - t0;
+    disp_screen_discard(parked);
+    struct mallinfo m1 = mallinfo();
+    uint16_t in_use, peak;
+    disp_screen_pool_info(&in_use, &peak);
+    info_printf("Screen switch: new/close %luus, restore/park %luus (each includes a repaint)\n",
+        (uint32_t)(new_us / loops), (uint32_t)(park_us / loops));
+    info_printf("Screen switch: heap high-water %u -> %u, in use %u -> %u. Pool %u in use, peak %u\n",
+        (unsigned)m0.arena, (unsigned)m1.arena, (unsigned)m0.uordblks, (unsigned)m1.uordblks, in_use, peak);
+    disp_render_offload(true);
+}
+
+void test_disp_widget_traffic(int updates, uint32_t interval_ms) {
+    disp_widget_t bar, busy, temp, ind[8];
+    if (updates < 1) {
+        updates = 1;
+    }
+    disp_render_offload(false);  // So the bytes are sent before they are counted
+    for (int retained = 0; retained < 2; retained++) {
+        disp_clear(Paint);
+        disp_widget_bar_init(&bar, 0, 0, "C0 ", 10, 0, 1000000, C16_LT_GREEN, C16_BLACK);
+        disp_widget_field_init(&busy, 0, 14, NULL, 5, 1, "%", C16_LT_GREEN, C16_BLACK);
+        disp_widget_field_init(&temp, 1, 0, "T ", 5, 1, "C", C16_LT_GREEN, C16_BLACK);
+        for (int i = 0; i < 8; i++) {
+            disp_widget_indicator_init(&ind[i], 2, i * 2, CHKBOX_CHECKED_CHR, CHKBOX_UNCHECKED_CHR, C16_LT_BLUE, C16_BLACK);
+        }
+        uint32_t cells0 = disp_widget_cells_put();
+        uint64_t b0 = spi_display_bytes();
+        for (int n = 0; n < updates; n++) {
+            // Steady state: the busy time wanders a little, the temperature
+            // changes now and then, and a sensor changes once in a while.
+            int32_t active = 120000 + ((n % 7) * 150);
+            int32_t temp_10 = 412 + ((n / 16) & 1);
+            uint8_t sensors = ((n / 32) & 1 ? 0x5A : 0x5B);
+            if (!retained) {
+                // What a timed repaint does: puts everything each time.
+                disp_widget_invalidate(&bar);
+                disp_widget_invalidate(&busy);
+                disp_widget_invalidate(&temp);
+                for (int i = 0; i < 8; i++) {
+                    disp_widget_invalidate(&ind[i]);
+                }
+            }
+            disp_widget_set(&bar, active);
+            disp_widget_set(&busy, active / 1000);
+            disp_widget_set(&temp, temp_10);
+            for (int i = 0; i < 8; i++) {
+                disp_widget_set(&ind[i], sensors & (0x80 >> i));
+            }
+            sleep_ms(interval_ms);
+        }
+        uint64_t bytes = spi_display_bytes() - b0;
+        info_printf("Status panel (%s): %lu cells, %lu bytes per update\n", (retained ? "retained" : "repaint all"),
+            (disp_widget_cells_put() - cells0) / updates, (uint32_t)(bytes / updates));
+    }
+    disp_render_offload(true);
+}
+
+#define TERM_TEST_BURST_ 100    // Characters in a burst (what the terminal takes from its input at once)
+
+void test_term_throughput(int chars) {
+    static const char* words[] = { "servo", "move", "ok", "load", "temp", "pos", "fault", "status" };
+    char burst[TERM_TEST_BURST_ + 1];
+    if (chars < TERM_TEST_BURST_) {
+        chars = TERM_TEST_BURST_;
+    }
+    for (int offload = 0; offload < 2; offload++) {
+        term_vt_reset();
+        disp_render_offload(offload);
+        disp_render_msg_us_max();
+        uint32_t full0 = disp_render_queue_full_cnt();
+        term_vt_stats_clear();
+        uint64_t b0 = spi_display_bytes();
+        uint64_t t0 = time_us_64();
+        int sent = 0;
+        int w = 0;
+        while (sent < chars) {
+            // Log style output, in bursts the size that the terminal takes from its input.
+            int n = 0;
+            while (n < TERM_TEST_BURST_ - 10) {
+                const char* word = words[w++ % 8];
+                if ((w % 11) == 0) {
+                    n += snprintf(burst + n, sizeof(burst) - n, "\r\n");
+                }
+                n += snprintf(burst + n, sizeof(burst) - n, "%s ", word);
+            }
+            term_vt_puts(burst);
+            term_vt_flush();
+            sent += n;
+        }
+        disp_render_offload(false);  // Wait for it all to be painted
+        uint64_t us = time_us_64() - t0;
+        uint64_t bytes = spi_display_bytes() - b0;
+        term_vt_stats_t stats;
+        term_vt_stats_get(&stats);
+        info_printf("Terminal output (%s): %lu chars in %lums, %lu chars/s, %lu lines scrolled, %lu display bytes, longest render message %luus, queue full %lu\n",
+            (offload ? "render core" : "direct"), (uint32_t)sent, (uint32_t)(us / 1000), (uint32_t)(((uint64_t)sent * 1000000) / us),
+            stats.scrolls, (uint32_t)bytes, disp_render_msg_us_max(), disp_render_queue_full_cnt() - full0);
+    }
+    term_vt_reset();
+    disp_render_offload(true);
+}
+
+void test_term_rx_load(uint32_t baud, int secs) {
+    if (baud) {
+        baud = uart_set_baudrate(HOST_COMM_UART, baud);
+    }
+    term_rx_stats_t s0, s1;
+    term_rx_stats_get(&s0);
+    uint64_t busy = 0;
+    uint64_t t0 = time_us_64();
+    uint64_t end = t0 + ((uint64_t)secs * 1000000);
+    while (time_us_64() < end) {
+        uint64_t tb = time_us_64();
+        int c;
+        int n = 0;
+        while ((c = term_getc()) >= 0) {
+            term_vt_putc((char)c);
+            n++;
+        }
+        if (n) {
+            term_vt_flush();
+            busy += time_us_64() - tb;
+        }
+    }
+    uint64_t us = time_us_64() - t0;
+    term_rx_stats_get(&s1);
+    uint32_t bytes = s1.bytes - s0.bytes;
+    uint32_t poll_us = s1.poll_us - s0.poll_us;
+    info_printf("Terminal input (%lu baud): %lu bytes in %lums, %lu bytes/s, %lu dropped, %lu messages (%lu deferred), receive load %lu.%02lu%%, with output %lu.%02lu%%\n",
+        baud, bytes, (uint32_t)(us / 1000), (uint32_t)(((uint64_t)bytes * 1000000) / us), s1.dropped - s0.dropped, s1.msgs - s0.msgs, s1.deferred - s0.deferred,
+        (uint32_t)(((uint64_t)poll_us * 100) / us), (uint32_t)((((uint64_t)poll_us * 10000) / us) % 100),
+        (uint32_t)(((busy + poll_us) * 100) / us), (uint32_t)((((busy + poll_us) * 10000) / us) % 100));
+}
+
+void test_term_scrollback(int lines, int pages) {
+    static const char* words[] = { "servo", "move", "ok", "load", "temp", "pos", "fault", "status" };
+    char line[80];
+    term_vt_reset();
+    term_vt_puts(CSI "3J");     // Clear the history
+    disp_render_offload(false);
+    for (int i = 0; i < lines; i++) {
+        snprintf(line, sizeof(line), "%5d " CSI "%dm%-6s" CSI "0m %s %d\r\n", i, 31 + (i % 6), words[i % 8], words[(i / 8) % 8], (i * 37) % 1000);
+        term_vt_puts(line);
+    }
+    term_vt_flush();
+    term_hist_stats_t hs;
+    term_hist_stats_get(&hs);
+    uint32_t per_line100 = (hs.lines ? (hs.bytes * 100) / hs.lines : 0);
+    info_printf("Scrollback: %u lines stored (%lu dropped) in %lu bytes, %lu.%02lu bytes per line (%u for the cells of a line)\n",
+        hs.lines, hs.dropped, hs.bytes, per_line100 / 100, per_line100 % 100, (unsigned)(disp_info_columns() * 2));
+    uint64_t us_back = 0;
+    uint64_t us_fwd = 0;
+    uint64_t b0 = spi_display_bytes();
+    int viewed = 0;
+    for (int p = 0; p < pages && term_vt_history_view_get() < term_hist_lines(); p++) {
+        uint64_t t0 = time_us_64();
+        term_vt_history_page(1);
+        us_back += time_us_64() - t0;
+        viewed++;
+    }
+    for (int p = 0; p < viewed; p++) {
+        uint64_t t0 = time_us_64();
+        term_vt_history_page(-1);
+        us_fwd += time_us_64() - t0;
+    }
+    uint64_t bytes = spi_display_bytes() - b0;
+    disp_scroll_area_clear(Paint);  // As if the screen was used by something else
+    uint64_t t0 = time_us_64();
+    term_vt_repaint();
+    uint32_t us_repaint = (uint32_t)(time_us_64() - t0);
+    if (viewed) {
+        info_printf("Scrollback: %d pages, page back %luus, page forward %luus, %lu display bytes per page, repaint after clear %luus\n",
+            viewed, (uint32_t)(us_back / viewed), (uint32_t)(us_fwd / viewed), (uint32_t)(bytes / (2 * viewed)), us_repaint);
+    }
+    disp_render_offload(true);
+}
+
+#define VT_TEST_SERVOS_ 8
+
+void test_term_vt_dashboard(int refreshes) {
+    int16_t pos[VT_TEST_SERVOS_];
+    int16_t load[VT_TEST_SERVOS_];
+    char buf[64];
+    if (refreshes < 1) {
+        refreshes = 1;
+    }
+    disp_render_offload(false);  // So the time includes painting, and the bytes are sent before they are counted
+    for (int ansi = 0; ansi < 2; ansi++) {
+        term_vt_reset();
+        for (int i = 0; i < VT_TEST_SERVOS_; i++) {
+            pos[i] = 500 + (i * 100);
+            load[i] = 10 + i;
+        }
+        if (ansi) {
+            // The labels are put once, then only the values are updated.
+            term_vt_puts(CSI "2J" CSI "1;1H" CSI "1mServo Status" CSI "0m");
+            for (int i = 0; i < VT_TEST_SERVOS_; i++) {
+                snprintf(buf, sizeof(buf), CSI "%d;1HServo %d  pos       load    %%", i + 2, i);
+                term_vt_puts(buf);
+            }
+            term_vt_flush();
+        }
+        term_vt_stats_clear();
+        uint64_t b0 = spi_display_bytes();
+        uint64_t t0 = time_us_64();
+        for (int n = 0; n < refreshes; n++) {
+            // A couple of the servos move each time, and now and then one is loaded.
+            int moved[2] = { n % VT_TEST_SERVOS_, (n * 3) % VT_TEST_SERVOS_ };
+            pos[moved[0]] += 7;
+            pos[moved[1]] -= 5;
+            load[moved[0]] = ((n & 0x0F) == 0 ? 85 : 10 + moved[0]);
+            if (!ansi) {
+                // What the host had to do without escape sequences: print the whole screen.
+                term_vt_puts("Servo Status\r\n");
+                for (int i = 0; i < VT_TEST_SERVOS_; i++) {
+                    snprintf(buf, sizeof(buf), "Servo %d  pos %4d  load %3d%%\r\n", i, pos[i], load[i]);
+                    term_vt_puts(buf);
+                }
+            }
+            else {
+                for (int m = 0; m < 2; m++) {
+                    int i = moved[m];
+                    snprintf(buf, sizeof(buf), CSI "%d;14H%4d" CSI "%d;25H%s%3d" CSI "0m", i + 2, pos[i], i + 2,
+                        (load[i] > 80 ? CSI "91m" : ""), load[i]);
+                    term_vt_puts(buf);
+                }
+            }
+            term_vt_flush();
+        }
+        uint64_t us = time_us_64() - t0;
+        uint64_t bytes = spi_display_bytes() - b0;
+        term_vt_stats_t stats;
+        term_vt_stats_get(&stats);
+        info_printf("Dashboard (%s): %lu bytes on the wire, %lu cells, %lu bytes to the display, %luus per refresh\n",
+            (ansi ? "ANSI updates" : "reprint"), stats.bytes / refreshes, stats.cells / refreshes,
+            (uint32_t)(bytes / refreshes), (uint32_t)(us / refreshes));
+    }
+    term_vt_reset();
+    disp_render_offload(true);
+}
+
+bool test_disp_emu_paths(void) {
+#if DISP_ILI_EMU && DISP_AB_BENCH
+    static const char* names[] = { "plain", "glyph cache", "16 bit frames", "DMA" };
+    uint16_t lines = disp_info_lines();
+    uint16_t cols = disp_info_columns();
+    for (uint16_t l = 0; l < lines; l++) {
+        for (uint16_t c = 0; c < cols; c++) {
+            disp_char_color(l, c, (char)('!' + ((l * cols + c) % 94)), colors[(l + c) % 15], colors[(l + 2 * c) % 15], No_Paint);
+        }
+    }
+    uint32_t want = 0;
+    bool same = true;
+    for (int i = 0; i < 4; i++) {
+        // Each run turns on one more of the paths.
+        glyph_cache_enable(i >= 1);
+        spi_display_frame16_enable(i >= 2);
+        spi_display_dma_enable(i >= 3);
+        ili_emu_stats_t stats;
+        ili_emu_stats_clear();
+        disp_update(Paint);
+        ili_emu_stats(&stats);
+        uint32_t hash = ili_emu_screen_hash();
+        if (i == 0) {
+            want = hash;
+        }
+        else if (hash != want) {
+            error_printf("Display emulator: screen with %s (%08lx) doesn't match (%08lx)\n", names[i], hash, want);
+            same = false;
+        }
+        info_printf("Display emulator %s: %lu ops, %lu commands (%lu CASET, %lu PASET, %lu RAMWR), %lu data bytes, %lu pixels\n",
+            names[i], stats.selects, stats.commands, stats.cmd_cnt[ILI_CASET], stats.cmd_cnt[ILI_PASET], stats.cmd_cnt[ILI_RAMWR],
+            (uint32_t)stats.data_bytes, (uint32_t)stats.pixels);
+    }
+    return (same);
+#else
+    info_printf("Display emulator paths: not built (set DISP_ILI_EMU and DISP_AB_BENCH)\n");
+    return (false);
+#endif
+}
+
+static uint32_t _gfx_x = 0x2545F491;
+
+static int _gfx_rand(int lo, int hi) {
+    _gfx_x ^= _gfx_x << 13;
+    _gfx_x ^= _gfx_x >> 17;
+    _gfx_x ^= _gfx_x << 5;
+    return (lo + (int)(_gfx_x % (uint32_t)(hi - lo + 1)));
+}
+
+/*
+ * Draw a random primitive of a kind (0-7).
+ */
+static void _gfx_prim_draw(int kind, int w, int h) {
+    static uint8_t bits[GFX_BITMAP_STRIDE(32) * 16];
+    gfx_point a = { _gfx_rand(-40, w + 40), _gfx_rand(-40, h + 40) };
+    gfx_point b = { _gfx_rand(-40, w + 40), _gfx_rand(-40, h + 40) };
+    gfx_rect rc = { a, b };
+    gfx_color_t color = _gfx_rand(1, 255);
+    int r = _gfx_rand(0, 50);
+    gfx_bitmap_t bm = { _gfx_rand(1, 32), _gfx_rand(1, 16), bits };
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        bits[i] = _gfx_rand(0, 255);
+    }
+    switch (kind) {
+        case 0:
+            gfx_hline(a.x, b.x, a.y, color);
+            break;
+        case 1:
+            gfx_vline(a.x, a.y, b.y, color);
+            break;
+        case 2:
+            gfx_line(&a, &b, color);
+            break;
+        case 3:
+            gfx_rect_draw(&rc, color);
+            break;
+        case 4:
+            gfx_rect_fill(&rc, color);
+            break;
+        case 5:
+            gfx_circle_draw(&a, r, color);
+            break;
+        case 6:
+            gfx_circle_fill(&a, r, color);
+            break;
+        default:
+            gfx_bitmap_draw(&a, &bm, color, GFX_COLOR_NONE);
+            break;
+    }
+}
+
+void test_gfx_primitives(int loops) {
+    static const char* names[] = { "hline", "vline", "line", "rect", "rect fill", "circle", "circle fill", "bitmap" };
+    if (loops < 1) {
+        loops = 1;
+    }
+    const gfx_driver_t* display_driver = gfx_driver_get();
+    if (!display_driver) {
+        error_printf("Graphics primitives: no display driver\n");
+        return;
+    }
+    int w = display_driver->screen_width();
+    int h = display_driver->screen_height();
+    for (int kind = 0; kind < 8; kind++) {
+        uint64_t t0 = time_us_64();
+        for (int n = 0; n < loops; n++) {
+            _gfx_prim_draw(kind, w, h);
+        }
+        uint64_t us = time_us_64() - t0;
+        info_printf("Graphics %s: %lu per second\n", names[kind], (uint32_t)(((uint64_t)loops * 1000000) / (us ? us : 1)));
+    }
+    disp_update(Paint);  // Put the text back
+}
+
+void test_disp_scroll_print(int lines) {
+    char buf[48];
+    if (lines < 1) {
+        lines = 1;
+    }
+    for (int burst = 0; burst < 2; burst++) {
+        disp_clear(Paint);
+        uint64_t b0 = spi_display_bytes();
+        uint64_t t0 = time_us_64();
+        for (int i = 0; i < lines; i++) {
+            snprintf(buf, sizeof(buf), "Line %4d: The quick brown fox jumps", i);
+            disp_prints(buf, No_Paint);
+            // Painting each line scrolls and paints for each of them.
+            disp_print_crlf(0, (burst ? No_Paint : Paint));
+        }
+        disp_paint();
+        uint64_t us = time_us_64() - t0;
+        uint64_t bytes = spi_display_bytes() - b0;
+        info_printf("Print %d lines (%s): %luus, %lu bytes sent\n",
+            lines, (burst ? "one paint" : "paint each line"), (uint32_t)us, (uint32_t)bytes);
+    }
+}
+
+bool test_icon_blit(int loops) {
+    static const icon_t* icons[] = { &icon_battery_ok, &icon_battery_low, &icon_servo_fault, &icon_switch_bank };
+    if (loops < 1) {
+        loops = 1;
+    }
+    uint8_t pb = gfxd_pixel_bytes();
+    gfxd_pixel_t bg = gfxd_pixel_from_rgb18(RGB18_BLACK);
+    bool ok = true;
+    for (int i = 0; i < (int)(sizeof(icons) / sizeof(icons[0])); i++) {
+        const icon_t* icon = icons[i];
+        size_t raw_size = (size_t)icon->width * icon->height * pb;
+        uint8_t* raw = malloc(raw_size);
+        if (!raw) {
+            error_printf("Icon blit: no memory for the raw pixels\n");
+            return (false);
+        }
+        if (!icon_decode(icon, raw, bg)) {
+            error_printf("Icon blit: %s has bad data\n", icon->name);
+            free(raw);
+            ok = false;
+            continue;
+        }
+        gfxd_screen_clr(RGB18_BLACK, true);
+#if DISP_ILI_EMU
+        // What was drawn should be the decoded pixels (the transparent ones left black).
+        icon_draw(icon, 0, 0, NULL);
+        for (int y = 0; y < icon->height; y++) {
+            for (int x = 0; x < icon->width; x++) {
+                rgb18_t rgb;
+                uint8_t px[GFXD_PIXEL_BYTES_MAX];
+                ili_emu_pixel_get(x, y, &rgb);
+                gfxd_pixel_put(px, gfxd_pixel_from_rgb18(rgb), pb);
+                if (memcmp(px, raw + (((y * icon->width) + x) * pb), pb) != 0) {
+                    error_printf("Icon blit: %s pixel %d,%d doesn't match\n", icon->name, x, y);
+                    ok = false;
+                    y = icon->height;
+                    break;
+                }
+            }
+        }
+#endif
+        int per_row = gfxd_screen_width() / icon->width;
+        uint64_t t0 = time_us_64();
+        for (int n = 0; n < loops; n++) {
+            icon_draw(icon, (n % per_row) * icon->width, 0, NULL);
+        }
+        uint64_t rle_us = time_us_64() - t0;
+        t0 = time_us_64();
+        for (int n = 0; n < loops; n++) {
+            gfxd_area_paint((n % per_row) * icon->width, icon->height, icon->width, icon->height, raw);
+        }
+        uint64_t raw_us = time_us_64() - t0;
+        info_printf("Icon %s %dx%d: %u bytes (+%u palette), raw %u bytes. Blit %luus, raw %luus\n",
+            icon->name, icon->width, icon->height, icon->rle_len, (unsigned)(icon->colors * sizeof(gfx_color_t)), (unsigned)raw_size,
+            (uint32_t)(rle_us / loops), (uint32_t)(raw_us / loops));
+        free(raw);
+    }
+    disp_update(Paint);  // Put the text back
+    return (ok);
+}
+
+void test_font_layout(int loops) {
+    const font_info_t* fi = &font_10_16;
+    if (loops < 1) {
+        loops = 1;
+    }
+    uint32_t rows_size = fi->glyph_cnt * fi->height * sizeof(uint16_t);
+    uint32_t index_size = (fi->index ? 128 : 0);
+    uint32_t aa_size = (fi->aa_rows ? fi->glyph_cnt * fi->height * sizeof(uint32_t) : 0);
+    info_printf("Font '%s' %dx%d: %u glyphs, rows %lu bytes, index %lu bytes, anti-aliasing %lu bytes\n",
+        fi->name, fi->width, fi->height, fi->glyph_cnt, rows_size, index_size, aa_size);
+
+    // Expand every glyph to pixels, assembling the rows from bytes (the way
+    // the font used to be read) and loading them whole.
+    uint8_t pb = gfxd_pixel_bytes();
+    gfxd_pixel_t fgpx = gfxd_pixel_from_rgb18(RGB18_WHITE);
+    gfxd_pixel_t bgpx = gfxd_pixel_from_rgb18(RGB18_BLACK);
+    uint8_t* pixels = malloc(fi->width * fi->height * pb);
+    if (!pixels) {
+        error_printf("Font layout: no memory for the pixels\n");
+        return;
+    }
+    const uint8_t* bytes = (const uint8_t*)fi->rows;
+    const int bpgl = sizeof(uint16_t);
+    uint32_t sys_mhz = clock_get_hz(clk_sys) / 1000000;
+    uint64_t t0 = time_us_64();
+    for (int n = 0; n < loops; n++) {
+        for (int c = 0; c < 128; c++) {
+            uint8_t* px = pixels;
+            uint16_t glyphindex = ((fi->index ? fi->index[c] : c) * fi->height * bpgl);
+            for (int glyph_line = 0; glyph_line < fi->height; glyph_line++) {
+                uint32_t cgr = 0;
+                for (int byte = 0; byte < bpgl; byte++) {
+                    cgr |= (bytes[glyphindex + byte + (glyph_line * bpgl)]) << (8u * byte);
+                }
+                for (uint32_t mask = (1u << (fi->width - 1u)); mask; mask >>= 1u) {
+                    px = gfxd_pixel_put(px, ((cgr & mask) ? fgpx : bgpx), pb);
+                }
+            }
+        }
+    }
+    uint64_t bytes_us = time_us_64() - t0;
+    t0 = time_us_64();
+    for (int n = 0; n < loops; n++) {
+        for (int c = 0; c < 128; c++) {
+            uint8_t* px = pixels;
+            const uint16_t* rows = font_glyph_rows(fi, c);
+            for (int glyph_line = 0; glyph_line < fi->height; glyph_line++) {
+                uint32_t cgr = rows[glyph_line];
+                for (uint32_t mask = (1u << (fi->width - 1u)); mask; mask >>= 1u) {
+                    px = gfxd_pixel_put(px, ((cgr & mask) ? fgpx : bgpx), pb);
+                }
+            }
+        }
+    }
+    uint64_t rows_us = time_us_64() - t0;
+    free(pixels);
+    uint32_t glyphs = (uint32_t)loops * 128;
+    info_printf("Font layout: %lu glyphs, byte rows %lu cycles/glyph, whole rows %lu cycles/glyph\n", glyphs,
+        (uint32_t)((bytes_us * sys_mhz) / glyphs), (uint32_t)((rows_us * sys_mhz) / glyphs));
+}
+
+#define RENDER_TEST_BURST_ 100  // Characters in a burst of output (like a terminal input burst)
+#define RENDER_TEST_LINE_ 40    // Characters in a line of output
+
+static struct {
+    int bursts;                 // Bursts for each run
+    int done;                   // Bursts done in this run
+    bool offload;
+    uint32_t chars;
+    uint64_t latency_total;
+    uint64_t latency_max;
+} _rlt;
+
+static void _render_latency_step(cmt_msg_t* msg);
+
+static void _render_latency_post(void) {
+    cmt_msg_t msg;
+    cmt_msg_init3(&msg, MSG_EXEC, MSG_PRI_NORM, _render_latency_step);
+    msg.data.ts_us = time_us_64();
+    postHWCtrlMsg(&msg);
+}
+
+static void _render_latency_step(cmt_msg_t* msg) {
+    uint64_t latency = time_us_64() - msg->data.ts_us;
+    if (_rlt.done > 0) {
+        // The wait for this message includes the display work done by the last step.
+        _rlt.latency_total += latency;
+        if (latency > _rlt.latency_max) {
+            _rlt.latency_max = latency;
+        }
+    }
+    if (_rlt.done == _rlt.bursts) {
+        info_printf("HWOS message latency with terminal output (%s): avg %luus, max %luus\n",
+            (_rlt.offload ? "render offloaded" : "render on HWOS"),
+            (uint32_t)(_rlt.latency_total / _rlt.bursts), (uint32_t)_rlt.latency_max);
+        if (_rlt.offload) {
+            return;  // Done (the offload is left on, the default)
+        }
+        _rlt.offload = true;
+        _rlt.done = 0;
+        _rlt.latency_total = 0;
+        _rlt.latency_max = 0;
+        disp_render_offload(true);
+    }
+    _rlt.done++;
+    // Post the next step before the output, so its wait includes the display work.
+    _render_latency_post();
+    for (int i = 0; i < RENDER_TEST_BURST_; i++) {
+        if ((++_rlt.chars % RENDER_TEST_LINE_) == 0) {
+            disp_render_crlf();
+        }
+        else {
+            disp_render_printc((char)('A' + (_rlt.chars % 26)));
+        }
+    }
+}
+
+void test_disp_render_latency(int bursts) {
+    memset(&_rlt, 0, sizeof(_rlt));
+    _rlt.bursts = (bursts < 1 ? 1 : bursts);
+    disp_render_offload(false);
+    _render_latency_post();
+}
+
+static volatile bool _repaint_busy;
+static int _repaint_loops;
+
+static void _repaint_screens(cmt_msg_t* msg) {
+    for (int i = 0; i < _repaint_loops; i++) {
+        disp_update(Paint);  // Repaints every line
+    }
+    _repaint_busy = false;
+}
+
+void test_expio_latency(int repaints) {
+    _repaint_loops = (repaints < 1 ? 1 : repaints);
+    for (int preempt = AB_FIRST_; preempt < 2; preempt++) {
+        AB_SWITCH_(spi_display_preempt_enable(preempt));
+        spi_txn_stats_clear();
+        uint32_t writes = 0;
+        uint32_t max_us = 0;
+        bool on = false;
+        _repaint_busy = true;
+        cmt_msg_t msg;
+        cmt_msg_init3(&msg, MSG_EXEC, MSG_PRI_NORM, _repaint_screens);
+        postDCSMsg(&msg);
+        while (_repaint_busy) {
+            on = !on;
+            uint64_t t0 = time_us_64();
+            eio_leda_on(on);
+            uint32_t us = (uint32_t)(time_us_64() - t0);
+            if (us > max_us) {
+                max_us = us;
+            }
+            writes++;
+            sleep_us(500);
+        }
+        info_printf("Expansion I/O writes during repaints (%s): max %luus over %lu writes, %lu interruptions\n",
+            (preempt ? "chunked" : "whole operations"), max_us, writes, spi_txn_preempt_cnt());
+    }
+    AB_SWITCH_(spi_display_preempt_enable(true));
+    eio_leda_on(false);
+}
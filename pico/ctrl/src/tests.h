@@ -12,6 +12,13 @@
 extern "C" {
 #endif
 
+#include <stdbool.h>
+#include <stdint.h>
+
+// The display tests use the `disp_*` functions directly. Once the message
+// loops are running, run them on the render core (DISP_RENDER_CORE), or turn
+// off the render offload (`disp_render_offload(false)`) first.
+
 /**
  * @brief Display lines of text on the display in various colors.
  * 
@@ -19,6 +26,269 @@ extern "C" {
  */
 extern void test_display_1(int loops);
 
+/**
+ * @brief Time full screen paints of the text display.
+ *
+ * Fills the screen with text, then repaints all of it `loops` times, first
+ * with the display data written by the CPU and then sent with DMA. Reports
+ * the time per paint and the fraction of it that the CPU was busy. (The
+ * blocking writes are only built with `DISP_AB_BENCH`.)
+ *
+ * @param loops The number of paints to average
+ */
+extern void test_disp_paint_timing(int loops);
+
+/**
+ * @brief Time full screen clears.
+ *
+ * Clears the screen `loops` times by streaming a filled line buffer (the way
+ * it used to be done), with the blocking pixel fill, and with the DMA pixel
+ * fill, and reports the time and CPU cycles used per clear for each. (The
+ * blocking fill is only built with `DISP_AB_BENCH`.)
+ *
+ * @param loops The number of clears for each
+ */
+extern void test_disp_clear_timing(int loops);
+
+/**
+ * @brief Compare full screen paints in the RGB666 and RGB565 pixel formats.
+ *
+ * Fills the screen with text and repaints all of it `loops` times in each
+ * format the controller supports. Reports the time and the bytes sent per
+ * paint. The original format is restored afterwards.
+ *
+ * @param loops The number of paints to average
+ */
+extern void test_disp_pixel_formats(int loops);
+
+/**
+ * @brief Time single character paints.
+ *
+ * Paints `chars` characters across the screen (so the window changes for
+ * each one), with the window words sent as bytes and then in 16 bit SPI
+ * frames, and reports the average time per character for each. (Sending the
+ * words as bytes is only built with `DISP_AB_BENCH`.)
+ *
+ * @param chars The number of characters to paint for each
+ */
+extern void test_disp_char_paint(int chars);
+
+/**
+ * @brief Check that the display paint paths make the same screen, with the emulator.
+ *
+ * Paints a screen of text through each of the paths (glyph cache, 16 bit
+ * frames, DMA) and checks the emulated screen is the same for all of them,
+ * pixel for pixel. Prints the SPI operations, commands and bytes for each.
+ * Needs a build with `DISP_ILI_EMU` set (9341) and `DISP_AB_BENCH` set (to
+ * switch the paths).
+ *
+ * @return true The screens were all the same
+ */
+extern bool test_disp_emu_paths(void);
+
+/**
+ * @brief Measure the throughput of the graphics primitives.
+ *
+ * Draws `loops` of each primitive (random positions and sizes) on the display
+ * and prints the primitives per second. The text screen is repainted when
+ * done. (The primitives are checked against the reference rasterizer by the
+ * host tests.)
+ *
+ * @param loops The number of each primitive
+ */
+extern void test_gfx_primitives(int loops);
+
+/**
+ * @brief Time printing lines of text to the screen.
+ *
+ * Prints `lines` lines painting after each one, then printing them all and
+ * painting once. The second only scrolls the display once and paints the lines
+ * that are left on the screen.
+ *
+ * @param lines The number of lines to print (200 is a good test)
+ */
+extern void test_disp_scroll_print(int lines);
+
+/**
+ * @brief Check the icon blitter and compare it with raw bitmaps.
+ *
+ * Decodes each icon to raw pixels, then draws each one `loops` times from its
+ * runs and `loops` times from the raw pixels. Prints the run data size against
+ * the raw size, and the time for each. When emulating the controller
+ * (`DISP_ILI_EMU`) the drawn pixels are also checked. The text screen is
+ * repainted when done.
+ *
+ * @param loops The number of times to draw each icon each way
+ * @return true The icons decoded (and matched)
+ */
+extern bool test_icon_blit(int loops);
+
+/**
+ * @brief Report the font's size and compare the glyph row layouts.
+ *
+ * Prints the flash used by the terminal font (rows, index, and anti-aliasing
+ * plane). Then expands all of the glyphs `loops` times, getting each row by
+ * assembling it from bytes (how the font was read before it was laid out in
+ * rows) and by loading the whole row, and prints the cycles per glyph for each.
+ *
+ * @param loops The number of times to expand all of the glyphs each way
+ */
+extern void test_font_layout(int loops);
+
+/**
+ * @brief Check the PIO palette expansion and compare paint throughput.
+ *
+ * Expands `loops` runs of random 4 bit pixels (of different lengths) into a
+ * buffer and checks them against the reference model, bit for bit. Then times
+ * full screen paints with the text rendered as pixels (with `DISP_AB_BENCH`)
+ * and as palette indexes. Call it on the render core (or with nothing else
+ * painting).
+ *
+ * @param loops The number of runs to check, and paints for each
+ * @return true The expansion matched the model
+ */
+extern bool test_pal_expand(int loops);
+
+/**
+ * @brief Measure the glyph cache on a typical terminal screen.
+ *
+ * Fills the screen with one color of text and a status line, then repaints
+ * it `loops` times without (with `DISP_AB_BENCH`) and then with the glyph
+ * cache. Reports the CPU time per paint (not counting waits on the display
+ * DMA) and the hit rate.
+ *
+ * @param loops The number of paints to average
+ */
+extern void test_glyph_cache(int loops);
+
+/**
+ * @brief Measure the display traffic of idle status updates.
+ *
+ * Updates the sensor bank status characters (one changing each time) and
+ * paints, `updates` times at `interval_ms`, first repainting whole lines (with
+ * `DISP_AB_BENCH`) and then only the changed cells. Reports the bytes sent to
+ * the display per update and per second.
+ *
+ * @param updates The number of status updates
+ * @param interval_ms The time between updates
+ */
+extern void test_disp_status_traffic(int updates, uint32_t interval_ms);
+
+/**
+ * @brief Time switching screens and check that it doesn't use the heap.
+ *
+ * Creates and closes a screen `loops` times, then restores and parks a
+ * screen `loops` times. Reports the time for each (they include repainting
+ * the screen), the heap high-water mark and use before and after, and the
+ * use of the screen context pool.
+ *
+ * @param loops The number of switches of each kind
+ */
+extern void test_disp_screen_switch(int loops);
+
+/**
+ * @brief Measure the display traffic of a status panel in steady state.
+ *
+ * Sets up a panel of widgets (a bar gauge, two fields and eight indicators)
+ * and updates it `updates` times at `interval_ms` with values that change a
+ * little now and then. This is done first putting all of the widgets each
+ * time (like a timed repaint), then letting the widgets put only what
+ * changed. Reports the cells put and the bytes sent to the display per
+ * update.
+ *
+ * @param updates The number of panel updates
+ * @param interval_ms The time between updates
+ */
+extern void test_disp_widget_traffic(int updates, uint32_t interval_ms);
+
+/**
+ * @brief Measure a dashboard refresh from the host through the terminal.
+ *
+ * Refreshes a servo status dashboard (a title and eight lines of values)
+ * `refreshes` times, with two servos changing each time. This is done first
+ * the way a host had to without escape sequences (printing the whole
+ * dashboard), then by positioning to the values that changed and sending
+ * them (with a color for a high load). Reports the bytes on the wire, the
+ * cells put, the bytes sent to the display, and the time per refresh.
+ * The terminal is reset when done.
+ *
+ * @param refreshes The number of refreshes for each
+ */
+extern void test_term_vt_dashboard(int refreshes);
+
+/**
+ * @brief Measure the sustained terminal output rate.
+ *
+ * Feeds `chars` characters of log style text (with line ends, so the
+ * terminal scrolls) through the terminal in bursts the size that it takes
+ * from its input. This is done rendering directly on this core, then
+ * offloaded to the render core. Reports the characters per second (until
+ * everything is painted), the lines scrolled, the bytes sent to the display,
+ * and the longest render message (how long other messages on the render
+ * core might have to wait). Must be called on core 0.
+ *
+ * @param chars The number of characters for each
+ */
+extern void test_term_throughput(int chars);
+
+/**
+ * @brief Measure the terminal's input path under a sustained stream.
+ *
+ * The host must be sending (for example, `cat` of a large file to the tty)
+ * at the baud rate. For `secs` seconds the input is taken and put through the
+ * terminal here (rather than by the input messages), timing the work. Reports
+ * the bytes per second received, the bytes dropped (the ring came around
+ * before they were read), the input messages posted, and the CPU load of the
+ * receive path (the receive timer) and of the receive path plus the terminal
+ * output. Must be called on core 0.
+ *
+ * @param baud The baud rate to set (the host must match), or 0 to leave it
+ * @param secs The seconds to measure
+ */
+extern void test_term_rx_load(uint32_t baud, int secs);
+
+/**
+ * @brief Measure the scrollback history.
+ *
+ * Feeds `lines` lines of colored log style text through the terminal, so
+ * they scroll into the history. Reports the lines stored, the bytes used per
+ * line (compared to the cells of a line), and the time to put a full page of
+ * the history on the screen (all cells, one paint) and to put the terminal
+ * back (and to repaint it after the area is cleared). This is done rendering on this core, so the time is until the page is
+ * painted. Must be called on core 0.
+ *
+ * @param lines The number of lines to feed
+ * @param pages The number of pages to view (back, then forward again)
+ */
+extern void test_term_scrollback(int lines, int pages);
+
+/**
+ * @brief Measure HWOS message latency during heavy terminal output.
+ *
+ * Outputs `bursts` bursts of text the way the terminal does, from HWOS
+ * messages, first rendering on HWOS and then offloaded to the render core.
+ * Each burst's message posts the next one before the output, and the time
+ * that message waits is the latency. Reports the average and maximum
+ * latency for each. This returns right away and reports when done. Must be
+ * called on core 0 (HWOS).
+ *
+ * @param bursts The number of bursts of output for each
+ */
+extern void test_disp_render_latency(int bursts);
+
+/**
+ * @brief Measure Expansion I/O write latency during full screen repaints.
+ *
+ * Repaints the whole screen `repaints` times on the render core, while
+ * toggling LED-A on this core, first with the display operations holding
+ * the SPI until they end (with `DISP_AB_BENCH`), then with the pixel data
+ * split into chunks.
+ * Reports the worst case write time for each. Must be called on core 0.
+ *
+ * @param repaints The number of full screen repaints for each
+ */
+extern void test_expio_latency(int repaints);
+
 #ifdef __cplusplus
 }
 #endif
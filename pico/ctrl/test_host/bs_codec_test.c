@@ -0,0 +1,226 @@
+/**
+ * Host tests for the Serial Bus Servo protocol codec.
+ *
+ * Round-trips every command and reply, checks that corruptions and
+ * truncations are rejected, fuzzes the decoder, and checks known packets
+ * from the HiWonder protocol document. The codec doesn't use the SDK, so it
+ * builds and runs on the development machine.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "servo/bs_codec.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FUZZ_LOOPS 200000
+
+static int _fails = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { fprintf(stderr, __VA_ARGS__); _fails++; } } while (0)
+
+/**
+ * @brief Fill in parameter values that exercise every byte of a layout.
+ */
+static void _params(bs_layout_t layout, uint32_t seed, bs_params_t* p) {
+    memset(p, 0, sizeof(bs_params_t));
+    switch (layout) {
+        case BSL_U8:
+            p->u8 = (uint8_t)seed;
+            break;
+        case BSL_S8:
+            p->s8 = (int8_t)(seed ^ 0x80);
+            break;
+        case BSL_S16:
+            p->s16 = (int16_t)(seed * 7 - 1000);
+            break;
+        case BSL_U16:
+            p->u16 = (uint16_t)(seed * 131);
+            break;
+        case BSL_MOVE:
+            p->move.pos = (int16_t)(seed * 3 - 100);
+            p->move.time = (uint16_t)(seed * 29);
+            break;
+        case BSL_LIMIT:
+            p->limit.min = (uint16_t)seed;
+            p->limit.max = (uint16_t)(seed * 17);
+            break;
+        case BSL_MODE:
+            p->mode.mode = (uint8_t)(seed & 1);
+            p->mode.speed = (int16_t)(seed * 5 - 1000);
+            break;
+        case BSL_NONE:
+            break;
+    }
+}
+
+static bool _params_eq(bs_layout_t layout, const bs_params_t* a, const bs_params_t* b) {
+    switch (layout) {
+        case BSL_U8:
+        case BSL_S8:
+            return (a->u8 == b->u8);
+        case BSL_S16:
+        case BSL_U16:
+            return (a->u16 == b->u16);
+        case BSL_MOVE:
+            return (a->move.pos == b->move.pos && a->move.time == b->move.time);
+        case BSL_LIMIT:
+            return (a->limit.min == b->limit.min && a->limit.max == b->limit.max);
+        case BSL_MODE:
+            return (a->mode.mode == b->mode.mode && a->mode.speed == b->mode.speed);
+        case BSL_NONE:
+            break;
+    }
+    return (true);
+}
+
+/**
+ * @brief Check the framing against packets worked out by hand from the protocol document.
+ */
+static void _known_packets(void) {
+    uint8_t buf[BSPKT_PAYLOAD_MAX_LEN];
+    bs_params_t params;
+    bs_packet_t pkt;
+
+    // Servo 1 to position 500 in 1000ms
+    static const uint8_t move[] = { 0x55, 0x55, 0x01, 0x07, 0x01, 0xF4, 0x01, 0xE8, 0x03, 0x16 };
+    memset(&params, 0, sizeof(params));
+    params.move.pos = 500;
+    params.move.time = 1000;
+    size_t len = bs_encode_cmd(buf, sizeof(buf), 1, BS_MOVE_TIME_WRITE, &params);
+    CHECK(len == sizeof(move) && memcmp(buf, move, sizeof(move)) == 0, "MOVE_TIME_WRITE doesn't match the known packet\n");
+    CHECK(bs_decode_cmd(move, sizeof(move), &pkt) == BSD_OK && pkt.params.move.pos == 500 && pkt.params.move.time == 1000,
+        "MOVE_TIME_WRITE known packet doesn't decode\n");
+
+    // Read the position of servo 3 (no parameters)
+    static const uint8_t pos_read[] = { 0x55, 0x55, 0x03, 0x03, 0x1C, 0xDD };
+    len = bs_encode_cmd(buf, sizeof(buf), 3, BS_POS_READ, NULL);
+    CHECK(len == sizeof(pos_read) && memcmp(buf, pos_read, sizeof(pos_read)) == 0, "POS_READ doesn't match the known packet\n");
+
+    // The reply: position -5
+    static const uint8_t pos_reply[] = { 0x55, 0x55, 0x03, 0x05, 0x1C, 0xFB, 0xFF, 0xE1 };
+    CHECK(bs_decode_reply(pos_reply, sizeof(pos_reply), &pkt) == BSD_OK && pkt.id == 3 && pkt.params.s16 == -5,
+        "POS_READ known reply doesn't decode\n");
+
+    // Framing errors are reported as such
+    uint8_t bad[sizeof(move)];
+    memcpy(bad, move, sizeof(move));
+    bad[BSPKT_HEADER2] = 0x54;
+    CHECK(bs_decode_cmd(bad, sizeof(bad), &pkt) == BSD_HEADER, "Bad header not reported\n");
+    memcpy(bad, move, sizeof(move));
+    bad[BSPKT_LEN] = 0x06;
+    CHECK(bs_decode_cmd(bad, sizeof(bad), &pkt) != BSD_OK, "Bad LEN accepted\n");
+    memcpy(bad, move, sizeof(move));
+    bad[sizeof(bad) - 1] ^= 0xFF;
+    CHECK(bs_decode_cmd(bad, sizeof(bad), &pkt) == BSD_CSUM, "Bad checksum not reported\n");
+    CHECK(bs_decode_cmd(move, sizeof(move) - 1, &pkt) == BSD_SHORT, "Short packet not reported\n");
+
+    // A command that doesn't have a reply, and an encode into a buffer that is too small
+    CHECK(bs_encode_reply(buf, sizeof(buf), 1, BS_MOVE_TIME_WRITE, &params) == 0, "Encoded a reply to a write\n");
+    CHECK(bs_encode_cmd(buf, sizeof(move) - 1, 1, BS_MOVE_TIME_WRITE, &params) == 0, "Encoded into a short buffer\n");
+}
+
+/**
+ * @brief Round-trip every command and reply, and check that every single byte
+ * corruption, and every truncation, is rejected.
+ */
+static int _round_trip(void) {
+    uint8_t buf[BSPKT_PAYLOAD_MAX_LEN];
+    bs_params_t params;
+    bs_packet_t pkt;
+    int cmds = 0;
+
+    for (int cmd = 0; cmd <= UINT8_MAX; cmd++) {
+        const bs_cmd_desc_t* desc = bs_cmd_desc((uint8_t)cmd);
+        if (!desc) {
+            CHECK(bs_encode_cmd(buf, sizeof(buf), 1, (uint8_t)cmd, NULL) == 0, "Encoded invalid command %d\n", cmd);
+            continue;
+        }
+        cmds++;
+        for (int side = 0; side < 2; side++) {
+            bool reply = (side == 1);
+            bs_layout_t layout = (reply ? desc->reply_layout : desc->cmd_layout);
+            if (reply && layout == BSL_NONE) {
+                continue;
+            }
+            for (uint32_t seed = 0; seed < 16; seed++) {
+                _params(layout, seed * 0x1111, &params);
+                uint8_t id = (uint8_t)(seed * 15);
+                size_t len = (reply ? bs_encode_reply(buf, sizeof(buf), id, desc->cmd, &params)
+                                    : bs_encode_cmd(buf, sizeof(buf), id, desc->cmd, &params));
+                if (len != BSPKT_LEN_FOR(bs_layout_len(layout))) {
+                    CHECK(false, "%s encoded length %zu\n", desc->name, len);
+                    break;
+                }
+                bs_decode_status_t ds = (reply ? bs_decode_reply(buf, len, &pkt) : bs_decode_cmd(buf, len, &pkt));
+                CHECK(ds == BSD_OK && pkt.id == id && pkt.cmd == desc->cmd && _params_eq(layout, &params, &pkt.params),
+                    "%s %s round-trip failed (%d)\n", desc->name, (reply ? "reply" : "cmd"), ds);
+                for (size_t i = 0; i < len; i++) {
+                    buf[i] ^= 0x01;
+                    ds = (reply ? bs_decode_reply(buf, len, &pkt) : bs_decode_cmd(buf, len, &pkt));
+                    buf[i] ^= 0x01;
+                    CHECK(ds != BSD_OK, "%s accepted with byte %zu corrupted\n", desc->name, i);
+                    ds = (reply ? bs_decode_reply(buf, i, &pkt) : bs_decode_cmd(buf, i, &pkt));
+                    CHECK(ds != BSD_OK, "%s accepted truncated to %zu\n", desc->name, i);
+                }
+            }
+        }
+    }
+    return (cmds);
+}
+
+/**
+ * @brief Fuzz the decoder. Anything it accepts must re-encode to the same bytes.
+ */
+static uint32_t _fuzz(uint32_t loops) {
+    uint8_t buf[BSPKT_PAYLOAD_MAX_LEN];
+    uint8_t fz[BSPKT_PAYLOAD_MAX_LEN + 4];
+    bs_packet_t pkt;
+    uint32_t x = 0x2545F491;
+    uint32_t accepted = 0;
+
+    for (uint32_t n = 0; n < loops; n++) {
+        for (size_t i = 0; i < sizeof(fz); i++) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            fz[i] = (uint8_t)x;
+        }
+        // Mostly give it good headers and plausible lengths so it gets past the first checks.
+        if (x & 0x100) {
+            fz[BSPKT_HEADER1] = fz[BSPKT_HEADER2] = BS_FRAME_HEADER;
+            fz[BSPKT_LEN] = 3 + (fz[BSPKT_LEN] % (BSPKT_PARAMS_MAX + 1));
+        }
+        size_t len = x % (sizeof(fz) + 1);
+        bool reply = (x & 0x200);
+        if ((reply ? bs_decode_reply(fz, len, &pkt) : bs_decode_cmd(fz, len, &pkt)) == BSD_OK) {
+            accepted++;
+            size_t elen = (reply ? bs_encode_reply(buf, sizeof(buf), pkt.id, pkt.cmd, &pkt.params)
+                                 : bs_encode_cmd(buf, sizeof(buf), pkt.id, pkt.cmd, &pkt.params));
+            // The MODE layout has a pad byte that is ignored, so don't compare it.
+            const bs_cmd_desc_t* desc = bs_cmd_desc(pkt.cmd);
+            bs_layout_t layout = (reply ? desc->reply_layout : desc->cmd_layout);
+            if (layout == BSL_MODE) {
+                buf[BSPKT_DATA + 1] = fz[BSPKT_DATA + 1];
+                buf[elen - 1] = fz[elen - 1];
+            }
+            CHECK(elen != 0 && elen <= len && memcmp(buf, fz, elen) == 0,
+                "Fuzz packet %u accepted but doesn't re-encode\n", n);
+        }
+    }
+    return (accepted);
+}
+
+int main(int argc, char** argv) {
+    uint32_t loops = (argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : FUZZ_LOOPS);
+
+    _known_packets();
+    int cmds = _round_trip();
+    uint32_t accepted = _fuzz(loops);
+    printf("Servo codec: %d commands checked, %u random packets (%u accepted), %d failures\n",
+        cmds, loops, accepted, _fails);
+
+    return (_fails == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,222 @@
+/**
+ * Host tests for the graphics primitives.
+ *
+ * Draws random primitives (positions and sizes that go off of the canvas,
+ * and random clip rectangles) with `gfx`, through a driver that captures the
+ * area fills into memory, and with the reference rasterizer (`gfx_ref`), and
+ * checks that they match, pixel for pixel. Neither uses the SDK, so they
+ * build and run on the development machine.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "gfx/gfx.h"
+#include "gfx/gfx_ref.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRIM_LOOPS 20000    // Of each primitive
+
+#define CANVAS_W 96
+#define CANVAS_H 64
+
+static const char* _names[] = { "hline", "vline", "line", "rect", "rect fill", "circle", "circle fill", "bitmap" };
+#define PRIM_KINDS ((int)(sizeof(_names) / sizeof(_names[0])))
+
+static uint8_t _got[CANVAS_W * CANVAS_H];
+static uint8_t _want[CANVAS_W * CANVAS_H];
+static uint32_t _fills;
+static uint32_t _x = 0x2545F491;
+
+// ############################################################################
+// Capture Driver
+// ############################################################################
+//
+
+static uint16_t _capture_width(void) {
+    return (CANVAS_W);
+}
+
+static uint16_t _capture_height(void) {
+    return (CANVAS_H);
+}
+
+static void _capture_fill(uint16_t x, uint16_t y, uint16_t w, uint16_t h, gfx_color_t color) {
+    _fills++;
+    if (w == 0 || h == 0 || x + w > CANVAS_W || y + h > CANVAS_H) {
+        // The driver is only given areas on the screen.
+        fprintf(stderr, "Fill off of the screen: %u,%u %ux%u\n", x, y, w, h);
+        exit(EXIT_FAILURE);
+    }
+    for (uint16_t r = y; r < y + h; r++) {
+        memset(_got + (r * CANVAS_W) + x, (uint8_t)color, w);
+    }
+}
+
+static const gfx_driver_t _capture_driver = {
+    .screen_width = _capture_width,
+    .screen_height = _capture_height,
+    .area_fill = _capture_fill,
+};
+
+// ############################################################################
+// Tests
+// ############################################################################
+//
+
+static int _rand(int lo, int hi) {
+    _x ^= _x << 13;
+    _x ^= _x >> 17;
+    _x ^= _x << 5;
+    return (lo + (int)(_x % (uint32_t)(hi - lo + 1)));
+}
+
+/*
+ * Draw a random primitive of a kind with gfx and with the reference.
+ */
+static void _prim_draw(int kind, gfx_ref_canvas_t* cv) {
+    static uint8_t bits[GFX_BITMAP_STRIDE(32) * 16];
+    gfx_point a = { _rand(-40, CANVAS_W + 40), _rand(-40, CANVAS_H + 40) };
+    gfx_point b = { _rand(-40, CANVAS_W + 40), _rand(-40, CANVAS_H + 40) };
+    gfx_rect rc = { a, b };
+    gfx_color_t color = _rand(1, 255);
+    int r = _rand(0, 50);
+    gfx_bitmap_t bm = { _rand(1, 32), _rand(1, 16), bits };
+    gfx_color_t bg = (_rand(0, 1) ? GFX_COLOR_NONE : _rand(1, 255));
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        bits[i] = _rand(0, 255);
+    }
+    switch (kind) {
+        case 0:
+            gfx_hline(a.x, b.x, a.y, color);
+            gfx_ref_hline(cv, a.x, b.x, a.y, color);
+            break;
+        case 1:
+            gfx_vline(a.x, a.y, b.y, color);
+            gfx_ref_vline(cv, a.x, a.y, b.y, color);
+            break;
+        case 2:
+            gfx_line(&a, &b, color);
+            gfx_ref_line(cv, &a, &b, color);
+            break;
+        case 3:
+            gfx_rect_draw(&rc, color);
+            gfx_ref_rect_draw(cv, &rc, color);
+            break;
+        case 4:
+            gfx_rect_fill(&rc, color);
+            gfx_ref_rect_fill(cv, &rc, color);
+            break;
+        case 5:
+            gfx_circle_draw(&a, r, color);
+            gfx_ref_circle_draw(cv, &a, r, color);
+            break;
+        case 6:
+            gfx_circle_fill(&a, r, color);
+            gfx_ref_circle_fill(cv, &a, r, color);
+            break;
+        default:
+            gfx_bitmap_draw(&a, &bm, color, bg);
+            gfx_ref_bitmap_draw(cv, &a, &bm, color, bg);
+            break;
+    }
+}
+
+/*
+ * Draw `loops` of each primitive, every other 8 with a random clip rectangle.
+ */
+static int _primitives(int loops) {
+    int fails = 0;
+    gfx_ref_canvas_t cv = { CANVAS_W, CANVAS_H, _want };
+    gfx_driver_set(&_capture_driver);
+    for (int n = 0; n < loops * PRIM_KINDS; n++) {
+        memset(_got, 0, sizeof(_got));
+        memset(_want, 0, sizeof(_want));
+        if (n & 8) {
+            gfx_rect clip = { { _rand(-10, CANVAS_W + 10), _rand(-10, CANVAS_H + 10) },
+                { _rand(-10, CANVAS_W + 10), _rand(-10, CANVAS_H + 10) } };
+            gfx_clip_set(&clip);
+            gfx_rect_normalize(&clip);
+            cv.clip = clip;
+        }
+        else {
+            gfx_clip_clear();
+            cv.clip = (gfx_rect){ { 0, 0 }, { CANVAS_W - 1, CANVAS_H - 1 } };
+        }
+        _prim_draw(n % PRIM_KINDS, &cv);
+        if (memcmp(_got, _want, sizeof(_got)) != 0) {
+            if (fails < 10) {
+                fprintf(stderr, "%s %d doesn't match the reference\n", _names[n % PRIM_KINDS], n);
+            }
+            fails++;
+        }
+    }
+    gfx_clip_clear();
+
+    return (fails);
+}
+
+/*
+ * Check some shapes with known pixels (so a change to both gfx and the
+ * reference is also caught).
+ */
+static int _known(void) {
+    int fails = 0;
+    gfx_driver_set(&_capture_driver);
+    gfx_clip_clear();
+
+    // A 5x3 filled rectangle from corners given backwards
+    memset(_got, 0, sizeof(_got));
+    gfx_rect rc = { { 14, 12 }, { 10, 10 } };
+    gfx_rect_fill(&rc, 7);
+    int set = 0;
+    for (int i = 0; i < (int)sizeof(_got); i++) {
+        set += (_got[i] != 0);
+    }
+    if (set != 15 || _got[(10 * CANVAS_W) + 10] != 7 || _got[(12 * CANVAS_W) + 14] != 7) {
+        fprintf(stderr, "Rect fill: %d pixels set (15 expected)\n", set);
+        fails++;
+    }
+
+    // A radius 2 circle has 12 pixels (Bresenham/midpoint)
+    memset(_got, 0, sizeof(_got));
+    gfx_point c = { 20, 20 };
+    gfx_circle_draw(&c, 2, 9);
+    set = 0;
+    for (int i = 0; i < (int)sizeof(_got); i++) {
+        set += (_got[i] != 0);
+    }
+    if (set != 12 || _got[(18 * CANVAS_W) + 20] != 9 || _got[(20 * CANVAS_W) + 22] != 9 || _got[(20 * CANVAS_W) + 20] != 0) {
+        fprintf(stderr, "Circle: %d pixels set (12 expected)\n", set);
+        fails++;
+    }
+
+    // A diagonal line off of the canvas only draws what is on it
+    memset(_got, 0, sizeof(_got));
+    gfx_point p1 = { -5, -5 };
+    gfx_point p2 = { 4, 4 };
+    gfx_line(&p1, &p2, 3);
+    set = 0;
+    for (int i = 0; i < (int)sizeof(_got); i++) {
+        set += (_got[i] != 0);
+    }
+    if (set != 5 || _got[0] != 3 || _got[(4 * CANVAS_W) + 4] != 3) {
+        fprintf(stderr, "Line: %d pixels set (5 expected)\n", set);
+        fails++;
+    }
+
+    return (fails);
+}
+
+int main(int argc, char** argv) {
+    int loops = (argc > 1 ? (int)strtol(argv[1], NULL, 0) : PRIM_LOOPS);
+
+    int fails = _known();
+    int mismatches = _primitives(loops);
+    printf("Graphics primitives: %d checked (%u fills), %d mismatches, %d known shape failures\n",
+        loops * PRIM_KINDS, _fills, mismatches, fails);
+
+    return (fails == 0 && mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,322 @@
+/**
+ * Host stand-in for the clock, the timer alarms and the core 0 message loop.
+ * See `host_cmt.h`.
+ *
+ * Also the board functions (time, output and panic) that go with them.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "host_cmt.h"
+
+#include "board.h"
+
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALARMS_MAX_         16
+#define GPIO_CNT_           48
+#define MSG_QUEUE_SIZE_     64
+#define SCHEDULED_MSGS_MAX_ 16
+#define HOUSEKEEPING_MS_    16
+
+typedef struct HOST_ALARM_ {
+    alarm_id_t id;              // 0 = free
+    uint64_t due_us;
+    alarm_callback_t callback;
+    void* user_data;
+} host_alarm_t;
+
+typedef struct HOST_SCHED_MSG_ {
+    int32_t remaining;          // 1ms ticks left (0 = free)
+    const cmt_msg_t* msg;
+} host_sched_msg_t;
+
+static uint64_t _now_us;
+static uint64_t _tick_us;       // Time of the next 1ms tick
+static uint32_t _ticks;
+
+static host_alarm_t _alarms[ALARMS_MAX_];
+static alarm_id_t _alarm_id_last;
+
+static host_sched_msg_t _sched_msgs[SCHEDULED_MSGS_MAX_];
+
+static cmt_msg_t _msgs[MSG_QUEUE_SIZE_];
+static int _msg_in;
+static int _msg_out;
+
+static const msg_handler_entry_t** _handler_entries;
+
+static bool _gpio_out[GPIO_CNT_];
+
+// ############################################################################
+// Internal Functions
+// ############################################################################
+//
+
+static void _dispatch(void) {
+    while (_msg_out != _msg_in) {
+        cmt_msg_t msg = _msgs[_msg_out];
+        _msg_out = (_msg_out + 1) % MSG_QUEUE_SIZE_;
+        if (msg.hdlr) {
+            msg.hdlr(&msg);
+            continue;
+        }
+        for (const msg_handler_entry_t** e = _handler_entries; e && *e; e++) {
+            if ((*e)->msg_id == (int)msg.id) {
+                (*e)->msg_handler(&msg);
+            }
+        }
+    }
+}
+
+static host_alarm_t* _alarm_next(void) {
+    host_alarm_t* next = NULL;
+    for (int i = 0; i < ALARMS_MAX_; i++) {
+        host_alarm_t* a = &_alarms[i];
+        if (a->id && (!next || a->due_us < next->due_us)) {
+            next = a;
+        }
+    }
+    return (next);
+}
+
+/*
+ * Call an alarm, and reschedule it the way the SDK does with what it returns.
+ */
+static void _alarm_fire(host_alarm_t* a) {
+    alarm_id_t id = a->id;
+    int64_t next = a->callback(id, a->user_data);
+    if (a->id != id) {
+        return;  // It was cancelled by the callback.
+    }
+    if (next < 0) {
+        a->due_us += (uint64_t)(-next);
+    }
+    else if (next > 0) {
+        a->due_us = _now_us + (uint64_t)next;
+    }
+    else {
+        a->id = 0;
+    }
+}
+
+/*
+ * The CMT 1ms tick: count down the scheduled messages, and post housekeeping.
+ */
+static void _tick(void) {
+    for (int i = 0; i < SCHEDULED_MSGS_MAX_; i++) {
+        host_sched_msg_t* sm = &_sched_msgs[i];
+        if (sm->remaining > 0 && --sm->remaining == 0) {
+            post_to_core0(sm->msg);
+        }
+    }
+    if (++_ticks % HOUSEKEEPING_MS_ == 0) {
+        cmt_msg_t msg;
+        cmt_msg_init2(&msg, MSG_HOUSEKEEPING_RT, MSG_PRI_LP);
+        post_to_core0(&msg);
+    }
+    _tick_us += 1000;
+}
+
+/*
+ * Run to a time, doing the alarms and ticks (the interrupts) that come due on
+ * the way, and handling the messages they post if `handle` is set.
+ */
+static void _run_to(uint64_t end_us, bool handle) {
+    if (handle) {
+        _dispatch();
+    }
+    while (true) {
+        host_alarm_t* a = _alarm_next();
+        uint64_t t = (a && a->due_us < _tick_us ? a->due_us : _tick_us);
+        if (t > end_us) {
+            break;
+        }
+        if (t > _now_us) {
+            _now_us = t;
+        }
+        if (a && a->due_us < _tick_us) {
+            _alarm_fire(a);
+        }
+        else {
+            _tick();
+        }
+        if (handle) {
+            _dispatch();
+        }
+    }
+    _now_us = end_us;
+}
+
+// ############################################################################
+// Board
+// ############################################################################
+//
+
+void board_panic(const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "PANIC: ");
+    vfprintf(stderr, fmt, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+    exit(EXIT_FAILURE);
+}
+
+uint32_t now_ms() {
+    return ((uint32_t)(_now_us / 1000));
+}
+
+uint64_t now_us() {
+    return (_now_us);
+}
+
+void debug_printf(const char* format, ...) {
+    // Only the info and above are shown.
+}
+
+void error_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
+
+void info_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void warn_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+// ############################################################################
+// SDK (alarms, busy wait and GPIO)
+// ############################################################################
+//
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past) {
+    for (int i = 0; i < ALARMS_MAX_; i++) {
+        host_alarm_t* a = &_alarms[i];
+        if (!a->id) {
+            if (++_alarm_id_last <= 0) {
+                _alarm_id_last = 1;
+            }
+            a->id = _alarm_id_last;
+            a->due_us = _now_us + us;
+            a->callback = callback;
+            a->user_data = user_data;
+            return (a->id);
+        }
+    }
+    return (-1);  // No alarm slots (the SDK returns -1 as well)
+}
+
+bool cancel_alarm(alarm_id_t alarm_id) {
+    for (int i = 0; i < ALARMS_MAX_; i++) {
+        if (alarm_id > 0 && _alarms[i].id == alarm_id) {
+            _alarms[i].id = 0;
+            return (true);
+        }
+    }
+    return (false);
+}
+
+void busy_wait_us(uint64_t delay_us) {
+    // The interrupts still happen, but messages wait for the loop.
+    _run_to(_now_us + delay_us, false);
+}
+
+bool gpio_get(uint gpio) {
+    return (gpio < GPIO_CNT_ ? _gpio_out[gpio] : false);
+}
+
+void gpio_put(uint gpio, bool value) {
+    if (gpio < GPIO_CNT_) {
+        _gpio_out[gpio] = value;
+    }
+}
+
+// ############################################################################
+// CMT
+// ############################################################################
+//
+
+void cmt_msg_init(cmt_msg_t* msg, msg_id_t id) {
+    cmt_msg_init3(msg, id, MSG_PRI_NORM, NULL_MSG_HDLR);
+}
+
+void cmt_msg_init2(cmt_msg_t* msg, msg_id_t id, msg_priority_t priority) {
+    cmt_msg_init3(msg, id, priority, NULL_MSG_HDLR);
+}
+
+void cmt_msg_init3(cmt_msg_t* msg, msg_id_t id, msg_priority_t priority, msg_handler_fn hdlr) {
+    msg->id = id;
+    msg->priority = priority;
+    msg->hdlr = hdlr;
+    msg->n = 0;
+    msg->t = 0;
+}
+
+void post_to_core0(const cmt_msg_t* msg) {
+    int next = (_msg_in + 1) % MSG_QUEUE_SIZE_;
+    if (next == _msg_out) {
+        board_panic("host_cmt - Message queue full (id: %d)", (int)msg->id);
+    }
+    _msgs[_msg_in] = *msg;
+    _msgs[_msg_in].t = now_ms();
+    _msg_in = next;
+}
+
+void schedule_core0_msg_in_ms(int32_t ms, const cmt_msg_t* msg) {
+    for (int i = 0; i < SCHEDULED_MSGS_MAX_; i++) {
+        host_sched_msg_t* sm = &_sched_msgs[i];
+        if (sm->remaining == 0) {
+            // Like the CMT, the message is read when it is posted.
+            sm->msg = msg;
+            sm->remaining = (ms > 0 ? ms : 1);
+            return;
+        }
+    }
+    board_panic("host_cmt - No scheduled message slot available");
+}
+
+void scheduled_msg_cancel(msg_id_t sched_msg_id) {
+    for (int i = 0; i < SCHEDULED_MSGS_MAX_; i++) {
+        host_sched_msg_t* sm = &_sched_msgs[i];
+        if (sm->remaining > 0 && sm->msg->id == sched_msg_id) {
+            sm->remaining = 0;
+        }
+    }
+}
+
+// ############################################################################
+// Public Functions
+// ############################################################################
+//
+
+void host_run_us(uint64_t us) {
+    _run_to(_now_us + us, true);
+}
+
+void host_cmt_init(const msg_handler_entry_t** handler_entries) {
+    _handler_entries = handler_entries;
+    _now_us = 0;
+    _tick_us = 1000;
+    _ticks = 0;
+    memset(_alarms, 0, sizeof(_alarms));
+    memset(_sched_msgs, 0, sizeof(_sched_msgs));
+    _msg_in = _msg_out = 0;
+}
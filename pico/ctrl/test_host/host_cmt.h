@@ -0,0 +1,41 @@
+/**
+ * Host stand-in for the clock, the timer alarms and the core 0 message loop.
+ *
+ * Time is simulated. It only moves when a test runs it (`host_run_us`), and
+ * then it goes from one alarm, or 1ms scheduled message tick, to the next.
+ * The messages that are posted are handled, in order, between them, in no
+ * time. So a test runs the same way every time, and a second of bus traffic
+ * takes a few milliseconds to run.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_CMT_H_
+#define _HOST_CMT_H_
+
+#include "cmt/cmt.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Run the simulated time forward.
+ *
+ * Alarms that come due are called, scheduled messages are posted as their
+ * time comes, a MSG_HOUSEKEEPING_RT is posted every 16ms, and the messages
+ * posted are handled. Time stops at `us` from now, after the messages posted
+ * by then have been handled.
+ *
+ * @param us The time to run for
+ */
+extern void host_run_us(uint64_t us);
+
+/**
+ * @brief Set up the message loop.
+ *
+ * @param handler_entries NULL terminated list of message handler entries
+ * (for messages that don't have a handler of their own)
+ */
+extern void host_cmt_init(const msg_handler_entry_t** handler_entries);
+
+#endif // _HOST_CMT_H_
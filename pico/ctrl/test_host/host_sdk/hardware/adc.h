@@ -0,0 +1,12 @@
+/**
+ * Host stand-in for the Pico SDK's `hardware/adc.h` (see `pico.h`).
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_HARDWARE_ADC_H_
+#define _HOST_SDK_HARDWARE_ADC_H_
+
+#include "pico.h"
+
+#endif // _HOST_SDK_HARDWARE_ADC_H_
@@ -0,0 +1,19 @@
+/**
+ * Host stand-in for the Pico SDK's `hardware/gpio.h` (see `pico.h`).
+ *
+ * The outputs are kept by the test's message loop (`host_cmt.c`), so a test
+ * can check the level a pin was left at.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_HARDWARE_GPIO_H_
+#define _HOST_SDK_HARDWARE_GPIO_H_
+
+#include "pico.h"
+
+extern bool gpio_get(uint gpio);
+
+extern void gpio_put(uint gpio, bool value);
+
+#endif // _HOST_SDK_HARDWARE_GPIO_H_
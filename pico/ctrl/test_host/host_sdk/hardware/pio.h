@@ -0,0 +1,41 @@
+/**
+ * Host stand-in for the Pico SDK's `hardware/pio.h` (see `pico.h`).
+ *
+ * There is no PIO on the host. The servo bus 1 PIO UART uses the simulated bus
+ * (`servo_sim`) in its place, so only the types, and an RX FIFO that is
+ * always empty, are needed.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_HARDWARE_PIO_H_
+#define _HOST_SDK_HARDWARE_PIO_H_
+
+#include "pico.h"
+
+#define PIO_FDEBUG_TXSTALL_LSB 24
+
+typedef struct {
+    volatile uint32_t fdebug;
+} pio_hw_t;
+
+typedef pio_hw_t* PIO;
+
+static inline PIO pio_get_instance(uint instance) {
+    static pio_hw_t hw[3];
+    return (&hw[instance % 3]);
+}
+
+#define pio0 (pio_get_instance(0))
+#define pio1 (pio_get_instance(1))
+#define pio2 (pio_get_instance(2))
+
+static inline bool pio_sm_is_rx_fifo_empty(PIO pio, uint sm) {
+    return (true);
+}
+
+static inline uint32_t pio_sm_get(PIO pio, uint sm) {
+    return (0);
+}
+
+#endif // _HOST_SDK_HARDWARE_PIO_H_
@@ -0,0 +1,33 @@
+/**
+ * Host stand-in for the Pico SDK's `hardware/spi.h` (see `pico.h`).
+ *
+ * There is no SPI on the host. The display's SPI operations are stood in for
+ * by the tests, so only the types are needed.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_HARDWARE_SPI_H_
+#define _HOST_SDK_HARDWARE_SPI_H_
+
+#include "pico.h"
+
+typedef struct spi_inst spi_inst_t;
+
+typedef struct {
+    volatile uint32_t dr;
+} spi_hw_t;
+
+#define spi0 ((spi_inst_t*)0)
+#define spi1 ((spi_inst_t*)1)
+
+static inline spi_hw_t* spi_get_hw(spi_inst_t* spi) {
+    static spi_hw_t hw[2];
+    return (&hw[(uintptr_t)spi & 1]);
+}
+
+static inline uint spi_get_dreq(spi_inst_t* spi, bool is_tx) {
+    return ((uint)(((uintptr_t)spi & 1) * 2) + (is_tx ? 0 : 1));
+}
+
+#endif // _HOST_SDK_HARDWARE_SPI_H_
@@ -0,0 +1,23 @@
+/**
+ * Host stand-in for the Pico SDK's `hardware/sync.h` (see `pico.h`).
+ *
+ * The simulated alarms only run between the test's message handlers, never in
+ * the middle of one, so there is nothing to disable.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_HARDWARE_SYNC_H_
+#define _HOST_SDK_HARDWARE_SYNC_H_
+
+#include "pico.h"
+
+static inline uint32_t save_and_disable_interrupts(void) {
+    return (0);
+}
+
+static inline void restore_interrupts(uint32_t status) {
+    (void)status;
+}
+
+#endif // _HOST_SDK_HARDWARE_SYNC_H_
@@ -0,0 +1,31 @@
+/**
+ * Host stand-in for the Pico SDK's `hardware/uart.h` (see `pico.h`).
+ *
+ * There is no UART on the host. The servo bus uses the simulated bus
+ * (`servo_sim`) in its place, so the UARTs never have anything to read.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_HARDWARE_UART_H_
+#define _HOST_SDK_HARDWARE_UART_H_
+
+#include "pico.h"
+
+typedef struct uart_inst uart_inst_t;
+
+#define uart0 ((uart_inst_t*)0x40070000)
+#define uart1 ((uart_inst_t*)0x40078000)
+
+#define UART0_IRQ 33
+#define UART1_IRQ 34
+
+static inline bool uart_is_readable(uart_inst_t* uart) {
+    return (false);
+}
+
+static inline char uart_getc(uart_inst_t* uart) {
+    return (0);
+}
+
+#endif // _HOST_SDK_HARDWARE_UART_H_
@@ -0,0 +1,22 @@
+/**
+ * Host stand-in for the Pico SDK's `pico.h`.
+ *
+ * The host tests build parts of the controller code that include the SDK
+ * headers (through `system_defs.h`) but don't use the hardware. These headers
+ * give them the types and the few declarations they need.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_PICO_H_
+#define _HOST_SDK_PICO_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define tight_loop_contents() ((void)0)
+
+#endif // _HOST_SDK_PICO_H_
@@ -0,0 +1,17 @@
+/**
+ * Host stand-in for the Pico SDK's `pico/stdlib.h` (see `pico.h`).
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_PICO_STDLIB_H_
+#define _HOST_SDK_PICO_STDLIB_H_
+
+#include "pico.h"
+#include "pico/time.h"
+
+static inline void sleep_ms(uint32_t ms) {
+    (void)ms;   // The emulated controller is ready immediately
+}
+
+#endif // _HOST_SDK_PICO_STDLIB_H_
@@ -0,0 +1,25 @@
+/**
+ * Host stand-in for the Pico SDK's `pico/time.h` (see `pico.h`).
+ *
+ * The alarms and the busy wait run on the simulated clock of the test's
+ * message loop (`host_cmt.c`).
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#ifndef _HOST_SDK_PICO_TIME_H_
+#define _HOST_SDK_PICO_TIME_H_
+
+#include "pico.h"
+
+typedef int32_t alarm_id_t;
+
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+extern alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past);
+
+extern bool cancel_alarm(alarm_id_t alarm_id);
+
+extern void busy_wait_us(uint64_t delay_us);
+
+#endif // _HOST_SDK_PICO_TIME_H_
@@ -0,0 +1,437 @@
+/**
+ * Host tests for the ILI display driver, run against the controller emulator.
+ *
+ * `ili_lcd_spi.c` sends its command stream through a stand-in for the SPI
+ * operations (`spi_display_host.c`) to the emulator (`ili_emu.c`). Each scene
+ * draws with the driver's functions and keeps what the screen should show. The
+ * emulated screen is then checked against it:
+ *  - pixel for pixel, and by its hash (`ili_emu_screen_hash`)
+ *  - by its PPM snapshot (also written to `ili<controller>_<scene>.ppm`)
+ *  - by the SPI bytes the scene took (the window commands and the pixel data)
+ *
+ * It is built once for each controller (`DISP_ILI_EMU` 9341 and 9488), which
+ * covers both pixel formats (RGB565 and RGB666).
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "display/display_rgb18/display_rgb18.h"
+#include "display/display_rgb18/ili_emu.h"
+#include "display/display_rgb18/ili_lcd_spi.h"
+#include "gfx/gfx.h"
+#include "gfx/gfx_ref.h"
+#include "spi_ops.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILL_RECTS 100
+
+static int _fails = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { fprintf(stderr, __VA_ARGS__); _fails++; } } while (0)
+
+static uint16_t _w;
+static uint16_t _h;
+static uint8_t _pb;             // Pixel bytes
+static rgb18_t* _want;          // The screen as it should be shown
+static uint64_t _want_bytes;    // The SPI bytes the scene should take
+static uint64_t _bytes0;
+// The driver only sends the column/page addresses that changed.
+static int _win_x1 = -1, _win_x2 = -1, _win_y1 = -1, _win_y2 = -1;
+static uint32_t _x = 0x2545F491;
+
+static uint32_t _rand(uint32_t n) {
+    _x ^= _x << 13;
+    _x ^= _x >> 17;
+    _x ^= _x << 5;
+    return (_x % n);
+}
+
+/*
+ * The color the controller keeps for a color sent in the current format.
+ */
+static rgb18_t _stored(rgb18_t rgb) {
+    if (gfxd_pixel_format() == GFXD_PIXFMT_RGB565) {
+        // 5 bit red and blue are extended to 6 bits with their top bit.
+        uint8_t r5 = rgb.r >> 3;
+        uint8_t b5 = rgb.b >> 3;
+        return ((rgb18_t){ ((r5 << 1) | (r5 >> 4)) << 2, rgb.g & 0xFC, ((b5 << 1) | (b5 >> 4)) << 2 });
+    }
+    return ((rgb18_t){ rgb.r & 0xFC, rgb.g & 0xFC, rgb.b & 0xFC });
+}
+
+static rgb18_t _rand_rgb(void) {
+    uint32_t v = _rand(1u << 24);
+    return ((rgb18_t){ (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16) });
+}
+
+static void _want_put(int x, int y, rgb18_t rgb) {
+    _want[(y * _w) + x] = _stored(rgb);
+}
+
+static void _want_fill(int x, int y, int w, int h, rgb18_t rgb) {
+    for (int r = y; r < y + h; r++) {
+        for (int c = x; c < x + w; c++) {
+            _want_put(c, r, rgb);
+        }
+    }
+}
+
+/*
+ * The bytes for setting a window and starting to write to it.
+ */
+static uint64_t _window_bytes(int x, int y, int w, int h) {
+    uint64_t bytes = 1;             // RAMWR
+    if (x != _win_x1 || (x + w - 1) != _win_x2) {
+        bytes += 1 + 4;             // CASET, start and end
+        _win_x1 = x;
+        _win_x2 = x + w - 1;
+    }
+    if (y != _win_y1 || (y + h - 1) != _win_y2) {
+        bytes += 1 + 4;             // PASET, start and end
+        _win_y1 = y;
+        _win_y2 = y + h - 1;
+    }
+    return (bytes);
+}
+
+static void _scene_begin(void) {
+    _bytes0 = spi_display_bytes();
+    _want_bytes = 0;
+    ili_emu_stats_clear();
+}
+
+static uint32_t _hash(const rgb18_t* screen) {
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < _w * _h; i++) {
+        const uint8_t px[3] = { screen[i].r, screen[i].g, screen[i].b };
+        for (int b = 0; b < 3; b++) {
+            h = (h ^ px[b]) * 16777619u;
+        }
+    }
+    return (h);
+}
+
+typedef struct _ppm_buf_ {
+    uint8_t* data;
+    size_t len;
+    size_t size;
+} ppm_buf_t;
+
+static bool _ppm_write(void* ctx, const uint8_t* data, size_t len) {
+    ppm_buf_t* buf = ctx;
+    if (buf->len + len > buf->size) {
+        return (false);
+    }
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return (true);
+}
+
+/*
+ * Check the emulated screen against what it should be, and the SPI bytes
+ * (unless `bytes_check` is false).
+ */
+static void _scene_check(const char* scene, const rgb18_t* want, bool bytes_check) {
+    int bad = 0;
+    for (int y = 0; y < _h; y++) {
+        for (int x = 0; x < _w; x++) {
+            rgb18_t got;
+            ili_emu_pixel_get(x, y, &got);
+            rgb18_t w = want[(y * _w) + x];
+            if (got.r != w.r || got.g != w.g || got.b != w.b) {
+                if (bad++ == 0) {
+                    fprintf(stderr, "ILI%d %s: pixel %d,%d is %02X%02X%02X (expected %02X%02X%02X)\n", DISP_ILI_EMU, scene,
+                        x, y, got.r, got.g, got.b, w.r, w.g, w.b);
+                }
+            }
+        }
+    }
+    CHECK(bad == 0, "ILI%d %s: %d pixels are wrong\n", DISP_ILI_EMU, scene, bad);
+    uint32_t hash = ili_emu_screen_hash();
+    CHECK(hash == _hash(want), "ILI%d %s: screen hash %08X (expected %08X)\n", DISP_ILI_EMU, scene, hash, _hash(want));
+
+    // The snapshot has the header, then the pixels as they are shown.
+    char hdr[32];
+    int hdr_len = snprintf(hdr, sizeof(hdr), "P6\n%u %u\n255\n", _w, _h);
+    ppm_buf_t ppm = { NULL, 0, (size_t)hdr_len + ((size_t)_w * _h * 3) };
+    ppm.data = malloc(ppm.size);
+    bool ok = (ppm.data != NULL && ili_emu_snapshot_ppm(_ppm_write, &ppm) && ppm.len == ppm.size);
+    CHECK(ok, "ILI%d %s: snapshot not written\n", DISP_ILI_EMU, scene);
+    if (ok) {
+        CHECK(memcmp(ppm.data, hdr, hdr_len) == 0, "ILI%d %s: snapshot header is wrong\n", DISP_ILI_EMU, scene);
+        const uint8_t* px = ppm.data + hdr_len;
+        for (int i = 0; i < _w * _h; i++, px += 3) {
+            if (px[0] != want[i].r || px[1] != want[i].g || px[2] != want[i].b) {
+                CHECK(false, "ILI%d %s: snapshot pixel %d,%d is wrong\n", DISP_ILI_EMU, scene, i % _w, i / _w);
+                break;
+            }
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "ili%d_%s.ppm", DISP_ILI_EMU, scene);
+        FILE* f = fopen(name, "wb");
+        if (f) {
+            fwrite(ppm.data, 1, ppm.len, f);
+            fclose(f);
+        }
+    }
+    free(ppm.data);
+
+    ili_emu_stats_t stats;
+    ili_emu_stats(&stats);
+    uint64_t bytes = spi_display_bytes() - _bytes0;
+    if (bytes_check) {
+        CHECK(bytes == _want_bytes, "ILI%d %s: %llu SPI bytes (expected %llu)\n", DISP_ILI_EMU, scene,
+            (unsigned long long)bytes, (unsigned long long)_want_bytes);
+    }
+    printf("ILI%d %-8s %08X %9llu SPI bytes, %6u commands (%u CASET, %u PASET, %u RAMWR), %llu pixels\n",
+        DISP_ILI_EMU, scene, hash, (unsigned long long)bytes, stats.commands, stats.cmd_cnt[ILI_CASET],
+        stats.cmd_cnt[ILI_PASET], stats.cmd_cnt[ILI_RAMWR], (unsigned long long)stats.pixels);
+}
+
+// ############################################################################
+// Scenes
+// ############################################################################
+//
+
+static void _init(void) {
+    ili_controller_type ct = ili_module_init();
+    CHECK(ct == DISP_ILI_EMU, "ILI%d: init found controller %d\n", DISP_ILI_EMU, ct);
+    _w = gfxd_screen_width();
+    _h = gfxd_screen_height();
+    _pb = gfxd_pixel_bytes();
+    if (DISP_ILI_EMU == ILI_CONTROLLER_9341) {
+        CHECK(_w == 240 && _h == 320 && _pb == 2, "ILI9341: %ux%u, %u bytes a pixel\n", _w, _h, _pb);
+    }
+    else {
+        CHECK(_w == 320 && _h == 480 && _pb == 3, "ILI9488: %ux%u, %u bytes a pixel\n", _w, _h, _pb);
+    }
+    // The registers the init data set, read back.
+    ili_disp_info_t* info = ili_disp_info();
+    CHECK(info->madctl == 0x48, "ILI%d: MADCTL %02X\n", DISP_ILI_EMU, info->madctl);
+    CHECK(info->pixelfmt == (uint8_t)gfxd_pixel_format(), "ILI%d: pixel format %02X\n", DISP_ILI_EMU, info->pixelfmt);
+    CHECK((info->pwr_mode & 0x14) == 0x14, "ILI%d: power mode %02X (not awake and on)\n", DISP_ILI_EMU, info->pwr_mode);
+    _want = calloc((size_t)_w * _h, sizeof(rgb18_t));
+}
+
+static void _clear(void) {
+    _scene_begin();
+    rgb18_t rgb = { 0x20, 0x40, 0x80 };
+    gfxd_screen_clr(rgb, true);
+    _want_fill(0, 0, _w, _h, rgb);
+    _want_bytes += _window_bytes(0, 0, _w, _h) + ((uint64_t)_w * _h * _pb);
+    _scene_check("clear", _want, true);
+}
+
+static void _fills(void) {
+    _scene_begin();
+    for (int i = 0; i < FILL_RECTS; i++) {
+        int x = _rand(_w);
+        int y = _rand(_h);
+        int w = 1 + _rand(_w - x);
+        int h = 1 + _rand(_h - y);
+        if (i & 1) {
+            w = 1 + _rand(8);   // Some narrow ones (short runs of pixels)
+            w = (x + w > _w ? _w - x : w);
+        }
+        rgb18_t rgb = _rand_rgb();
+        gfxd_area_fill(x, y, w, h, rgb);
+        _want_fill(x, y, w, h, rgb);
+        _want_bytes += _window_bytes(x, y, w, h) + ((uint64_t)w * h * _pb);
+    }
+    _scene_check("fills", _want, true);
+}
+
+/*
+ * Paint areas from pixel data (every pixel a different color).
+ */
+static void _paint(void) {
+    _scene_begin();
+    uint8_t* data = malloc((size_t)_w * _h * _pb);
+    for (int i = 0; i < 8; i++) {
+        int w = 1 + _rand(_w / 2);
+        int h = 1 + _rand(_h / 2);
+        int x = _rand(_w - w + 1);
+        int y = _rand(_h - h + 1);
+        uint8_t* p = data;
+        for (int r = 0; r < h; r++) {
+            for (int c = 0; c < w; c++) {
+                rgb18_t rgb = { (uint8_t)(c * 4), (uint8_t)(r * 4), (uint8_t)((c + r + i * 32) * 2) };
+                p = gfxd_pixel_put(p, gfxd_pixel_from_rgb18(rgb), _pb);
+                _want_put(x + c, y + r, rgb);
+            }
+        }
+        gfxd_area_paint(x, y, w, h, data);
+        _want_bytes += _window_bytes(x, y, w, h) + ((uint64_t)w * h * _pb);
+    }
+    // A full line
+    uint16_t line = _rand(_h);
+    uint8_t* p = data;
+    for (int c = 0; c < _w; c++) {
+        rgb18_t rgb = { 0xFC, (uint8_t)c, 0x00 };
+        p = gfxd_pixel_put(p, gfxd_pixel_from_rgb18(rgb), _pb);
+        _want_put(c, line, rgb);
+    }
+    gfxd_line_paint(line, data);
+    _want_bytes += _window_bytes(0, line, _w, 1) + ((uint64_t)_w * _pb);
+    free(data);
+    _scene_check("paint", _want, true);
+}
+
+/*
+ * Stream pixels into a window in pieces, and into a second window in the same
+ * operation.
+ */
+static void _stream(void) {
+    _scene_begin();
+    int w = 37;
+    int h = 23;
+    uint8_t data[37 * 23 * GFXD_PIXEL_BYTES_MAX];
+    uint8_t* p = data;
+    for (int i = 0; i < w * h; i++) {
+        rgb18_t rgb = _rand_rgb();
+        p = gfxd_pixel_put(p, gfxd_pixel_from_rgb18(rgb), _pb);
+        _want_put(10 + (i % w), 20 + (i / w), rgb);
+        _want_put(_w - w + (i % w), _h - h + (i / w), rgb);
+    }
+    gfxd_area_stream_begin(10, 20, w, h);
+    _want_bytes += _window_bytes(10, 20, w, h);
+    gfxd_area_stream(data, 100);
+    gfxd_area_stream(data + (100 * _pb), (w * h) - 100);
+    gfxd_area_stream_window(_w - w, _h - h, w, h);
+    _want_bytes += _window_bytes(_w - w, _h - h, w, h);
+    gfxd_area_stream(data, w * h);
+    gfxd_area_stream_end();
+    _want_bytes += (uint64_t)w * h * _pb * 2;
+    _scene_check("stream", _want, true);
+}
+
+/*
+ * Draw with the graphics functions (through the driver's area fill), checked
+ * against the reference rasterizer.
+ */
+static void _gfx(void) {
+    _scene_begin();
+    uint8_t* px = calloc((size_t)_w * _h, 1);
+    gfx_ref_canvas_t cv = { _w, _h, px, { { 0, 0 }, { _w - 1, _h - 1 } } };
+    gfx_clip_clear();
+    for (int i = 0; i < 24; i++) {
+        uint8_t v = (uint8_t)(0x10 + (i * 9));  // Grey, so the canvas byte is the color
+        gfx_color_t color = GFX_RGB(v, v, v);
+        gfx_point a = { (int)_rand(_w + 40) - 20, (int)_rand(_h + 40) - 20 };
+        gfx_point b = { (int)_rand(_w + 40) - 20, (int)_rand(_h + 40) - 20 };
+        gfx_rect rc = { a, b };
+        int r = 2 + _rand(60);
+        switch (i % 4) {
+            case 0:
+                gfx_circle_fill(&a, r, color);
+                gfx_ref_circle_fill(&cv, &a, r, color);
+                break;
+            case 1:
+                gfx_circle_draw(&a, r, color);
+                gfx_ref_circle_draw(&cv, &a, r, color);
+                break;
+            case 2:
+                gfx_line(&a, &b, color);
+                gfx_ref_line(&cv, &a, &b, color);
+                break;
+            default:
+                gfx_rect_draw(&rc, color);
+                gfx_ref_rect_draw(&cv, &rc, color);
+                break;
+        }
+    }
+    for (int i = 0; i < _w * _h; i++) {
+        if (px[i]) {
+            _want_put(i % _w, i / _w, (rgb18_t){ px[i], px[i], px[i] });
+        }
+    }
+    free(px);
+    // Many small fills, so the bytes are only shown. Leave a known window.
+    gfxd_window_set_fullscreen();
+    _win_x1 = _win_y1 = 0;
+    _win_x2 = _w - 1;
+    _win_y2 = _h - 1;
+    _scene_check("gfx", _want, false);
+}
+
+/*
+ * The driver's color bars: a clear to black, then red, green and blue ramps
+ * (64 levels, 2 pixels each) 4 rows high.
+ */
+static void _colors(void) {
+    _scene_begin();
+    ili_colors_show();
+    _want_fill(0, 0, _w, _h, RGB18_BLACK);
+    _want_bytes += _window_bytes(0, 0, _w, _h) + ((uint64_t)_w * _h * _pb);
+    for (int bar = 0; bar < 3; bar++) {
+        for (int y = bar * 4; y < (bar * 4) + 4; y++) {
+            for (int x = 0; x < 128; x++) {
+                uint8_t level = (uint8_t)((x / 2) << 2);
+                rgb18_t rgb = { (bar == 0 ? level : 0), (bar == 1 ? level : 0), (bar == 2 ? level : 0) };
+                _want_put(x, y, rgb);
+            }
+        }
+        _want_bytes += _window_bytes(0, bar * 4, 128, 4) + (128 * 4 * _pb);
+    }
+    _scene_check("colors", _want, true);
+}
+
+/*
+ * Scroll the area between fixed top and bottom lines, and leave the scroll.
+ */
+static void _scroll(void) {
+    int top = 16;
+    int bottom = 32;
+    int vsa = _h - top - bottom;
+    rgb18_t* shown = malloc((size_t)_w * _h * sizeof(rgb18_t));
+    // Rows that are all different, so a wrong row shows.
+    for (int y = 0; y < _h; y++) {
+        rgb18_t rgb = { (uint8_t)(y * 4), (uint8_t)((y >> 4) << 2), 0x80 };
+        gfxd_area_fill(0, y, _w, 1, rgb);
+        _want_fill(0, y, _w, 1, rgb);
+        _window_bytes(0, y, _w, 1);
+    }
+    _scene_begin();
+    gfxd_scroll_set_area(top, bottom);
+    _want_bytes += (1 + 6) + (1 + 2);       // VSCRDEF and VSCRSADD
+    for (int start = top; start < top + vsa; start += 37) {
+        gfxd_scroll_set_start(start);
+        _want_bytes += 1 + 2;
+    }
+    int start = top + ((vsa - 1) / 37) * 37;
+    for (int y = 0; y < _h; y++) {
+        int row = y;
+        if (y >= top && y < top + vsa) {
+            row = start + (y - top);
+            row = (row >= top + vsa ? row - vsa : row);
+        }
+        memcpy(shown + (y * _w), _want + (row * _w), _w * sizeof(rgb18_t));
+    }
+    _scene_check("scroll", shown, true);
+    _scene_begin();
+    gfxd_scroll_exit();
+    _want_bytes += 3 + _window_bytes(0, 0, _w, _h);    // DISPOFF, NORON, DISPON, window
+    _scene_check("noscroll", _want, true);
+    free(shown);
+}
+
+int main(int argc, char** argv) {
+    if (!ili_emu_init(DISP_ILI_EMU)) {
+        fprintf(stderr, "ILI%d: no memory for the frame memory\n", DISP_ILI_EMU);
+        return (EXIT_FAILURE);
+    }
+    _init();
+    _clear();
+    _fills();
+    _paint();
+    _stream();
+    _gfx();
+    _colors();
+    _scroll();
+    printf("ILI%d: %d failures\n", DISP_ILI_EMU, _fails);
+
+    return (_fails == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
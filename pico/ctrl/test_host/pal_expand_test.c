@@ -0,0 +1,167 @@
+/**
+ * Host tests for the palette expansion model.
+ *
+ * Checks the palette entries (the SPI frames) made for known RGB565 and
+ * RGB666 pixels, the entry addresses the PIO program builds, and the frames
+ * the model expands packed pixels into, for both formats, for pixel counts
+ * that don't fill the last word, with the padding in it set. The model
+ * doesn't use the SDK, so it builds and runs on the development machine.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "display/display_rgb18/pal_expand_model.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIXELS_MAX 40               // Most pixels in a run (5 words)
+#define SENTINEL 0xDEAD             // In the frames past the last one
+
+static int _fails = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { fprintf(stderr, __VA_ARGS__); _fails++; } } while (0)
+
+typedef struct _known_entry_ {
+    const char* name;
+    uint8_t px[3];                  // The pixel's bytes, as sent
+    uint16_t frames[PAL_EXPAND_ENTRY_FRAMES];
+} known_entry_t;
+
+// RGB666: 6 bits of each color in the top of a byte, sent as two 12 bit frames.
+static const known_entry_t _rgb666[] = {
+    { "black",   { 0x00, 0x00, 0x00 }, { 0x000, 0x000 } },
+    { "red",     { 0xFC, 0x00, 0x00 }, { 0xFC0, 0x000 } },
+    { "green",   { 0x00, 0xFC, 0x00 }, { 0x00F, 0xC00 } },
+    { "blue",    { 0x00, 0x00, 0xFC }, { 0x000, 0x0FC } },
+    { "white",   { 0xFC, 0xFC, 0xFC }, { 0xFCF, 0xCFC } },
+    { "orange",  { 0xFC, 0xA4, 0x00 }, { 0xFCA, 0x400 } },
+    { "grey",    { 0x80, 0x80, 0x80 }, { 0x808, 0x080 } },
+};
+
+// RGB565: One 16 bit frame (high byte first), in both halves of the entry.
+static const known_entry_t _rgb565[] = {
+    { "black",   { 0x00, 0x00 }, { 0x0000, 0x0000 } },
+    { "red",     { 0xF8, 0x00 }, { 0xF800, 0xF800 } },
+    { "green",   { 0x07, 0xE0 }, { 0x07E0, 0x07E0 } },
+    { "blue",    { 0x00, 0x1F }, { 0x001F, 0x001F } },
+    { "white",   { 0xFF, 0xFF }, { 0xFFFF, 0xFFFF } },
+    { "orange",  { 0xFD, 0x20 }, { 0xFD20, 0xFD20 } },
+};
+
+static uint32_t _x = 0x2545F491;
+
+static uint32_t _rand(void) {
+    _x ^= _x << 13;
+    _x ^= _x >> 17;
+    _x ^= _x << 5;
+    return (_x);
+}
+
+static void _known_entries(const known_entry_t* known, int n, uint8_t pixel_bytes) {
+    for (int i = 0; i < n; i++) {
+        uint16_t entry[PAL_EXPAND_ENTRY_FRAMES];
+        pal_expand_model_entry(known[i].px, pixel_bytes, entry);
+        CHECK(entry[0] == known[i].frames[0] && entry[1] == known[i].frames[1],
+            "RGB%s %s: frames %03X %03X (expected %03X %03X)\n", (pixel_bytes == 3 ? "666" : "565"), known[i].name,
+            entry[0], entry[1], known[i].frames[0], known[i].frames[1]);
+    }
+}
+
+/*
+ * The two 12 bit frames of an RGB666 entry are the 24 bits of the pixel, in
+ * order. A 16 bit frame is the 2 bytes, high first.
+ */
+static void _entry_bits(void) {
+    for (int n = 0; n < 10000; n++) {
+        uint32_t r = _rand();
+        uint8_t px[3] = { (uint8_t)r, (uint8_t)(r >> 8), (uint8_t)(r >> 16) };
+        uint16_t entry[PAL_EXPAND_ENTRY_FRAMES];
+        pal_expand_model_entry(px, 3, entry);
+        uint32_t bits = ((uint32_t)px[0] << 16) | ((uint32_t)px[1] << 8) | px[2];
+        CHECK(entry[0] < 0x1000 && entry[1] < 0x1000 && (((uint32_t)entry[0] << 12) | entry[1]) == bits,
+            "RGB666 %06X: frames %03X %03X\n", bits, entry[0], entry[1]);
+        pal_expand_model_entry(px, 2, entry);
+        CHECK(entry[0] == ((px[0] << 8) | px[1]) && entry[1] == entry[0],
+            "RGB565 %02X%02X: frames %04X %04X\n", px[0], px[1], entry[0], entry[1]);
+    }
+}
+
+static void _addresses(void) {
+    static const uint32_t palettes[] = { 0x00000000, 0x20001040, 0x2007FFC0, 0xFFFFFFC0 };
+    for (size_t p = 0; p < sizeof(palettes) / sizeof(palettes[0]); p++) {
+        for (uint32_t i = 0; i < 32; i++) {
+            uint32_t addr = pal_expand_model_addr(palettes[p], i);
+            uint32_t want = palettes[p] | ((i & 0x0F) << 2);
+            CHECK(addr == want, "Address of %u in palette %08X: %08X (expected %08X)\n", i, palettes[p], addr, want);
+        }
+    }
+}
+
+/*
+ * Expand runs of each length, with random indexes and padding, and check the
+ * frames against the entries for the indexes.
+ */
+static void _expand(const known_entry_t* known, int n, uint8_t pixel_bytes) {
+    uint16_t palette[PAL_EXPAND_COLORS][PAL_EXPAND_ENTRY_FRAMES];
+    for (int i = 0; i < PAL_EXPAND_COLORS; i++) {
+        // The known colors, then some that are all different.
+        uint8_t px[3] = { (uint8_t)(i * 16 + 1), (uint8_t)(i * 8 + 2), (uint8_t)(i * 4 + 3) };
+        pal_expand_model_entry((i < n ? known[i].px : px), pixel_bytes, palette[i]);
+    }
+    uint32_t fpp = (pixel_bytes == 3 ? 2 : 1);
+    for (uint32_t pixels = 1; pixels <= PIXELS_MAX; pixels++) {
+        uint32_t packed[(PIXELS_MAX + 7) / 8];
+        uint8_t index[PIXELS_MAX];
+        for (uint32_t w = 0; w < (pixels + 7) / 8; w++) {
+            packed[w] = _rand() | 0xF0000000;   // The last pixel of a word (or padding) is 15
+        }
+        for (uint32_t i = 0; i < pixels; i++) {
+            index[i] = (packed[i / 8] >> ((i % 8) * 4)) & 0x0F;
+        }
+        uint16_t frames[(PIXELS_MAX * 2) + 1];
+        for (size_t f = 0; f < sizeof(frames) / sizeof(frames[0]); f++) {
+            frames[f] = SENTINEL;
+        }
+        uint32_t got = pal_expand_model(palette, fpp, packed, pixels, frames);
+        CHECK(got == pixels * fpp, "RGB%s %u pixels: %u frames\n", (pixel_bytes == 3 ? "666" : "565"), pixels, got);
+        for (uint32_t i = 0; i < pixels; i++) {
+            for (uint32_t f = 0; f < fpp; f++) {
+                CHECK(frames[(i * fpp) + f] == palette[index[i]][f], "RGB%s %u pixels: pixel %u frame %u is %04X (expected %04X)\n",
+                    (pixel_bytes == 3 ? "666" : "565"), pixels, i, f, frames[(i * fpp) + f], palette[index[i]][f]);
+            }
+        }
+        // The padding isn't expanded.
+        CHECK(frames[pixels * fpp] == SENTINEL, "RGB%s %u pixels: frame written past the end\n",
+            (pixel_bytes == 3 ? "666" : "565"), pixels);
+    }
+    // A known run: red, green, blue, white (indexes 1-4) and the start of the next word.
+    uint32_t packed[2] = { 0x00004321, 0x00000001 };
+    uint16_t frames[18];
+    uint32_t got = pal_expand_model(palette, fpp, packed, 9, frames);
+    for (uint32_t i = 0; i < 4; i++) {
+        for (uint32_t f = 0; f < fpp; f++) {
+            CHECK(frames[(i * fpp) + f] == known[i + 1].frames[f], "RGB%s known run: pixel %u frame %u is %04X (expected %04X)\n",
+                (pixel_bytes == 3 ? "666" : "565"), i, f, frames[(i * fpp) + f], known[i + 1].frames[f]);
+        }
+    }
+    CHECK(got == 9 * fpp && frames[8 * fpp] == known[1].frames[0], "RGB%s known run: the 9th pixel isn't red\n",
+        (pixel_bytes == 3 ? "666" : "565"));
+}
+
+int main(int argc, char** argv) {
+    int n666 = (int)(sizeof(_rgb666) / sizeof(_rgb666[0]));
+    int n565 = (int)(sizeof(_rgb565) / sizeof(_rgb565[0]));
+
+    _known_entries(_rgb666, n666, 3);
+    _known_entries(_rgb565, n565, 2);
+    _entry_bits();
+    _addresses();
+    _expand(_rgb666, n666, 3);
+    _expand(_rgb565, n565, 2);
+    printf("Palette expansion: %d RGB666 and %d RGB565 entries, runs of 1-%d pixels, %d failures\n",
+        n666, n565, PIXELS_MAX, _fails);
+
+    return (_fails == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
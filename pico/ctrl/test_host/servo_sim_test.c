@@ -0,0 +1,373 @@
+/**
+ * Host tests for the servo bus (`servo`) and servo group (`servos`) layers,
+ * on the simulated servo bus (`servo_sim`).
+ *
+ * The servo code is built with SERVO_BUS_SIM and two buses, the same as the
+ * firmware with the simulated bus, and runs on the simulated clock and message
+ * loop of `host_cmt`. Checks the adaptive reply timeout, the offline marking
+ * and probing of servos that don't reply, the throughput of one bus and of
+ * the two buses together, and the start-up and status polling of the rover's
+ * servos.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "host_cmt.h"
+
+#include "servo/servo.h"
+#include "servo/servo_mh.h"
+#include "servo/servo_sim.h"
+#include "servo/servos.h"
+
+#include "board.h"
+#include "system_defs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define READ_WAIT_MAX_US 100000
+
+// The servos added by `servos_module_init` (latency 300µs, jitter 200µs)
+#define DRV_ID_FIRST 10     // 10-15 on bus 0
+#define DIR_ID_FIRST 50     // 50-53 on bus 1
+#define SIM_LATENCY_AVG_US 400
+
+static int _fails;
+
+#define CHECK(cond, ...) do { if (!(cond)) { fprintf(stderr, __VA_ARGS__); _fails++; } } while (0)
+
+static uint32_t _status_rcvd[BS_BROADCAST_ID];
+static uint32_t _read_errors[BS_BROADCAST_ID];
+
+// ############################################################################
+// Message Handlers
+// ############################################################################
+//
+
+static void _handle_read_error(cmt_msg_t* msg) {
+    _read_errors[msg->data.servo_params.servo_id]++;
+}
+
+static void _handle_status_rcvd(cmt_msg_t* msg) {
+    _status_rcvd[msg->data.servo_params.servo_id]++;
+}
+
+static void _handle_housekeeping(cmt_msg_t* msg) {
+    servos_housekeeping();
+}
+
+static const msg_handler_entry_t _read_error_handler_entry = { MSG_SERVO_READ_ERROR, _handle_read_error };
+static const msg_handler_entry_t _status_rcvd_handler_entry = { MSG_SERVO_STATUS_RCVD, _handle_status_rcvd };
+static const msg_handler_entry_t _housekeeping_handler_entry = { MSG_HOUSEKEEPING_RT, _handle_housekeeping };
+
+static const msg_handler_entry_t* _handler_entries[] = {
+    &servo_rxd_handler_entry,
+    &servo_tx_done_handler_entry,
+    &servos_read_error_handler_entry,
+    &servos_status_rcvd_handler_entry,
+    &_read_error_handler_entry,
+    &_status_rcvd_handler_entry,
+    &_housekeeping_handler_entry,
+    NULL
+};
+
+// ############################################################################
+// Internal Functions
+// ############################################################################
+//
+
+static void _servo_init(servo_t* servo, uint8_t bus, uint8_t id) {
+    memset(servo, 0, sizeof(servo_t));
+    servo->id = id;
+    servo->bus = bus;
+}
+
+/*
+ * Run until the reads on a bus are done.
+ */
+static void _reads_wait(uint8_t bus) {
+    uint64_t end = now_us() + READ_WAIT_MAX_US;
+    while (servo_bus_reads_pending(bus)) {
+        if (now_us() >= end) {
+            fprintf(stderr, "Bus %hhu reads didn't finish\n", bus);
+            exit(EXIT_FAILURE);
+        }
+        host_run_us(10);
+    }
+}
+
+/*
+ * Read the position of a servo and wait for the result.
+ *
+ * @return 1 it replied, 0 it didn't, -1 the read wasn't sent
+ */
+static int _read(servo_t* servo, uint32_t* us) {
+    uint32_t replies = _status_rcvd[servo->id];
+    uint64_t start = now_us();
+    if (!servo_position_read(servo)) {
+        return (-1);
+    }
+    _reads_wait(servo->bus);
+    if (us) {
+        *us = (uint32_t)(now_us() - start);
+    }
+    return (_status_rcvd[servo->id] != replies ? 1 : 0);
+}
+
+/*
+ * Keep the bus queues of servos full of position reads for a time.
+ */
+static void _reads_saturate(servo_t* servos, int cnt, uint64_t us) {
+    uint64_t end = now_us() + us;
+    while (now_us() < end) {
+        for (int i = 0; i < cnt; i++) {
+            servo_position_read(&servos[i]);  // Not sent if one is already queued
+        }
+        host_run_us(100);
+    }
+    for (int i = 0; i < cnt; i++) {
+        _reads_wait(servos[i].bus);
+    }
+}
+
+static bool _tx_released(void) {
+    return (gpio_get(SERVO_CTRL_TX_EN_GPIO) == SERVO_CTRL_TX_DIS
+        && gpio_get(SERVO_B1_TX_EN_GPIO) == SERVO_CTRL_TX_DIS);
+}
+
+// ############################################################################
+// Tests
+// ############################################################################
+//
+
+/*
+ * The reply timeout follows each servo's latency, from the 20ms start value,
+ * down to the floor for a quick servo, and backs off when a reply is missed.
+ */
+static void _adaptive_timeout(void) {
+    servo_t fast, slow, slower;
+    _servo_init(&fast, 0, DRV_ID_FIRST);
+    _servo_init(&slow, 0, 20);
+    _servo_init(&slower, 0, 22);
+    servo_sim_servo_add(0, 20, 2500, 0);
+    servo_sim_servo_add(0, 22, 8000, 0);
+
+    CHECK(servo_reply_timeout_ms(&slow) == 20, "Timeout before any replies is %hu (20 expected)\n", servo_reply_timeout_ms(&slow));
+    int ok = 0;
+    for (int i = 0; i < 20; i++) {
+        ok += (_read(&fast, NULL) == 1);
+        ok += (_read(&slow, NULL) == 1);
+        ok += (_read(&slower, NULL) == 1);
+    }
+    CHECK(ok == 60, "%d of 60 reads replied\n", ok);
+    CHECK(servo_position(&slow) == 500, "Slow servo position %hd (500 expected)\n", servo_position(&slow));
+    // The latency is to the end of the reply (8 bytes after the servo's latency).
+    uint32_t lat = servo_reply_latency_us(&slow);
+    CHECK(lat >= 3000 && lat <= 3300, "Slow servo latency %uus (3000-3300 expected)\n", lat);
+    uint16_t to_fast = servo_reply_timeout_ms(&fast);
+    uint16_t to_slow = servo_reply_timeout_ms(&slow);
+    uint16_t to_slower = servo_reply_timeout_ms(&slower);
+    CHECK(to_fast == 3, "Fast servo timeout %hums (floor of 3 expected)\n", to_fast);
+    CHECK(to_slow >= 4 && to_slow <= 6, "Slow servo timeout %hums (4-6 expected)\n", to_slow);
+    CHECK(to_slower >= 9 && to_slower <= 11, "Slower servo timeout %hums (9-11 expected)\n", to_slower);
+
+    // A miss costs the adaptive timeout (not the 20ms), and doubles it.
+    servo_bus_stats_t before, after;
+    servo_bus_stats(0, &before);
+    servo_sim_servo_present(20, false);
+    uint32_t us;
+    int r = _read(&slow, &us);
+    servo_bus_stats(0, &after);
+    CHECK(r == 0, "Read of an unplugged servo didn't fail\n");
+    CHECK(us <= (to_slow + 2) * 1000u, "Missed reply took %uus (timeout %hums)\n", us, to_slow);
+    CHECK(after.timeouts - before.timeouts == 1 && after.timeout_wait_ms - before.timeout_wait_ms == to_slow,
+        "Miss counted %u timeouts, %ums waiting (1, %hums expected)\n",
+        after.timeouts - before.timeouts, after.timeout_wait_ms - before.timeout_wait_ms, to_slow);
+    CHECK(servo_reply_timeout_ms(&slow) == to_slow * 2, "Timeout after a miss %hums (%dms expected)\n",
+        servo_reply_timeout_ms(&slow), to_slow * 2);
+    CHECK(servo_online(&slow), "Servo offline after one miss\n");
+
+    // When it replies again the timeout comes back down.
+    servo_sim_servo_present(20, true);
+    CHECK(_read(&slow, NULL) == 1, "Read after plugging back in didn't reply\n");
+    CHECK(servo_reply_timeout_ms(&slow) == to_slow, "Timeout after a reply %hums (%hums expected)\n",
+        servo_reply_timeout_ms(&slow), to_slow);
+    CHECK(_tx_released(), "TX left enabled\n");
+}
+
+/*
+ * A servo that stops replying is marked offline and only probed once a
+ * second, and comes back online when it answers. A servo that doesn't
+ * answer a ping is marked offline right away.
+ */
+static void _offline_probing(void) {
+    servo_t gone, missing;
+    _servo_init(&gone, 0, 21);
+    _servo_init(&missing, 0, 23);
+    servo_sim_servo_add(0, 21, 400, 0);
+    servo_sim_servo_add(0, 23, 400, 0);
+
+    CHECK(_read(&gone, NULL) == 1, "Servo 21 didn't reply\n");
+    servo_sim_servo_present(21, false);
+    for (int i = 0; i < 3; i++) {
+        CHECK(servo_online(&gone), "Servo offline after %d misses\n", i);
+        CHECK(_read(&gone, NULL) == 0, "Read %d of an unplugged servo didn't fail\n", i);
+    }
+    CHECK(!servo_online(&gone), "Servo online after 3 misses\n");
+
+    // Reads are skipped (without using the bus) until the probe time.
+    servo_bus_stats_t before, after;
+    servo_bus_stats(0, &before);
+    servo_sim_stats_t sb, sa;
+    servo_sim_stats(0, &sb);
+    int skipped = 0;
+    for (int i = 0; i < 95; i++) {
+        skipped += (_read(&gone, NULL) < 0);
+        host_run_us(10000);
+    }
+    servo_bus_stats(0, &after);
+    servo_sim_stats(0, &sa);
+    CHECK(skipped == 95 && after.reads_skipped - before.reads_skipped == 95,
+        "%d reads skipped in the first 950ms offline (95 expected)\n", skipped);
+    CHECK(sa.bytes_in == sb.bytes_in, "Offline servo reads used the bus (%u bytes)\n", sa.bytes_in - sb.bytes_in);
+
+    // After a second a read goes out (the probe), fails, and waits another second.
+    host_run_us(60000);
+    CHECK(_read(&gone, NULL) == 0, "Probe of an offline servo wasn't sent\n");
+    CHECK(_read(&gone, NULL) < 0, "Read right after a probe wasn't skipped\n");
+    CHECK(!servo_online(&gone), "Servo online after a failed probe\n");
+
+    // Plugged back in, the next probe finds it.
+    servo_sim_servo_present(21, true);
+    host_run_us(500000);
+    CHECK(_read(&gone, NULL) < 0, "Read half way to the next probe wasn't skipped\n");
+    host_run_us(510000);
+    CHECK(_read(&gone, NULL) == 1, "Probe of a servo that is back didn't reply\n");
+    CHECK(servo_online(&gone), "Servo not back online after replying\n");
+    CHECK(_read(&gone, NULL) == 1, "Read after coming back online didn't reply\n");
+
+    // A ping that isn't answered takes the ping timeout, and marks it offline.
+    servo_sim_servo_present(23, false);
+    uint32_t replies = _status_rcvd[23];
+    uint32_t errors = _read_errors[23];
+    uint64_t start = now_us();
+    CHECK(servo_ping(&missing), "Ping wasn't sent\n");
+    _reads_wait(0);
+    uint32_t us = (uint32_t)(now_us() - start);
+    CHECK(_status_rcvd[23] == replies && _read_errors[23] == errors + 1, "Unanswered ping didn't fail\n");
+    CHECK(us <= 5000, "Unanswered ping took %uus (ping timeout is 3ms)\n", us);
+    CHECK(!servo_online(&missing), "Servo online after an unanswered ping\n");
+    CHECK(_read(&missing, NULL) < 0, "Read after an unanswered ping wasn't skipped\n");
+    CHECK(_tx_released(), "TX left enabled\n");
+}
+
+/*
+ * Reads kept queued for the rover's servos keep a bus busy, and the two buses
+ * run at the same time, so together they do twice what one does.
+ */
+static void _two_bus_throughput(void) {
+    servo_t servos[10];
+    for (int i = 0; i < 6; i++) {
+        _servo_init(&servos[i], 0, DRV_ID_FIRST + i);
+    }
+    for (int i = 0; i < 4; i++) {
+        _servo_init(&servos[6 + i], 1, DIR_ID_FIRST + i);
+    }
+    // The most reads a bus can do: command and reply on the wire, and the latency.
+    uint32_t wire_rate = (uint32_t)(1000000000ull / ((6 + 8) * (uint64_t)SERVO_SIM_BYTE_NS + SIM_LATENCY_AVG_US * 1000ull));
+    servo_bus_stats_t b0, b1, a0, a1;
+    servo_sim_stats_t sim0, sim1;
+
+    // Bus 0 by itself
+    servo_bus_stats(0, &b0);
+    _reads_saturate(servos, 6, 1000000);
+    servo_bus_stats(0, &a0);
+    uint32_t one = a0.replies - b0.replies;
+    CHECK(one >= (wire_rate * 9) / 10 && one <= (wire_rate * 102) / 100, "Bus 0 did %u reads/s (%u possible)\n", one, wire_rate);
+
+    // Both buses
+    servo_sim_stats_clear(0);
+    servo_sim_stats_clear(1);
+    servo_bus_stats(0, &b0);
+    servo_bus_stats(1, &b1);
+    _reads_saturate(servos, 10, 1000000);
+    servo_bus_stats(0, &a0);
+    servo_bus_stats(1, &a1);
+    servo_sim_stats(0, &sim0);
+    servo_sim_stats(1, &sim1);
+    uint32_t both0 = a0.replies - b0.replies;
+    uint32_t both1 = a1.replies - b1.replies;
+    CHECK(both0 >= (one * 98) / 100, "Bus 0 did %u reads/s with bus 1 busy (%u alone)\n", both0, one);
+    CHECK(both0 + both1 >= (one * 19) / 10, "Both buses did %u reads/s (%u for one)\n", both0 + both1, one);
+    CHECK(a0.timeouts == b0.timeouts && a1.timeouts == b1.timeouts, "Timeouts with every servo replying\n");
+    CHECK(sim0.collisions == 0 && sim1.collisions == 0, "%u/%u collisions\n", sim0.collisions, sim1.collisions);
+    CHECK(_tx_released(), "TX left enabled\n");
+    printf("Servo bus throughput: %u reads/s one bus, %u + %u reads/s two buses (%u possible per bus)\n",
+        one, both0, both1, wire_rate);
+}
+
+/*
+ * The rover's servos start up (with one missing), the steering servos are
+ * moved to the middle, and each bus is polled at the poll period.
+ */
+static void _start_and_poll(void) {
+    // Put the left-front steering servo off center, to see the start-up move it.
+    servo_t lf;
+    _servo_init(&lf, 1, DIR_ID_FIRST);
+    servo_move(&lf, 100, 0);
+    _reads_wait(1);
+    host_run_us(2000);
+    CHECK(servo_sim_servo_position(DIR_ID_FIRST) == 100, "Steering servo at %hd (100 expected)\n", servo_sim_servo_position(DIR_ID_FIRST));
+    servo_sim_servo_present(DIR_ID_FIRST + 3, false);
+
+    servos_start();
+    // The move to the middle takes 1 second, so half way it is at 300 less the start-up time.
+    host_run_us(500000);
+    int16_t pos = servo_sim_servo_position(DIR_ID_FIRST);
+    CHECK(pos >= 280 && pos <= 300, "Steering servo at %hd half way through the start-up move (280-300 expected)\n", pos);
+    host_run_us(600000);
+    pos = servo_sim_servo_position(DIR_ID_FIRST);
+    CHECK(pos == 500, "Steering servo at %hd after the start-up move (500 expected)\n", pos);
+
+    // Each bus polls its servos every 50ms. The missing one is only probed.
+    servo_bus_stats_t b0, b1, a0, a1;
+    servo_bus_stats(0, &b0);
+    servo_bus_stats(1, &b1);
+    host_run_us(2000000);
+    servo_bus_stats(0, &a0);
+    servo_bus_stats(1, &a1);
+    uint32_t r0 = (a0.replies - b0.replies) / 2;
+    uint32_t r1 = (a1.replies - b1.replies) / 2;
+    CHECK(r0 >= 114 && r0 <= 120, "Bus 0 polled %u reads/s (6 servos at 20Hz expected)\n", r0);
+    CHECK(r1 >= 57 && r1 <= 60, "Bus 1 polled %u reads/s (3 servos at 20Hz expected)\n", r1);
+    CHECK(a1.timeouts - b1.timeouts <= 2, "Bus 1 had %u timeouts in 2s (probes only expected)\n", a1.timeouts - b1.timeouts);
+    CHECK(a1.reads_skipped > b1.reads_skipped, "Missing servo wasn't skipped\n");
+    CHECK(a0.timeouts == b0.timeouts, "Bus 0 had %u timeouts\n", a0.timeouts - b0.timeouts);
+
+    // The drive servos were put in motor mode.
+    servo_t lf_drive;
+    _servo_init(&lf_drive, 0, DRV_ID_FIRST);
+    uint32_t replies = _status_rcvd[DRV_ID_FIRST];
+    while (!servo_read(&lf_drive, BS_SERVO_OR_MOTOR_MODE_READ)) {
+        host_run_us(100);
+    }
+    while (_status_rcvd[DRV_ID_FIRST] == replies || servo_reply(&lf_drive)->cmd != BS_SERVO_OR_MOTOR_MODE_READ) {
+        host_run_us(100);
+    }
+    CHECK(servo_reply(&lf_drive)->params.mode.mode == BS_MOTOR_MODE, "Drive servo not in motor mode\n");
+    printf("Servo polling: %u + %u reads/s\n", r0, r1);
+}
+
+int main(int argc, char** argv) {
+    host_cmt_init(_handler_entries);
+    servos_module_init();
+
+    _adaptive_timeout();
+    _offline_probing();
+    _two_bus_throughput();
+    _start_and_poll();
+    printf("Servo bus on the simulated bus: %d failures\n", _fails);
+
+    return (_fails == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
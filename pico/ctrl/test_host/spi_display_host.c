@@ -0,0 +1,166 @@
+/**
+ * Host stand-in for the display's SPI operations (and what else
+ * `ili_lcd_spi.c` uses from outside of the display driver).
+ *
+ * The display commands and data go to the controller emulator (`ili_emu`), the
+ * way they do on the device in a `DISP_ILI_EMU` build, and the bytes are
+ * counted like `spi_display_bytes` does. There is no DMA, so the DMA functions
+ * write the data when they are called, and there is no other SPI device, so
+ * pixel data is never interrupted.
+ *
+ * Copyright 2023-25 AESilky
+ * SPDX-License-Identifier: MIT License
+ */
+#include "spi_ops.h"
+
+#include "board.h"
+#include "display/display_rgb18/display_rgb18.h"
+#include "display/display_rgb18/ili_emu.h"
+#include "display/display_rgb18/pal_expand.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static uint64_t _disp_bytes;
+static bool _disp_begun;
+static bool _disp_selected;
+
+static void _check(bool ok, const char* what) {
+    if (!ok) {
+        // The driver used the SPI the way it can't on the device.
+        fprintf(stderr, "SPI stand-in: %s\n", what);
+        exit(EXIT_FAILURE);
+    }
+}
+
+// ############################################################################
+// Display SPI Operations
+// ############################################################################
+//
+
+void spi_display_begin(void) {
+    _check(!_disp_begun, "spi_display_begin while begun");
+    _disp_begun = true;
+}
+
+void spi_display_end(void) {
+    _check(_disp_begun, "spi_display_end without a begin");
+    _check(!_disp_selected, "spi_display_end with the display selected");
+    _disp_begun = false;
+}
+
+void spi_display_select() {
+    _check(_disp_begun, "spi_display_select without a begin");
+    _disp_selected = true;
+    ili_emu_select(true);
+}
+
+void spi_none_select() {
+    _disp_selected = false;
+    ili_emu_select(false);
+}
+
+void spi_display_command_mode(bool cmd) {
+    ili_emu_command_mode(cmd);
+}
+
+uint64_t spi_display_bytes(void) {
+    return (_disp_bytes);
+}
+
+int spi_display_read_buf(uint8_t txval, uint8_t* dst, size_t len) {
+    _check(_disp_selected, "read with the display not selected");
+    return (ili_emu_read(dst, len));
+}
+
+int spi_display_write8_buf(const uint8_t* buf, size_t len) {
+    _check(_disp_selected, "write with the display not selected");
+    _disp_bytes += len;
+    ili_emu_write(buf, len);
+    return ((int)len);
+}
+
+void spi_display_write8_buf_dma(const uint8_t* buf, size_t len) {
+    spi_display_write8_buf(buf, len);
+}
+
+int spi_display_write16(uint16_t data) {
+    return (spi_display_write16_buf(&data, 1));
+}
+
+int spi_display_write16_buf(const uint16_t* buf, size_t len) {
+    _check(_disp_selected, "write with the display not selected");
+    _disp_bytes += (len * sizeof(uint16_t));
+    ili_emu_write_frames(buf, len, 16);
+    return ((int)len);
+}
+
+void spi_display_fill_dma(const uint8_t* pixel, uint8_t pixel_bytes, uint32_t pixels) {
+    _check(_disp_selected, "fill with the display not selected");
+    _disp_bytes += ((uint64_t)pixels * pixel_bytes);
+    // The same frames the device sends (the pattern is two frames either way).
+    uint16_t pattern[PAL_EXPAND_ENTRY_FRAMES];
+    pal_expand_model_entry(pixel, pixel_bytes, pattern);
+    unsigned bits = (pixel_bytes == 3 ? 12 : 16);
+    uint32_t frames = (pixel_bytes == 3 ? pixels * 2 : pixels);
+    uint16_t fbuf[32];
+    for (int i = 0; i < 32; i++) {
+        fbuf[i] = pattern[i & 1];
+    }
+    while (frames) {
+        uint32_t n = (frames < 32 ? frames : 32);
+        ili_emu_write_frames(fbuf, n, bits);
+        frames -= n;
+    }
+}
+
+void spi_display_dma_external(uint frame_bits, size_t bytes, spi_display_dma_wait_fn wait) {
+    _check(false, "external DMA (the palette expansion isn't available on the host)");
+}
+
+void spi_display_pixels_begin(spi_display_resume_fn resume) {
+    _check(_disp_selected, "pixels with the display not selected");
+}
+
+// ############################################################################
+// Palette Expansion (not available)
+// ############################################################################
+//
+
+bool pal_expand_ready(void) {
+    return (false);
+}
+
+uint pal_expand_frame_bits(void) {
+    return (12);
+}
+
+void pal_expand_start(const uint32_t* packed, uint32_t pixels, volatile void* dst, uint dreq, bool dst_increment) {
+    _check(false, "pal_expand_start (the palette expansion isn't available on the host)");
+}
+
+void pal_expand_wait(void) {
+}
+
+// ############################################################################
+// Board and Display
+// ############################################################################
+//
+
+const rgb18_t RGB18_BLACK = { 0x00, 0x00, 0x00 };
+
+rgb18_t rgb18_from_color16(colorn16_t c16) {
+    // Only the black/white end points (the tests use rgb18_t colors).
+    return (c16 ? (rgb18_t){ 0xFC, 0xFC, 0xFC } : RGB18_BLACK);
+}
+
+void display_backlight_on(bool on) {
+}
+
+void warn_printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+}
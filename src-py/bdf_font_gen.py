@@ -0,0 +1,273 @@
+'''
+Utility program to compile a BDF font into the font data used by the display
+(see `display/fonts/font.h`).
+
+    python3 bdf_font_gen.py [options] -o <out_base> font.bdf
+
+Writes `<out_base>.c` and `<out_base>.h` with a `font_info_t` named for the
+output file (or `--name`).
+
+The glyphs are laid out for the renderer: one `uint16_t` per glyph row, with
+the left pixel in bit `width - 1`. Each glyph is placed in the character cell
+using the font's ascent (the baseline is `FONT_ASCENT` rows down).
+
+Options:
+    -r, --range LO-HI   Characters to include (repeat for more ranges). The
+                        default is all 128 (0x00-0x7F). When they aren't all
+                        included, an index maps the characters to the glyphs
+                        and the ones left out use the default character.
+    --default CODE      Character for the ones left out (default: the font's
+                        DEFAULT_CHAR, or space).
+    --cursor-line N     Suggested cursor line (default: height - 3).
+    --aa                The BDF is drawn at twice the cell size. The glyphs
+                        are reduced to the cell with a 2 bit coverage
+                        (anti-aliasing) plane, one `uint32_t` per row. The 1
+                        bit rows are the pixels that are at least half covered.
+
+Copyright 2023-25 AESilky (SilkyDesign)
+SPDX-License-Identifier: MIT
+'''
+import argparse
+import os
+import sys
+
+
+def read_bdf(path):
+    '''Read a BDF font. Returns (properties, bounding box, {encoding: (name, bbx, rows)}).'''
+    props = {}
+    fbbx = None
+    glyphs = {}
+    with open(path, encoding='utf-8') as f:
+        lines = [ln.rstrip('\n') for ln in f]
+    i = 0
+    in_props = False
+    while i < len(lines):
+        ln = lines[i]
+        key, _, rest = ln.partition(' ')
+        if key == 'FONTBOUNDINGBOX':
+            fbbx = [int(v) for v in rest.split()]
+        elif key == 'STARTPROPERTIES':
+            in_props = True
+        elif key == 'ENDPROPERTIES':
+            in_props = False
+        elif in_props:
+            props[key] = rest.strip().strip('"')
+        elif key == 'STARTCHAR':
+            name = rest.strip()
+            enc = -1
+            bbx = None
+            rows = []
+            i += 1
+            while lines[i] != 'ENDCHAR':
+                k, _, r = lines[i].partition(' ')
+                if k == 'ENCODING':
+                    enc = int(r.split()[0])
+                elif k == 'BBX':
+                    bbx = [int(v) for v in r.split()]
+                elif k == 'BITMAP':
+                    i += 1
+                    while lines[i] != 'ENDCHAR':
+                        rows.append(lines[i].strip())
+                        i += 1
+                    break
+                i += 1
+            if enc >= 0:
+                glyphs[enc] = (name, bbx, rows)
+        i += 1
+    if fbbx is None:
+        raise ValueError('{}: no FONTBOUNDINGBOX'.format(path))
+    return props, fbbx, glyphs
+
+
+def render(glyph, width, height, ascent, x0):
+    '''Render a glyph into a cell. Returns rows of pixels (lists of 0/1).'''
+    cell = [[0] * width for _ in range(height)]
+    if glyph is None:
+        return cell
+    _, (w, h, xoff, yoff), rows = glyph
+    top = ascent - (yoff + h)
+    for by, hexrow in enumerate(rows[:h]):
+        bits = int(hexrow, 16) if hexrow else 0
+        nbits = len(hexrow) * 4
+        for bx in range(w):
+            if bits & (1 << (nbits - 1 - bx)):
+                x = xoff - x0 + bx
+                y = top + by
+                if 0 <= x < width and 0 <= y < height:
+                    cell[y][x] = 1
+    return cell
+
+
+def reduce_aa(cell, width, height):
+    '''Reduce a 2x cell to coverage (0-3) for each pixel.'''
+    cov = []
+    for y in range(height):
+        row = []
+        for x in range(width):
+            n = cell[2 * y][2 * x] + cell[2 * y][2 * x + 1] + cell[2 * y + 1][2 * x] + cell[2 * y + 1][2 * x + 1]
+            row.append(min(3, ((n * 3) + 2) // 4))
+        cov.append(row)
+    return cov
+
+
+def parse_range(s):
+    lo, _, hi = s.partition('-')
+    lo = int(lo, 0)
+    hi = int(hi, 0) if hi else lo
+    if not (0 <= lo <= hi <= 0x7F):
+        raise argparse.ArgumentTypeError('range must be within 0x00-0x7F')
+    return range(lo, hi + 1)
+
+
+def bit_header(width):
+    '''The bit numbers over the pixel art (grouped by nibble).'''
+    nums = []
+    marks = []
+    for b in range(width - 1, -1, -1):
+        sep = '|' if (b % 4 == 3 and b != width - 1) else ' '
+        nums.append(sep + str(b % 10))
+        marks.append(sep + '-')
+    return ''.join(nums).lstrip(), ''.join(marks).lstrip()
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Compile a BDF font into display font data.')
+    ap.add_argument('-o', '--out', required=True, help='Output file base name (writes .c and .h)')
+    ap.add_argument('-n', '--name', help='Name of the font_info_t (default: the output file name)')
+    ap.add_argument('-r', '--range', action='append', type=parse_range, help='Characters to include (LO-HI)')
+    ap.add_argument('--default', type=lambda v: int(v, 0), help='Character for the ones left out')
+    ap.add_argument('--cursor-line', type=int, help='Suggested cursor line')
+    ap.add_argument('--aa', action='store_true', help='The BDF is 2x, make a 2 bit anti-aliasing plane')
+    ap.add_argument('bdf', help='The BDF font')
+    args = ap.parse_args()
+
+    props, fbbx, glyphs = read_bdf(args.bdf)
+    scale = 2 if args.aa else 1
+    width = fbbx[0] // scale
+    height = fbbx[1] // scale
+    if width > 16:
+        raise ValueError('{}: cell width {} is more than 16'.format(args.bdf, width))
+    ascent = int(props.get('FONT_ASCENT', fbbx[1] + fbbx[3]))
+    chars = sorted(set(c for r in (args.range or [range(0x80)]) for c in r))
+    default = args.default if args.default is not None else int(props.get('DEFAULT_CHAR', 0x20))
+    if len(chars) < 0x80 and default not in chars:
+        raise ValueError('default character 0x{:02X} is not included'.format(default))
+    cursor_line = args.cursor_line if args.cursor_line is not None else height - 3
+    family = props.get('FAMILY_NAME', os.path.splitext(os.path.basename(args.bdf))[0])
+    base = os.path.basename(args.out)
+    name = args.name or base
+
+    rows = []
+    aa_rows = []
+    labels = []
+    for c in chars:
+        glyph = glyphs.get(c)
+        cell = render(glyph, width * scale, height * scale, ascent, fbbx[2])
+        if args.aa:
+            cov = reduce_aa(cell, width, height)
+            aa_rows.append([sum(v << (2 * (width - 1 - x)) for x, v in enumerate(r)) for r in cov])
+            cell = [[1 if v >= 2 else 0 for v in r] for r in cov]
+        rows.append([sum(v << (width - 1 - x) for x, v in enumerate(r)) for r in cell])
+        if 0x20 <= c < 0x7F:
+            labels.append("'{}'".format(chr(c)))
+        else:
+            labels.append('< {} >'.format(glyph[0] if glyph else 'missing'))
+        if glyph is None:
+            print('0x{:02X} is not in the font (blank)'.format(c), file=sys.stderr)
+
+    nums, marks = bit_header(width)
+    c_lines = [
+        '/**',
+        ' * Copyright 2023-25 AESilky',
+        ' *',
+        ' * SPDX-License-Identifier: BSD-3-Clause',
+        ' */',
+        '#include "{}.h"'.format(base),
+        '',
+        '//',
+        '// Font data for {}'.format(family),
+        '//',
+        '// Generated by src-py/bdf_font_gen.py from {} - do not edit.'.format(os.path.basename(args.bdf)),
+        '// {} glyphs{}'.format(len(chars), ', with a 2 bit anti-aliasing plane' if args.aa else ''),
+        '//',
+        '',
+        'static const uint16_t _rows[] =',
+        '{',
+    ]
+    for label, grows in zip(['0x{:02X} {}'.format(c, lb) for c, lb in zip(chars, labels)], rows):
+        c_lines.append('\t// {} ({} wide x {} high cell)'.format(label, width, height))
+        c_lines.append('\t//      // {}'.format(nums))
+        c_lines.append('\t//      // {}'.format(marks))
+        for r in grows:
+            art = ''.join('# ' if r & (1 << (width - 1 - x)) else '  ' for x in range(width)).rstrip()
+            c_lines.append('\t0x{:04X}, // {}'.format(r, art).rstrip())
+        c_lines.append('')
+    c_lines.append('};')
+    if args.aa:
+        c_lines += ['', 'static const uint32_t _aa_rows[] =', '{']
+        for c, grows in zip(chars, aa_rows):
+            c_lines.append('\t// 0x{:02X}'.format(c))
+            for i in range(0, len(grows), 4):
+                c_lines.append('\t' + ' '.join('0x{:08X},'.format(r) for r in grows[i:i + 4]))
+        c_lines.append('};')
+    if len(chars) < 0x80:
+        glyph_of = {c: i for i, c in enumerate(chars)}
+        index = [glyph_of.get(c, glyph_of[default]) for c in range(0x80)]
+        c_lines += ['', 'static const uint8_t _index[] =', '{']
+        for i in range(0, 0x80, 16):
+            c_lines.append('\t' + ' '.join('{:3d},'.format(v) for v in index[i:i + 16]))
+        c_lines.append('};')
+    has_lowercase = all(c in chars for c in range(ord('a'), ord('z') + 1))
+    fields = [
+        ('"{}",'.format(family), 'name'),
+        ('{},'.format(width), 'width'),
+        ('{},'.format(height), 'height'),
+        ('{},'.format(cursor_line), 'suggested cursor line'),
+        ('0x{:08X},'.format((1 << width) - 1), 'bitmask'),
+        ('{},'.format('true' if has_lowercase else 'false'), 'has lowercase'),
+        ('{},'.format(len(chars)), 'glyph count'),
+        ('{},'.format('_index' if len(chars) < 0x80 else 'NULL'), 'index'),
+        ('_rows,', 'glyph rows'),
+        ('{},'.format('_aa_rows' if args.aa else 'NULL'), 'anti-aliasing rows'),
+    ]
+    c_lines += ['', '', 'const font_info_t {} ='.format(name), '{']
+    c_lines += ['\t{}\t// {}'.format(v.ljust(16), cmt) for v, cmt in fields]
+    c_lines.append('};')
+    guard = '_{}_H_'.format(base.upper())
+    h_lines = [
+        '/**',
+        ' * Copyright 2023-25 AESilky',
+        ' *',
+        ' * SPDX-License-Identifier: BSD-3-Clause',
+        ' */',
+        '',
+        '#ifndef {}'.format(guard),
+        '#define {}'.format(guard),
+        '#ifdef __cplusplus',
+        ' extern "C" {',
+        '#endif',
+        '',
+        '#include "font.h"',
+        '',
+        '/**',
+        ' * @brief Information for the {} font.'.format(family),
+        ' * @ingroup display',
+        ' */',
+        'extern const font_info_t {};'.format(name),
+        '',
+        '#ifdef __cplusplus',
+        '}',
+        '#endif',
+        '#endif // {}'.format(guard),
+    ]
+    # The font files use CRLF line endings, like the rest of the font directory.
+    with open(args.out + '.c', 'w', encoding='utf-8', newline='\r\n') as f:
+        f.write('\n'.join(c_lines) + '\n')
+    with open(args.out + '.h', 'w', encoding='utf-8', newline='\r\n') as f:
+        f.write('\n'.join(h_lines) + '\n')
+    size = len(chars) * height * 2 + (len(chars) * height * 4 if args.aa else 0) + (0x80 if len(chars) < 0x80 else 0)
+    print('{}: {} glyphs {}x{}, {} bytes'.format(name, len(chars), width, height, size), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,269 @@
+'''
+Utility program to convert icon images (PNG or PPM) into the run-length
+encoded icon data used by the display (see `display/icons/icon.h`).
+
+    python3 icon_rle_gen.py [-t RRGGBB] -o <out_base> image [image...]
+
+Writes `<out_base>.c` and `<out_base>.h` with an `icon_t` named `icon_<name>`
+for each image (the name is the file name without the extension).
+
+Pixels with alpha < 128 (PNG), or of the transparent color (`-t`), are
+transparent. The colors are reduced to the display's 6 bits each, and an icon
+can have up to 16 colors (including transparent).
+
+Only the Python standard library is used (PNG is decoded with zlib).
+
+Copyright 2023-25 AESilky (SilkyDesign)
+SPDX-License-Identifier: MIT
+'''
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+COLORS_MAX = 16
+NO_TRANSPARENT = 0xFF
+RUN_SHORT_MAX = 15
+RUN_LONG_MIN = 16
+RUN_LONG_MAX = RUN_LONG_MIN + 255
+
+
+def read_ppm(path):
+    '''Read a P3 (text) or P6 (binary) PPM. Returns (width, height, [(r,g,b,a)...]).'''
+    with open(path, 'rb') as f:
+        data = f.read()
+    # Header tokens (skipping comments)
+    tokens = []
+    pos = 0
+    while len(tokens) < 4:
+        while data[pos:pos + 1].isspace():
+            pos += 1
+        if data[pos:pos + 1] == b'#':
+            while data[pos:pos + 1] not in (b'\n', b''):
+                pos += 1
+            continue
+        start = pos
+        while not data[pos:pos + 1].isspace():
+            pos += 1
+        tokens.append(data[start:pos].decode('ascii'))
+    magic, width, height, maxval = tokens[0], int(tokens[1]), int(tokens[2]), int(tokens[3])
+    if magic == 'P6':
+        pos += 1  # Single whitespace after the header
+        if maxval > 255:
+            raise ValueError('{}: 16 bit PPM is not supported'.format(path))
+        values = list(data[pos:pos + (width * height * 3)])
+    elif magic == 'P3':
+        values = [int(v) for v in data[pos:].split()[:width * height * 3]]
+    else:
+        raise ValueError('{}: not a P3/P6 PPM'.format(path))
+    if len(values) < width * height * 3:
+        raise ValueError('{}: not enough pixel data'.format(path))
+    scale = 255 / maxval
+    pixels = []
+    for i in range(0, width * height * 3, 3):
+        pixels.append((round(values[i] * scale), round(values[i + 1] * scale), round(values[i + 2] * scale), 255))
+    return width, height, pixels
+
+
+def _paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def read_png(path):
+    '''Read a non-interlaced PNG. Returns (width, height, [(r,g,b,a)...]).'''
+    with open(path, 'rb') as f:
+        data = f.read()
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError('{}: not a PNG'.format(path))
+    pos = 8
+    idat = b''
+    plte = []
+    trns = b''
+    while pos < len(data):
+        length, ctype = struct.unpack('>I4s', data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if ctype == b'IHDR':
+            width, height, depth, color_type, _, _, interlace = struct.unpack('>IIBBBBB', chunk)
+        elif ctype == b'PLTE':
+            plte = [tuple(chunk[i:i + 3]) for i in range(0, len(chunk), 3)]
+        elif ctype == b'tRNS':
+            trns = chunk
+        elif ctype == b'IDAT':
+            idat += chunk
+        elif ctype == b'IEND':
+            break
+    if interlace:
+        raise ValueError('{}: interlaced PNG is not supported'.format(path))
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[color_type]
+    if depth != 8 and not (color_type in (0, 3) and depth in (1, 2, 4)):
+        raise ValueError('{}: {} bit PNG is not supported'.format(path, depth))
+    bits_pp = channels * depth
+    bpp = max(1, bits_pp // 8)
+    stride = (width * bits_pp + 7) // 8
+    raw = zlib.decompress(idat)
+    rows = []
+    prev = bytearray(stride)
+    for y in range(height):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                line[i] = (line[i] + _paeth(a, b, c)) & 0xFF
+        rows.append(line)
+        prev = line
+    pixels = []
+    for line in rows:
+        for x in range(width):
+            if depth < 8:
+                per_byte = 8 // depth
+                v = (line[x // per_byte] >> ((per_byte - 1 - (x % per_byte)) * depth)) & ((1 << depth) - 1)
+                samples = [v]
+            else:
+                samples = list(line[x * channels:(x + 1) * channels])
+            if color_type == 3:
+                r, g, b = plte[samples[0]]
+                a = trns[samples[0]] if samples[0] < len(trns) else 255
+            elif color_type in (0, 4):
+                g = samples[0] * 255 // ((1 << depth) - 1)
+                r, b = g, g
+                a = samples[1] if color_type == 4 else 255
+            else:
+                r, g, b = samples[:3]
+                a = samples[3] if color_type == 6 else 255
+            pixels.append((r, g, b, a))
+    return width, height, pixels
+
+
+def encode(name, width, height, pixels, transparent):
+    '''Build the palette and the runs for an image.'''
+    palette = []
+    color_index = {}
+    trans_index = NO_TRANSPARENT
+    indexes = []
+    for (r, g, b, a) in pixels:
+        if a < 128 or (transparent is not None and (r, g, b) == transparent):
+            if trans_index == NO_TRANSPARENT:
+                trans_index = len(palette)
+                palette.append(0)
+            indexes.append(trans_index)
+            continue
+        color = ((r & 0xFC) << 16) | ((g & 0xFC) << 8) | (b & 0xFC)
+        if color not in color_index:
+            color_index[color] = len(palette)
+            palette.append(color)
+        indexes.append(color_index[color])
+        if len(palette) > COLORS_MAX:
+            raise ValueError('{}: more than {} colors (after reducing to 6 bits)'.format(name, COLORS_MAX))
+    rle = bytearray()
+    for y in range(height):
+        row = indexes[y * width:(y + 1) * width]
+        x = 0
+        while x < width:
+            index = row[x]
+            n = 1
+            while x + n < width and row[x + n] == index and n < RUN_LONG_MAX:
+                n += 1
+            if n <= RUN_SHORT_MAX:
+                rle.append((index << 4) | (n - 1))
+            else:
+                rle.append((index << 4) | 0x0F)
+                rle.append(n - RUN_LONG_MIN)
+            x += n
+    return palette, trans_index, rle
+
+
+def main():
+    ap = argparse.ArgumentParser(description='Convert images to run-length encoded display icons.')
+    ap.add_argument('-o', '--out', required=True, help='Output file base name (writes .c and .h)')
+    ap.add_argument('-t', '--transparent', help='Transparent color (RRGGBB hex)')
+    ap.add_argument('images', nargs='+', help='PNG or PPM images')
+    args = ap.parse_args()
+    transparent = None
+    if args.transparent:
+        v = int(args.transparent, 16)
+        transparent = ((v >> 16) & 0xFF, (v >> 8) & 0xFF, v & 0xFF)
+
+    base = os.path.basename(args.out)
+    guard = '_{}_H_'.format(base.upper())
+    h_lines = [
+        '/**',
+        ' * @brief Icons (generated by src-py/icon_rle_gen.py - do not edit).',
+        ' * @ingroup display',
+        ' *',
+        ' * Copyright 2023-25 AESilky',
+        ' *',
+        ' * SPDX-License-Identifier: MIT',
+        ' */',
+        '#ifndef {}'.format(guard),
+        '#define {}'.format(guard),
+        '#ifdef __cplusplus',
+        'extern "C" {',
+        '#endif',
+        '',
+        '#include "icon.h"',
+        '',
+    ]
+    c_lines = [
+        '/**',
+        ' * Icons (generated by src-py/icon_rle_gen.py - do not edit).',
+        ' *',
+        ' * Copyright 2023-25 AESilky',
+        ' *',
+        ' * SPDX-License-Identifier: MIT',
+        ' */',
+        '#include "{}.h"'.format(base),
+    ]
+    for path in args.images:
+        name = os.path.splitext(os.path.basename(path))[0]
+        if path.lower().endswith('.png'):
+            width, height, pixels = read_png(path)
+        else:
+            width, height, pixels = read_ppm(path)
+        palette, trans_index, rle = encode(name, width, height, pixels, transparent)
+        raw_bytes = width * height * 3
+        print('{}: {}x{}, {} colors, {} bytes ({} raw RGB666)'.format(name, width, height, len(palette), len(rle), raw_bytes),
+              file=sys.stderr)
+        h_lines.append('extern const icon_t icon_{};  // {}x{}, {} bytes'.format(name, width, height, len(rle)))
+        c_lines.append('')
+        c_lines.append('static const gfx_color_t _{}_palette[] = {{'.format(name))
+        c_lines.append('    ' + ', '.join('0x{:06X}'.format(c) for c in palette) + ',')
+        c_lines.append('};')
+        c_lines.append('static const uint8_t _{}_rle[] = {{'.format(name))
+        for i in range(0, len(rle), 16):
+            c_lines.append('    ' + ', '.join('0x{:02X}'.format(b) for b in rle[i:i + 16]) + ',')
+        c_lines.append('};')
+        c_lines.append('const icon_t icon_{} = {{'.format(name))
+        c_lines.append('    "{}", {}, {}, {}, {},'.format(name, width, height, len(palette),
+                                                         'ICON_NO_TRANSPARENT' if trans_index == NO_TRANSPARENT else trans_index))
+        c_lines.append('    _{0}_palette, sizeof(_{0}_rle), _{0}_rle,'.format(name))
+        c_lines.append('};')
+    h_lines += [
+        '',
+        '#ifdef __cplusplus',
+        '}',
+        '#endif',
+        '#endif // {}'.format(guard),
+    ]
+    with open(args.out + '.h', 'w') as f:
+        f.write('\n'.join(h_lines) + '\n')
+    with open(args.out + '.c', 'w') as f:
+        f.write('\n'.join(c_lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()